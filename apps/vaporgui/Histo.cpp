@@ -20,10 +20,25 @@
 #include <vapor/DataMgrUtils.h>
 #include "Histo.h"
 #include <cassert>
+#include <sstream>
+#include <limits>
+#include <algorithm>
 using namespace VAPoR;
 using namespace Wasp;
 
-#define SAMPLE_RATE 30
+namespace {
+    // Upper bound on the number of non-empty block bins kept in the cache
+    const size_t MaxBlockCacheSize = 1 << 22;
+    
+    // Normalize a refinement or compression level, which may count down 
+    // from the finest level if negative, to the range 0..n-1
+    int normalizeLevel(int level, int n)
+    {
+        if (level < 0)
+            level += n;
+        return std::max(0, std::min(level, n - 1));
+    }
+}
 
 #ifndef __FLT_EPSILON__
 #define __FLT_EPSILON__ FLT_EPSILON
@@ -78,7 +93,26 @@ void Histo::reset(int newNumBins, float mnData, float mxData)
 }
 
 void Histo::addToBin(float val) {
+    int side;
+    int index = getBinIndex(val, &side);
     
+    if (side < 0)
+        _numSamplesBelow++;
+    else if (side > 0)
+        _numSamplesAbove++;
+    
+    if (index == INT_MIN)
+        return;
+    if (index < 0)
+        _below[index + _nBinsBelow]++;
+    else if (index >= _numBins)
+        _above[index - _numBins]++;
+    else
+        _binArray[index]++;
+}
+
+int Histo::getBinIndex(float val, int *side) const
+{
     // The additional checks below are because
     // 1. The data min/max are imperfect, e.g. calculated max is 1 but E value of 1.1
     // 2. Float precision errors, e.g.
@@ -88,28 +122,31 @@ void Histo::addToBin(float val) {
     //    >  0 - -1 = 1
     //    >  1 * array size = out of bounds
     
+    *side = 0;
     if (val < _minMapData) {
-        _numSamplesBelow++;
-        if (_below) {
-            assert(_minMapData-_minData > 0);
-            int index = (val-_minData)/(_minMapData-_minData) * _nBinsBelow;
-            
-            if (index >= _nBinsBelow)
-                index = _nBinsBelow - 1;
-            if (index >= 0)
-                _below[index]++;
-        }
+        *side = -1;
+        if (!_below)
+            return INT_MIN;
+        assert(_minMapData-_minData > 0);
+        int index = (val-_minData)/(_minMapData-_minData) * _nBinsBelow;
+        
+        if (index >= _nBinsBelow)
+            index = _nBinsBelow - 1;
+        if (index < 0)
+            return INT_MIN;
+        return index - _nBinsBelow;
     } else if (val > _maxMapData) {
-        _numSamplesAbove++;
-        if (_above) {
-            assert(_maxData-_maxMapData > 0);
-            int index = (val-_maxMapData)/(_maxData-_maxMapData) * _nBinsAbove;
-            
-            if (index < 0)
-                index = 0;
-            if (index < _nBinsAbove)
-                _above[index]++;
-        }
+        *side = 1;
+        if (!_above)
+            return INT_MIN;
+        assert(_maxData-_maxMapData > 0);
+        int index = (val-_maxMapData)/(_maxData-_maxMapData) * _nBinsAbove;
+        
+        if (index < 0)
+            index = 0;
+        if (index >= _nBinsAbove)
+            return INT_MIN;
+        return _numBins + index;
     } else
     {
         int intVal = 0;
@@ -120,7 +157,7 @@ void Histo::addToBin(float val) {
         
         if (intVal < 0) intVal = 0;
         if (intVal >= _numBins) intVal = _numBins-1;
-        _binArray[intVal]++;
+        return intVal;
     }
 }
     
@@ -222,10 +259,13 @@ int Histo::getBinIndexForValue(float v)
 }
 
 int Histo::Populate(const std::string &varName, VAPoR::DataMgr *dm, VAPoR::RenderParams *rp)
+{
+    return populate(varName, dm, rp, calculateNumSteps(varName, dm, rp) - 1);
+}
+
+int Histo::populate(const std::string &varName, VAPoR::DataMgr *dm, VAPoR::RenderParams *rp, int step)
 {
     size_t ts    = rp->GetCurrentTimestep();
-    int refLevel = rp->GetRefinementLevel();
-    int lod      = rp->GetCompressionLevel();
     vector<double> minExts, maxExts;
     rp->GetBox()->GetExtents(minExts, maxExts);
     
@@ -234,8 +274,8 @@ int Histo::Populate(const std::string &varName, VAPoR::DataMgr *dm, VAPoR::Rende
         setProperties(mf->getMinMapValue(), mf->getMaxMapValue(), varName, ts);
         _minExts = minExts;
         _maxExts = maxExts;
-        _lod = lod;
-        _refLevel = refLevel;
+        _lod = rp->GetCompressionLevel();
+        _refLevel = rp->GetRefinementLevel();
     }
     
     
@@ -269,21 +309,57 @@ int Histo::Populate(const std::string &varName, VAPoR::DataMgr *dm, VAPoR::Rende
     if (_above) memset(_above, 0, _nBinsAbove*sizeof(*_above));
     
     
+    int refLevel, lod;
+    getStepLevels(varName, dm, rp, step, &refLevel, &lod);
+    
+    int stride = DataMgrUtils::GetDefaultMetaInfoStride(dm, varName, refLevel);
+    
+    // Histograms are stored with the data manager's metadata, which may
+    // be persisted across sessions. The key must not contain ':'
+    std::ostringstream metaKey;
+    metaKey.precision(std::numeric_limits<double>::max_digits10);
+    metaKey << "Histo " << stride << " " << _numBins << " " << _nBinsBelow << " " << _nBinsAbove << " "
+        << _minMapData << " " << _maxMapData << " " << _minData << " " << _maxData;
+    for (auto v : minExts) metaKey << " " << v;
+    for (auto v : maxExts) metaKey << " " << v;
+    
+    vector<double> binValues;
+    if (dm->GetVariableMetadata(ts, varName, refLevel, lod, metaKey.str(), binValues) && setBinValues(binValues)) {
+        calculateMaxBinSize();
+        _populated = true;
+        _step = step;
+        _numSteps = calculateNumSteps(varName, dm, rp);
+        return 0;
+    }
+    
     Grid *grid;
     int rc = DataMgrUtils::GetGrids(dm, ts, varName, minExts, maxExts, true, &refLevel, &lod, &grid);
     
     if (rc < 0)
         return -1;
     
-    grid->SetInterpolationOrder(1);
+    // Block histograms can be reused as long as neither the data nor
+    // the bins change
+    std::ostringstream key;
+    key.precision(9);
+    key << varName << " " << ts << " " << refLevel << " " << lod << " " << stride << " "
+        << _numBins << " " << _nBinsBelow << " " << _nBinsAbove << " "
+        << _minMapData << " " << _maxMapData << " " << _minData << " " << _maxData;
+    if (key.str() != _blockCacheKey) {
+        _blockCache.clear();
+        _blockCacheSize = 0;
+        _blockCacheKey = key.str();
+    }
     
-    if (shouldUseSampling(varName, dm, rp))
-        populateSamplingHistogram(grid, minExts, maxExts);
-    else
-        populateIteratingHistogram(grid, calculateStride(varName, dm, rp));
+    populateIteratingHistogram(grid, stride, minExts, maxExts, dm->GetNumThreads());
+    
+    getBinValues(binValues);
+    dm->SetVariableMetadata(ts, varName, refLevel, lod, metaKey.str(), binValues);
     
     calculateMaxBinSize();
     _populated = true;
+    _step = step;
+    _numSteps = calculateNumSteps(varName, dm, rp);
     
     delete grid;
     return 0;
@@ -310,100 +386,193 @@ bool Histo::NeedsUpdate(const std::string &varName, VAPoR::DataMgr *dm, VAPoR::R
     return false;
 }
 
-int Histo::PopulateIfNeeded(const std::string &varName, VAPoR::DataMgr *dm, VAPoR::RenderParams *rp)
+int Histo::PopulateIfNeeded(const std::string &varName, VAPoR::DataMgr *dm, VAPoR::RenderParams *rp, bool progressive)
 {
     if (!NeedsUpdate(varName, dm, rp))
         return 0;
     
     reset(_numBins);
+    if (progressive)
+        return populate(varName, dm, rp, 0);
     return Populate(varName, dm, rp);
 }
 
-void Histo::populateIteratingHistogram(const Grid *grid, const int stride)
+int Histo::Refine(const std::string &varName, VAPoR::DataMgr *dm, VAPoR::RenderParams *rp)
 {
-    VAssert(grid);
-    
-    float missingValue = grid->GetMissingValue();
-    Grid::ConstIterator enditr = grid->cend();
+    if (NeedsUpdate(varName, dm, rp))
+        return PopulateIfNeeded(varName, dm, rp, true);
+    if (IsConverged())
+        return 0;
     
-    for (auto itr = grid->cbegin(); itr != enditr; itr += stride) {
-        float v = *itr;
-        if (v != missingValue)
-            addToBin(v);
-    }
+    int step = _step + 1;
+    reset(_numBins);
+    return populate(varName, dm, rp, step);
 }
 
-#define X 0
-#define Y 1
-#define Z 2
-
-void Histo::populateSamplingHistogram(const Grid *grid, const vector<double> &minExts, const vector<double> &maxExts)
+void Histo::populateIteratingHistogram(const Grid *grid, const int stride, const vector<double> &minExts, const vector<double> &maxExts, int nthreads)
 {
     VAssert(grid);
-    VAssert(minExts.size() == 3 && maxExts.size() == 3);
-    
-    double dx = (maxExts[X]-minExts[X]) / SAMPLE_RATE;
-    double dy = (maxExts[Y]-minExts[Y]) / SAMPLE_RATE;
-    double dz = (maxExts[Z]-minExts[Z]) / SAMPLE_RATE;
-    std::vector<double> deltas = {dx, dy, dz};
-    
-    float varValue, missingValue;
-    std::vector<double> coords(3, 0.0);
-    
-    double xStartPoint = minExts[X] + deltas[X]/2.f;
-    double yStartPoint = minExts[Y] + deltas[Y]/2.f;
-    double zStartPoint = minExts[Z] + deltas[Z]/2.f;
     
-    coords[X] = xStartPoint;
-    coords[Y] = yStartPoint;
-    coords[Z] = zStartPoint;
-    
-    int iSamples = SAMPLE_RATE;
-    int jSamples = SAMPLE_RATE;
-    int kSamples = SAMPLE_RATE;
+    float missingValue = grid->GetMissingValue();
     
-    if (deltas[X] == 0)
-        iSamples = 1;
-    if (deltas[Y] == 0)
-        jSamples = 1;
-    if (deltas[Z] == 0)
-        kSamples = 1;
+    // Identify blocks by their coordinates in the whole mesh, rather than
+    // in the grid, which depends on the box
+    vector<size_t> bdims = grid->GetDimensionInBlks();
+    vector<size_t> bs = grid->GetBlockSize();
+    vector<size_t> minAbs = grid->GetMinAbs();
+    auto blockID = [&](size_t b) {
+        size_t id = 0;
+        for (int i = 0; i < bdims.size(); i++) {
+            size_t c = b % bdims[i] + (i < minAbs.size() ? minAbs[i] / bs[i] : 0);
+            b /= bdims[i];
+            id |= c << (21 * i);
+        }
+        return id;
+    };
+    
+    // Bins are stored from the lowest below-range bin up
+    int nBelow = _below ? _nBinsBelow : 0;
+    int nAbove = _above ? _nBinsAbove : 0;
+    size_t nBins = nBelow + _numBins + nAbove;
+    
+    struct ThreadBins {
+        vector<unsigned int> total;
+        vector<unsigned int> block;
+        vector<int> touched;
+        long totalBelow = 0, totalAbove = 0;
+        long blockBelow = 0, blockAbove = 0;
+        bool inBlock = false;
+        size_t id = 0;
+        bool cached = false;
+        bool masked = false;
+        size_t skip = 0;
+        vector<std::pair<size_t, BlockBins>> newBlocks;
+    };
+    
+    nthreads = Grid::GetNumBlockThreads(nthreads);
+    vector<ThreadBins> threads(nthreads);
+    for (auto &tb : threads) {
+        tb.total.resize(nBins, 0);
+        tb.block.resize(nBins, 0);
+    }
     
-    for (int k=0; k<kSamples; k++) {
-        coords[Y] = yStartPoint;
+    auto endBlock = [&](ThreadBins &tb) {
+        if (!tb.inBlock || tb.cached) {
+            tb.inBlock = false;
+            return;
+        }
+        
+        BlockBins bb;
+        bb.below = tb.blockBelow;
+        bb.above = tb.blockAbove;
+        for (int i : tb.touched) {
+            bb.bins.push_back(std::make_pair(i - nBelow, tb.block[i]));
+            tb.total[i] += tb.block[i];
+            tb.block[i] = 0;
+        }
+        tb.totalBelow += tb.blockBelow;
+        tb.totalAbove += tb.blockAbove;
+        
+        // Blocks cut by the box can't be reused for another box
+        if (!tb.masked)
+            tb.newBlocks.push_back(std::make_pair(tb.id, std::move(bb)));
         
-        for (int j=0; j<jSamples; j++) {
-            coords[X] = xStartPoint;
+        tb.touched.clear();
+        tb.blockBelow = tb.blockAbove = 0;
+        tb.inBlock = false;
+    };
+    
+    // All of the spans of a block are visited by the same thread, one 
+    // after another. Every stride-th value is sampled, starting over in
+    // each block so that block histograms don't depend on the box.
+    grid->ForEachIndexedBlock(minExts, maxExts, [&](int t, size_t b, const float *values, const unsigned char *mask, size_t n) {
+        ThreadBins &tb = threads[t];
+        size_t id = blockID(b);
+        if (!tb.inBlock || tb.id != id) {
+            endBlock(tb);
+            tb.inBlock = true;
+            tb.id = id;
+            tb.masked = mask != nullptr;
+            tb.skip = 0;
             
-            for (int i=0; i<iSamples; i++) {
-                varValue = grid->GetValue(coords);
-                missingValue = grid->GetMissingValue();
-                if (varValue != missingValue)
-                    addToBin(varValue);
-                coords[X] += deltas[X];
+            auto itr = _blockCache.find(id);
+            tb.cached = !mask && itr != _blockCache.end();
+            if (tb.cached) {
+                for (const auto &bin : itr->second.bins)
+                    tb.total[bin.first + nBelow] += bin.second;
+                tb.totalBelow += itr->second.below;
+                tb.totalAbove += itr->second.above;
             }
-            coords[Y] += deltas[Y];
         }
-        coords[Z] += deltas[Z];
+        if (tb.cached)
+            return;
+        
+        size_t i = tb.skip;
+        for (; i < n; i += stride) {
+            float v = values[i];
+            if (v == missingValue || (mask && !mask[i]))
+                continue;
+            
+            int side;
+            int index = getBinIndex(v, &side);
+            if (side < 0)
+                tb.blockBelow++;
+            else if (side > 0)
+                tb.blockAbove++;
+            if (index == INT_MIN)
+                continue;
+            
+            unsigned int &count = tb.block[index + nBelow];
+            if (count++ == 0)
+                tb.touched.push_back(index + nBelow);
+        }
+        tb.skip = i - n;
+    }, nthreads);
+    
+    for (auto &tb : threads) {
+        endBlock(tb);
+        
+        for (int i = 0; i < nBelow; i++)
+            _below[i] += tb.total[i];
+        for (int i = 0; i < _numBins; i++)
+            _binArray[i] += tb.total[nBelow + i];
+        for (int i = 0; i < nAbove; i++)
+            _above[i] += tb.total[nBelow + _numBins + i];
+        _numSamplesBelow += tb.totalBelow;
+        _numSamplesAbove += tb.totalAbove;
+        
+        for (auto &block : tb.newBlocks) {
+            if (_blockCacheSize + block.second.bins.size() > MaxBlockCacheSize)
+                break;
+            _blockCacheSize += block.second.bins.size();
+            _blockCache[block.first] = std::move(block.second);
+        }
     }
 }
 
-#undef X
-#undef Y
-#undef Z
-
-int Histo::calculateStride(const std::string &varName, VAPoR::DataMgr *dm, const VAPoR::RenderParams *rp) const
+void Histo::getBinValues(vector<double> &values) const
 {
-    return DataMgrUtils::GetDefaultMetaInfoStride(dm, varName, rp->GetRefinementLevel());
+    values.clear();
+    values.push_back(_numSamplesBelow);
+    values.push_back(_numSamplesAbove);
+    for (int i = 0; i < _nBinsBelow; i++) values.push_back(_below[i]);
+    for (int i = 0; i < _numBins; i++) values.push_back(_binArray[i]);
+    for (int i = 0; i < _nBinsAbove; i++) values.push_back(_above[i]);
 }
 
-bool Histo::shouldUseSampling(const std::string &varName, VAPoR::DataMgr *dm, const VAPoR::RenderParams *rp) const
+bool Histo::setBinValues(const vector<double> &values)
 {
-    // TODO how does this handle with unstructured grids?
-    int nDims = dm->GetNumDimensions(varName);
-    if (nDims == 3)
-        return true;
-    return false;
+    size_t n = 2 + std::max(_nBinsBelow, 0) + _numBins + std::max(_nBinsAbove, 0);
+    if (values.size() != n)
+        return false;
+    
+    const double *v = values.data();
+    _numSamplesBelow = *v++;
+    _numSamplesAbove = *v++;
+    for (int i = 0; i < _nBinsBelow; i++) _below[i] = *v++;
+    for (int i = 0; i < _numBins; i++) _binArray[i] = *v++;
+    for (int i = 0; i < _nBinsAbove; i++) _above[i] = *v++;
+    return true;
 }
 
 void Histo::setProperties(float mnData, float mxData, string var, int ts)
@@ -418,6 +587,19 @@ void Histo::setProperties(float mnData, float mxData, string var, int ts)
     _timestepOfUpdate = ts;
 }
 
+int Histo::calculateNumSteps(const std::string &varName, VAPoR::DataMgr *dm, const VAPoR::RenderParams *rp) const
+{
+    int refLevel = normalizeLevel(rp->GetRefinementLevel(), dm->GetNumRefLevels(varName));
+    int lod = normalizeLevel(rp->GetCompressionLevel(), dm->GetCRatios(varName).size());
+    return std::max(refLevel, lod) + 1;
+}
+
+void Histo::getStepLevels(const std::string &varName, VAPoR::DataMgr *dm, const VAPoR::RenderParams *rp, int step, int *refLevel, int *lod) const
+{
+    *refLevel = std::min(step, normalizeLevel(rp->GetRefinementLevel(), dm->GetNumRefLevels(varName)));
+    *lod = std::min(step, normalizeLevel(rp->GetCompressionLevel(), dm->GetCRatios(varName).size()));
+}
+
 void Histo::calculateMaxBinSize()
 {
     int maxBinSize = 0;
@@ -23,6 +23,7 @@
 #include <string>
 #include <vector>
 #include <climits>
+#include <unordered_map>
 #include <vapor/MyBase.h>
 #include <vapor/StructuredGrid.h>
 #include <vapor/RenderParams.h>
@@ -56,7 +57,18 @@ public:
     
     int Populate(const std::string &varName, VAPoR::DataMgr *dm, VAPoR::RenderParams *rp);
     bool NeedsUpdate(const std::string &varName, VAPoR::DataMgr *dm, VAPoR::RenderParams *rp);
-    int PopulateIfNeeded(const std::string &varName, VAPoR::DataMgr *dm, VAPoR::RenderParams *rp);
+    
+    // If progressive is true, only the coarsest approximation of the
+    // histogram is computed, which can then be improved with Refine()
+    int PopulateIfNeeded(const std::string &varName, VAPoR::DataMgr *dm, VAPoR::RenderParams *rp, bool progressive = false);
+    
+    // Compute the next finer approximation of the histogram, starting
+    // over if the parameters changed
+    int Refine(const std::string &varName, VAPoR::DataMgr *dm, VAPoR::RenderParams *rp);
+    
+    // True if the histogram was computed at the requested refinement
+    // and compression levels
+    bool IsConverged() const { return _populated && _step == _numSteps - 1; }
 	
 private:
 	unsigned int* _binArray = nullptr;
@@ -77,12 +89,35 @@ private:
 	string _varnameOfUpdate;
     bool autoSetProperties = false;
     
-    void populateIteratingHistogram(const VAPoR::Grid *grid, const int stride);
-    void populateSamplingHistogram(const VAPoR::Grid *grid, const vector<double> &minExts, const vector<double> &maxExts);
-    int calculateStride(const std::string &varName, VAPoR::DataMgr *dm, const VAPoR::RenderParams *rp) const;
-    bool shouldUseSampling(const std::string &varName, VAPoR::DataMgr *dm, const VAPoR::RenderParams *rp) const;
+    // Approximations are computed from coarse to fine refinement and 
+    // compression levels. _step is the approximation currently held.
+    int _step = -1;
+    int _numSteps = 0;
+    
+    // Histograms of the blocks that lie entirely inside the box, so that
+    // a box change only rebins the blocks it affects. Bins are indexed
+    // as in getBinSize(). The cache is only valid for the bin layout and 
+    // data described by _blockCacheKey.
+    struct BlockBins {
+        std::vector<std::pair<int, unsigned int>> bins;
+        long below = 0;
+        long above = 0;
+    };
+    std::string _blockCacheKey;
+    std::unordered_map<size_t, BlockBins> _blockCache;
+    size_t _blockCacheSize = 0;
+    
+    int populate(const std::string &varName, VAPoR::DataMgr *dm, VAPoR::RenderParams *rp, int step);
+    void populateIteratingHistogram(const VAPoR::Grid *grid, const int stride, const vector<double> &minExts, const vector<double> &maxExts, int nthreads);
+    int getBinIndex(float val, int *side) const;
+    void getStepLevels(const std::string &varName, VAPoR::DataMgr *dm, const VAPoR::RenderParams *rp, int step, int *refLevel, int *lod) const;
+    int calculateNumSteps(const std::string &varName, VAPoR::DataMgr *dm, const VAPoR::RenderParams *rp) const;
     void setProperties(float mnData, float mxData, string var, int ts);
     void calculateMaxBinSize();
+    
+    // Serialize the bin counts for DataMgr::SetVariableMetadata()
+    void getBinValues(std::vector<double> &values) const;
+    bool setBinValues(const std::vector<double> &values);
     void _getDataRange(const std::string &varName, VAPoR::DataMgr *d, VAPoR::RenderParams *r, float *min, float *max) const;
 };
 
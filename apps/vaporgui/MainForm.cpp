@@ -50,6 +50,8 @@
 #include <QStatusBar>
 #include <QDebug>
 #include <QScreen>
+#include <QStandardPaths>
+#include <QDir>
 
 #include <vapor/Version.h>
 #include <vapor/DataMgr.h>
@@ -344,6 +346,16 @@ MainForm::MainForm(
 	_controlExec->SetCacheSize(sP->GetCacheMB());
 	_controlExec->SetNumThreads(sP->GetNumThreads());
 
+	// Persist data ranges, histograms, etc. across sessions. DataMgr
+	// bounds the directory; removing it only costs recomputation
+	//
+	QString cacheDir = QStandardPaths::writableLocation(
+		QStandardPaths::CacheLocation
+	);
+	if (! cacheDir.isEmpty() && QDir().mkpath(cacheDir)) {
+		_controlExec->SetMetadataCacheDir(cacheDir.toStdString());
+	}
+
 	bool lockSize = sP->GetWinSizeLock();
 	if (lockSize) {
 		size_t width, height;
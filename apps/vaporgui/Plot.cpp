@@ -549,6 +549,22 @@ void Plot::_spaceTabPlotClicked()
     for( int i = 0; i < point1.size(); i++ )
         p1p2span.push_back( point2[i] - point1[i] );
 
+    // Sample locations are the same for every variable
+    std::vector< std::vector<double> >   samples( numOfSamples );
+    for( int i = 0; i < numOfSamples; i++ )
+    {
+        if( i == 0 )
+            samples[i] = point1;
+        else if( i == numOfSamples - 1 )
+            samples[i] = point2;
+        else
+        {
+            for( int j = 0; j < point1.size(); j++ )
+                samples[i].push_back( (double)i / (double)(numOfSamples-1) * 
+                                      p1p2span[j] + point1[j] );
+        }
+    }
+
     std::vector< std::vector<float> >    sequences;
     for( int v = 0; v < enabledVars.size(); v++ )
     {
@@ -557,25 +573,21 @@ void Plot::_spaceTabPlotClicked()
                             refinementLevel, compressLevel );
         if( grid )
         {
+            // Pack the samples with the grid's geometry dimension and
+            //   evaluate them all with one call
+            size_t ndim = grid->GetGeometryDim();
+            std::vector<double> coords( numOfSamples * ndim, 0.0 );
+            for( int i = 0; i < numOfSamples; i++ )
+                for( int j = 0; j < ndim && j < samples[i].size(); j++ )
+                    coords[ i * ndim + j ] = samples[i][j];
+
+            grid->SampleMany( coords.data(), numOfSamples, seq.data() );
+
             float missingVal  = grid->GetMissingValue();
             for( int i = 0; i < numOfSamples; i++ )
             {
-                std::vector<double>     sample;
-                if( i == 0 )
-                    sample = point1;
-                else if( i == numOfSamples - 1 )
-                    sample = point2;
-                else
-                {
-                    for( int j = 0; j < point1.size(); j++ )
-                        sample.push_back( (double)i / (double)(numOfSamples-1) * 
-                                           p1p2span[j] + point1[j] );
-                }
-                float fieldVal = grid->GetValue( sample );
-                if( fieldVal == missingVal )
+                if( seq[i] == missingVal )
                     seq[i] = std::nanf("1");
-                else
-                    seq[i] = fieldVal;
             }
             sequences.push_back( seq );
         }
@@ -35,6 +35,8 @@
 #include <algorithm>
 #include <vapor/MyBase.h>
 #include <vapor/DataStatus.h>
+#include <vapor/QuantileEngine.h>
+#include <vapor/Moments.h>
 
 using namespace Wasp;
 using namespace VAPoR;
@@ -472,18 +474,19 @@ void Statistics::_updateButtonClicked()
         _validStats.GetCount(   varname, &count );
         if( count == -1 )
         {
-            _calc3M( varname );
+            _calcMoments( varname );
             _updateStatsTable();
         }
         float m3[3]{0.0f, 0.0f, 0.0f}, median = 0.0f, stddev = 0.0f;
         _validStats.Get3MStats( varname, m3 );
         _validStats.GetMedian ( varname, &median );
         _validStats.GetStddev ( varname, &stddev );
-        if( ( statsParams->GetMinEnabled() || 
-              statsParams->GetMaxEnabled() ||
-              statsParams->GetMeanEnabled()    )  && std::isnan(m3[2]) )
+        if( ( ( statsParams->GetMinEnabled() || 
+                statsParams->GetMaxEnabled() ||
+                statsParams->GetMeanEnabled()    )  && std::isnan(m3[2]) ) ||
+            ( statsParams->GetStdDevEnabled() && std::isnan( stddev ) ) )
         {
-            _calc3M( varname );
+            _calcMoments( varname );
             _updateStatsTable();
         }
         if( statsParams->GetMedianEnabled() && std::isnan( median ) )
@@ -491,11 +494,6 @@ void Statistics::_updateButtonClicked()
             _calcMedian( varname );
             _updateStatsTable();
         }
-        if( statsParams->GetStdDevEnabled() && std::isnan( stddev ) )
-        {
-            _calcStddev( varname );
-            _updateStatsTable();
-        }
     }
 }
 
@@ -696,7 +694,7 @@ void Statistics::_removeVarChanged( int index )
     _validStats.RemoveVariable( varName );
 }
 
-bool Statistics::_calc3M( std::string varname )
+bool Statistics::_calcMoments( std::string varname )
 {
     // Initialize pointers
     GUIStateParams* guiParams = dynamic_cast<GUIStateParams*>
@@ -712,46 +710,32 @@ bool Statistics::_calc3M( std::string varname )
         maxTS = minTS;
     std::vector<double> minExtent, maxExtent;
     statsParams->GetBox()->GetExtents( minExtent, maxExtent );
-
-    float c = 0.0;
-    float sum = 0.0;
-    float min = std::numeric_limits<float>::max();
-    float max = -min;
-    long   count = 0;
-
+    int refLevel  = statsParams->GetRefinementLevel();
+    int compLevel = statsParams->GetCompressionLevel();
+
+    // Min, max, mean, and stddev all come from a single pass over each 
+    // time step. The DataMgr caches the moments of each time step, so 
+    // extending the time range only reads the new time steps. Time steps 
+    // are visited one at a time, and GetDataMoments() scans the blocks of 
+    // each one in parallel.
+    VAPoR::Moments moments;
     for( int ts = minTS; ts <= maxTS; ts++ )
     {
-        VAPoR::Grid* grid = currentDmgr->GetVariable( ts, varname, 
-                statsParams->GetRefinementLevel(), statsParams->GetCompressionLevel(),
-                minExtent, maxExtent );
-        if( grid )
-        {
-            Grid::ConstIterator endItr  = grid->cend(); 
-            float missingVal            = grid->GetMissingValue();
-
-            for( Grid::ConstIterator it = grid->cbegin(minExtent, maxExtent); it != endItr; ++it )
-            {
-                if( *it != missingVal )
-                {
-                    float val = *it; 
-                    min = min < val ? min : val;
-                    max = max > val ? max : val;
-                    float y = val - c;
-                    float t = sum + y;
-                           c = t - sum - y;
-                         sum = t; 
-                    count++;
-                }
-            }
-
-            delete grid;    // delete the grid after using it! 
-        }
+        // A time step whose region can't be read contributes nothing
+        VAPoR::Moments m;
+        currentDmgr->GetDataMoments( ts, varname, refLevel, compLevel,
+                                     minExtent, maxExtent, m, 
+                                     currentDmgr->GetNumThreads() );
+        moments.Merge( m );
     }
-    
+
+    long count = (long)moments.GetCount();
     if( count > 0 )
     {
-        float m3[3] = {min, max, sum/(float)count};
+        float m3[3] = { (float)moments.GetMin(), (float)moments.GetMax(), 
+                        (float)moments.GetMean() };
         _validStats.Add3MStats( varname, m3 );
+        _validStats.AddStddev( varname, (float)moments.GetStddev() );
     }
     else    // count == 0
     {
@@ -780,108 +764,60 @@ bool Statistics::_calcMedian( std::string varname )
     std::vector<double> minExtent, maxExtent;
     statsParams->GetBox()->GetExtents( minExtent, maxExtent );
 
-    std::vector<float> buffer;
-    for( int ts = minTS; ts <= maxTS; ts++ )
-    {
-        VAPoR::Grid* grid = currentDmgr->GetVariable( ts, varname, 
+    // The median is streamed without keeping all of the values in memory.
+    // The exact median takes several passes over the values, so it is only 
+    // computed for a single time step, whose grid is read once. Reading many 
+    // time steps again for every pass costs too much, so their median is 
+    // approximated in a single pass instead.
+    const bool exact = minTS == maxTS;
+    QuantileEngine engine( exact ? QuantileEngine::EXACT : QuantileEngine::APPROXIMATE, 
+                           0.0001, currentDmgr->GetNumThreads() );
+    engine.SetQuantiles( {0.5} );
+
+    VAPoR::Grid* exactGrid = nullptr;
+    if( exact )
+        exactGrid = currentDmgr->GetVariable( minTS, varname, 
                 statsParams->GetRefinementLevel(), statsParams->GetCompressionLevel(),
                 minExtent, maxExtent );
-        if( grid )
-        {
-            Grid::ConstIterator endItr  = grid->cend(); 
-            float missingVal            = grid->GetMissingValue();
-
-            for( Grid::ConstIterator it = grid->cbegin(minExtent, maxExtent); it != endItr; ++it )
-            {
-                if( *it != missingVal )
-                    buffer.push_back( *it );
-            }
-        }
-    }
-    
-    if( buffer.size() > 0 )
-    {
-        std::sort( buffer.begin(), buffer.end() );
-        float median = buffer.at( buffer.size() / 2 );
-        _validStats.AddMedian( varname, median );
-    }
-    else
-    {
-        //std::cerr << "Error: Zero value got selected!!" << std::endl;
-    }
-        
-    _validStats.AddCount(  varname, buffer.size() );
-
-    return true;
-}
-
-bool Statistics::_calcStddev( std::string varname )
-{
-    // Initialize pointers
-    GUIStateParams* guiParams = dynamic_cast<GUIStateParams*>
-                    (_controlExec->GetParamsMgr()->GetParams( GUIStateParams::GetClassType() ));
-    std::string dsName = guiParams->GetStatsDatasetName();
-    StatisticsParams* statsParams = dynamic_cast<StatisticsParams*>
-            (_controlExec->GetParamsMgr()->GetAppRenderParams(dsName, StatisticsParams::GetClassType()));
-    VAPoR::DataMgr* currentDmgr = _controlExec->GetDataStatus()->GetDataMgr( dsName );
-
-    int minTS = statsParams->GetCurrentTimestep();
-    int maxTS = statsParams->GetCurrentMaxTS();
-    if( !currentDmgr->IsTimeVarying( varname ) )
-        maxTS = minTS;
-    std::vector<double> minExtent, maxExtent;
-    statsParams->GetBox()->GetExtents( minExtent, maxExtent );
-
-    float c     = 0.0;
-    float sum   = 0.0;
-    long  count = 0;
-    float m3[3];
-    _validStats.Get3MStats( varname, m3 );
-    if( std::isnan( m3[2] ) )
-    {
-        this->_calc3M( varname );
-        _validStats.Get3MStats( varname, m3 );
-    }
 
-    for( int ts = minTS; ts <= maxTS; ts++ )
+    while( engine.BeginPass() )
     {
-        VAPoR::Grid* grid = currentDmgr->GetVariable( ts, varname, 
-                statsParams->GetRefinementLevel(), statsParams->GetCompressionLevel(),
-                minExtent, maxExtent );
-        if( grid )
+        for( int ts = minTS; ts <= maxTS; ts++ )
         {
-            Grid::ConstIterator endItr  = grid->cend(); 
-            float missingVal            = grid->GetMissingValue();
-            for( Grid::ConstIterator it = grid->cbegin(minExtent, maxExtent); it != endItr; ++it )
+            VAPoR::Grid* grid = exactGrid;
+            if( !exact )
+                grid = currentDmgr->GetVariable( ts, varname, 
+                        statsParams->GetRefinementLevel(), statsParams->GetCompressionLevel(),
+                        minExtent, maxExtent );
+            if( grid )
             {
-                if( *it != missingVal )
-                {
-                    float val = *it;
-                    float y = (val - m3[2]) * (val - m3[2]) - c;
-                    float t = sum + y;
-                           c = t - sum - y;
-                         sum = t; 
-                    count++;
-                }
+                grid->ForEachBlock( minExtent, maxExtent, 
+                                    engine.GetVisitor( grid->GetMissingValue() ),
+                                    engine.GetNumThreads() );
+                if( !exact )
+                    delete grid;    // delete the grid after using it! 
             }
         }
+        engine.EndPass();
     }
+    if( exactGrid )
+        delete exactGrid;
     
-    if( count > 0 )
+    std::vector<double> median;
+    if( engine.GetQuantiles( median ) == 0 )
     {
-        _validStats.AddStddev( varname, std::sqrt( sum / (float)count ));
+        _validStats.AddMedian( varname, (float)median[0] );
     }
     else
     {
         //std::cerr << "Error: Zero value got selected!!" << std::endl;
     }
-       
-    _validStats.AddCount(  varname, count );
+        
+    _validStats.AddCount(  varname, engine.GetCount() );
 
     return true;
 }
 
-
 // ValidStats class
 //
 int Statistics::ValidStats::_getVarIdx( std::string& varName )
@@ -134,8 +134,7 @@ private:
     void                _updateStatsTable();
 
     // calculations should put results in _validStats directly.
-    bool                _calc3M( std::string ); // min, max, mean
+    bool                _calcMoments( std::string ); // min, max, mean, stddev
     bool                _calcMedian( std::string );
-    bool                _calcStddev( std::string );
 };
 #endif
@@ -4,6 +4,7 @@
 #include <vapor/DataMgr.h>
 #include <QPainter>
 #include <QPicture>
+#include <QTimer>
 #include <glm/glm.hpp>
 #include <Histo.h>
 #include "ErrorReporter.h"
@@ -24,6 +25,13 @@ TFHistogramMap::TFHistogramMap(const std::string &variableNameTag, TFMapWidget *
 : TFMap(variableNameTag, parent)
 {
     _scalingMenu = new ParamsDropdownMenuItem(this, SCALING_TAG, {"Linear", "Logarithmic", "Boolean"}, {}, "Histogram Scaling");
+    
+    // The histogram is first computed from coarse data, and refined one
+    // level at a time from the event loop so the editor stays responsive
+    _refineTimer = new QTimer(this);
+    _refineTimer->setSingleShot(true);
+    _refineTimer->setInterval(0);
+    connect(_refineTimer, SIGNAL(timeout()), this, SLOT(_refineHistogram()));
 }
 
 QSize TFHistogramMap::minimumSizeHint() const
@@ -45,13 +53,30 @@ void TFHistogramMap::paramsUpdate()
 {
     if (_histo.getNumBins() != width() || _histo.getNumBins() == 0)
         _histo.reset(width() ? width() : 256); // This can be called before it is resized
-    if (_histo.PopulateIfNeeded(getVariableName(), getDataMgr(), getRenderParams()) < 0)
+    if (_histo.PopulateIfNeeded(getVariableName(), getDataMgr(), getRenderParams(), true) < 0)
         MSG_ERR("Failed to populate histogram");
+    else if (!_histo.IsConverged())
+        _refineTimer->start();
     
     _scalingMenu->Update(getRenderParams());
     update();
 }
 
+void TFHistogramMap::_refineHistogram()
+{
+    if (!getDataMgr() || !getRenderParams())
+        return;
+    
+    if (_histo.Refine(getVariableName(), getDataMgr(), getRenderParams()) < 0) {
+        MSG_ERR("Failed to populate histogram");
+        return;
+    }
+    if (!_histo.IsConverged())
+        _refineTimer->start();
+    
+    update();
+}
+
 TFInfoWidget *TFHistogramMap::createInfoWidget()
 {
     TFHistogramInfoWidget *info = new TFHistogramInfoWidget(getVariableNameTag());
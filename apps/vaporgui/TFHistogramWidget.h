@@ -7,6 +7,7 @@
 #include "TFMapWidget.h"
 
 class ParamsDropdownMenuItem;
+class QTimer;
 
 class TFHistogramMap : public TFMap {
     Q_OBJECT
@@ -39,12 +40,14 @@ private:
     VAPoR::RenderParams *_renderParams = nullptr;
     Histo _histo;
     ParamsDropdownMenuItem *_scalingMenu;
+    QTimer *_refineTimer;
     bool _dynamicScaling = true;
     
     ScalingType _getScalingType() const;
     
 private slots:
     void _menuDynamicScalingToggled(bool on);
+    void _refineHistogram();
     
 signals:
     void InfoDeselected();
@@ -11,6 +11,8 @@
 #include "vapor/common.h"
 #include <string>
 #include <vector>
+#include <functional>
+#include <memory>
 
 namespace flow
 {
@@ -25,6 +27,7 @@ public:
 
     // Constructor and destructor
     Advection();
+   ~Advection();
 
     //
     // Major action functions
@@ -34,6 +37,10 @@ public:
                          ADVECTION_METHOD method = ADVECTION_METHOD::RK4 );
     // Advect as many steps as necessary to reach a certain time: targetT.
     // Note: it only considers particles that have already passed startT.
+    //
+    // Note: both functions advect streams in parallel (see SetNumThreads()), 
+    //       so velocityField must support concurrent queries. 
+    //       Streams are independent, so results are the same as in serial mode.
     int  AdvectTillTime( Field* velocityField, float startT, float deltaT, float targetT,
                          ADVECTION_METHOD method = ADVECTION_METHOD::RK4 );
 
@@ -44,6 +51,12 @@ public:
     int CalculateParticleValues(     Field* scalarField, bool skipNonZero );
     int CalculateParticleProperties( Field* scalarField  );
 
+    // Same as CalculateParticleValues( scalarField, true ), except that it only
+    // visits particles added to the streams since its last call, so the cost
+    // of coloring a growing advection is proportional to the new particles.
+    // Particles are visited again after UseSeedParticles() or ResetParticleValues().
+    int CalculateNewParticleValues(  Field* scalarField );
+
     // Reset all particle values to zero
     void ResetParticleValues( );
     // Clear all existing properties of a particle
@@ -86,6 +99,47 @@ public:
                                       bool  append = false ) const;
     int  InputStreamsGnuplot(  const std::string& filename );
 
+    //
+    // Output a binary file with the same particles as the gnuplot counterparts.
+    // Unlike the text files, it keeps full precision, particle properties, and
+    // stream separators, and can be memory-mapped, e.g. with numpy.memmap().
+    // Each call adds a section to the file (a new file unless append is true):
+    //   char[8]        magic "VAPORFL\0"
+    //   uint32         format version (1)
+    //   uint32         P, number of properties of each particle
+    //   uint64         S, number of streams
+    //   uint64         N, number of particles, including separators
+    //   uint64         M, number of bytes of metadata
+    //   char[M]        metadata, free form text such as "key = value" lines,
+    //                  followed by zero padding to a multiple of 8 bytes
+    //   uint64[S+1]    offsets; stream s is particles offsets[s] to offsets[s+1]-1
+    //   float32[N]     X positions, followed by the same for Y, Z, time, 
+    //                  value, and each of the P properties
+    //   zero padding to a multiple of 8 bytes
+    // Integers and floats are in the byte order of the writer (little endian on
+    // all supported platforms). Separators have NaN time and value, and missing
+    // properties are NaN.
+    //
+    int  OutputStreamsBinaryMaxPart(  const std::string& filename,
+                                      size_t             maxPart,
+                                      bool               append   = false,
+                                      const std::string& metadata = "" ) const;
+    int  OutputStreamsBinaryMaxTime(  const std::string& filename,
+                                      float              time,
+                                      bool               append   = false,
+                                      const std::string& metadata = "" ) const;
+    // Use every particle, but not separators, of every section of a binary file
+    // as a seed. The file is memory-mapped where supported.
+    int  InputStreamsBinary(   const std::string& filename );
+    // Test if a file starts like a binary file written by this class
+    static bool IsStreamsBinary( const std::string& filename );
+
+    // Set the number of threads used to advect streams.
+    // A value of 0, the default, uses the number of hardware threads;
+    // a value of 1 advects all streams on the calling thread.
+    void   SetNumThreads( size_t numThreads );
+    size_t GetNumThreads() const;
+
     // Query properties (most are properties of the velocity field)
     int  CheckReady() const;
 
@@ -100,11 +154,19 @@ private:
     float       _lowerAngleCos, _upperAngleCos;         // Cosine values of the threshold angles
     std::vector<int>            _separatorCount;        // how many separators does each stream have.
                                 // Useful to determine how many steps are there in a stream.
+    std::vector<size_t>         _valuedCount;           // how many leading particles of each stream
+                                // CalculateNewParticleValues() has visited.
     // If the advection is performed in a periodic fashion along one or more dimensions.
     // These variables are **not** intended to be decided by Advection, but by someone
     // who's more knowledgeable about the field.
     bool                        _isPeriodic[3];         // is it periodic in X, Y, Z dimensions ?
     glm::vec2                   _periodicBounds[3];     // periodic boundaries in X, Y, Z dimensions
+    size_t                      _numThreads = 0;        // 0 means use all hardware threads
+
+    // Threads that help advecting streams. They are kept between advection steps, 
+    // and only replaced when the number of threads changes.
+    class WorkerPool;
+    std::unique_ptr<WorkerPool> _workers;
 
 
     // Advection methods here could assume all input is valid.
@@ -113,6 +175,18 @@ private:
     int _advectRK4( Field*, const Particle&, float deltaT,   // Input
                     Particle& p1 ) const;                    // Output
 
+    // Advect a single stream, identified by its index in _streams.
+    // They return true if at least one new particle is added to the stream.
+    bool _advectStreamOneStep(  Field*, float deltaT, ADVECTION_METHOD, 
+                                size_t streamIdx );
+    bool _advectStreamTillTime( Field*, float startT, float deltaT, float targetT,
+                                ADVECTION_METHOD, size_t streamIdx );
+
+    // Apply "func" to the index of every stream using up to GetNumThreads() threads,
+    // or only the calling thread if "field" does not support concurrent queries.
+    // It returns true if "func" returned true for any stream.
+    bool _forEachStream( const Field* field, const std::function<bool(size_t)>& func );
+
     // Get an adjust factor for deltaT based on how curvy the past two steps are.
     //   A value in range (0.0, 1.0) means shrink deltaT.
     //   A value in range (1.0, inf) means enlarge deltaT.
@@ -131,6 +205,11 @@ private:
     // Upon failure, this function returns a nullptr.  In this case,
     // the caller of this function will need to close this file object.
     std::FILE*  _prepareFileWrite( const std::string& filename, bool append ) const;
+
+    // Write a binary section with the first numPart[i] particles of stream i.
+    int  _outputStreamsBinary( const std::string& filename, 
+                               const std::vector<size_t>& numPart,
+                               bool append, const std::string& metadata ) const;
 };
 };
 
@@ -19,6 +19,12 @@ namespace VAPoR {
 //! A block-based memory allocator. Allocates contiguous runs of
 //! memory blocks from a memory pool of user defined size.
 //!
+//! Free runs are kept in segregated free lists indexed by a two-level 
+//! size class (a power of two, subdivided linearly), as in the 
+//! Two-Level Segregated Fit (TLSF) allocator. Allocation and freeing
+//! take constant time, and adjacent free runs are coalesced immediately,
+//! which keeps fragmentation of the pool low.
+//!
 //! N.B. the memory pool is stored in a static class member and
 //! can only be freed by calling RequestMemSize() with a zero value 
 //! after all instances of this class have been destroyed
@@ -64,35 +70,104 @@ public:
  //! \b Alloc() calls.
  //! \param[in] page_aligned If true, start address of memory pool 
  //! will be page aligned
+ //! \param[in] huge_pages If true, and supported by the operating 
+ //! system, the memory pool is backed by huge (transparent) pages to 
+ //! reduce TLB misses. Implies \p page_aligned.
  //
  static int RequestMemSize(
-	size_t blk_size, size_t num_blks, bool page_aligned = true
+	size_t blk_size, size_t num_blks, bool page_aligned = true,
+	bool huge_pages = false
  );
 
  static size_t GetBlkSize() {return(_blk_size);}
 
+ //! Memory pool statistics
+ //!
+ //! All sizes are in blocks
+ //!
+ //! \sa GetStats()
+ //
+ class Stats {
+ public:
+  Stats() : 
+	totalBlks(0), usedBlks(0), freeBlks(0), freeRuns(0), 
+	largestFreeRun(0), fragmentation(0.0) 
+  {}
+
+  size_t totalBlks;		// Blocks currently allocated to the pool
+  size_t usedBlks;		// Blocks handed out by Alloc()
+  size_t freeBlks;		// Blocks available to Alloc()
+  size_t freeRuns;		// Number of runs of contiguous free blocks
+  size_t largestFreeRun;	// Length of the largest run of free blocks
+
+  // One minus the ratio of the largest free run to the total number 
+  // of free blocks. Zero if the free memory is contiguous, approaching
+  // one as free memory is scattered over many small runs
+  //
+  double fragmentation;	
+ };
+
+ //! Return memory pool statistics
+ //
+ static Stats GetStats();
+
 private:
  typedef struct {
-	size_t _nfree;	// number of contiguous free blocks
-	size_t _nused;	// number of contiguous used blocks
-	void *_blk;		// pointer to first free/used block
- } _mem_allocation_t; 
- 
- static vector < vector <_mem_allocation_t > > _mem_regions;
- static vector <size_t>	_mem_region_sizes;	// size of mem in blocks
- static vector <unsigned char *> _blks;	// memory pool
+	unsigned char *_blks;	// first block in region (aligned)
+	void *_mem;				// memory returned by operating system
+	size_t _mem_size;		// size of _mem in bytes
+	bool _mmapped;			// true if _mem was obtained with mmap()
+	size_t _nblks;			// number of blocks in region
+	size_t _first;			// index of region's first block in pool
+ } _mem_region_t;
+
+ // Number of second level size classes per power of two, log2
+ //
+ static const int SL_LOG2 = 4;
+ static const int SL_COUNT = 1 << SL_LOG2;
+ static const int FL_COUNT = 64;
+ static const size_t NIL = (size_t) -1;
+
+ static vector <_mem_region_t> _mem_regions;	// memory pool
+
+ // Per-block meta data, indexed by a block's index in the pool.
+ // _run_size and _run_free are valid for the first and last block of each
+ // run of free or used blocks. _next_free and _prev_free link the
+ // first blocks of free runs in the same size class.
+ //
+ static vector <size_t> _run_size;
+ static vector <unsigned char> _run_free;
+ static vector <size_t> _next_free;
+ static vector <size_t> _prev_free;
+
+ // Heads of the segregated free lists, and bitmaps of non-empty lists
+ //
+ static size_t _free_heads[FL_COUNT][SL_COUNT];
+ static unsigned long long _fl_bitmap;
+ static unsigned int _sl_bitmap[FL_COUNT];
 
  static size_t	_mem_size_max_req;	// max requested size of mem in blocks
  static bool	_page_aligned_req;	// requested page align memory 
+ static bool	_huge_pages_req;	// requested huge page backing
  static size_t	_blk_size_req;	// requested size of block in bytes
 
  static size_t	_mem_size_max;	// max size of mem in blocks
  static bool	_page_aligned;	// page align memory 
+ static bool	_huge_pages;	// back memory with huge pages
  static size_t	_blk_size;	// size of block in bytes
+ static size_t	_nused;		// number of blocks in use
 
  static int _ref_count;	// # instances of object.
 
  static int	_Reinit(size_t n);
+ static void _free_pool();
+
+ static void _mapping_insert(size_t n, int &fl, int &sl);
+ static void _mapping_search(size_t n, int &fl, int &sl);
+ static size_t _find_free(size_t n);
+ static void _insert_free(size_t blk);
+ static void _remove_free(size_t blk);
+ static void _set_run(size_t blk, size_t n, bool free);
 
 };
 };
@@ -401,7 +401,8 @@ private:
 
 	vector <size_t> _dims;	// dimensions of array
 	int _nlevels;	// Number of wavelet transformation levels
-	vector <void *> _indexvec; // used to sort wavelet coefficients
+	vector <size_t> _indexvec; // used to select wavelet coefficients
+	vector <unsigned char> _groupvec; // selection group of each coefficient
 	size_t _nx;
 	size_t _ny;
 	size_t _nz;
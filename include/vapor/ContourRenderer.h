@@ -83,6 +83,11 @@ private:
         vector<double> boxMin, boxMax;
         vector<double> contourValues;
     } _cacheParams;
+    
+    // Value ranges of tiles of consecutive cells, used to skip tiles that
+    // no contour crosses. Valid for the grid identified by _tileRangesKey.
+    string _tileRangesKey;
+    vector<float> _tileMin, _tileMax;
 
     int  _buildCache();
     bool _isCacheDirty() const;
@@ -93,6 +93,17 @@ public:
  //
     void SetCacheSize(size_t sizeMB);
 
+ //! Set the directory for persistent data set metadata
+ //!
+ //! Data sets opened after this call persist their metadata (e.g. 
+ //! data ranges and histograms) in \p dir, so that it need not be 
+ //! recomputed when they are opened again. An empty string, the 
+ //! default, disables the persistent metadata cache.
+ //!
+ //! \sa DataStatus::SetMetadataCacheDir()
+ //
+    void SetMetadataCacheDir(string dir);
+
 
  //! Create a new visualizer
  //!
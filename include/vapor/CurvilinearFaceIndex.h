@@ -0,0 +1,136 @@
+#ifndef _CurvilinearFaceIndex_
+#define _CurvilinearFaceIndex_
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <vapor/common.h>
+#include <vapor/RegularGrid.h>
+#include <vapor/QuadTreeRectangle.hpp>
+
+namespace VAPoR {
+//
+//! \class CurvilinearFaceIndex
+//! \brief Spatial index of the horizontal faces of a curvilinear grid
+//!
+//! This class finds the faces (quadrilateral cells) of a curvilinear
+//! grid whose bounding rectangles contain a point expressed in user
+//! coordinates. The faces are partitioned into the blocks of the grid,
+//! each of which has its own quad tree (a Block). A small quad tree over
+//! the block bounds selects the blocks to search.
+//!
+//! Because a Block only depends on the coordinates of the nodes of
+//! its faces, not on the region of the mesh a grid was read for, Blocks
+//! may be shared by the indices of any grids that contain them.
+//
+class VDF_API CurvilinearFaceIndex {
+public:
+
+ //! \class Block
+ //! \brief Quad tree of the faces belonging to one grid block
+ //!
+ //! A face belongs to the block containing its first node, i.e. the
+ //! node with the smallest I and J indices.
+ //
+ class VDF_API Block {
+ public:
+
+  //! Index faces [\p i0 .. \p i0 + \p ni - 1] x [\p j0 .. \p j0 + \p nj - 1]
+  //!
+  //! \param[in] xrg 2D grid of the X user coordinates of the nodes
+  //! \param[in] yrg 2D grid of the Y user coordinates of the nodes
+  //! \param[in] i0 I index of the first node of the first face
+  //! \param[in] j0 J index of the first node of the first face
+  //! \param[in] ni Number of faces along I. \p i0 + \p ni must be less
+  //! than the I dimension of \p xrg
+  //! \param[in] nj Number of faces along J. \p j0 + \p nj must be less
+  //! than the J dimension of \p xrg
+  //
+  Block(
+	const RegularGrid &xrg, const RegularGrid &yrg,
+	size_t i0, size_t j0, size_t ni, size_t nj
+  );
+
+  size_t GetNumFaces() const {return(_ni * _nj); }
+
+  //! Return an estimate of the memory used by the block, in bytes
+  //
+  size_t GetNumBytes() const;
+
+ private:
+  friend class CurvilinearFaceIndex;
+
+  size_t _ni;
+  size_t _nj;
+  float _bounds[4];	// left, top, right, bottom
+  std::unique_ptr <QuadTreeRectangle<float, size_t> > _qtr;
+ };
+
+ //! Assemble an index from blocks
+ //!
+ //! \param[in] dim0 The I dimension of the grid's nodes
+ //! \param[in] blocks The blocks of the grid
+ //! \param[in] origins The I and J indices of the first face of each
+ //! block, i.e. the \p i0 and \p j0 the block was constructed with,
+ //! for each element of \p blocks
+ //
+ CurvilinearFaceIndex(
+	size_t dim0,
+	const std::vector <std::shared_ptr <const Block> > &blocks,
+	const std::vector <size_t> &origins
+ );
+
+ //! Return the faces whose bounding rectangles may contain a point
+ //!
+ //! \param[in] x X user coordinate of the point
+ //! \param[in] y Y user coordinate of the point
+ //! \param[out] faces Indices of the faces, linearized over the I and
+ //! J dimensions of the grid's nodes. The face index is the index of the
+ //! face's first node.
+ //
+ void GetFacesContained(float x, float y, std::vector <size_t> &faces) const;
+
+ //! Construct missing blocks in parallel
+ //!
+ //! Constructs the elements of \p blocks that are NULL, with
+ //! \p nthreads threads.
+ //!
+ //! \param[in] origins I and J indices of the first face of each block
+ //! \param[in] sizes Number of faces along I and J of each block
+ //! \param[in,out] blocks Blocks, one per pair of \p origins
+ //! \param[in] nthreads Number of threads to use. If less than one
+ //! the number of hardware threads is used.
+ //!
+ //! \sa Block::Block()
+ //
+ static void MakeBlocks(
+	const RegularGrid &xrg, const RegularGrid &yrg,
+	const std::vector <size_t> &origins,
+	const std::vector <size_t> &sizes,
+	std::vector <std::shared_ptr <const Block> > &blocks,
+	int nthreads = 0
+ );
+
+ //! Construct an index of all the faces of a grid
+ //!
+ //! \param[in] xrg 2D grid of the X user coordinates of the nodes
+ //! \param[in] yrg 2D grid of the Y user coordinates of the nodes
+ //! \param[in] bs Number of nodes along I and J of the grid blocks
+ //! \param[in] nthreads Number of threads to use. If less than one
+ //! the number of hardware threads is used.
+ //
+ static std::shared_ptr <const CurvilinearFaceIndex> Make(
+	const RegularGrid &xrg, const RegularGrid &yrg,
+	const std::vector <size_t> &bs, int nthreads = 0
+ );
+
+private:
+ size_t _dim0;
+ std::vector <std::shared_ptr <const Block> > _blocks;
+ std::vector <size_t> _origins;
+ std::unique_ptr <QuadTreeRectangle<float, size_t> > _qtr;
+};
+
+};
+
+#endif
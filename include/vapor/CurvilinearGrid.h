@@ -3,7 +3,7 @@
 #include <vapor/common.h>
 #include <vapor/Grid.h>
 #include <vapor/RegularGrid.h>
-#include <vapor/QuadTreeRectangle.hpp>
+#include <vapor/CurvilinearFaceIndex.h>
 
 
 namespace VAPoR {
@@ -62,10 +62,10 @@ public:
  //! values specify the Y user coordinates.
  //! \param[in] zcoords  A 1D vector whose size matches that of the K
  //! dimension of this class, and whose values specify the Z user coordinates.
- //! \param[in] qtr A QuadTreeRectangle instance that contains a quad tree 
- //! that may be used to find the cell(s) containing a given point
- //! expressed in user coordintes. if \p qtr is NULL the class will
- //! generate its own QuadTreeRectangle instance. 
+ //! \param[in] faceIndex A CurvilinearFaceIndex instance that 
+ //! may be used to find the cell(s) containing a given point
+ //! expressed in user coordintes. if \p faceIndex is NULL the class will
+ //! generate its own CurvilinearFaceIndex instance. 
  //!
  //!
  //! \sa RegularGrid()
@@ -77,7 +77,7 @@ public:
 	const RegularGrid &xrg,
 	const RegularGrid &yrg,
 	const std::vector <double> &zcoords,
-	std::shared_ptr<const QuadTreeRectangle<float, size_t> > qtr
+	std::shared_ptr <const CurvilinearFaceIndex> faceIndex
  );
 
  //! \copydoc StructuredGrid::StructuredGrid()
@@ -108,10 +108,10 @@ public:
  //! \param[in] zrg A 3D RegularGrid instance whose
  //! I, J, K dimensionality matches that of this class instance, and whose
  //! values specify the Z user coordinates.
- //! \param[in] qtr A QuadTreeRectangle instance that contains a quad tree 
- //! that may be used to find the cell(s) containing a given point
- //! expressed in user coordintes. if \p qtr is NULL the class will
- //! generate its own QuadTreeRectangle instance. 
+ //! \param[in] faceIndex A CurvilinearFaceIndex instance that 
+ //! may be used to find the cell(s) containing a given point
+ //! expressed in user coordintes. if \p faceIndex is NULL the class will
+ //! generate its own CurvilinearFaceIndex instance. 
  //!
  //!
  //! \sa RegularGrid()
@@ -123,7 +123,7 @@ public:
 	const RegularGrid &xrg,
 	const RegularGrid &yrg,
 	const RegularGrid &zrg,
-	std::shared_ptr <const QuadTreeRectangle<float, size_t> > qtr
+	std::shared_ptr <const CurvilinearFaceIndex> faceIndex
  );
 
  //! \copydoc StructuredGrid::StructuredGrid()
@@ -149,10 +149,10 @@ public:
  //! \param[in] yrg A 2D RegularGrid instance whose
  //! I and J dimensionality matches that of this class instance, and whose
  //! values specify the Y user coordinates.
- //! \param[in] qtr A QuadTreeRectangle instance that contains a quad tree 
- //! that may be used to find the cell(s) containing a given point
- //! expressed in user coordintes. if \p qtr is NULL the class will
- //! generate its own QuadTreeRectangle instance. 
+ //! \param[in] faceIndex A CurvilinearFaceIndex instance that 
+ //! may be used to find the cell(s) containing a given point
+ //! expressed in user coordintes. if \p faceIndex is NULL the class will
+ //! generate its own CurvilinearFaceIndex instance. 
  //!
  //!
  //! \sa RegularGrid()
@@ -163,18 +163,18 @@ public:
 	const std::vector <float *> &blks,
 	const RegularGrid &xrg,
 	const RegularGrid &yrg,
-	std::shared_ptr <const QuadTreeRectangle<float, size_t> > qtr
+	std::shared_ptr <const CurvilinearFaceIndex> faceIndex
  );
 
  CurvilinearGrid() = default;
  virtual ~CurvilinearGrid() {
-	if (_qtr) {
-		_qtr = nullptr;	// qtr is a C++ shared pointer
+	if (_faceIndex) {
+		_faceIndex = nullptr;	// faceIndex is a C++ shared pointer
 	}
  }
 
- std::shared_ptr <const QuadTreeRectangle<float, size_t> > GetQuadTreeRectangle() const {
-    return(_qtr);
+ std::shared_ptr <const CurvilinearFaceIndex> GetFaceIndex() const {
+    return(_faceIndex);
  }
 
  static std::string GetClassType() {
@@ -228,6 +228,16 @@ public:
  //
  virtual bool InsideGrid(const std::vector <double> &coords) const override;
 
+ //! \copydoc Grid::SampleMany()
+ //!
+ //! Each point's cell is searched for starting from the cell of the 
+ //! previous point.
+ //
+ virtual void SampleMany(
+	const double *coords, size_t n, float *values
+ ) const override;
+ using Grid::SampleMany;
+
 
 
 
@@ -310,6 +320,10 @@ protected:
 	const std::vector <double> &coords
  ) const override;
 
+ virtual void GetIndicesCellMany(
+	const double *coords, size_t n, size_t *indices, bool *found
+ ) const override;
+
 
 private:
  std::vector <double> _zcoords;
@@ -319,20 +333,14 @@ private:
  RegularGrid _yrg;
  RegularGrid _zrg;
  bool _terrainFollowing;
- std::shared_ptr <const QuadTreeRectangle<float, size_t> > _qtr;
-
- mutable struct {
-	size_t k = 0;
-	float z0 = 0.0;
-	float z1 = 0.0;
- } _insideGridCache;
+ std::shared_ptr <const CurvilinearFaceIndex> _faceIndex;
 
  void _curvilinearGrid(
 	const RegularGrid &xrg,
 	const RegularGrid &yrg,
 	const RegularGrid &zrg,
 	const std::vector <double> &zcoords,
-	std::shared_ptr <const QuadTreeRectangle<float, size_t> > qtr
+	std::shared_ptr <const CurvilinearFaceIndex> faceIndex
  );
 
  void _GetUserExtents(
@@ -350,6 +358,34 @@ private:
 	double lambda[4], double zwgt[2]
  ) const;
 
+ bool _testFace(
+	size_t i, size_t j, const double pt[2],
+	NodeReader &xr, NodeReader &yr, double lambda[4], int &exitEdge
+ ) const;
+
+ bool _locateFace(
+	const double pt[2], NodeReader &xr, NodeReader &yr,
+	std::vector <size_t> &faces, bool useHint,
+	size_t &i, size_t &j, double lambda[4]
+ ) const;
+
+ bool _locateCell(
+	std::vector <double> &coords, bool clamp,
+	NodeReader &xr, NodeReader &yr, std::vector <size_t> &faces, bool &hint,
+	size_t &i, size_t &j, size_t &k, double lambda[4], double zwgt[2]
+ ) const;
+
+ bool _needsClampCoord() const;
+
+ float _getValueNearestNeighbor(
+	size_t i, size_t j, size_t k, const double lambda[4],
+	const double zwgt[2]
+ ) const;
+
+ float _getValueLinear(
+	size_t i, size_t j, size_t k, const double lambda[4], double zwgt[2]
+ ) const;
+
  void _getIndicesHelper(
 	const std::vector <double> &coords,
 	std::vector <size_t> &indices
@@ -365,8 +401,6 @@ private:
 	double zwgt[2]
  ) const;
 
- std::shared_ptr <QuadTreeRectangle<float, size_t> >_makeQuadTreeRectangle() const;
-
 };
 };
 #endif
@@ -1,6 +1,14 @@
 #include <vector>
 #include <iostream>
 #include <list>
+#include <map>
+#include <unordered_map>
+#include <mutex>
+#include <memory>
+#include <deque>
+#include <thread>
+#include <future>
+#include <condition_variable>
 #include "vapor/VAssert.h"
 #include <vapor/BlkMemMgr.h>
 #include <vapor/DC.h>
@@ -13,6 +21,7 @@
 #include <vapor/UDUnitsClass.h>
 #include <vapor/GridHelper.h>
 #include <vapor/DerivedVarMgr.h>
+#include <vapor/Moments.h>
 
 #ifndef	DataMgvV3_0_h
 #define DataMgvV3_0_h
@@ -48,6 +57,15 @@ class DerivedCoordVar;
 //! not, unless otherwise documented, log an error message upon
 //! failure (return of false).
 //!
+//! The GetVariable(), GetDataRange(), and GetDataMoments() family of 
+//! methods may be called concurrently from multiple threads. Cache 
+//! lookups, grid construction, and range calculations proceed in parallel. Reads from the 
+//! underlying DC, which is not re-entrant, are serialized, and concurrent 
+//! requests for the same region are coalesced so that the region is 
+//! read only once. Grids returned without a lock may be evicted 
+//! by another thread at any time, so callers sharing a DataMgr between
+//! threads should request locked grids and release them with UnlockGrid().
+//!
 //! \param level 
 //! \parblock
 //! Grid refinement level for multiresolution variables. 
@@ -115,7 +133,10 @@ public:
  //!
  //! The DataMgr will attempt to cache previously read data and coordinate
  //! variables in memory. The \p mem_size specifies the requested cache
- //! size in MEGABYTES!!!
+ //! size in MEGABYTES!!! The spatial search indices of unstructured
+ //! and curvilinear grids, up to a quarter of it, and intermediate 
+ //! results of derived variables, up to an eighth, are charged against
+ //! the same budget as they are built.
  //!
  //! \param[in] format A string indicating the format of data collection.
  //!
@@ -139,15 +160,49 @@ public:
  //! a list of input data files.
  //!
  //! \param[in] files A list of file paths
+ //! \param[in] options A list of options. In addition to the options
+ //! recognized by the underlying DC, the following are supported:
+ //! \li \b -proj4 \a string : PROJ4 string used for horizontal coordinate
+ //! transformations
+ //! \li \b -project_to_pcs : Transform geographic coordinates to a 
+ //! projected coordinate system
+ //! \li \b -vertical_xform : Transform vertical coordinates
+ //! \li \b -metadata_cache \a dir : Persist per-variable metadata that is
+ //! expensive to recompute (data ranges, variable extents, block 
+ //! coordinate bounds, and any metadata stored with 
+ //! SetVariableMetadata()) in a sidecar file in the directory \a dir.
+ //! The sidecar file is identified by the data collection format, the 
+ //! options, the paths of \p files, and the sizes and modification 
+ //! times of all of the data files (including those in the data 
+ //! directory of a VDC), and is ignored if any of these change.
+ //! Sidecar files of other data collections that have not been used
+ //! for 90 days are removed from \a dir, as are the least recently
+ //! used ones while all of them together exceed 64 MB. The directory
+ //! may be cleared at any time; the metadata is then recomputed.
+ //! \li \b -huge_pages : Back the cache memory pool with huge pages,
+ //! where supported by the operating system. See BlkMemMgr::RequestMemSize()
  //! 
  //! \retval status A negative int is returned on failure and an error
  //! message will be logged with MyBase::SetErrMsg()
  //!
+ //! \sa SaveMetadataCache()
  //
  virtual int Initialize(
 	const vector <string> &paths, const std::vector <string> &options
  );
 
+ //! Return the number of execution threads
+ //!
+ //! Returns the thread count requested when the class was constructed.
+ //! A value of 0 indicates that the thread count should be determined
+ //! by the environment.
+ //!
+ //! \sa DataMgr()
+ //
+ int GetNumThreads() const {
+	return(_nthreads);
+ }
+
 
  //! \copydoc DC::GetDimensionNames()
  //
@@ -469,7 +524,79 @@ std::vector <size_t> GetCRatios(string varname) const;
 	vector <double> min, vector <double> max, std::vector <double> &range
  );
 
+ //! Compute summary statistics of a variable within a specified ROI
+ //!
+ //! This method computes the count, minimum, maximum, mean, and variance
+ //! of the values of a variable that lie inside the region of interest
+ //! (ROI) specified by \p min and \p max, in a single pass over the
+ //! data. Missing values are ignored. The results are cached, so
+ //! statistics over many time steps can be assembled by merging the
+ //! moments of each time step, and only time steps that haven't been
+ //! seen before are read.
+ //!
+ //! This method may be called concurrently, e.g. for different time
+ //! steps.
+ //!
+ //! \param[out] moments The moments of the variable
+ //! \param[in] nthreads Number of threads used to scan the variable. If
+ //! zero the number of threads passed to the constructor is used.
+ //!
+ //! \sa Moments::Merge(), GetDataRange()
+ //
+ int GetDataMoments(
+	size_t ts, string varname, int level, int lod,
+	vector <double> min, vector <double> max, Moments &moments,
+	int nthreads = 0
+ );
+
  
+ //! Store client-computed metadata for a variable
+ //!
+ //! This method allows clients to cache metadata derived from a 
+ //! variable, for example a histogram, alongside the metadata 
+ //! computed internally by the DataMgr. The metadata are discarded
+ //! when the variable is purged from the cache, and are persisted
+ //! across sessions if a metadata cache directory was specified to
+ //! Initialize().
+ //!
+ //! \param[in] key A client-chosen name identifying the metadata
+ //! \param[in] values The metadata values
+ //!
+ //! \sa GetVariableMetadata()
+ //
+ void SetVariableMetadata(
+	size_t ts, string varname, int level, int lod, string key,
+	const std::vector <double> &values
+ );
+
+ //! Retrieve client-computed metadata for a variable
+ //!
+ //! \param[out] values The metadata values stored with 
+ //! SetVariableMetadata()
+ //! \retval found Returns true if metadata named by \p key exist for
+ //! the specified variable, time step, level, and lod
+ //!
+ //! \sa SetVariableMetadata()
+ //
+ bool GetVariableMetadata(
+	size_t ts, string varname, int level, int lod, string key,
+	std::vector <double> &values
+ ) const;
+
+ //! Write the persistent metadata cache
+ //!
+ //! If a metadata cache directory was specified with the 
+ //! \b -metadata_cache option to Initialize(), write the cached metadata
+ //! to the sidecar file. This method is called automatically when 
+ //! the class is destroyed or reinitialized.
+ //!
+ //! \retval status A negative int is returned if the sidecar file 
+ //! could not be written. 
+ //!
+ //! \sa Initialize()
+ //
+ int SaveMetadataCache();
+
  //! \copydoc DC::GetDimLensAtLevel()
  //!
  virtual int GetDimLensAtLevel(
@@ -522,10 +649,104 @@ std::vector <size_t> GetCRatios(string varname) const;
 
  //! Clear the memory cache
  //!
- //! This method clears the internal memory cache of all entries
+ //! This method clears the internal memory cache of all entries. 
+ //! Pending prefetch requests are cancelled, and any in progress are
+ //! allowed to complete first.
  //
  void	Clear();
 
+ //! Region cache statistics
+ //!
+ //! \sa GetCacheStats(), ResetCacheStats()
+ //
+ class CacheStats {
+ public:
+  CacheStats() : hits(0), misses(0), evictions(0), regions(0) {}
+
+  size_t hits;		// Region requests satisfied from the cache
+  size_t misses;	// Region requests that had to be read from the DC
+  size_t evictions;	// Unlocked regions freed to make room for new ones
+  size_t regions;	// Regions currently resident in the cache
+ };
+
+ //! Return region cache statistics
+ //!
+ //! Returns the number of cache hits, misses, and evictions accumulated 
+ //! since construction or the last call to ResetCacheStats(), 
+ //! as well as the number of regions currently cached.
+ //!
+ //! \sa ResetCacheStats()
+ //
+ CacheStats GetCacheStats() const;
+
+ //! Reset the region cache hit, miss, and eviction counters to zero
+ //!
+ //! \sa GetCacheStats()
+ //
+ void ResetCacheStats();
+
+ //! Asynchronously read a variable into the cache
+ //!
+ //! This method queues a request to read the region of a variable
+ //! described by the arguments, which have the same meaning as for 
+ //! GetVariable(), and returns immediately. The request is serviced 
+ //! by a pool of background threads. A subsequent call to GetVariable()
+ //! with the same arguments will be satisfied from the cache if the
+ //! request has completed.
+ //!
+ //! Prefetching only uses cache memory that is not already occupied:
+ //! it never evicts cached regions, and therefore never invalidates 
+ //! unlocked grids held by other threads. A request that does not fit
+ //! in the remaining cache memory fails.
+ //!
+ //! Derived data variables, such as those defined by Python scripts, 
+ //! are not prefetched: the request fails immediately. Errors
+ //! encountered by a request are not reported through SetErrMsg().
+ //!
+ //! \retval future A future whose value is the status of the 
+ //! request: zero if the region was read into the cache, negative if 
+ //! the read failed or the request was cancelled.
+ //!
+ //! \sa PrefetchAhead(), CancelPrefetch()
+ //
+ std::shared_future <int> Prefetch(
+	size_t ts, string varname, int level, int lod,
+	std::vector <double> min, std::vector <double> max
+ );
+
+ //! Prefetch the time steps that follow the current one
+ //!
+ //! Queue Prefetch() requests for the time steps \p ts + 1 through 
+ //! \p ts + GetPrefetchWindow(). Pending requests for \p varname that 
+ //! have not been started and that fall outside of this window, 
+ //! for example because the current time step moved backwards, are
+ //! cancelled. Typically called each time the current time step
+ //! changes.
+ //!
+ //! \sa Prefetch(), SetPrefetchWindow()
+ //
+ void PrefetchAhead(
+	size_t ts, string varname, int level, int lod,
+	std::vector <double> min, std::vector <double> max
+ );
+
+ //! Set the number of time steps read ahead by PrefetchAhead()
+ //!
+ //! \param[in] n Number of time steps. A value of zero disables 
+ //! PrefetchAhead(). The default is one.
+ //
+ void SetPrefetchWindow(int n);
+
+ int GetPrefetchWindow() const { return(_prefetchWindow); }
+
+ //! Cancel all pending prefetch requests
+ //!
+ //! Requests that have not been started are removed from the queue and 
+ //! their futures are set to a negative value. A request that is
+ //! currently being read is allowed to complete.
+ //
+ void CancelPrefetch();
+
  //! Returns true if indicated data volume is available
  //!
  //! Returns true if the variable identified by the timestep, variable
@@ -612,6 +833,12 @@ std::vector <size_t> GetCRatios(string varname) const;
  //
  bool IsVariableNative(string varname) const;
 
+ //! Add or remove a derived variable
+ //!
+ //! Pending prefetch requests are cancelled, and any in progress are
+ //! allowed to complete first, so that no prefetch thread uses a 
+ //! variable after it is removed.
+ //
  int AddDerivedVar(DerivedDataVar *derivedVar);
 
  void RemoveDerivedVar(string varname);
@@ -642,6 +869,12 @@ std::vector <size_t> GetCRatios(string varname) const;
 	std::vector <size_t> &bmax
   ) const;
 
+  // Serialize to, and deserialize from, the metadata cache. Write()
+  // returns false, and writes nothing, if the extents are not finite
+  //
+  bool Write(std::ostream &o) const;
+  bool Read(std::istream &i);
+
   friend std::ostream &operator<<(
 	std::ostream &o, const BlkExts &b
   );
@@ -705,9 +938,15 @@ private:
 	void Purge(std::vector <string> varnames); 
 
 	void Clear() {
+		std::lock_guard <std::mutex> guard(_mutex);
 		_cache.clear(); 
 	}
 
+	// Serialize to, and deserialize from, the metadata cache
+	//
+	void Write(std::ostream &o) const;
+	bool Read(std::istream &i);
+
   static string _make_hash(
 	string key, size_t ts, std::vector <string> cvars, int level, int lod
   );
@@ -720,10 +959,12 @@ private:
   private:
 
   std::map <string, std::vector <C> > _cache;
+  mutable std::mutex _mutex;
 
  };
 
  mutable std::map <size_t, std::vector<string> > _dataVarNamesCache;
+ mutable std::mutex _dataVarNamesCacheMutex;
 
  string _format;
  int _nthreads;
@@ -736,28 +977,110 @@ private:
  DerivedVarMgr _dvm;
  bool _doTransformHorizontal;
  bool _doTransformVertical;
- string _openVarName;
 
  std::vector <double> _timeCoordinates;
  string _proj4String;
  string _proj4StringDefault;
  std::vector <size_t> _bs;
 
- typedef struct {
+ // Uniquely identifies a cached region
+ //
+ class region_key_t {
+ public:
+	region_key_t() : ts(0), level(0), lod(0) {}
+	region_key_t(
+		size_t ts_, string varname_, int level_, int lod_,
+		const std::vector <size_t> &bmin_, const std::vector <size_t> &bmax_
+	) : ts(ts_), varname(varname_), level(level_), lod(lod_), 
+		bmin(bmin_), bmax(bmax_) {}
+
+	bool operator==(const region_key_t &rhs) const {
+		return(
+			ts == rhs.ts && level == rhs.level && lod == rhs.lod &&
+			bmin == rhs.bmin && bmax == rhs.bmax && varname == rhs.varname
+		);
+	}
+
 	size_t ts;
 	string varname;
 	int level;
 	int lod;
 	std::vector <size_t> bmin;
 	std::vector <size_t> bmax;
+ };
+
+ class region_key_hash_t {
+ public:
+	size_t operator()(const region_key_t &key) const;
+ };
+
+ typedef struct {
+	region_key_t key;
 	int lock_counter;
 	void *blks;
+	size_t nblks;	// number of blocks in blks
+	bool valid;		// false until data have been read into blks
  } region_t;
 
- // a list of all allocated regions
+ typedef std::list <region_t>::iterator region_itr_t;
+
+ // A list of all allocated regions, ordered from least to most
+ // recently used. Regions are indexed by their key, and by their 
+ // block address (for unlocking), so that no list scans are required
+ //
  std::list <region_t> _regionsList;
+ std::unordered_map <
+	region_key_t, region_itr_t, region_key_hash_t
+ > _regionsMap;
+ std::unordered_map <const void *, region_itr_t> _regionsBlksMap;
+ CacheStats _cacheStats;
+
+ // Guards the region cache and the memory allocator. Recursive because
+ // the allocator may free regions to satisfy a request
+ //
+ mutable std::recursive_mutex _regionsMutex;
+
+ // Per-variable, per-time step read locks, see _varReadMutex(). 
+ // Recursive because reading a derived variable reads its inputs 
+ // through the DataMgr
+ //
+ std::map <
+	std::pair <size_t, string>, std::unique_ptr <std::recursive_mutex> 
+ > _varReadMutexes;
+ std::mutex _varReadMutexesMutex;
+
+ // The DC, and the netCDF library beneath it, are not re-entrant. Calls
+ // into the DC are serialized on this lock, which is always acquired 
+ // after any per-variable read lock
+ //
+ std::recursive_mutex _dcMutex;
+
+ typedef struct {
+	size_t ts;
+	string varname;
+	int level;
+	int lod;
+	std::vector <double> min;
+	std::vector <double> max;
+	std::shared_ptr <std::promise <int> > promise;
+	std::shared_future <int> future;
+ } prefetch_request_t;
+
+ // Pending prefetch requests, serviced in order by a pool of threads
+ // that is grown on demand. _prefetchIdle counts the workers waiting
+ // for a request.
+ //
+ std::deque <prefetch_request_t> _prefetchQueue;
+ std::mutex _prefetchMutex;
+ std::condition_variable _prefetchCond;
+ std::vector <std::thread> _prefetchThreads;
+ int _prefetchIdle;
+ bool _prefetchShutdown;
+ int _prefetchWindow;
 
  VAPoR::BlkMemMgr  *_blk_mem_mgr;
+ size_t _blksInUse;		// blocks allocated to regions
+ bool _hugePages;
 
 
  std::vector <PipeLine *> _PipeLines;
@@ -768,6 +1091,13 @@ private:
  mutable VarInfoCache <void *> _varInfoCacheVoidPtr;
 
  std::map <string, BlkExts> _blkExtsCache;
+ std::mutex _blkExtsCacheMutex;
+
+ // Persistent metadata cache. See Initialize()
+ //
+ string _metadataCacheDir;
+ string _metadataCachePath;
+ string _metadataCacheSignature;
 
  // Get the immediate variable dependencies of a variable
  //
@@ -955,6 +1285,15 @@ UnstructuredGrid2D *_make_grid_unstructured2d(
  
  int _parseOptions(vector <string> &options);
 
+ string _metadataCacheSig(
+	const std::vector <string> &files, const std::vector <string> &options
+ ) const;
+ int _loadMetadataCache();
+
+ // Remove stale sidecar files from the metadata cache directory
+ //
+ void _pruneMetadataCache() const;
+
  template <typename T> 
  T *_get_region_from_cache(
 	size_t ts,
@@ -1053,6 +1392,11 @@ UnstructuredGrid2D *_make_grid_unstructured2d(
 
  bool _free_lru();
  void _free_var(string varname);
+ void _erase_region(region_itr_t itr);
+
+ void _prefetchWorker();
+ int _prefetchRegion(const prefetch_request_t &req);
+ void _stopPrefetch();
 
  int _level_correction(string varname, int &level) const;
  int _lod_correction(string varname, int &lod) const;
@@ -1101,19 +1445,65 @@ UnstructuredGrid2D *_make_grid_unstructured2d(
  DerivedDataVar *_getDerivedDataVar(string varname) const;
  DerivedCoordVar *_getDerivedCoordVar(string varname) const;
 
+ // Return the lock serializing reads of variable \p varname at time
+ // step \p ts
+ //
+ std::recursive_mutex &_varReadMutex(size_t ts, string varname);
+
+ // Return a lock on the DC for reading \p varname. The lock is not 
+ // acquired for derived data variables, which read through the DataMgr
+ //
+ std::unique_lock <std::recursive_mutex> _lockDC(string varname);
+
  int _openVariableRead(size_t ts, string varname, int level, int lod);
 
+ // Largest per-thread read staging buffer, in bytes, kept between reads
+ //
+ size_t _maxScratchSize() const { return(_mem_size * 1024 * 1024 / 16); }
+
+ // Largest share of the memory budget, in bytes, of the spatial search 
+ // index cache of unstructured and curvilinear grids
+ //
+ size_t _gridHelperCacheSize() const { return(_mem_size * 1024 * 1024 / 4); }
+
+ // Largest share of the memory budget, in bytes, of the cache of 
+ // intermediate results of derived variables
+ //
+ size_t _derivedVarCacheSize() const { return(_mem_size * 1024 * 1024 / 8); }
+
+ // Memory budget, in bytes, of the block cache, which it shares with
+ // the other caches
+ //
+ size_t _blockCacheSize() const { return(_mem_size * 1024 * 1024); }
+
+ // Bytes held by the caches that are charged against the block cache's
+ // budget as they are used
+ //
+ size_t _sharedCacheBytes() const { 
+	return(_gridHelper.GetCacheBytes() + _dvm.GetCacheBytes());
+ }
+
+ // Return true if \p nblocks more blocks fit in the block cache's
+ // budget alongside what the shared caches hold
+ //
+ bool _fitsBlockCache(size_t nblocks) const;
+
+ // Evict from the shared caches enough to make room for \p nblocks 
+ // blocks. Returns false if nothing could be evicted
+ //
+ bool _trimSharedCaches(size_t nblocks);
+
  template <class T>
  int _readRegionBlock(
-	int fd,
+	int fd, string varname,
 	const vector <size_t> &min, const vector <size_t> &max, T *region
  );
  template <class T>
  int _readRegion(
-	int fd,
+	int fd, string varname,
 	const vector <size_t> &min, const vector <size_t> &max, T *region
  );
- int _closeVariable(int fd);
+ int _closeVariable(int fd, string varname);
 
  int _getVar(string varname, int level, int lod, float *data);
 
@@ -188,6 +188,17 @@ public:
 		_cacheSize = sizeMB;
 	}
 
+	//! Set the directory for persistent DataMgr metadata
+	//!
+	//! If \p dir is not empty, data sets opened subsequently persist
+	//! their metadata (data ranges, histograms, etc.) in \p dir, and
+	//! reuse it when opened again. See the \b -metadata_cache option of
+	//! DataMgr::Initialize(). 
+	//
+	void SetMetadataCacheDir(string dir) {
+		_metadataCacheDir = dir;
+	}
+
 	string GetMapProjection() const;
 	string GetMapProjectionDefault(string dataSetName) const;
 	
@@ -228,6 +239,7 @@ private:
 	
 	size_t _cacheSize;
 	int _nThreads;
+	string _metadataCacheDir;
 	map <string, DataMgr*> _dataMgrs;
 	map <string, vector <size_t>> _timeMap;
 	vector <double> _timeCoords;
@@ -1,5 +1,9 @@
 #include <iostream>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <list>
+#include <unordered_map>
 #include <vapor/DC.h>
 #include <vapor/MyBase.h>
 #include <vapor/Proj4API.h>
@@ -12,6 +16,77 @@ namespace VAPoR {
 
 class NetCDFCollection;
 
+//!
+//! \class DerivedVarCache
+//!
+//! \brief Memory bounded cache of intermediate results of derived variables
+//!
+//! Derived variables may store arrays they compute from their inputs,
+//! or inputs they read, for reuse by later reads of the same or other
+//! derived variables. For example, the terrain following vertical
+//! coordinates of a WRF data set are all resampled from one elevation
+//! field. Least recently used arrays are evicted once the total size of
+//! the cached arrays exceeds the budget. This class is thread safe.
+//!
+//! \sa DerivedVarMgr
+//
+class VDF_API DerivedVarCache {
+public:
+ typedef std::shared_ptr <const std::vector <float> > Array;
+
+ //! \param[in] max_bytes Memory budget in bytes
+ //
+ DerivedVarCache(size_t max_bytes = 64 * 1024 * 1024);
+
+ //! Set the memory budget in bytes, evicting arrays as needed
+ //
+ void SetCacheSize(size_t max_bytes);
+
+ //! Return the number of bytes of the cached arrays
+ //
+ size_t GetBytes() const;
+
+ //! Evict least recently used arrays until the cache holds no more
+ //! than \p max_bytes, without changing its budget
+ //
+ void Trim(size_t max_bytes);
+
+ //! Return the array stored under \p key, or NULL if there isn't one
+ //
+ Array Get(const string &key);
+
+ //! Store \p array under \p key, replacing any array already stored
+ //! under \p key. Arrays larger than the budget are not stored.
+ //
+ void Put(const string &key, const Array &array);
+
+ //! Record whether the values of the region of a variable identified
+ //! by \p key are the same at every time step
+ //
+ void SetTimeInvariant(const string &key, bool invariant);
+
+ //! Return 1 if the region identified by \p key is known to be time
+ //! invariant, 0 if it is known to vary, and -1 if unknown.
+ //
+ int GetTimeInvariant(const string &key) const;
+
+ //! Remove all arrays and time invariance records
+ //
+ void Clear();
+
+private:
+ mutable std::mutex _mutex;
+ size_t _maxBytes;
+ size_t _bytes;
+ std::list <std::pair <string, Array> > _lru;	// most recent first
+ std::unordered_map <
+	string, std::list <std::pair <string, Array> >::iterator
+ > _map;
+ std::map <string, bool> _timeInvariant;
+
+ void _evict(size_t max_bytes);
+};
+
 //!
 //! \class DerivedVar
 //!
@@ -36,6 +111,7 @@ public:
 
  DerivedVar(string varName) {
 	_derivedVarName = varName;
+	_cache = NULL;
  };
 
  virtual ~DerivedVar() {}
@@ -117,9 +193,19 @@ public:
 	int lod
  ) const = 0;
 
+ //! Set the cache used to memoize intermediate results
+ //!
+ //! \param[in] cache Cache shared with other derived variables. If NULL,
+ //! the default, nothing is memoized.
+ //
+ void SetCache(DerivedVarCache *cache) {
+	_cache = cache;
+ }
+
 protected:
  string _derivedVarName;
  DC::FileTable _fileTable;
+ DerivedVarCache *_cache;
 
  int _getVar(
 	DC *dc, size_t ts, string varname, int level, int lod,
@@ -139,6 +225,24 @@ protected:
 	float *region
  ) const;
 
+ // Same as _getVar(), but memoized in _cache. If timeInvariant is true 
+ // the variable is expected to have the same values at every time step,
+ // which is verified against another time step the first time each 
+ // region is read. If so, the region is shared by all time steps.
+ //
+ int _getVarCached(
+	DC *dc, size_t ts, string varname, int level, int lod,
+	const std::vector <size_t> &min, const std::vector <size_t> &max,
+	bool timeInvariant, DerivedVarCache::Array &array
+ ) const;
+
+ // Return a key identifying a region of a variable in _cache
+ //
+ static string _cacheKey(
+	const string &name, size_t ts, int level, int lod,
+	const std::vector <size_t> &min, const std::vector <size_t> &max
+ );
+
 };
 
 //!
@@ -389,16 +493,27 @@ private:
 	const std::vector <size_t> &min, const std::vector <size_t> &max,
 	float *region
  );
+ // The 1D and 2D helpers also return the coordinate NOT being read
+ // (Y if this is the X coordinate variable, and vice versa) in \p other
+ //
  int _readRegionHelper1D(
 	DC::FileTable::FileObject *f,
 	const std::vector <size_t> &min, const std::vector <size_t> &max,
-	float *region
+	float *region, float *other
  );
  int _readRegionHelper2D(
 	DC::FileTable::FileObject *f,
 	const std::vector <size_t> &min, const std::vector <size_t> &max,
-	float *region
+	float *region, float *other
  );
+
+ // Return the _cache key of the projected X (\p lonFlag true) or Y 
+ // coordinates
+ //
+ string _projCacheKey(
+	bool lonFlag, size_t ts, int lod,
+	const std::vector <size_t> &min, const std::vector <size_t> &max
+ ) const;
  
 };
 
@@ -875,6 +990,19 @@ private:
  string _PHBVar;
  float _grav;
  DC::CoordVar _coordVarInfo;
+
+ int _getElevationW(
+	size_t ts, int level, int lod,
+	const std::vector <size_t> &wMin, const std::vector <size_t> &wMax,
+	DerivedVarCache::Array &elev
+ ) const;
+
+ int _getElevation(
+	size_t ts, int level, int lod,
+	const std::vector <size_t> &wMin, const std::vector <size_t> &wMax,
+	const std::vector <size_t> &bMin, const std::vector <size_t> &bMax,
+	DerivedVarCache::Array &elev
+ ) const;
  
 };
 
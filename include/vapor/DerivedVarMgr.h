@@ -40,6 +40,34 @@ public:
 
  void AddMesh(const Mesh &m);
 
+ //! Set the memory budget, in bytes, of the cache of intermediate 
+ //! results shared by the derived variables
+ //!
+ //! \sa DerivedVarCache
+ //
+ void SetCacheSize(size_t max_bytes) {
+	_cache.SetCacheSize(max_bytes);
+ }
+
+ //! Return the number of bytes held by the cache of intermediate results
+ //
+ size_t GetCacheBytes() const {
+	return(_cache.GetBytes());
+ }
+
+ //! Evict least recently used intermediate results until the cache 
+ //! holds no more than \p max_bytes
+ //
+ void TrimCache(size_t max_bytes) {
+	_cache.Trim(max_bytes);
+ }
+
+ //! Remove all intermediate results from the cache
+ //
+ void ClearCache() {
+	_cache.Clear();
+ }
+
 protected:
 
  //! \copydoc Initialize()
@@ -208,6 +236,7 @@ private:
 
 private:
  DC::FileTable _fileTable;
+ DerivedVarCache _cache;
 
 };
 };
@@ -30,6 +30,13 @@ public:
     //
     virtual int GetNumberOfTimesteps() const = 0;
 
+    //
+    // If this field may be queried by multiple threads at the same time.
+    // Fields whose values come from code that has to run on one thread, 
+    // such as Python scripts, return false, and are then advected serially.
+    //
+    virtual bool SupportsConcurrentQueries() const { return true; }
+
     //
     // Get the field value at a certain position, at a certain time.
     // Users could control if this method checks position inside volume.
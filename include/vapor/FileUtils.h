@@ -27,6 +27,7 @@ COMMON_API std::string POSIXPathToWindows(std::string path);
 COMMON_API std::string POSIXPathToCurrentOS(const std::string &path);
 COMMON_API std::string CleanupPath(std::string path);
 COMMON_API long GetFileModifiedTime(const std::string &path);
+COMMON_API long long GetFileSize(const std::string &path);
 COMMON_API bool IsPathAbsolute(const std::string &path);
 COMMON_API bool Exists(const std::string &path);
 COMMON_API bool IsRegularFile(const std::string &path);
@@ -0,0 +1,75 @@
+/*
+ * Incrementally assembled vertices of the flow lines of an Advection.
+ */
+
+#ifndef FLOWLINEBUFFER_H
+#define FLOWLINEBUFFER_H
+
+#include "vapor/Advection.h"
+#include "vapor/common.h"
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace flow
+{
+//
+// FlowLineBuffer keeps the samples of every stream of an Advection, split into 
+// lines at separator particles. When the advection only grows, e.g. when an 
+// unsteady advection steps forward in time, Update() only visits the particles 
+// added since its last call.
+//
+// Assemble() lays the lines out for drawing as GL_LINE_STRIP_ADJACENCY, each 
+// with an extra leading and trailing vertex that extends the line by one unit. 
+// The class doesn't use OpenGL, so it can be used without a GL context.
+//
+class FLOW_API FlowLineBuffer final
+{
+public:
+    struct Vertex
+    {
+        glm::vec3   p;
+        float       v;
+    };
+
+    // Forget all samples
+    void Reset();
+
+    // Add the particles of "adv" that haven't been added yet, and whose time is no 
+    // greater than maxTime, considering at most the first maxParticles particles 
+    // (including separators) of each stream.
+    // The buffer starts over if maxTime or maxParticles is smaller than in the 
+    // previous call, or if "adv" no longer matches what was added.
+    // Note: particle values are copied when a particle is added, so the caller
+    //       needs to Reset() the buffer when values of existing particles change.
+    void Update( const Advection* adv, double maxTime, size_t maxParticles );
+
+    // Lay out the samples whose time is no less than minTime.
+    // Lines with fewer than 2 such samples are skipped.
+    //   vertices:  the vertices of all lines, one after another
+    //   sizes:     the number of vertices of each line
+    void Assemble( double minTime, std::vector<Vertex>& vertices,
+                   std::vector<int>& sizes ) const;
+
+    // Retrieve the total number of samples kept
+    size_t GetNumOfSamples() const;
+
+private:
+    struct Line
+    {
+        std::vector<Vertex> vertices;
+        std::vector<double> times;
+    };
+    struct Stream
+    {
+        size_t              consumed = 0;       // number of particles visited
+        bool                open     = false;   // if the last line is still growing
+        std::vector<Line>   lines;
+    };
+
+    std::vector<Stream>     _streams;
+    double                  _maxTime      = 0.0;
+    size_t                  _maxParticles = 0;
+};
+};
+
+#endif
@@ -10,6 +10,7 @@
 #include "vapor/FlowParams.h"
 #include "vapor/GLManager.h"
 #include "vapor/Advection.h"
+#include "vapor/FlowLineBuffer.h"
 #include "vapor/VaporField.h"
 
 #include <glm/glm.hpp>
@@ -76,6 +77,7 @@ private:
     bool                _cache_isSteady             = false;
     long                _cache_steadyNumOfSteps     = 0;
     size_t              _cache_currentTS            = 0;
+    size_t              _advectedTS                 = 0;    // unsteady advection has reached this TS
     std::vector<bool>   _cache_periodic             { false, false, false };
     std::vector<float>  _cache_rake                 { 0.f, 0.f, 0.f, 0.f, 0.f, 0.f };
     std::vector<long>   _cache_gridNumOfSeeds       { 5, 5, 5};
@@ -106,6 +108,10 @@ private:
     unsigned int _VBO = 0;
     vector<int> _streamSizes;
 
+    // Samples of the lines being rendered. When only new particles have been
+    // added (_renderStatus is TIME_STEP_OOD), only those are visited.
+    flow::FlowLineBuffer _lineBuffer;
+
     //
     // Member functions
     //
@@ -123,6 +129,14 @@ private:
     void _restoreGLState() const;
     glm::vec3 _getScales();
 
+    // Output the streams of an advection to the flow line output file of params.
+    // File names ending in ".vfl" get the binary format, and others gnuplot text.
+    int  _outputFlowlines( const flow::Advection* adv, const FlowParams* params, 
+                           bool append ) const;
+
+    // Use the particles in a binary or gnuplot file as seeds.
+    int  _inputSeeds( flow::Advection* adv, const std::string& filename ) const;
+
     // Update values of _cache_* and _state_* member variables.
     int _updateFlowCacheAndStates( const FlowParams* );
 
@@ -6,6 +6,7 @@
 #include <vector>
 #include <string>
 #include <limits>
+#include <functional>
 #include "vapor/VAssert.h"
 #include <memory>
 #include <vapor/common.h>
@@ -231,7 +232,73 @@ public:
 	std::vector <double> coords = {x, y, z};
 	return(GetValue(coords));
  }
- 
+
+ //! Reconstruct the sampled scalar function at many points
+ //!
+ //! This method returns the same values as calling GetValue() for each
+ //! of \p n points, but without the per point overhead of doing so.
+ //! Derived classes provide specialized implementations that hoist
+ //! grid properties out of the loop and read grid points directly from
+ //! the blocks of data, reusing the last block visited for runs of
+ //! nearby points.
+ //!
+ //! \param[in] coords An array of \p n points stored contiguously, each
+ //! with GetGeometryDim() coordinates: (x0, y0, [z0,] x1, y1, [z1,] ...)
+ //! \param[in] n The number of points
+ //! \param[out] values An array of \p n reconstructed values
+ //!
+ //! \sa GetValue()
+ //
+ virtual void SampleMany(
+	const double *coords, size_t n, float *values
+ ) const;
+
+ //! Reconstruct the sampled scalar function at many points
+ //!
+ //! This version of SampleMany() takes the points in separate
+ //! coordinate arrays.
+ //!
+ //! \param[in] x An array of \p n X coordinates
+ //! \param[in] y An array of \p n Y coordinates
+ //! \param[in] z An array of \p n Z coordinates. Ignored, and may be NULL,
+ //! if GetGeometryDim() is less than three.
+ //! \param[in] n The number of points
+ //! \param[out] values An array of \p n reconstructed values
+ //!
+ void SampleMany(
+	const double *x, const double *y, const double *z, size_t n,
+	float *values
+ ) const;
+
+ //! Locate the cells containing many points
+ //!
+ //! This method returns the same cells as calling GetIndicesCell() for
+ //! each of \p n points, but without the per point overhead of doing so.
+ //! Derived classes whose point location is expensive start the search 
+ //! for each point from the cell containing the previous point, so 
+ //! batches of nearby points are located fastest. A point on the 
+ //! boundary shared by several cells may be assigned to any of them.
+ //!
+ //! \param[in] coords An array of \p n points stored contiguously, each
+ //! with GetGeometryDim() coordinates: (x0, y0, [z0,] x1, y1, [z1,] ...)
+ //! \param[in] n The number of points
+ //! \param[out] indices An array of \p n cell indices, each with 
+ //! GetDimensions().size() elements, stored contiguously. The indices of
+ //! points outside of the grid are undefined.
+ //! \param[out] found An array of \p n flags, true if the point is 
+ //! contained by a cell
+ //! \param[in] morton If true, the points are visited in the order of 
+ //! a Morton (Z-order) curve, which improves the coherence of scattered
+ //! points. The results are returned in the order of \p coords 
+ //! regardless.
+ //!
+ //! \sa GetIndicesCell(), MortonOrder()
+ //
+ void LocateCellsMany(
+	const double *coords, size_t n, size_t *indices, bool *found,
+	bool morton = false
+ ) const;
+
 
  //! Return the extents of the user coordinate system
  //!
@@ -436,19 +503,112 @@ public:
  //! Return the min and max data value
  //!
  //! This method returns the values of grid points with min and max values,
- //! respectively.
+ //! respectively. Grid points with the missing value are ignored.
  //!
- //! For dataless grids the missing value is returned.
+ //! For dataless grids, or grids with only missing values, the missing 
+ //! value is returned.
  //!
  //! \param[out] range[2] A two-element array containing the mininum and
  //! maximum values, in that order
+ //! \param[in] nthreads Number of threads to use. If less than one 
+ //! the number of hardware threads is used.
  //!
- virtual void GetRange(float range[2]) const;
+ //! \sa ForEachBlock()
+ //!
+ virtual void GetRange(float range[2], int nthreads = 1) const;
  virtual void GetRange(
 	std::vector <size_t> min, std::vector <size_t> max,
 	float range[2]
  ) const;
 
+ //! Function called by ForEachBlock() for each span of grid values
+ //!
+ //! \param[in] thread Index of the calling thread, in the range 
+ //! 0..nthreads-1. Visitors can use it to accumulate into per thread
+ //! state without locking.
+ //! \param[in] values A contiguous array of \p n grid values
+ //! \param[in] mask If not NULL, an array of \p n flags. Values whose flag
+ //! is zero lie outside of the box passed to ForEachBlock(), and should be 
+ //! ignored.
+ //! \param[in] n Number of values in the span
+ //!
+ typedef std::function<void (
+	int thread, const float *values, const unsigned char *mask, size_t n
+ )> BlockVisitor;
+
+ //! Visit all of the grid values, one block at a time
+ //!
+ //! This method hands the values of the grid to \p visitor as contiguous 
+ //! spans of memory, each lying within a single block. Whole blocks are
+ //! passed as a single span where possible. Together the spans cover 
+ //! every grid point exactly once, but in no particular order. This is
+ //! a much faster way than Grid::ConstIterator to reduce all of the 
+ //! values of a grid, as it avoids the per value overhead of the 
+ //! iterator and exposes runs of memory that the compiler can vectorize.
+ //!
+ //! Blocks are distributed over \p nthreads threads, which call 
+ //! \p visitor concurrently.
+ //!
+ //! Dataless grids have no spans.
+ //!
+ //! \param[in] visitor Function called for each span
+ //! \param[in] nthreads Number of threads to use. If less than one 
+ //! the number of hardware threads is used.
+ //!
+ //! \sa cbegin()
+ //
+ void ForEachBlock(const BlockVisitor &visitor, int nthreads = 1) const;
+
+ //! Visit the grid values inside a box, one block at a time
+ //!
+ //! This version of ForEachBlock() passes a mask with each span that
+ //! flags grid points inside or on the axis-aligned box defined by
+ //! \p minu and \p maxu. These are the points visited by 
+ //! cbegin(minu, maxu). Spans with no points inside the box are skipped, 
+ //! and the mask is NULL for blocks whose bounding box lies entirely 
+ //! inside the box.
+ //!
+ //! \param[in] minu Minimum box coordinate.
+ //! \param[in] maxu Maximum box coordinate.
+ //
+ void ForEachBlock(
+	const std::vector <double> &minu, const std::vector <double> &maxu,
+	const BlockVisitor &visitor, int nthreads = 1
+ ) const;
+
+ //! Function called by ForEachIndexedBlock() for each span of grid values
+ //!
+ //! \param[in] block Linear index of the block containing the span,
+ //! with the first dimension varying fastest. See GetDimensionInBlks(). 
+ //! All of the spans of a block are passed to the same thread, one 
+ //! after the other.
+ //!
+ //! \sa BlockVisitor
+ //
+ typedef std::function<void (
+	int thread, size_t block, const float *values, const unsigned char *mask,
+	size_t n
+ )> IndexedBlockVisitor;
+
+ //! Visit the grid values inside a box, one block at a time
+ //!
+ //! This method is identical to ForEachBlock(), but also tells 
+ //! \p visitor which block each span belongs to, so that results can be
+ //! kept per block.
+ //
+ void ForEachIndexedBlock(
+	const std::vector <double> &minu, const std::vector <double> &maxu,
+	const IndexedBlockVisitor &visitor, int nthreads = 1
+ ) const;
+
+ //! Return the number of threads ForEachBlock() uses
+ //!
+ //! Returns the number of threads that ForEachBlock() runs when passed 
+ //! \p nthreads. Visitors are passed thread indices less than this
+ //! number.
+ //
+ static int GetNumBlockThreads(int nthreads);
+
  //! Return true if the specified point lies inside the grid
  //!
  //! This method can be used to determine if a point expressed in
@@ -1199,6 +1359,16 @@ protected:
 	const std::vector <double> &coords
  ) const = 0;
 
+ //! Locate the cells containing \p n points, visiting the points
+ //! in the order given
+ //!
+ //! Called by LocateCellsMany(), whose parameters it shares. This 
+ //! implementation calls GetIndicesCell() for each point.
+ //
+ virtual void GetIndicesCellMany(
+	const double *coords, size_t n, size_t *indices, bool *found
+ ) const;
+
  virtual float *GetValueAtIndex(
 	const std::vector <float *> &blks, const size_t indices[3]
  ) const;
@@ -1259,6 +1429,50 @@ protected:
 	}
  }
 
+ //! Fast read access to grid point values for SampleMany()
+ //! implementations
+ //!
+ //! Returns the same values as Grid::AccessIJK(), but remembers the
+ //! last block visited so that reading nearby grid points skips the
+ //! block lookup. Should only be used by classes that do not
+ //! override AccessIJK() or GetValueAtIndex().
+ //
+ class NodeReader {
+ public:
+	NodeReader(const Grid *g);
+
+	float Get(size_t i, size_t j = 0, size_t k = 0) {
+		if (! _blks) return(_missingValue);
+
+		if (i >= _dims[0]) i = _dims[0] - 1;
+		if (j >= _dims[1]) j = _dims[1] - 1;
+		if (k >= _dims[2]) k = _dims[2] - 1;
+
+		// Unsigned wrap around makes indices below the block origin
+		// fail the test too
+		//
+		if (i - _org[0] >= _bs[0] || j - _org[1] >= _bs[1] ||
+			k - _org[2] >= _bs[2]) {
+
+			_setBlock(i,j,k);
+		}
+		return(_blk[
+			((k - _org[2]) * _bs[1] + (j - _org[1])) * _bs[0] + (i - _org[0])
+		]);
+	}
+
+ private:
+	const std::vector <float *> *_blks;
+	size_t _dims[3];
+	size_t _bs[3];
+	size_t _bdims[3];
+	size_t _org[3];
+	const float *_blk;
+	float _missingValue;
+
+	void _setBlock(size_t i, size_t j, size_t k);
+ };
+
  virtual void ClampCellIndex(
 	const std::vector <size_t> &indices,
 	size_t *cIndices
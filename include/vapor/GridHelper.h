@@ -1,6 +1,7 @@
 #include <vector>
 #include <unordered_map>
 #include <list>
+#include <mutex>
 #include <cstddef>
 #include <stdexcept>
 #include <vapor/DC.h>
@@ -21,10 +22,46 @@ class VDF_API GridHelper : public Wasp::MyBase {
 
 public:
 
- GridHelper(size_t max_size = 10) : _qtrCache(max_size) {}
+ //! \param[in] max_bytes Memory budget, in bytes, of the cache of
+ //! spatial search indices of unstructured and curvilinear grids
+ //! \param[in] nthreads Number of threads used to construct the 
+ //! indices. If less than one the number of hardware threads is used.
+ //
+ GridHelper(size_t max_bytes = 64 * 1024 * 1024, int nthreads = 0) : 
+	_indexCache(max_bytes), _nthreads(nthreads) {}
 
  ~GridHelper();
 
+ //! Set the memory budget, in bytes, of the spatial search index cache
+ //!
+ //! Least recently used indices are evicted from the cache until it 
+ //! fits the budget. Evicted indices remain in memory until the last
+ //! grid using them is destroyed.
+ //
+ void SetCacheSize(size_t max_bytes) {
+	_indexCache.set_max_bytes(max_bytes);
+ }
+
+ //! Return the number of bytes of the indices in the spatial search 
+ //! index cache
+ //
+ size_t GetCacheBytes() const {
+	return(_indexCache.bytes());
+ }
+
+ //! Evict least recently used indices until the cache holds no more 
+ //! than \p max_bytes, without changing its budget
+ //
+ void TrimCache(size_t max_bytes) {
+	_indexCache.trim(max_bytes);
+ }
+
+ //! Set the number of threads used to construct spatial search indices
+ //
+ void SetNumThreads(int nthreads) {
+	_nthreads = nthreads;
+ }
+
  string GetGridType(
 	const DC::Mesh &m,
 	const std::vector <DC::CoordVar> &cvarsinfo,
@@ -86,79 +123,119 @@ public:
 
 private:
 
+ // LRU cache bounded by the total size, in bytes, of its values. The
+ // most recently added value is kept even if it alone exceeds the budget.
+ //
  template<typename key_t, typename value_t>
  class lru_cache {
  public:
-  typedef typename std::pair<key_t, value_t > key_value_pair_t;
-  typedef typename std::list<key_value_pair_t>::iterator list_iterator_t;
+  struct entry_t {
+	key_t key;
+	value_t value;
+	size_t nbytes;
+  };
+  typedef typename std::list<entry_t>::iterator list_iterator_t;
 
   lru_cache() : 
-	_max_size(10)
+	_max_bytes(64 * 1024 * 1024),
+	_nbytes(0)
   {}
 
-  lru_cache(size_t max_size) :
-	_max_size(max_size) 
+  lru_cache(size_t max_bytes) :
+	_max_bytes(max_bytes),
+	_nbytes(0)
   {}
 	
-  value_t put(const key_t& key, value_t value) {
-	value_t rvalue = NULL;
+  void put(const key_t& key, value_t value, size_t nbytes) {
+	std::lock_guard <std::mutex> guard(_mutex);
 	auto it = _cache_items_map.find(key);
-	_cache_items_list.push_front(key_value_pair_t(key, value));
 	if (it != _cache_items_map.end()) {
-		rvalue = it->second->second;
+		_nbytes -= it->second->nbytes;
 		_cache_items_list.erase(it->second);
 		_cache_items_map.erase(it);
 	}
+	_cache_items_list.push_front(entry_t{key, value, nbytes});
 	_cache_items_map[key] = _cache_items_list.begin();
+	_nbytes += nbytes;
 
-	if (_cache_items_map.size() > _max_size) {
-		auto last = _cache_items_list.end();
-		last--;
-			rvalue = last->second;
-		_cache_items_map.erase(last->first);
-		_cache_items_list.pop_back();
-	}
-	return(rvalue);
+	_evict();
   }
 
   value_t get(const key_t& key) {
+	std::lock_guard <std::mutex> guard(_mutex);
 	auto it = _cache_items_map.find(key);
 	if (it == _cache_items_map.end()) return(NULL);
 
 	_cache_items_list.splice(
 		_cache_items_list.begin(), _cache_items_list, it->second
 	);
-	return it->second->second;
+	return it->second->value;
   }
 
   value_t remove_lru() {
+	std::lock_guard <std::mutex> guard(_mutex);
 	if (! _cache_items_map.size()) return(NULL);
 
 	auto last = _cache_items_list.end();
 	last--;
-	value_t rvalue = last->second;
-	last->second = nullptr;	// necessary for delete?
-	_cache_items_map.erase(last->first);
+	value_t rvalue = last->value;
+	_nbytes -= last->nbytes;
+	_cache_items_map.erase(last->key);
 	_cache_items_list.pop_back();
 	return(rvalue);
   }
 
-	
-  bool exists(const key_t& key) const;
-	
+  void set_max_bytes(size_t max_bytes) {
+	std::lock_guard <std::mutex> guard(_mutex);
+	_max_bytes = max_bytes;
+	_evict();
+  }
+
+  void trim(size_t max_bytes) {
+	std::lock_guard <std::mutex> guard(_mutex);
+	while (_nbytes > max_bytes && _cache_items_list.size()) {
+		auto last = _cache_items_list.end();
+		last--;
+		_nbytes -= last->nbytes;
+		_cache_items_map.erase(last->key);
+		_cache_items_list.pop_back();
+	}
+  }
+
   size_t size() const {
+	std::lock_guard <std::mutex> guard(_mutex);
 	return _cache_items_map.size();
   }
 
-  
+  size_t bytes() const {
+	std::lock_guard <std::mutex> guard(_mutex);
+	return _nbytes;
+  }
 	
  private:
-  std::list<key_value_pair_t> _cache_items_list;
+  std::list<entry_t> _cache_items_list;
   std::unordered_map<key_t, list_iterator_t> _cache_items_map;
-  size_t _max_size;
+  size_t _max_bytes;
+  size_t _nbytes;
+  mutable std::mutex _mutex;
+
+  void _evict() {
+	while (_nbytes > _max_bytes && _cache_items_list.size() > 1) {
+		auto last = _cache_items_list.end();
+		last--;
+		_nbytes -= last->nbytes;
+		_cache_items_map.erase(last->key);
+		_cache_items_list.pop_back();
+	}
+  }
  };
 
- lru_cache<string, std::shared_ptr<const QuadTreeRectangle<float, size_t> > > _qtrCache;
+ // Spatial search indices: QuadTreeRectangle instances of unstructured
+ // grids, keyed by region, and CurvilinearFaceIndex::Block instances
+ // of curvilinear grids, keyed by block. Both share one budget.
+ //
+ lru_cache<string, std::shared_ptr<const void> > _indexCache;
+ int _nthreads;
 
 
  RegularGrid *_make_grid_regular(
@@ -306,6 +383,15 @@ UnstructuredGridLayered *_make_grid_unstructured_layered(
 	const vector <size_t> &bmax
  ) const;
 
+ string _getFaceBlockKey(
+	size_t ts,
+	int level,
+	int lod,
+	const vector <DC::CoordVar> &cvarsinfo,
+	const vector <size_t> &block,
+	const vector <size_t> &nfaces
+ ) const;
+
 
 };
 
@@ -73,6 +73,13 @@ public:
  //!
  float GetValue(const std::vector <double> &coords) const override;
 
+ //! \copydoc Grid::SampleMany()
+ //
+ virtual void SampleMany(
+	const double *coords, size_t n, float *values
+ ) const override;
+ using Grid::SampleMany;
+
  //! \copydoc Grid::GetInterpolationOrder()
  //
  virtual int GetInterpolationOrder() const override {
@@ -0,0 +1,93 @@
+#ifndef _Moments_
+#define _Moments_
+
+#include <vector>
+#include <cstddef>
+#include <vapor/common.h>
+
+namespace VAPoR {
+//
+//! \class Moments
+//! \brief Mergeable summary statistics of a collection of values
+//!
+//! This class accumulates the count, minimum, maximum, mean, and sum of
+//! squared deviations from the mean of a collection of values in a single
+//! pass. Partial results computed independently, for example by different
+//! threads or for different time steps, can be combined with Merge()
+//! without revisiting the values. Values are accumulated with Welford's
+//! method, and partial results merged with the pairwise update of Chan et
+//! al., both of which avoid the cancellation of the textbook
+//! sum-of-squares formula.
+//
+class VDF_API Moments {
+public:
+
+ Moments();
+
+ //! Add a single value
+ //
+ void Add(double v);
+
+ //! Add values
+ //!
+ //! Adds the \p n values in \p values that aren't equal to \p missingValue
+ //! and whose \p mask flag, if \p mask isn't NULL, is nonzero. NaNs are
+ //! ignored.
+ //!
+ //! \sa Grid::ForEachBlock()
+ //
+ void Add(
+	const float *values, const unsigned char *mask, size_t n,
+	float missingValue
+ );
+
+ //! Combine the values summarized by \p rhs with this object's
+ //
+ void Merge(const Moments &rhs);
+
+ //! Return the number of values
+ //
+ size_t GetCount() const {return(_count); }
+
+ //! Return the minimum value, or the largest double if there are no values
+ //
+ double GetMin() const {return(_min); }
+
+ //! Return the maximum value, or the lowest double if there are no values
+ //
+ double GetMax() const {return(_max); }
+
+ //! Return the mean, or zero if there are no values
+ //
+ double GetMean() const {return(_mean); }
+
+ //! Return the population variance, or zero if there are no values
+ //
+ double GetVariance() const;
+
+ //! Return the population standard deviation
+ //
+ double GetStddev() const;
+
+ //! Serialize the moments, e.g. for caching with
+ //! DataMgr::SetVariableMetadata()
+ //
+ std::vector <double> Encode() const;
+
+ //! Restore moments serialized with Encode()
+ //!
+ //! \retval status Returns false if \p v isn't a valid encoding
+ //
+ bool Decode(const std::vector <double> &v);
+
+private:
+ size_t _count;
+ double _min;
+ double _max;
+ double _mean;
+ double _m2;
+};
+
+};
+
+#endif
@@ -64,7 +64,9 @@ const float BELOW_GRID = 0.f;
 //
 // The MyBase base class provides a simple error reporting mechanism 
 // that can be used by derrived classes. N.B. the error messages/codes
-// are stored in static class members.
+// are stored per thread: a message set by one thread is not seen, or
+// overwritten, by another. The callbacks and FILE pointers are shared
+// by all threads.
 //
 class COMMON_API MyBase {
 public:
@@ -104,10 +106,11 @@ public:
  //! Retrieves the last error message set with SetErrMsg().
  //! It is the 
  //! caller's responsibility to copy the message returned to user space.
+ //! Only messages set by the calling thread are returned.
  //! \sa SetErrMsg(), SetErrCode()
  //! \retval msg A pointer to null-terminated string.
  //
- static const char	*GetErrMsg() {return(ErrMsg);}
+ static const char	*GetErrMsg();
 
  //! Record an error code
  // 
@@ -115,7 +118,7 @@ public:
  //! \param[in] err_code The error code
  //! \sa GetErrMsg(), GetErrCode(), SetErrMsg()
  //
- static void	SetErrCode(int err_code) { ErrCode = err_code; }
+ static void	SetErrCode(int err_code);
 
  //! Retrieve the current error code
  // 
@@ -124,7 +127,7 @@ public:
  //! \sa SetErrMsg(), SetErrCode()
  //! \retval code An erroor code
  //
- static int	GetErrCode() {return(ErrCode); }
+ static int	GetErrCode();
 
  //! Set a callback function for error messages
  //!
@@ -187,7 +190,7 @@ public:
  //! \sa SetDiagMsg()
  //! \retval msg A pointer to null-terminated string.
  //
- static const char	*GetDiagMsg() {return(DiagMsg);}
+ static const char	*GetDiagMsg();
 
 
  //! Set a callback function for diagnostic messages
@@ -212,6 +215,20 @@ public:
  //
  static DiagMsgCB_T GetDiagMsgCB() { return(DiagMsgCB); };
 
+ //!
+ //! Enable or disable diagnostic message reporting.
+ //!
+ //! When disabled calls to SetDiagMsg() report no messages
+ //! either through the diagnostic message callback or the diagnostic
+ //! message FILE pointer. The setting applies only to the calling thread.
+ //! 
+ //! \param[in] enable Boolean flag to enable or disable reporting
+ //! \retval prev The previous setting
+ //!
+ static bool EnableDiagMsg(bool enable);
+
+ static bool GetEnableDiagMsg();
+
  //! Set the file pointer to whence diagnostic messages are written
  //!
  //! This method permits the specification of a file pointer to which
@@ -236,28 +253,20 @@ public:
  //!
  //! When disabled calls to SetErrMsg() report no error messages
  //! either through the error message callback or the error message
- //! FILE pointer. 
+ //! FILE pointer. The setting applies only to the calling thread.
  //! 
  //! \param[in] enable Boolean flag to enable or disable error reporting
  //!
- static bool EnableErrMsg(bool enable) {
-	bool prev = Enabled; Enabled = enable; return (prev);
- };
+ static bool EnableErrMsg(bool enable);
 
- static bool GetEnableErrMsg() {return Enabled; }
+ static bool GetEnableErrMsg();
 
- // N.B. the error codes/messages are stored in static class members!!!
- static char 	*ErrMsg;
- static int	ErrCode;
- static int	ErrMsgSize;
+ // N.B. the error codes/messages are stored per thread in MyBase.cpp
  static FILE	*ErrMsgFilePtr;
  static ErrMsgCB_T ErrMsgCB;
 
- static char 	*DiagMsg;
- static int	DiagMsgSize;
  static FILE	*DiagMsgFilePtr;
  static DiagMsgCB_T DiagMsgCB;
- static bool Enabled;
 
  
 
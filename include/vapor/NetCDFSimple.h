@@ -349,6 +349,27 @@ public:
  //!
  static bool IsNCTypeText(int type);
 
+ //! Enable or disable memory-mapped reads
+ //!
+ //! When enabled (the default), variables stored in netCDF classic or
+ //! 64-bit offset format files are read directly from a read-only
+ //! memory mapping of the file whenever the external type of the
+ //! variable matches the type of the Read() buffer (e.g. \b NC_FLOAT
+ //! into a float array). The requested hyperslab is assembled with a
+ //! single strided (byte-swapping) copy from the mapped file pages,
+ //! bypassing the netCDF library's internal buffering. All other
+ //! reads, including those from netCDF-4/HDF5 files, are serviced
+ //! by the netCDF library.
+ //!
+ //! The setting takes effect the next time a file is opened with
+ //! OpenRead().
+ //!
+ //! \param[in] enable Boolean indicating whether mapped reads are
+ //! permitted
+ //
+ static void SetMMapRead(bool enable) { _mmapReadEnabled = enable; }
+ static bool GetMMapRead() { return(_mmapReadEnabled); }
+
  VDF_API friend std::ostream &operator<<(std::ostream &o, const NetCDFSimple &nc);
 
 private:
@@ -363,6 +384,32 @@ private:
  std::vector <std::pair <string, string> > _str_atts;
  std::vector <NetCDFSimple::Variable> _variables;
 
+ // Location of a variable's data in a classic (CDF-1) or 64-bit
+ // offset (CDF-2) format file, as recorded in the file header
+ //
+ class mmap_var_t {
+ public:
+	int _type;						// external netCDF type
+	bool _isRecord;					// true if slowest dim is unlimited
+	std::vector <size_t> _dims;		// dim lengths, slowest varying first
+	size_t _begin;					// file offset of first element
+ };
+
+ static bool _mmapReadEnabled;
+ std::vector <mmap_var_t> _mmapVars;	// indexed by varid. Empty if unmappable
+ size_t _mmapRecSize;	// size in bytes of one record
+ const unsigned char *_mmapAddr;	// read-only mapping of _path, or NULL
+ size_t _mmapLen;
+
+ int _mmapParseHeader();
+ void _mmapOpen();
+ void _mmapClose();
+
+ template <class T>
+ bool _mmapRead(
+	int varid, const size_t start[], const size_t count[], T *data
+ ) const;
+
  int _GetAtts(
 	int ncid, int varid,
 	std::vector <std::pair <string, std::vector <double> > > &flt_atts,
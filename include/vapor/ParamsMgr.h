@@ -26,6 +26,8 @@
 #include <stack>
 #include <utility>
 #include <functional>
+#include <memory>
+#include <vector>
 
 #include <vapor/DataMgr.h>
 #include <vapor/ParamsBase.h>
@@ -521,6 +523,26 @@ public:
 	return(_ssave.RedoSize());
  }
 
+ //! Return statistics about the memory used by the undo/redo history
+ //!
+ //! Saved states share the parts of the parameter tree that didn't
+ //! change between them. These statistics reflect that sharing.
+ //!
+ //! \param[out] nodes Number of distinct parameter nodes stored by the
+ //! undo and redo stacks and the base state
+ //! \param[out] bytes Estimate of the memory used by those nodes, in bytes
+ //! \param[out] lastSaveNodes Number of nodes copied by the most recent
+ //! state save
+ //! \param[out] lastSaveTime Time taken by the most recent state save,
+ //! in seconds
+ //
+ void GetUndoRedoStats(
+	size_t &nodes, size_t &bytes, size_t &lastSaveNodes,
+	double &lastSaveTime
+ ) const {
+	_ssave.GetStats(nodes, bytes, lastSaveNodes, lastSaveTime);
+ }
+
  //! Register a boolean flag to capture state changes
  //!
  //! This method registers the address of boolean flag whose value
@@ -591,10 +613,7 @@ private:
 	emitStateChange();
   }
 
-  void Rebase() {
-	if (_state0) delete _state0;
-	_state0 = new XmlNode(*_rootNode);
-  }
+  void Rebase();
   void Save(const XmlNode *node, string description);
   void BeginGroup(string descripion);
   void EndGroup();
@@ -607,10 +626,11 @@ private:
 
   bool GetEnabled() const { return (_enabled); }
 
-  const XmlNode *GetTop(string &description) const;
-  const XmlNode *GetBase() const {
-	return(_state0);
-  }
+  // Reconstruct the state on top of the undo stack, or the base state
+  // if the undo stack is empty. The caller is responsible for deleting
+  // the returned tree. Returns NULL if no state has been saved.
+  //
+  XmlNode *GetTop(string &description) const;
 
   bool Undo();
   bool Redo();
@@ -634,22 +654,44 @@ private:
          _intermediateStateChangeCBs.push_back(callback);
      }
 
+  void GetStats(
+	size_t &nodes, size_t &bytes, size_t &lastSaveNodes,
+	double &lastSaveTime
+  ) const;
+
  private:
 
+  // Immutable snapshot of a node of the params tree. Successive
+  // snapshots share the nodes, and the node contents, that didn't
+  // change between them, so saving a state only copies what changed.
+  //
+  class StateNode {
+  public:
+	std::shared_ptr <const XmlNode> content;	// node without children
+	std::vector <std::shared_ptr <const StateNode> > children;
+  };
+  typedef std::shared_ptr <const StateNode> State;
+
   bool _enabled;
   int _stackSize;
   const XmlNode *_rootNode;
-  const XmlNode *_state0;
+  State _state0;
 
   std::stack <string>  _groups;
-  std::deque <std::pair <string, XmlNode *>> _undoStack;
-  std::deque <std::pair <string, XmlNode *>> _redoStack;
+  std::deque <std::pair <string, State>> _undoStack;
+  std::deque <std::pair <string, State>> _redoStack;
+
+  size_t _lastSaveNodes;
+  double _lastSaveTime;
 
   std::vector <bool *> _stateChangeFlags;
   std::vector <std::function<void()> >_stateChangeCBs;
   std::vector <std::function<void()> >_intermediateStateChangeCBs;
 
-  void cleanStack(int maxN, std::deque <std::pair <string, XmlNode *>> &s);
+  void cleanStack(int maxN, std::deque <std::pair <string, State>> &s);
+  State makeState(const XmlNode *node, const State &prev, size_t &ncopied) const;
+  State makeState();
+  void saveState(const string &description);
   void emitStateChange();
   void emitIntermediateStateChange();
    
@@ -1,6 +1,8 @@
 #ifndef _Proj4API_h_
 #define	_Proj4API_h_
 
+#include <string>
+#include <atomic>
 #include <vapor/MyBase.h>
 
 namespace VAPoR {
@@ -14,6 +16,11 @@ namespace VAPoR {
 //! This class provides a convience wrapper for the proj4 Cartographic
 //! Projections Library http://trac.osgeo.org/proj/
 //!
+//! Large transforms are split across threads. Transforms between
+//! geographic coordinates and the Mercator or Lambert Conformal Conic
+//! projections are computed in closed form, rather than by proj4,
+//! once a sample of the points has been checked to agree with proj4.
+//!
 class VDF_API Proj4API : public Wasp::MyBase {
 
 public:
@@ -53,6 +60,9 @@ public:
 	//! \note As with the proj4 C library the transformations are 
 	//! performed in place, modifiying the input values
 	//!
+	//! \note The transforms of Initialize()'s projections are not
+	//! thread safe. 
+	//!
 	//! \param[in,out] x array of longitudes or PCS X values
 	//! \param[in,out] y array of latitudes or PCS Y values
 	//! \param[in] n num elements in x, y, and z
@@ -130,9 +140,23 @@ public:
 	bool IsCylindrical() const;
 
 private:
+ class FastProj;
+
  void* _pjSrc;
  void* _pjDst;
 
+ // Closed form implementation of the transform, if there is one. 
+ // _fastVerified is 1 once a transform agreed with proj4, 0 if one
+ // disagreed, and -1 before either. Concurrent transforms may verify 
+ // at the same time, so it is atomic.
+ //
+ FastProj *_fastProj;
+ bool _fastForward;
+ mutable std::atomic <int> _fastVerified;
+
+ void _initFastProj();
+ bool _fastTransform(double *x, double *y, size_t n, int offset) const;
+
  int _Initialize(
 	string srcdef, string dstdef, void **pjSrc, void **pjDst
  ) const; 
@@ -85,7 +85,11 @@ public:
  //! of the DataMgr variable may be provided to \p script as a NumPy
  //! array. Currently this occurs if all of the input variables named
  //! by \p inputs and the requested output variable are sampled on the 
- //! same mesh.
+ //! same mesh. If in addition \p script is pointwise, i.e. it only applies
+ //! element-wise arithmetic, comparisons, and NumPy universal functions
+ //! to its inputs, and \p coordFlag is false, the requested region is
+ //! evaluated one DataMgr block at a time, and the input arrays are
+ //! read-only views of the DataMgr's blocks rather than copies.
  //
  int AddFunction(
 	string name,
@@ -206,7 +210,8 @@ private:
 	std::vector <string> inNames,
 	string script,
 	DataMgr *dataMgr,
-	bool coordFlag
+	bool coordFlag,
+	bool pointwiseFlag = false
  );
 
  ~DerivedPythonVar() {}
@@ -266,6 +271,7 @@ private:
   string _script;
   DataMgr *_dataMgr;
   bool _coordFlag;
+  bool _pointwiseFlag;
   DC::FileTable _fileTable;
   vector <size_t> _dims;
   bool _meshMatchFlag;
@@ -283,6 +289,12 @@ private:
 	float *region
   );
 
+  int _readRegionTiled(
+	int fd,
+	const std::vector <size_t> &min, const std::vector <size_t> &max,
+	float *region
+  );
+
  };
 
  class func_c {
@@ -321,20 +333,46 @@ private:
 
  static void _cleanupDict(PyObject *mainDict, vector <string> keynames) ;
 
+ // Same as Calculate(), but for a compiled script. The strides, in
+ // elements, give the layout of each array. An empty stride vector
+ // means the array is contiguous. Input arrays with strides are views of
+ // memory owned by the caller, such as DataMgr blocks, and are exposed
+ // to the script read-only.
+ //
+ static int _calculate(
+	PyObject *code,
+	const vector <string> &inputVarNames,
+	const vector <vector <size_t> > &inputVarDims,
+	const vector <vector <size_t> > &inputVarStrides,
+	const vector <float *> &inputVarArrays,
+	const vector <string> &outputVarNames,
+	const vector <vector <size_t> > &outputVarDims,
+	const vector <vector <size_t> > &outputVarStrides,
+	const vector <float *> &outputVarArrays
+ ) ;
+
  static int _c2python(
 	PyObject *dict,
-	vector <string> inputVarNames,
-	vector <vector <size_t> > inputVarDims,
-	vector <float *> inputVarArrays
+	const vector <string> &inputVarNames,
+	const vector <vector <size_t> > &inputVarDims,
+	const vector <vector <size_t> > &inputVarStrides,
+	const vector <float *> &inputVarArrays
  ) ;
 
  static int _python2c(
 	PyObject *dict,
-	vector <string> outputVarNames,
-	vector <vector <size_t> > outputVarDims,
-	vector <float *> outputVarArrays
+	const vector <string> &outputVarNames,
+	const vector <vector <size_t> > &outputVarDims,
+	const vector <vector <size_t> > &outputVarStrides,
+	const vector <float *> &outputVarArrays
  ) ;
 
+ // Return true if the script can be evaluated on any subset of its
+ // inputs' elements, i.e. if each output element only depends on the
+ // input elements at the same position
+ //
+ static bool _isPointwise(const string &script);
+
  bool _validOutputVar(string name) const;
  int _checkOutVars(const vector <string> &outputVarNames) const;
  bool _validOutputMesh(string name) const;
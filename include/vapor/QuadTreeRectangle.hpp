@@ -172,6 +172,17 @@ public:
 	}
  }
 
+ //! Return an estimate of the memory used by the tree, in bytes
+ //
+ size_t GetNumBytes() const {
+	size_t nbytes = sizeof(*this) + _nodes.capacity() * sizeof(node_t *);
+	for (size_t i = 0; i<_nodes.size(); i++) {
+		nbytes += sizeof(node_t);
+		nbytes += _nodes[i]->get_payloads().capacity() * sizeof(S);
+	}
+	return(nbytes);
+ }
+
  friend std::ostream& operator<<(std::ostream &os, const QuadTreeRectangle& q) {
     os << "Num nodes : " << q._nodes.size() << std::endl;
 	const node_t *root = q._nodes[q._rootidx];
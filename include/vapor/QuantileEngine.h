@@ -0,0 +1,152 @@
+#ifndef _QuantileEngine_
+#define _QuantileEngine_
+
+#include <vector>
+#include <memory>
+#include <vapor/MyBase.h>
+#include <vapor/Grid.h>
+
+namespace VAPoR {
+//
+//! \class QuantileEngine
+//! \brief Compute quantiles of very large collections of values
+//!
+//! This class computes quantiles (e.g. the median or percentiles) of the
+//! values of one or more grids, such as a variable over many time steps,
+//! without storing all of the values. Values are streamed in spans,
+//! concurrently from multiple threads, typically with
+//! Grid::ForEachBlock().
+//!
+//! Two modes are supported:
+//!
+//! \li \b Exact Quantiles are the exact values that a full sort would
+//! return. The values have to be streamed more than once: each pass
+//! narrows down the range of values containing each quantile with a
+//! histogram, until few enough values are left to be selected
+//! directly. Memory use is bounded by the buffer limit, unless a pass
+//! fails to narrow the range, in which case the remaining values are
+//! selected directly.
+//!
+//! \li \b Approximate Quantiles are found in a single pass with a
+//! mergeable KLL sketch per thread. The rank of a returned quantile is
+//! within about \p epsilon * N of the requested rank, where N is the
+//! number of values, using memory proportional to 1 / \p epsilon.
+//!
+//! Usage:
+//!
+//! \code
+//! QuantileEngine qe(QuantileEngine::EXACT, 0.0, nthreads);
+//! qe.SetQuantiles({0.25, 0.5, 0.75});
+//! while (qe.BeginPass()) {
+//! 	for (each grid) grid->ForEachBlock(qe.GetVisitor(missingValue), nthreads);
+//! 	qe.EndPass();
+//! }
+//! qe.GetQuantiles(values);
+//! \endcode
+//!
+//! The quantile \a q of N values is the value with index
+//! floor(\a q * N), clamped to N-1, in sorted order.
+//
+class VDF_API QuantileEngine : public Wasp::MyBase {
+public:
+
+ enum Mode {EXACT, APPROXIMATE};
+
+ //! \param[in] mode Exact or approximate quantiles
+ //! \param[in] epsilon Relative rank error of approximate quantiles.
+ //! Ignored for exact quantiles.
+ //! \param[in] nthreads Maximum number of threads that concurrently
+ //! stream values. If less than one the number of hardware threads
+ //! is used.
+ //! \param[in] bufferLimit Number of values exact mode may keep in
+ //! memory for the final selection of each quantile
+ //
+ QuantileEngine(
+	Mode mode = EXACT, double epsilon = 0.001, int nthreads = 0,
+	size_t bufferLimit = 1 << 22
+ );
+ virtual ~QuantileEngine();
+
+ //! Set the quantiles to compute, and reset the engine
+ //!
+ //! \param[in] quantiles Quantiles in the range [0..1]
+ //
+ void SetQuantiles(const std::vector <double> &quantiles);
+
+ //! Start streaming values
+ //!
+ //! Returns false once the quantiles are known, so it can be used as
+ //! the condition of a loop over all of the values.
+ //
+ bool BeginPass();
+
+ //! Finish a pass over all of the values
+ //
+ void EndPass();
+
+ //! Add values
+ //!
+ //! Adds the \p n values in \p values that aren't equal to \p missingValue
+ //! and whose \p mask flag, if \p mask isn't NULL, is nonzero. NaNs and
+ //! infinities are ignored. May be called concurrently with different values of
+ //! \p thread. Every pass must add the same values.
+ //!
+ //! \param[in] thread Index of the calling thread, less than the number
+ //! of threads passed to the constructor
+ //
+ void Add(
+	int thread, const float *values, const unsigned char *mask, size_t n,
+	float missingValue
+ );
+
+ //! Return a visitor that adds grid values to the engine
+ //!
+ //! \sa Grid::ForEachBlock(), Add()
+ //
+ Grid::BlockVisitor GetVisitor(float missingValue);
+
+ //! Return the requested quantiles
+ //!
+ //! \param[out] values The quantiles, in the order they were requested
+ //! \retval status A negative value is returned if no values were added,
+ //! or not all passes were made.
+ //
+ int GetQuantiles(std::vector <double> &values) const;
+
+ //! Return the number of values added in a pass
+ //
+ size_t GetCount() const;
+
+ //! Return the number of threads passed to Add()
+ //
+ int GetNumThreads() const {return(_nthreads); }
+
+private:
+ class Sketch;
+ struct Target;
+ struct ThreadState;
+
+ Mode _mode;
+ double _epsilon;
+ int _nthreads;
+ size_t _bufferLimit;
+ std::vector <double> _quantiles;
+ int _pass;
+ bool _done;
+ size_t _count;
+ float _min;
+ float _max;
+ std::vector <Target> _targets;
+ std::vector <std::unique_ptr <ThreadState> > _threads;
+ std::vector <double> _results;
+
+ void _reset();
+ void _endCountPass();
+ void _endRefinePass();
+ void _endApproximatePass();
+ size_t _rank(double q) const;
+};
+
+};
+
+#endif
@@ -93,6 +93,13 @@ public:
  //
  virtual bool InsideGrid(const std::vector <double> &coords) const override;
 
+ //! \copydoc Grid::SampleMany()
+ //
+ virtual void SampleMany(
+	const double *coords, size_t n, float *values
+ ) const override;
+ using Grid::SampleMany;
+
 
  class ConstCoordItrRG : public Grid::ConstCoordItrAbstract {
  public:
@@ -333,6 +333,12 @@ private:
 
 	size_t _timestep;
 
+	// Time step and variable most recently passed to 
+	// DataMgr::PrefetchAhead()
+	//
+	size_t _prefetchTimestep;
+	string _prefetchVarName;
+
 #ifdef	VAPOR3_0_0_ALPHA
 	static ControlExec* _controlExec;
 #endif
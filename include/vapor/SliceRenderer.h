@@ -77,6 +77,13 @@ namespace VAPoR {
             float* dataValues, 
             Grid* grid
         ) const;
+        void _populateDataRow(
+            float* dataValues,
+            Grid* grid,
+            std::vector<double> coords,
+            int axis,
+            double delta
+        ) const;
 
         double _newWaySeconds;
         double _newWayInlineSeconds;
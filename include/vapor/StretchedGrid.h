@@ -111,6 +111,13 @@ public:
  //
  virtual bool InsideGrid(const std::vector <double> &coords) const override;
 
+ //! \copydoc Grid::SampleMany()
+ //
+ virtual void SampleMany(
+	const double *coords, size_t n, float *values
+ ) const override;
+ using Grid::SampleMany;
+
  //! Returns reference to vector containing X user coordinates
  //!
  //! Returns reference to vector passed to constructor 
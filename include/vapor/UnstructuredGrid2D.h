@@ -119,6 +119,16 @@ public:
 	const std::vector <double> &coords
  ) const override;
 
+ //! \copydoc Grid::SampleMany()
+ //!
+ //! Each point's face is searched for starting from the face of the 
+ //! previous point and its neighbors.
+ //
+ virtual void SampleMany(
+	const double *coords, size_t n, float *values
+ ) const override;
+ using Grid::SampleMany;
+
 
  /////////////////////////////////////////////////////////////////////////////
  //
@@ -180,6 +190,11 @@ public:
  
  VDF_API friend std::ostream &operator<<(std::ostream &o, const UnstructuredGrid2D &sg);
 
+protected:
+ virtual void GetIndicesCellMany(
+	const double *coords, size_t n, size_t *indices, bool *found
+ ) const override;
+
 private:
  UnstructuredGridCoordless _xug;
  UnstructuredGridCoordless _yug;
@@ -214,6 +229,17 @@ private:
 	double *lambda, int &nlambda
  ) const;
 
+ bool _testFace(
+	size_t face, const double pt[2], double *verts, double *lambda,
+	int &nlambda
+ ) const;
+
+ bool _locateFace(
+	const double pt[2], bool &hint, size_t &face,
+	std::vector <size_t> &candidates, double *verts, double *lambda,
+	int &nlambda
+ ) const;
+
  std::shared_ptr<QuadTreeRectangle<float, size_t> >_makeQuadTreeRectangle() const;
 
 
@@ -2,12 +2,14 @@
 #define VAPORFIELD_H
 
 #include <list>
+#include <memory>
+#include <mutex>
+#include <cstdint>
 #include "vapor/Field.h"
 #include "vapor/Particle.h"
 #include "vapor/DataMgr.h"
 #include "vapor/FlowParams.h"
 #include "vapor/Grid.h"
-#include "vapor/unique_ptr_cache.hpp"
 
 namespace flow
 {
@@ -19,7 +21,10 @@ namespace flow
 class FLOW_API VaporField final : public Field
 {
 public:
+    // cache_limit is the number of grids to keep resolved. At least two
+    // time steps are always kept, so that temporal interpolation works.
     VaporField( size_t cache_limit );
+   ~VaporField();
 
     //
     // Functions from class Field
@@ -33,11 +38,21 @@ public:
                                float& scalar,                          // output
                                bool checkInsideVolume = true )      const override;
     virtual int  GetNumberOfTimesteps()                             const override;
+    virtual bool SupportsConcurrentQueries()                        const override;
 
     //
     // Functions for interaction with VAPOR components
     //
     void AssignDataManager( VAPoR::DataMgr*    dmgr );
+
+    //
+    // Takes a snapshot of the parameters that decide which grids are sampled
+    // (variables, box extents, refinement and compression levels, current time
+    // step, velocity multiplier, and DefaultZ). Resolved grids are kept per time 
+    // step, and are only invalidated when the variables, extents, levels, or 
+    // DefaultZ change. Changes to the params object do not take effect until 
+    // this function is called again.
+    //
     void UpdateParams(const VAPoR::FlowParams* p );
 
     //  
@@ -99,6 +114,7 @@ public:
     // Store the default Z value for variables that are 2D grids in nature.
     // In this case, a 3D one-layer "GrownGrid" is created with 
     // the 3rd dimension being DefaultZ.
+    // Changes to DefaultZ take effect at the next UpdateParams().
     //
     float DefaultZ = 0.0f;
 
@@ -110,29 +126,68 @@ public:
 
 private:
 
+    //
+    // The grids of one time step, resolved for one parameter snapshot.
+    // A ResolvedStep is never modified once built, so it is shared between
+    // threads, and stays valid for as long as a thread holds on to it, 
+    // even after being evicted from the cache.
+    //
+    struct ResolvedStep
+    {
+        size_t              timestep;
+        bool                isScalar;   // one scalar grid, or three velocity grids
+        int                 numGrids;
+        const VAPoR::Grid*  grids[3];
+        float               missingValues[3];
+        std::unique_ptr<const GridWrapper>  wrappers[3];
+
+        // Samples all grids at pos. Returns false if any of them has a 
+        // missing value there.
+        bool Sample( const glm::vec3& pos, float* values ) const;
+        bool InsideGrid( const glm::vec3& pos ) const;
+    };
+    using StepPtr = std::shared_ptr<const ResolvedStep>;
+
     // Member variables
     std::vector<float>          _timestamps;    // in ascending order
     VAPoR::DataMgr*             _datamgr = nullptr;   
     const VAPoR::FlowParams*    _params  = nullptr;
-    using cacheType = VAPoR::unique_ptr_cache< std::string, GridWrapper, 9 >;
-    mutable cacheType           _recentGrids;   // so this variable can be 
-                                                // modified by a const function.
-    const std::string           _constantGridZero = "ConstantGrid with zeros";
-
-    // Member functions
-    std::string _paramsToString(  size_t currentTS, const std::string& var, int refLevel, 
-            int compLevel, const std::vector<double>& min, const std::vector<double>& max ) const;
+    const size_t                _cacheLimit;
+
+    // Parameter snapshot taken by UpdateParams()
+    std::vector<double>         _extMin, _extMax;
+    int                         _refLevel       = 0;
+    int                         _compLevel      = 0;
+    size_t                      _currentTS      = 0;
+    float                       _velocityMult   = 1.0f;
+    float                       _defaultZ       = 0.0f;
+    uint64_t                    _generation;    // unique id of this snapshot
+
+    // Serializes grid retrieval and release so concurrent queries are safe.
+    // It is recursive because evicting a step releases its grids.
+    mutable std::recursive_mutex _recentStepsMutex;
+    mutable std::list<StepPtr>  _recentSteps;   // most recently used first
 
     // Are the following member pointers set? 1) _datamgr, 2) _params
     bool _isReady() const;
 
-    // _getAGrid will use _params to retrieve/generate grids. 
+    // Invalidates all resolved steps. Must not be called while sampling.
+    void _invalidate();
+
+    // Returns the grids of a time step, resolving them if needed.
+    // Threads first check the steps they used most recently, so repeated
+    // queries of the same step neither lock nor look anything up. 
     // In the case of failing to generate a requested grid, nullptr will be returned.
     // This failure will also be recorded to MyBase.
+    StepPtr _getStep( size_t timestep, bool isScalar ) const;
+    StepPtr _resolveStep( size_t timestep, bool isScalar ) const;
+
+    // _getAGrid will use the parameter snapshot to retrieve/generate a grid. 
+    // The returned grid is owned by the returned wrapper, or nullptr on failure.
     // Note 1: If a variable name is empty, we then return a ConstantField.
     // Note 2: If a variable is essentially 2D, we then grow it to be 3D 
     //         and return a GrownGrid.
-    const VAPoR::Grid* _getAGrid( size_t              timestep,
+    const GridWrapper* _getAGrid( size_t              timestep,
                                   const std::string&  varName ) const ;
 
 };
@@ -717,9 +717,7 @@ private:
  int _numfiles; // Number of NetCDF files 
  int _currentVersion; // Current WASP version number;
  int _fileVersion; // version number of opened file;
- Wasp::SmartBuf _blockbuf;    // Dynamic storage for blocks
- Wasp::SmartBuf _coeffbuf;    // Dynamic storage wavelet coefficients
- Wasp::SmartBuf _sigbuf;  // Dynamic storage encoded signficance maps
+ Wasp::SmartBuf _blockbuf;    // Dynamic storage for blocks, coefficients and maps
 
  bool _open;    // compressed variable open for reading or writing?
  string _open_wname;  // wavelet name of opened variable
@@ -504,6 +504,24 @@ virtual void SetElementStringVec(
 	return(! (*this == rhs));
  };
 
+ //! Return true if this node's tag, attributes, and element data are
+ //! equal to those of \p rhs. Children are not compared.
+ //!
+ //! \sa operator==()
+ //
+ bool EqualsIgnoringChildren(const XmlNode &rhs) const;
+
+ //! Create a parentless copy of this node without its children
+ //!
+ //! \sa XmlNode(const XmlNode &)
+ //
+ XmlNode *CloneWithoutChildren() const;
+
+ //! Return an estimate of the memory used by this node's tag,
+ //! attributes, and element data, excluding its children, in bytes
+ //
+ size_t GetNumBytes() const;
+
  //! Return boolean indicating if this node is the root of the tree
  //!
  //! This method returns true if the node is the root if the tree. I.e.
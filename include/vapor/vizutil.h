@@ -1,6 +1,9 @@
 #ifndef _vizutil_h_
 #define _vizutil_h_
 
+#include <vector>
+#include <cstddef>
+
 namespace VAPoR {
 
 //! Decompose a hexahedron into 5 tetrahedra
@@ -161,6 +164,25 @@ bool WachspressCoords2D(
 //
 bool InsideConvexPolygon(const double verts[], const double pt[], int n);
 
+//! Order points along a Morton (Z-order) curve
+//!
+//! This function computes the order in which to visit points so that 
+//! points close to each other in space are mostly visited close to each
+//! other in time. The points' coordinates are quantized over their 
+//! bounding box, and the points are sorted by the interleaved bits of the
+//! quantized coordinates. Visiting scattered points in this order improves
+//! the coherence of point location and sampling.
+//!
+//! \param[in] coords An array of \p n points stored contiguously, each 
+//! with \p ndim coordinates: (x0, y0, [z0,] x1, y1, [z1,] ...)
+//! \param[in] n The number of points
+//! \param[in] ndim The number of coordinates of each point, 1, 2, or 3
+//! \param[out] order The indices of the points, in Morton order
+//
+void MortonOrder(
+	const double coords[], size_t n, int ndim, std::vector <size_t> &order
+);
+
 };
 
 #endif
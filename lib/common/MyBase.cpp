@@ -9,6 +9,7 @@
 #include <vector>
 #include <iostream>
 #include <sstream>
+#include <mutex>
 
 #include <vapor/MyBase.h>
 #ifdef WIN32
@@ -46,14 +47,36 @@ void * operator new[] (size_t sz) {
 }
 #endif
 
-char 	*MyBase::ErrMsg = NULL;
-int	MyBase::ErrMsgSize = 0;
-int	MyBase::ErrCode = 0;
+namespace {
+
+// Message buffers are private to each thread so that concurrent callers
+// (e.g. DataMgr worker threads) don't overwrite each other's messages
+// while they are being formatted or read back
+//
+struct msgbuf_t {
+	msgbuf_t() : msg(NULL), size(0) {}
+	~msgbuf_t() { if (msg) delete [] msg; }
+
+	char *msg;
+	int size;
+};
+
+thread_local msgbuf_t ErrMsgBuf;
+thread_local msgbuf_t DiagMsgBuf;
+thread_local int ErrCode = 0;
+thread_local bool Enabled = true;
+thread_local bool DiagEnabled = true;
+
+// Serializes calls to the (shared) callbacks and FILE pointers. Recursive
+// because a callback may itself report a message
+//
+std::recursive_mutex ReportMutex;
+
+};
+
 FILE	*MyBase::ErrMsgFilePtr = NULL;
 void (*MyBase::ErrMsgCB) (const char *msg, int err_code) = NULL;
 
-char 	*MyBase::DiagMsg = NULL;
-int	MyBase::DiagMsgSize = 0;
 #ifdef	DEBUG
 FILE	*MyBase::DiagMsgFilePtr = stderr;
 #else
@@ -61,8 +84,6 @@ FILE	*MyBase::DiagMsgFilePtr = NULL;
 #endif
 void (*MyBase::DiagMsgCB) (const char *msg) = NULL;
 
-bool MyBase::Enabled = true;
-
 MyBase::MyBase() {
 	SetClassName("MyBase");
 }
@@ -139,14 +160,15 @@ void	MyBase::SetErrMsg(
 	ErrCode = 1;
 
 	va_start(args, format);
-	_SetErrMsg(&ErrMsg, &ErrMsgSize, format, args);
+	_SetErrMsg(&ErrMsgBuf.msg, &ErrMsgBuf.size, format, args);
 	va_end(args);
 
+	std::lock_guard <std::recursive_mutex> guard(ReportMutex);
 
-	if (ErrMsgCB) (*ErrMsgCB) (ErrMsg, ErrCode);
+	if (ErrMsgCB) (*ErrMsgCB) (ErrMsgBuf.msg, ErrCode);
 
 	if (ErrMsgFilePtr) {
-		(void) fprintf(ErrMsgFilePtr, "%s\n", ErrMsg);
+		(void) fprintf(ErrMsgFilePtr, "%s\n", ErrMsgBuf.msg);
 	}
 }
 
@@ -162,14 +184,15 @@ void	MyBase::SetErrMsg(
 	ErrCode = errcode;
 
 	va_start(args, format);
-	_SetErrMsg(&ErrMsg, &ErrMsgSize, format, args);
+	_SetErrMsg(&ErrMsgBuf.msg, &ErrMsgBuf.size, format, args);
 	va_end(args);
 
+	std::lock_guard <std::recursive_mutex> guard(ReportMutex);
 
-	if (ErrMsgCB) (*ErrMsgCB) (ErrMsg, ErrCode);
+	if (ErrMsgCB) (*ErrMsgCB) (ErrMsgBuf.msg, ErrCode);
 
 	if (ErrMsgFilePtr) {
-		(void) fprintf(ErrMsgFilePtr, "%s\n", ErrMsg);
+		(void) fprintf(ErrMsgFilePtr, "%s\n", ErrMsgBuf.msg);
 	}
 }
 
@@ -179,17 +202,57 @@ void	MyBase::SetDiagMsg(
 ) {
 	va_list args;	// initialize to make valgrind shutup
 
+	if (! DiagEnabled) return;
+
 	va_start(args, format);
-	_SetErrMsg(&DiagMsg, &DiagMsgSize, format, args);
+	_SetErrMsg(&DiagMsgBuf.msg, &DiagMsgBuf.size, format, args);
 	va_end(args);
 
-	if (DiagMsgCB) (*DiagMsgCB) (DiagMsg);
+	std::lock_guard <std::recursive_mutex> guard(ReportMutex);
+
+	if (DiagMsgCB) (*DiagMsgCB) (DiagMsgBuf.msg);
 
 	if (DiagMsgFilePtr) {
-		(void) fprintf(DiagMsgFilePtr, "%s\n", DiagMsg);
+		(void) fprintf(DiagMsgFilePtr, "%s\n", DiagMsgBuf.msg);
 	}
 }
 
+const char *MyBase::GetErrMsg() {
+	return(ErrMsgBuf.msg);
+}
+
+void MyBase::SetErrCode(int err_code) {
+	ErrCode = err_code;
+}
+
+int MyBase::GetErrCode() {
+	return(ErrCode);
+}
+
+const char *MyBase::GetDiagMsg() {
+	return(DiagMsgBuf.msg);
+}
+
+bool MyBase::EnableErrMsg(bool enable) {
+	bool prev = Enabled;
+	Enabled = enable;
+	return (prev);
+}
+
+bool MyBase::GetEnableErrMsg() {
+	return(Enabled);
+}
+
+bool MyBase::EnableDiagMsg(bool enable) {
+	bool prev = DiagEnabled;
+	DiagEnabled = enable;
+	return (prev);
+}
+
+bool MyBase::GetEnableDiagMsg() {
+	return(DiagEnabled);
+}
+
 int	Wasp::IsPowerOfTwo(
 	unsigned int x
 ) {
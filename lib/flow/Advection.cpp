@@ -1,9 +1,118 @@
 #include <iostream>
 #include "vapor/Advection.h"
 #include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <limits>
+#ifndef WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
 
 using namespace flow;
 
+namespace {
+    // Layout of a binary section up to the metadata text. See Advection.h.
+    const char      binaryMagic[8]    = { 'V', 'A', 'P', 'O', 'R', 'F', 'L', '\0' };
+    const uint32_t  binaryVersion     = 1;
+    const size_t    binaryHeaderSize  = 8 + 4 + 4 + 8 + 8 + 8;
+
+    // Number of floats staged before each write
+    const size_t    binaryWriteBuffer = 1024 * 1024;
+
+    size_t pad8( size_t n ) { return (n + 7) / 8 * 8; }
+};
+
+//
+// A fixed set of threads that all run the same job whenever Run() is called.
+// The calling thread runs the job too, and Run() returns once every thread 
+// has finished it.
+//
+class Advection::WorkerPool final
+{
+public:
+    explicit WorkerPool( size_t numHelpers )
+    {
+        _threads.reserve( numHelpers );
+        for( size_t i = 0; i < numHelpers; i++ )
+            _threads.emplace_back( &WorkerPool::_work, this );
+    }
+
+   ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock( _mutex );
+            _quit = true;
+        }
+        _wake.notify_all();
+        for( auto& t : _threads )
+            t.join();
+    }
+
+    WorkerPool(            const WorkerPool& ) = delete;
+    WorkerPool& operator=( const WorkerPool& ) = delete;
+
+    size_t NumHelpers() const
+    {
+        return _threads.size();
+    }
+
+    void Run( const std::function<void()>& job )
+    {
+        {
+            std::lock_guard<std::mutex> lock( _mutex );
+            _job  = &job;
+            _busy = _threads.size();
+            _round++;
+        }
+        _wake.notify_all();
+
+        job();
+
+        std::unique_lock<std::mutex> lock( _mutex );
+        _done.wait( lock, [this]() { return _busy == 0; } );
+        _job = nullptr;
+    }
+
+private:
+    std::vector<std::thread>        _threads;
+    std::mutex                      _mutex;
+    std::condition_variable         _wake, _done;
+    const std::function<void()>*    _job   = nullptr;
+    uint64_t                        _round = 0;     // number of jobs started
+    size_t                          _busy  = 0;     // helpers still running the current job
+    bool                            _quit  = false;
+
+    void _work()
+    {
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock( _mutex );
+        while( true )
+        {
+            _wake.wait( lock, [&]() { return _quit || _round != seen; } );
+            if( _quit )
+                return;
+            seen = _round;
+            const std::function<void()>* job = _job;
+
+            lock.unlock();
+            (*job)();
+            lock.lock();
+
+            if( --_busy == 0 )
+                _done.notify_one();
+        }
+    }
+};
+
 // Constructor;
 Advection::Advection() : _lowerAngle( 3.0f ), _upperAngle( 15.0f )
 {
@@ -16,6 +125,9 @@ Advection::Advection() : _lowerAngle( 3.0f ), _upperAngle( 15.0f )
     }
 }
 
+// Destructor; defined here where WorkerPool is complete.
+Advection::~Advection() = default;
+
 void
 Advection::UseSeedParticles( const std::vector<Particle>& seeds )
 {
@@ -27,6 +139,8 @@ Advection::UseSeedParticles( const std::vector<Particle>& seeds )
     _separatorCount.resize( seeds.size() );
     for( auto& e : _separatorCount )
         e = 0;
+
+    _valuedCount.assign( seeds.size(), 0 );
 }
 
 int
@@ -50,65 +164,180 @@ Advection::AdvectOneStep( Field* velocity, float deltaT, ADVECTION_METHOD method
     if( ready != 0 )
         return ready;
 
+    // Streams are independent of each other, so they are advected in parallel.
+    bool happened = _forEachStream( velocity, [&]( size_t streamIdx ) -> bool 
+        {
+            return _advectStreamOneStep( velocity, deltaT, method, streamIdx );
+        } );
+
+    if( happened )
+        return ADVECT_HAPPENED;
+    else
+        return 0;
+}
+
+int
+Advection::AdvectTillTime( Field* velocity, float startT, float deltaT, float targetT, 
+                           ADVECTION_METHOD method )
+{
+    int ready = CheckReady();
+    if( ready != 0 )
+        return ready;
+
+    // Streams are independent of each other, so they are advected in parallel.
+    bool happened = _forEachStream( velocity, [&]( size_t streamIdx ) -> bool 
+        {
+            return _advectStreamTillTime( velocity, startT, deltaT, targetT, 
+                                          method, streamIdx );
+        } );
+
+    if( happened )
+        return ADVECT_HAPPENED;
+    else
+        return 0;
+}
+
+bool
+Advection::_advectStreamOneStep( Field* velocity, float deltaT, 
+                                 ADVECTION_METHOD method, size_t streamIdx )
+{
+    auto& s = _streams[streamIdx];
+
+    // Check if the particle is inside of the volume.
+    // Also wrap it along periodic dimensions if enabled.
+    if( !velocity->InsideVolumeVelocity( s.back().time, s.back().location ) )
+    {
+        auto& p0 = s.back();
+        // Attempt to apply periodicity
+        bool locChanged = false;
+        auto loc = p0.location;
+        for( int i = 0; i < 3; i++ )    // correct coordinates in each periodic dimension
+        {
+            if( _isPeriodic[i] )
+            {
+                loc[i] = _applyPeriodic( loc[i], _periodicBounds[i][0], _periodicBounds[i][1] );
+                locChanged = true;
+            }
+        }
+
+        if( !locChanged )   // no dimension is periodic
+            return false;   // skip this particle, since it's out of the volume
+
+        // If the new location comes inside volume, then we do these things:
+        // 1) Update the location of p0 to represent the wrapped result.
+        // 2) Insert a separator particle before p0.
+        if( velocity->InsideVolumeVelocity( p0.time, loc ) )
+        {
+            p0.location = loc;
+
+            Particle separator;
+            separator.SetSpecial( true );
+            auto itr = s.end(); // Should use const iterator here, 
+                                // but gcc-4.8 on CentOS7 doesn't support...
+            --itr;      // insert before the last element, p0
+            s.insert( itr, std::move(separator) );
+            _separatorCount[streamIdx]++;
+        }
+        else
+            return false;   // skip this particle, since it's out of the volume
+
+    }   // end of if condition
+
+    const auto& past0 = s.back();
+    float dt = deltaT;
+    if( s.size() > 2 )  // If there are at least 3 particles in the stream and
+    {                   // neither is a separator, we also adjust *dt*
+        const auto& past1 = s[ s.size()-2 ];
+        const auto& past2 = s[ s.size()-3 ];
+        if( (!past1.IsSpecial()) && (!past2.IsSpecial()) )
+        {
+            float mindt = deltaT / 20.0f,   maxdt = deltaT * 20.0f;
+            dt  = past0.time - past1.time;     // step size used by last integration
+            dt *= _calcAdjustFactor( past2, past1, past0 );
+            if( dt > 0 )    // integrate forward 
+                dt  = glm::clamp( dt, mindt, maxdt );
+            else            // integrate backward
+                dt  = glm::clamp( dt, maxdt, mindt );
+        }
+    }
+
+    Particle p1;
+    int rv = 0;
+    switch (method)
+    {
+        case ADVECTION_METHOD::EULER:
+            rv = _advectEuler( velocity, past0, dt, p1 ); break;
+        case ADVECTION_METHOD::RK4:
+            rv = _advectRK4(   velocity, past0, dt, p1 ); break;
+    }
+    if( rv != 0 )   // Advection wasn't successful for some reason...
+        return false;
+
+    // Advection successful, keep the new particle.
+    s.push_back( std::move(p1) );
+    return true;
+}
+
+bool
+Advection::_advectStreamTillTime( Field* velocity, float startT, float deltaT, 
+                                  float targetT, ADVECTION_METHOD method, 
+                                  size_t streamIdx )
+{
+    auto& s = _streams[streamIdx];
     bool happened = false;
-    size_t streamIdx = 0;
-    for( auto& s : _streams )       // Process one stream at a time
+
+    Particle p0 = s.back();     // Start from the last particle in this stream
+    if( p0.time < startT )      // Skip this stream if it didn't advance to startT
+        return false;
+
+    while( p0.time < targetT )
     {
         // Check if the particle is inside of the volume.
-        // Also wrap it along periodic dimensions if enabled.
-        if( !velocity->InsideVolumeVelocity( s.back().time, s.back().location ) )
+        // Wrap it along periodic dimensions if applicable.
+        if( !velocity->InsideVolumeVelocity( p0.time, p0.location ) )
         {
-            auto& p0 = s.back();
-            // Attempt to apply periodicity
             bool locChanged = false;
-            auto loc = p0.location;
-            for( int i = 0; i < 3; i++ )    // correct coordinates in each periodic dimension
+            auto itr = s.end(); --itr;  // pointing to the last element
+            auto loc = itr->location;
+            for( int i = 0; i < 3; i++ )
             {
                 if( _isPeriodic[i] )
                 {
-                    loc[i] = _applyPeriodic( loc[i], _periodicBounds[i][0], _periodicBounds[i][1] );
-                    locChanged = true;
-                }
+                    loc[i] = _applyPeriodic( loc[i], _periodicBounds[i][0], _periodicBounds[i][1] );  
+                    locChanged = true; 
+                } 
             }
-
             if( !locChanged )   // no dimension is periodic
-                continue;       // skip this particle, since it's out of the volume
+                break;          // break the while loop
 
-            // If the new location comes inside volume, then we do these things:
-            // 1) Update the location of p0 to represent the wrapped result.
-            // 2) Insert a separator particle before p0.
-            if( velocity->InsideVolumeVelocity( p0.time, loc ) )
+            // See if the new location is inside of the volume
+            if( velocity->InsideVolumeVelocity( itr->time, loc ) )
             {
-                p0.location = loc;
-
+                itr->location = loc;
+                p0 = *itr;  // p0 is equal to the wrapped particle
+                
                 Particle separator;
                 separator.SetSpecial( true );
-                auto itr = s.end(); // Should use const iterator here, 
-                                    // but gcc-4.8 on CentOS7 doesn't support...
-                --itr;      // insert before the last element, p0
                 s.insert( itr, std::move(separator) );
                 _separatorCount[streamIdx]++;
             }
-            else
-                continue;   // skip this particle, since it's out of the volume
+            else 
+                break;  // break the while loop
 
-        }   // end of if condition
+        }   // Finish of the if condition
 
-        const auto& past0 = s.back();
         float dt = deltaT;
-        if( s.size() > 2 )  // If there are at least 3 particles in the stream and
-        {                   // neither is a separator, we also adjust *dt*
+        if( s.size() > 2 )  // If there are at least 3 particles in the stream, 
+        {                   // we also adjust *dt*
+            float mindt = deltaT / 20.0f,   maxdt = deltaT * 20.0f;
+            maxdt = glm::min( maxdt, targetT - p0.time );
             const auto& past1 = s[ s.size()-2 ];
             const auto& past2 = s[ s.size()-3 ];
             if( (!past1.IsSpecial()) && (!past2.IsSpecial()) )
             {
-                float mindt = deltaT / 20.0f,   maxdt = deltaT * 20.0f;
-                dt  = past0.time - past1.time;     // step size used by last integration
-                dt *= _calcAdjustFactor( past2, past1, past0 );
-                if( dt > 0 )    // integrate forward 
-                    dt  = glm::clamp( dt, mindt, maxdt );
-                else            // integrate backward
-                    dt  = glm::clamp( dt, maxdt, mindt );
+                dt  = p0.time - past1.time;     // step size used by last integration
+                dt *= _calcAdjustFactor( past2, past1, p0 );
+                dt  = glm::clamp( dt, mindt, maxdt );
             }
         }
 
@@ -117,124 +346,94 @@ Advection::AdvectOneStep( Field* velocity, float deltaT, ADVECTION_METHOD method
         switch (method)
         {
             case ADVECTION_METHOD::EULER:
-                rv = _advectEuler( velocity, past0, dt, p1 ); break;
+                rv = _advectEuler( velocity, p0, dt, p1 ); break;
             case ADVECTION_METHOD::RK4:
-                rv = _advectRK4(   velocity, past0, dt, p1 ); break;
+                rv = _advectRK4(   velocity, p0, dt, p1 ); break;
         }
         if( rv != 0 )   // Advection wasn't successful for some reason...
-            continue;
+        {
+            break;
+        }
         else            // Advection successful, keep the new particle.
         {
             happened = true;
-            s.push_back( std::move(p1) );
+            s.push_back( p1 );
+            p0 = std::move( p1 );
         }
+    }   // Finish the while loop to advect one particle to a time
 
-        streamIdx++;
+    return happened;
+}
 
-    }   // end of for loop
+void
+Advection::SetNumThreads( size_t numThreads )
+{
+    _numThreads = numThreads;
+}
 
-    if( happened )
-        return ADVECT_HAPPENED;
-    else
-        return 0;
+size_t
+Advection::GetNumThreads() const
+{
+    if( _numThreads > 0 )
+        return _numThreads;
+
+    size_t n = std::thread::hardware_concurrency();
+    return n > 0 ? n : 1;
 }
 
-int
-Advection::AdvectTillTime( Field* velocity, float startT, float deltaT, float targetT, 
-                           ADVECTION_METHOD method )
+bool
+Advection::_forEachStream( const Field* field, const std::function<bool(size_t)>& func )
 {
-    int ready = CheckReady();
-    if( ready != 0 )
-        return ready;
+    const size_t numStreams = _streams.size();
+    size_t numThreads = std::min( GetNumThreads(), numStreams );
+    if( !field->SupportsConcurrentQueries() )
+        numThreads = 1;
 
-    bool happened = false;
-    size_t streamIdx = 0;
-    for( auto& s : _streams )       // Process one stream at a time
+    if( numThreads <= 1 )
     {
-        Particle p0 = s.back();     // Start from the last particle in this stream
-        if( p0.time < startT )      // Skip this stream if it didn't advance to startT
-            continue;
+        bool happened = false;
+        for( size_t i = 0; i < numStreams; i++ )
+            if( func( i ) )
+                happened = true;
+        return happened;
+    }
 
-        while( p0.time < targetT )
-        {
-            // Check if the particle is inside of the volume.
-            // Wrap it along periodic dimensions if applicable.
-            if( !velocity->InsideVolumeVelocity( p0.time, p0.location ) )
-            {
-                bool locChanged = false;
-                auto itr = s.end(); --itr;  // pointing to the last element
-                auto loc = itr->location;
-                for( int i = 0; i < 3; i++ )
-                {
-                    if( _isPeriodic[i] )
-                    {
-                        loc[i] = _applyPeriodic( loc[i], _periodicBounds[i][0], _periodicBounds[i][1] );  
-                        locChanged = true; 
-                    } 
-                }
-                if( !locChanged )   // no dimension is periodic
-                    break;          // break the while loop
-
-                // See if the new location is inside of the volume
-                if( velocity->InsideVolumeVelocity( itr->time, loc ) )
-                {
-                    itr->location = loc;
-                    p0 = *itr;  // p0 is equal to the wrapped particle
-                    
-                    Particle separator;
-                    separator.SetSpecial( true );
-                    s.insert( itr, std::move(separator) );
-                    _separatorCount[streamIdx]++;
-                }
-                else 
-                    break;  // break the while loop
-
-            }   // Finish of the if condition
-
-            float dt = deltaT;
-            if( s.size() > 2 )  // If there are at least 3 particles in the stream, 
-            {                   // we also adjust *dt*
-                float mindt = deltaT / 20.0f,   maxdt = deltaT * 20.0f;
-                maxdt = glm::min( maxdt, targetT - p0.time );
-                const auto& past1 = s[ s.size()-2 ];
-                const auto& past2 = s[ s.size()-3 ];
-                if( (!past1.IsSpecial()) && (!past2.IsSpecial()) )
-                {
-                    dt  = p0.time - past1.time;     // step size used by last integration
-                    dt *= _calcAdjustFactor( past2, past1, p0 );
-                    dt  = glm::clamp( dt, mindt, maxdt );
-                }
-            }
+    // Advection runs one step per frame, so the helper threads are kept 
+    // rather than started for every step. The pool is sized by GetNumThreads() 
+    // rather than numThreads, so a changing number of streams does not replace it.
+    const size_t numHelpers = GetNumThreads() - 1;
+    if( _workers == nullptr || _workers->NumHelpers() != numHelpers )
+    {
+        _workers.reset();
+        _workers.reset( new WorkerPool( numHelpers ) );
+    }
 
-            Particle p1;
-            int rv = 0;
-            switch (method)
-            {
-                case ADVECTION_METHOD::EULER:
-                    rv = _advectEuler( velocity, p0, dt, p1 ); break;
-                case ADVECTION_METHOD::RK4:
-                    rv = _advectRK4(   velocity, p0, dt, p1 ); break;
-            }
-            if( rv != 0 )   // Advection wasn't successful for some reason...
-            {
-                break;
-            }
-            else            // Advection successful, keep the new particle.
-            {
-                happened = true;
-                s.push_back( p1 );
-                p0 = std::move( p1 );
-            }
-        }   // Finish the while loop to advect one particle to a time
+    // Streams vary wildly in how much work they take, so rather than giving
+    // each thread a fixed share, threads repeatedly grab the next small chunk
+    // of streams until none are left. Chunks are small enough that threads 
+    // finishing early pick up the remaining work of the slow ones.
+    const size_t chunk = std::max( size_t(1), numStreams / (numThreads * 32) );
+    std::atomic<size_t> next( 0 );
+    std::atomic<bool>   happened( false );
 
-        streamIdx++;
+    std::function<void()> worker = [&]()
+    {
+        bool local = false;
+        for( size_t begin = next.fetch_add( chunk ); begin < numStreams; 
+             begin = next.fetch_add( chunk ) )
+        {
+            const size_t end = std::min( begin + chunk, numStreams );
+            for( size_t i = begin; i < end; i++ )
+                if( func( i ) )
+                    local = true;
+        }
+        if( local )
+            happened = true;
+    };
 
-    }   // Finish the for loop to advect all particles to a time
+    _workers->Run( worker );    // the calling thread does its share too
 
-    if( happened )
-        return ADVECT_HAPPENED;
-    else
-        return 0;
+    return happened;
 }
 
 
@@ -272,6 +471,44 @@ Advection::CalculateParticleValues( Field* scalar, bool skipNonZero )
 }
 
 
+int
+Advection::CalculateNewParticleValues( Field* scalar )
+{
+    if( _valuedCount.size() != _streams.size() )
+        _valuedCount.assign( _streams.size(), 0 );
+
+    size_t fewestValued = _streams.empty() ? 0 : _valuedCount[0];
+    size_t mostSteps    = 0;
+    for( size_t s = 0; s < _streams.size(); s++ )
+    {
+        fewestValued = std::min( fewestValued, _valuedCount[s] );
+        mostSteps    = std::max( mostSteps,    _streams[s].size() );
+    }
+
+    // Same order as CalculateParticleValues(), but starting from the first new step
+    for( size_t i = fewestValued; i < mostSteps; i++ )
+    {
+        for( size_t s = 0; s < _streams.size(); s++ )
+        {
+            if( i < _valuedCount[s] || i >= _streams[s].size() )
+                continue;
+            auto& p = _streams[s][i];
+            if( p.IsSpecial() || p.value != 0.0f )
+                continue;
+            float value;
+            int rv = scalar->GetScalar( p.time, p.location, value, false );
+            if( rv == 0 )
+                p.value = value;
+        }
+    }
+
+    for( size_t s = 0; s < _streams.size(); s++ )
+        _valuedCount[s] = _streams[s].size();
+
+    return 0;
+}
+
+
 int
 Advection::CalculateParticleProperties( Field* scalar )
 {
@@ -509,6 +746,243 @@ Advection::InputStreamsGnuplot( const std::string& filename )
     return 0;
 }
 
+int
+Advection::OutputStreamsBinaryMaxPart( const std::string&  filename, 
+                                       size_t              maxPart,
+                                       bool                append,
+                                       const std::string&  metadata ) const
+{
+    // Same particles as OutputStreamsGnuplotMaxPart(), with the separators in between
+    std::vector<size_t> numPart( _streams.size(), 0 );
+    for( size_t s = 0; s < _streams.size(); s++ )
+    {
+        size_t count = 0;
+        size_t i     = 0;
+        for( ; i < _streams[s].size() && count < maxPart; i++ )
+            if( !_streams[s][i].IsSpecial() )
+                count++;
+        numPart[s] = i;
+    }
+
+    return _outputStreamsBinary( filename, numPart, append, metadata );
+}
+
+int
+Advection::OutputStreamsBinaryMaxTime( const std::string&  filename,
+                                       float               timeStamp,
+                                       bool                append,
+                                       const std::string&  metadata ) const
+{
+    // Same particles as OutputStreamsGnuplotMaxTime(), with the separators in between
+    std::vector<size_t> numPart( _streams.size(), 0 );
+    for( size_t s = 0; s < _streams.size(); s++ )
+    {
+        size_t i = 0;
+        for( ; i < _streams[s].size(); i++ )
+            if( _streams[s][i].time > timeStamp )
+                break;
+        numPart[s] = i;
+    }
+
+    return _outputStreamsBinary( filename, numPart, append, metadata );
+}
+
+int
+Advection::_outputStreamsBinary( const std::string&          filename,
+                                 const std::vector<size_t>&  numPart,
+                                 bool                        append,
+                                 const std::string&          metadata ) const
+{
+    if( filename.empty() )
+        return FILE_ERROR;
+
+    std::FILE* f = std::fopen( filename.c_str(), append ? "ab" : "wb" );
+    if( f == nullptr )
+        return FILE_ERROR;
+
+    std::vector<uint64_t> offsets( 1, 0 );
+    uint32_t numProp = 0;
+    for( size_t s = 0; s < _streams.size(); s++ )
+    {
+        offsets.push_back( offsets.back() + numPart[s] );
+        for( size_t i = 0; i < numPart[s]; i++ )
+            numProp = std::max( numProp, uint32_t(_streams[s][i].GetNumOfProperties()) );
+    }
+
+    uint64_t numStreams = _streams.size();
+    uint64_t numTotal   = offsets.back();
+    uint64_t metaBytes  = metadata.size();
+
+    char header[ binaryHeaderSize ];
+    char* ptr = header;
+    std::memcpy( ptr, binaryMagic,    8 );  ptr += 8;
+    std::memcpy( ptr, &binaryVersion, 4 );  ptr += 4;
+    std::memcpy( ptr, &numProp,       4 );  ptr += 4;
+    std::memcpy( ptr, &numStreams,    8 );  ptr += 8;
+    std::memcpy( ptr, &numTotal,      8 );  ptr += 8;
+    std::memcpy( ptr, &metaBytes,     8 );
+
+    const char zeros[8] = { 0 };
+    size_t metaPad = pad8( binaryHeaderSize + metadata.size() ) - binaryHeaderSize - metadata.size();
+    bool   ok      = std::fwrite( header, 1, binaryHeaderSize, f ) == binaryHeaderSize &&
+                     std::fwrite( metadata.data(), 1, metadata.size(), f ) == metadata.size() &&
+                     std::fwrite( zeros, 1, metaPad, f ) == metaPad &&
+                     std::fwrite( offsets.data(), sizeof(uint64_t), offsets.size(), f ) == offsets.size();
+
+    // Write one array at a time, through a large staging buffer
+    std::vector<float> buf;
+    buf.reserve( binaryWriteBuffer );
+    auto flush = [&]()
+    {
+        ok  = ok && std::fwrite( buf.data(), sizeof(float), buf.size(), f ) == buf.size();
+        buf.clear();
+    };
+
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    for( uint32_t c = 0; c < 5 + numProp && ok; c++ )
+    {
+        for( size_t s = 0; s < _streams.size(); s++ )
+        {
+            for( size_t i = 0; i < numPart[s]; i++ )
+            {
+                const auto& p = _streams[s][i];
+                float v;
+                if( c < 3 )
+                    v = p.location[c];
+                else if( c == 3 )
+                    v = p.time;
+                else if( c == 4 )
+                    v = p.value;
+                else 
+                    v = int(c - 5) < p.GetNumOfProperties() ? p.RetrieveProperty( c - 5 ) : nan;
+                buf.push_back( v );
+                if( buf.size() == binaryWriteBuffer )
+                    flush();
+            }
+        }
+    }
+    flush();
+
+    size_t dataPad = pad8( numTotal * sizeof(float) * (5 + numProp) ) - 
+                     numTotal * sizeof(float) * (5 + numProp);
+    ok = ok && std::fwrite( zeros, 1, dataPad, f ) == dataPad;
+
+    if( std::fclose( f ) != 0 )
+        ok = false;
+
+    return ok ? 0 : FILE_ERROR;
+}
+
+bool
+Advection::IsStreamsBinary( const std::string& filename )
+{
+    std::FILE* f = std::fopen( filename.c_str(), "rb" );
+    if( f == nullptr )
+        return false;
+
+    char magic[8];
+    bool is = std::fread( magic, 1, 8, f ) == 8 && std::memcmp( magic, binaryMagic, 8 ) == 0;
+    std::fclose( f );
+
+    return is;
+}
+
+int
+Advection::InputStreamsBinary( const std::string& filename )
+{
+    // Map the file, or read it where mapping isn't available
+    const char*         addr = nullptr;
+    size_t              len  = 0;
+    std::vector<char>   contents;
+#ifndef WIN32
+    int fd = open( filename.c_str(), O_RDONLY );
+    if( fd < 0 )
+        return FILE_ERROR;
+    struct stat statbuf;
+    if( fstat( fd, &statbuf ) < 0 || statbuf.st_size == 0 )
+    {
+        close( fd );
+        return FILE_ERROR;
+    }
+    len = statbuf.st_size;
+    void* map = mmap( NULL, len, PROT_READ, MAP_SHARED, fd, 0 );
+    close( fd );
+    if( map == MAP_FAILED )
+        return FILE_ERROR;
+    addr = static_cast<const char*>( map );
+#else
+    std::ifstream ifs( filename, std::ios::binary );
+    if( !ifs.is_open() )
+        return FILE_ERROR;
+    contents.assign( std::istreambuf_iterator<char>( ifs ), std::istreambuf_iterator<char>() );
+    addr = contents.data();
+    len  = contents.size();
+#endif
+
+    std::vector<Particle> newSeeds;
+    bool   ok  = len > 0;
+    size_t pos = 0;
+    while( ok && pos < len )
+    {
+        if( len - pos < binaryHeaderSize || std::memcmp( addr + pos, binaryMagic, 8 ) != 0 )
+        {
+            ok = false;
+            break;
+        }
+
+        uint32_t version, numProp;
+        uint64_t numStreams, numTotal, metaBytes;
+        const char* ptr = addr + pos + 8;
+        std::memcpy( &version,    ptr, 4 );  ptr += 4;
+        std::memcpy( &numProp,    ptr, 4 );  ptr += 4;
+        std::memcpy( &numStreams, ptr, 8 );  ptr += 8;
+        std::memcpy( &numTotal,   ptr, 8 );  ptr += 8;
+        std::memcpy( &metaBytes,  ptr, 8 );
+        if( version != binaryVersion || metaBytes > len || numStreams > len || numTotal > len )
+        {
+            ok = false;
+            break;
+        }
+
+        // Locate the arrays, making sure they are all inside of the file
+        size_t offsetsPos = pos + pad8( binaryHeaderSize + metaBytes );
+        size_t arraysPos  = offsetsPos + (numStreams + 1) * sizeof(uint64_t);
+        size_t arraysLen  = numTotal * sizeof(float) * (5 + size_t(numProp));
+        if( arraysPos > len || arraysLen > len - arraysPos )
+        {
+            ok = false;
+            break;
+        }
+
+        // Copy values out rather than casting, so nothing depends on the
+        // alignment of the mapping.
+        const char* arrays = addr + arraysPos;
+        for( uint64_t i = 0; i < numTotal; i++ )
+        {
+            float v[4];
+            for( int c = 0; c < 4; c++ )
+                std::memcpy( &v[c], arrays + (c * numTotal + i) * sizeof(float), sizeof(float) );
+            if( std::isnan( v[3] ) )  // separator
+                continue;
+            newSeeds.emplace_back( v, v[3] );
+        }
+
+        pos = arraysPos + pad8( arraysLen );
+    }
+
+#ifndef WIN32
+    munmap( const_cast<char*>( addr ), len );
+#endif
+
+    if( !ok )
+        return FILE_ERROR;
+
+    if( newSeeds.size() > 0 )
+        this->UseSeedParticles( newSeeds );
+
+    return 0;
+}
+
 size_t 
 Advection::GetNumberOfStreams() const
 {
@@ -552,6 +1026,8 @@ Advection::ResetParticleValues()
     for( auto& stream : _streams )
         for( auto& part : stream )
             part.value = 0.0f;
+
+    _valuedCount.assign( _streams.size(), 0 );
 }
 
 void
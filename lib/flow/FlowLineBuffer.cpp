@@ -0,0 +1,119 @@
+#include "vapor/FlowLineBuffer.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace flow;
+
+void
+FlowLineBuffer::Reset()
+{
+    _streams.clear();
+    _maxTime      = 0.0;
+    _maxParticles = 0;
+}
+
+void
+FlowLineBuffer::Update( const Advection* adv, double maxTime, size_t maxParticles )
+{
+    size_t numOfStreams = adv->GetNumberOfStreams();
+
+    bool startOver = _streams.size() != numOfStreams || 
+                     maxTime < _maxTime || maxParticles < _maxParticles;
+    for( size_t s = 0; s < _streams.size() && !startOver; s++ )
+        if( _streams[s].consumed > adv->GetStreamAt(s).size() )
+            startOver = true;
+    if( startOver )
+    {
+        _streams.clear();
+        _streams.resize( numOfStreams );
+    }
+    _maxTime      = maxTime;
+    _maxParticles = maxParticles;
+
+    for( size_t s = 0; s < numOfStreams; s++ )
+    {
+        const auto& particles = adv->GetStreamAt( s );
+        auto&       stream    = _streams[s];
+        size_t      sn        = std::min( particles.size(), maxParticles );
+
+        // When the last particle of a stream leaves a periodic volume, Advection 
+        // wraps it around and inserts a separator before it. If that particle was
+        // already added, take it back and visit it again after the separator.
+        if( stream.open && stream.consumed > 0 && particles[ stream.consumed-1 ].IsSpecial() )
+        {
+            auto& line = stream.lines.back();
+            line.vertices.pop_back();
+            line.times.pop_back();
+            if( line.vertices.empty() )
+                stream.lines.pop_back();
+            stream.open = false;
+        }
+
+        for( ; stream.consumed < sn; stream.consumed++ )
+        {
+            const auto& p = particles[ stream.consumed ];
+            if( p.IsSpecial() )         // a separator ends the current line
+            {
+                stream.open = false;
+                continue;
+            }
+
+            // Particles are in time order, so stop at the first one that's too late.
+            if( p.time > maxTime )
+                break;
+
+            if( !stream.open )
+            {
+                stream.lines.emplace_back();
+                stream.open = true;
+            }
+            auto& line = stream.lines.back();
+            line.vertices.push_back( {p.location, p.value} );
+            line.times.push_back( p.time );
+        }
+    }
+}
+
+void
+FlowLineBuffer::Assemble( double minTime, std::vector<Vertex>& vertices,
+                          std::vector<int>& sizes ) const
+{
+    vertices.clear();
+    sizes.clear();
+    vertices.reserve( GetNumOfSamples() );
+
+    for( const auto& stream : _streams )
+    {
+        for( const auto& line : stream.lines )
+        {
+            // Samples are in time order, so the ones to skip are at the front.
+            size_t first = std::lower_bound( line.times.cbegin(), line.times.cend(), minTime ) 
+                           - line.times.cbegin();
+            size_t svn   = line.vertices.size() - first;
+            if( svn < 2 )
+                continue;
+
+            const Vertex* sv = line.vertices.data() + first;
+            glm::vec3 prep( -glm::normalize(sv[1].p - sv[0].p) + sv[0].p );
+            glm::vec3 post(  glm::normalize(sv[svn-1].p - sv[svn-2].p) + sv[svn-1].p );
+
+            size_t vn = vertices.size();
+            vertices.resize( vn + svn + 2 );
+            vertices[vn] = {prep, sv[0].v};
+            std::memcpy( vertices.data() + vn + 1, sv, sizeof(Vertex) * svn );
+            vertices[vn + svn + 1] = {post, sv[svn-1].v};
+
+            sizes.push_back( svn + 2 );
+        }
+    }
+}
+
+size_t
+FlowLineBuffer::GetNumOfSamples() const
+{
+    size_t num = 0;
+    for( const auto& stream : _streams )
+        for( const auto& line : stream.lines )
+            num += line.vertices.size();
+    return num;
+}
@@ -1,4 +1,5 @@
-#include <sstream>
+#include <algorithm>
+#include <atomic>
 
 #include "vapor/VaporField.h"
 #include "vapor/ConstantGrid.h"
@@ -6,30 +7,77 @@
 
 using namespace flow;
 
+namespace {
+    // Snapshot ids are unique across all VaporField instances, so that ids 
+    // remembered by a thread never match a different field.
+    std::atomic<uint64_t> nextGeneration( 1 );
+
+    // Query coordinates for Grid methods, reused to avoid an allocation 
+    // on every sample.
+    const std::vector<double>& toCoords( const glm::vec3& pos )
+    {
+        static thread_local std::vector<double> coords( 3 );
+        coords[0] = pos.x;
+        coords[1] = pos.y;
+        coords[2] = pos.z;
+        return coords;
+    }
+};
+
 // Constructor
 VaporField::VaporField( size_t cache_limit )
+          : _cacheLimit( cache_limit ),
+            _generation( nextGeneration++ )
 { }
 
 
+// Destructor
+VaporField::~VaporField()
+{
+    _invalidate();
+}
+
+
+bool
+VaporField::ResolvedStep::Sample( const glm::vec3& pos, float* values ) const
+{
+    const std::vector<double>& coords = toCoords( pos );
+    bool hasMissing = false;
+    for( int i = 0; i < numGrids; i++ )
+    {
+        values[i] = grids[i]->GetValue( coords );
+        if( values[i] == missingValues[i] )
+            hasMissing = true;
+    }
+    return !hasMissing;
+}
+
+
+bool
+VaporField::ResolvedStep::InsideGrid( const glm::vec3& pos ) const
+{
+    const std::vector<double>& coords = toCoords( pos );
+    for( int i = 0; i < numGrids; i++ )
+        if( !grids[i]->InsideGrid( coords ) )
+            return false;
+    return true;
+}
+
+
 bool
 VaporField::InsideVolumeVelocity( float time, const glm::vec3& pos ) const
 {
-    const std::vector<double> coords{ pos.x, pos.y, pos.z };
-    const VAPoR::Grid* grid = nullptr;
+    StepPtr step;
     VAssert( _isReady() );
 
     // In case of steady field, we only check a specific time step
     if( IsSteady )
     {
-        size_t currentTS = _params->GetCurrentTimestep();
-        for( auto& v : VelocityNames )
-        {
-            grid = _getAGrid( currentTS, v );
-            if( grid == nullptr )
-                return false;
-            if( !grid->InsideGrid( coords ) )
-                return false;
-        }
+        step = _getStep( _currentTS, false );
+        if( step == nullptr )
+            return false;
+        if( !step->InsideGrid( pos ) )
+            return false;
     }
     else    // we check two time steps
     {
@@ -44,26 +92,20 @@ VaporField::InsideVolumeVelocity( float time, const glm::vec3& pos ) const
             return false;
 
         // Then test if pos is inside of time step "floor"
-        for( auto& v : VelocityNames )
-        {
-            grid = _getAGrid( floor, v );
-            if( grid == nullptr )
-                return false;
-            if( !grid->InsideGrid( coords ) )
-                return false;
-        }
+        step = _getStep( floor, false );
+        if( step == nullptr )
+            return false;
+        if( !step->InsideGrid( pos ) )
+            return false;
 
         // If time is larger than _timestamps[floor], we also need to test _timestamps[floor+1]
         if( time > _timestamps[floor] )
         {
-            for( auto& v : VelocityNames )
-            {
-                grid = _getAGrid( floor + 1, v );
-                if( grid == nullptr )
-                    return false;
-                if( !grid->InsideGrid( coords ) )
-                    return false;
-            }
+            step = _getStep( floor + 1, false );
+            if( step == nullptr )
+                return false;
+            if( !step->InsideGrid( pos ) )
+                return false;
         }
     }
 
@@ -79,18 +121,16 @@ VaporField::InsideVolumeScalar( float time, const glm::vec3& pos ) const
     if( ScalarName.empty() )
         return true;
 
-    const std::vector<double> coords{ pos.x, pos.y, pos.z };
-    const VAPoR::Grid* grid = nullptr;
+    StepPtr step;
     VAssert( _isReady() );
 
     // In case of steady field, we only check a specific time step
     if( IsSteady )
     {
-        size_t currentTS = _params->GetCurrentTimestep();
-        grid = _getAGrid( currentTS, ScalarName );
-        if( grid == nullptr )
+        step = _getStep( _currentTS, true );
+        if( step == nullptr )
             return false;
-        if( !grid->InsideGrid( coords ) )
+        if( !step->InsideGrid( pos ) )
             return false;
     }
     else    // we check two time steps
@@ -105,19 +145,19 @@ VaporField::InsideVolumeScalar( float time, const glm::vec3& pos ) const
         if( rv != 0 ) return false;
 
         // Then test if pos is inside of time step "floor"
-        grid = _getAGrid( floor, ScalarName );
-        if( grid == nullptr )
+        step = _getStep( floor, true );
+        if( step == nullptr )
             return false;
-        if( !grid->InsideGrid( coords ) )
+        if( !step->InsideGrid( pos ) )
             return false;
 
         // If time is larger than _timestamps[floor], we also need to test _timestamps[floor+1]
         if( time > _timestamps[floor] )
         {
-            grid = _getAGrid( floor + 1, ScalarName );
-            if( grid == nullptr )
+            step = _getStep( floor + 1, true );
+            if( step == nullptr )
                 return false;
-            if( !grid->InsideGrid( coords ) )
+            if( !step->InsideGrid( pos ) )
                 return false;
         }
     }
@@ -127,22 +167,19 @@ VaporField::InsideVolumeScalar( float time, const glm::vec3& pos ) const
 
 int VaporField::GetVelocityIntersection( size_t ts, glm::vec3& minxyz, glm::vec3& maxxyz ) const
 {
-    const VAPoR::Grid* grid = nullptr;
     std::vector<double> min[3], max[3];
 
-    // For each velocity variables
-    for( int i = 0; i < 3; i++ )
+    StepPtr step = _getStep( ts, false );
+    if( step == nullptr )
     {
-        grid = _getAGrid( ts, VelocityNames[i] );
-        if( grid == nullptr )
-        {
-            Wasp::MyBase::SetErrMsg("Vector field not available at requested time step!");
-            return GRID_ERROR;
-        }
-        else
-            grid->GetUserExtents( min[i], max[i] );
+        Wasp::MyBase::SetErrMsg("Vector field not available at requested time step!");
+        return GRID_ERROR;
     }
 
+    // For each velocity variables
+    for( int i = 0; i < 3; i++ )
+        step->grids[i]->GetUserExtents( min[i], max[i] );
+
     minxyz = glm::vec3 ( min[0][0], min[0][1], min[0][2] );
     maxxyz = glm::vec3 ( max[0][0], max[0][1], max[0][2] );
 
@@ -161,35 +198,22 @@ int
 VaporField::GetVelocity( float time, const glm::vec3& pos, glm::vec3& velocity,
                          bool  checkInsideVolume ) const
 {
-    const std::vector<double> coords{ pos.x, pos.y, pos.z };
-    const VAPoR::Grid* grid = nullptr;
-
     // First make sure the query positions are inside of the volume
     if( checkInsideVolume )
         if( !InsideVolumeVelocity( time, pos ) )
             return OUT_OF_FIELD; 
 
-    // Retrieve the missing value and velocity multiplier 
-    const float mult = _params->GetVelocityMultiplier();
-    glm::vec3 missingV( 0.0f ); // stores missing values for 3 velocity variables
+    const float mult = _velocityMult;
     velocity = glm::vec3( 0.0f );
 
     if( IsSteady )
     {
-        size_t currentTS = _params->GetCurrentTimestep();
-        for( int i = 0; i < 3; i++ )
-        {
-            grid = _getAGrid( currentTS, VelocityNames[i] );
-            if( grid == nullptr )
-                return GRID_ERROR;
-            velocity[i] = grid->GetValue( coords );
-            missingV[i] = grid->GetMissingValue();
-        }
-        auto hasMissing = glm::equal( velocity, missingV );
-        if( glm::any( hasMissing ) )
-            velocity = glm::vec3( 0.0f );
-        else
-            velocity *= mult;
+        StepPtr step = _getStep( _currentTS, false );
+        if( step == nullptr )
+            return GRID_ERROR;
+        glm::vec3 v;
+        if( step->Sample( pos, &v[0] ) )
+            velocity = v * mult;
     }
     else
     {
@@ -204,20 +228,11 @@ VaporField::GetVelocity( float time, const glm::vec3& pos, glm::vec3& velocity,
 
         // Find the velocity values at floor time step
         glm::vec3 floorVelocity, ceilVelocity;
-        for( int i = 0; i < 3; i++ )
-        {
-            grid = _getAGrid( floorTS, VelocityNames[i] ); 
-            if( grid == nullptr )
-                return GRID_ERROR;
-            floorVelocity[i] = grid->GetValue( coords );
-            missingV[i]      = grid->GetMissingValue();
-        }
-        auto hasMissing = glm::equal( floorVelocity, missingV );
-        if( glm::any( hasMissing ) )
-        {
-            velocity = glm::vec3( 0.0f );
+        StepPtr step = _getStep( floorTS, false );
+        if( step == nullptr )
+            return GRID_ERROR;
+        if( !step->Sample( pos, &floorVelocity[0] ) )
             return 0;
-        }
 
         if( time == _timestamps[floorTS] )
         {
@@ -227,20 +242,11 @@ VaporField::GetVelocity( float time, const glm::vec3& pos, glm::vec3& velocity,
         {
             // We need to make sure there aren't duplicate time stamps 
             VAssert( _timestamps[floorTS+1] > _timestamps[floorTS] );
-            for( int i = 0; i < 3; i++ )
-            {
-                grid = _getAGrid( floorTS + 1, VelocityNames[i] );
-                if( grid == nullptr )
-                    return GRID_ERROR;
-                ceilVelocity[i] = grid->GetValue( coords );
-                missingV[i]     = grid->GetMissingValue();
-            }
-            hasMissing = glm::equal( ceilVelocity, missingV );
-            if( glm::any( hasMissing ) )
-            {
-                velocity = glm::vec3( 0.0f );
+            step = _getStep( floorTS + 1, false );
+            if( step == nullptr )
+                return GRID_ERROR;
+            if( !step->Sample( pos, &ceilVelocity[0] ) )
                 return 0;
-            }
             
             float weight = (time - _timestamps[floorTS]) / 
                            (_timestamps[floorTS+1] - _timestamps[floorTS]);
@@ -264,20 +270,18 @@ VaporField::GetScalar( float time, const glm::vec3& pos, float& scalar,
         if( !InsideVolumeScalar( time, pos ) )
             return OUT_OF_FIELD;
 
-    const std::vector<double> coords{ pos.x, pos.y, pos.z };
-    const VAPoR::Grid* grid = nullptr;
+    StepPtr step;
 
     if( IsSteady )
     {
-        size_t currentTS = _params->GetCurrentTimestep();
-        grid = _getAGrid( currentTS, ScalarName );
-        if( grid == nullptr )
+        step = _getStep( _currentTS, true );
+        if( step == nullptr )
             return GRID_ERROR;
-        float gridV = grid->GetValue( coords );
-        if( gridV  == grid->GetMissingValue() )
-            scalar  = 0.0f;
-        else
+        float gridV;
+        if( step->Sample( pos, &gridV ) )
             scalar  = gridV;
+        else
+            scalar  = 0.0f;
     }
     else
     {
@@ -289,11 +293,11 @@ VaporField::GetScalar( float time, const glm::vec3& pos, float& scalar,
         size_t floorTS = 0;
         int rv  = LocateTimestamp( time, floorTS );
         VAssert( rv == 0 );
-        grid = _getAGrid( floorTS, ScalarName );
-        if( grid == nullptr )
+        step = _getStep( floorTS, true );
+        if( step == nullptr )
             return GRID_ERROR;
-        float floorScalar = grid->GetValue( coords );
-        if( floorScalar  == grid->GetMissingValue() )
+        float floorScalar;
+        if( !step->Sample( pos, &floorScalar ) )
         {
             scalar = 0.0f;
             return 0;
@@ -303,11 +307,11 @@ VaporField::GetScalar( float time, const glm::vec3& pos, float& scalar,
             scalar = floorScalar;
         else
         {
-            grid = _getAGrid( floorTS + 1, ScalarName );
-            if( grid == nullptr )
+            step = _getStep( floorTS + 1, true );
+            if( step == nullptr )
                 return GRID_ERROR;
-            float ceilScalar = grid->GetValue( coords );
-            if( ceilScalar  == grid->GetMissingValue() )
+            float ceilScalar;
+            if( !step->Sample( pos, &ceilScalar ) )
             {
                 scalar = 0.0f;
                 return 0;
@@ -342,6 +346,8 @@ VaporField::AssignDataManager( VAPoR::DataMgr* dmgr )
     _timestamps.resize( timeCoords.size() );
     for( size_t i = 0; i < timeCoords.size(); i++ )
         _timestamps[i] = timeCoords[i];
+
+    _invalidate();
 }
 
 
@@ -352,15 +358,54 @@ VaporField::UpdateParams( const VAPoR::FlowParams* p )
 
     // Update properties of this Field
     IsSteady = p->GetIsSteady();
-    ScalarName = p->GetColorMapVariableName();
+    std::string scalarName = p->GetColorMapVariableName();
+    std::string velocityNames[3];
     auto velNames = p->GetFieldVariableNames();
     for( int i = 0; i < 3; i++ )
     {
         if( i < velNames.size() )
-            VelocityNames[i] = velNames.at(i);
+            velocityNames[i] = velNames.at(i);
         else
-            VelocityNames[i] = "";  // make sure it keeps an empty string,
+            velocityNames[i] = "";  // make sure it keeps an empty string,
     }                               // instead of whatever left from before.
+
+    std::vector<double> extMin, extMax;
+    p->GetBox()->GetExtents( extMin, extMax );
+    int    refLevel  = p->GetRefinementLevel();
+    int    compLevel = p->GetCompressionLevel();
+    _currentTS       = p->GetCurrentTimestep();
+    _velocityMult    = p->GetVelocityMultiplier();
+
+    // Resolved grids stay valid unless anything that decides which grids 
+    // are sampled has changed. They are looked up by time step, so a new 
+    // current time step does not invalidate them.
+    bool changed = scalarName != ScalarName || extMin != _extMin || extMax != _extMax ||
+                   refLevel != _refLevel || compLevel != _compLevel || 
+                   DefaultZ != _defaultZ;
+    for( int i = 0; i < 3; i++ )
+        changed = changed || velocityNames[i] != VelocityNames[i];
+
+    if( changed )
+    {
+        ScalarName = scalarName;
+        for( int i = 0; i < 3; i++ )
+            VelocityNames[i] = velocityNames[i];
+        _extMin    = extMin;
+        _extMax    = extMax;
+        _refLevel  = refLevel;
+        _compLevel = compLevel;
+        _defaultZ  = DefaultZ;
+        _invalidate();
+    }
+}
+
+
+void
+VaporField::_invalidate()
+{
+    const std::lock_guard<std::recursive_mutex> lock( _recentStepsMutex );
+    _recentSteps.clear();
+    _generation = nextGeneration++;
 }
 
 
@@ -397,10 +442,26 @@ int VaporField::GetNumberOfTimesteps() const
 }
 
 
+bool VaporField::SupportsConcurrentQueries() const
+{
+    // Derived variables are computed by Python scripts when their grids are
+    // resolved, which may happen on any thread that samples this field.
+    if( _datamgr == nullptr )
+        return true;
+    if( !ScalarName.empty() && _datamgr->IsVariableDerived( ScalarName ) )
+        return false;
+    for( int i = 0; i < 3; i++ )
+        if( !VelocityNames[i].empty() && _datamgr->IsVariableDerived( VelocityNames[i] ) )
+            return false;
+
+    return true;
+}
+
+
 int VaporField::CalcDeltaTFromCurrentTimeStep( float& delT ) const
 {
     VAssert( _isReady() );
-    const auto currentTS = _params->GetCurrentTimestep();
+    const auto currentTS = _currentTS;
     const auto timestamp = _timestamps.at( currentTS );
 
     // Let's find the intersection of 3 velocity components.
@@ -437,7 +498,7 @@ int VaporField::CalcDeltaTFromCurrentTimeStep( float& delT ) const
     // Let's find the maximum velocity on these sampled locations
     // Note that we want the raw velocity, which will be the value
     // returned by GetVelocity() divided by the velocity multiplier.
-    float mult =  _params->GetVelocityMultiplier();
+    float mult =  _velocityMult;
     if(   mult == 0.0f )
           mult =  1.0f;
     const float mult1o = 1.0f / mult;
@@ -464,49 +525,124 @@ int VaporField::CalcDeltaTFromCurrentTimeStep( float& delT ) const
 }
 
 
-const VAPoR::Grid* VaporField::_getAGrid( size_t timestep, const std::string& varName ) const
+VaporField::StepPtr VaporField::_getStep( size_t timestep, bool isScalar ) const
 {
-    // First check if we have the requested grid in our cache.
-    // If it exists, return the grid directly.
-    std::vector<double>            extMin, extMax;
-    _params->GetBox()->GetExtents( extMin, extMax );
-    int refLevel    = _params->GetRefinementLevel();
-    int compLevel   = _params->GetCompressionLevel();
-    std::string key = _paramsToString( timestep, varName, refLevel, compLevel, extMin, extMax );
-
-    const auto& grid_wrapper = _recentGrids.query( key );
-
-    if( grid_wrapper != nullptr ) {
-        const VAPoR::Grid* grid = grid_wrapper->grid();
-        // Is this a GrownGrid? 
-        const VAPoR::GrownGrid* ggrid = dynamic_cast<const VAPoR::GrownGrid*>(grid);
-        if( ggrid == nullptr )
-            return grid;
-        else    // Need to test if the DefaultZ value has changed.
+    // Each thread remembers the steps it used last. Only weak references 
+    // are kept, so a thread never extends the lifetime of a step, which 
+    // also holds a data manager lock on its grids.
+    struct RecentStep
+    {
+        uint64_t                            generation = 0;
+        size_t                              timestep   = 0;
+        bool                                isScalar   = false;
+        std::weak_ptr<const ResolvedStep>   step;
+    };
+    static thread_local RecentStep threadSteps[4];
+    static thread_local int        nextThreadStep = 0;
+
+    // _generation only changes in UpdateParams() or AssignDataManager(),
+    // which are never called while the field is being sampled.
+    const uint64_t generation = _generation;
+    for( auto& r : threadSteps )
+    {
+        if( r.generation == generation && r.timestep == timestep && r.isScalar == isScalar )
         {
-            if( ggrid->GetDefaultZ() == this->DefaultZ )    // DefaultZ is the same! 
-                return grid;
-            // If DefaultZ has changed, a new GrownGrid will be constructed 
-            // with the new DefaultZ value.
+            StepPtr step = r.step.lock();
+            if( step != nullptr )
+                return step;
         }
     }
 
+    StepPtr step;
+    {
+        // Advection queries grids from multiple threads. Both the cache and the 
+        // data manager must only be accessed by one thread at a time.
+        const std::lock_guard<std::recursive_mutex> lock( _recentStepsMutex );
+
+        auto it = std::find_if( _recentSteps.begin(), _recentSteps.end(), 
+                                [timestep, isScalar]( const StepPtr& s )
+                                { return s->timestep == timestep && s->isScalar == isScalar; } );
+        if( it != _recentSteps.end() )
+        {
+            step = *it;
+            _recentSteps.splice( _recentSteps.begin(), _recentSteps, it );
+        }
+        else
+        {
+            step = _resolveStep( timestep, isScalar );
+            if( step == nullptr )
+                return nullptr;
+            _recentSteps.push_front( step );
+
+            // Evict the least recently used steps, but keep two for 
+            // temporal interpolation.
+            size_t numGrids = 0;
+            for( const auto& s : _recentSteps )
+                numGrids += s->numGrids;
+            while( _recentSteps.size() > 2 && numGrids > _cacheLimit )
+            {
+                numGrids -= _recentSteps.back()->numGrids;
+                _recentSteps.pop_back();
+            }
+        }
+    }
+
+    RecentStep& r = threadSteps[ nextThreadStep ];
+    nextThreadStep = (nextThreadStep + 1) % 4;
+    r.generation = generation;
+    r.timestep   = timestep;
+    r.isScalar   = isScalar;
+    r.step       = step;
+
+    return step;
+}
+
+
+VaporField::StepPtr VaporField::_resolveStep( size_t timestep, bool isScalar ) const
+{
+    // A step may be released last by any thread, long after it has been 
+    // evicted. Destroying it unlocks its grids in the data manager, so that
+    // must be serialized as well.
+    std::shared_ptr<ResolvedStep> step( new ResolvedStep, [this]( ResolvedStep* s )
+    {
+        const std::lock_guard<std::recursive_mutex> lock( _recentStepsMutex );
+        delete s;
+    } );
+    step->timestep = timestep;
+    step->isScalar = isScalar;
+    step->numGrids = isScalar ? 1 : 3;
+
+    for( int i = 0; i < step->numGrids; i++ )
+    {
+        const std::string& varName = isScalar ? ScalarName : VelocityNames[i];
+        step->wrappers[i].reset( _getAGrid( timestep, varName ) );
+        if( step->wrappers[i] == nullptr )
+            return nullptr;
+        step->grids[i]         = step->wrappers[i]->grid();
+        step->missingValues[i] = step->grids[i]->GetMissingValue();
+    }
+
+    return step;
+}
+
+
+const VaporField::GridWrapper* VaporField::_getAGrid( size_t timestep, const std::string& varName ) const
+{
     //
-    // There's no such grid in our cache! 
-    // Let's create a new grid by doing one of the three things, and then put it in the cache.
+    // Create a new grid by doing one of the three things:
     // 1) create it by ourselves if a ConstantGrid is required, or
     // 2) ask for it from the data manager,
     // 3) query a 2D grid and grow it to be a GrownGrid.
     //
     VAPoR::Grid* grid = nullptr;
-    if( key == _constantGridZero )  // need a ConstantGrid
+    if( varName.empty() )   // need a ConstantGrid
     {
         grid = new VAPoR::ConstantGrid( 0.0f, 3 );
     }
     else
     {
-        grid = _datamgr->GetVariable( timestep, varName, refLevel, compLevel,
-                                      extMin, extMax, true );
+        grid = _datamgr->GetVariable( timestep, varName, _refLevel, _compLevel,
+                                      _extMin, _extMax, true );
     }
     if( grid == nullptr )
     {
@@ -515,20 +651,17 @@ const VAPoR::Grid* VaporField::_getAGrid( size_t timestep, const std::string& va
     }
 
     // Now we have this grid, but also put it in a GridWrapper so 
-    // 1) it will be properly deleted, and 2) it is stored in our cache
-    // where its ownership is kept.
+    // it will be properly deleted.
     // We also make it become a GrownGrid if it's 2D in nature.
     int dim = _datamgr->GetVarTopologyDim( varName );
     if( dim == 3 || dim == 0 )  // dim == 0 happens when varName is empty.
     {
-        _recentGrids.insert( key, new GridWrapper(grid, _datamgr) );
-        return grid;
+        return new GridWrapper( grid, _datamgr );
     }
     else if( dim == 2 )
     {
-        VAPoR::GrownGrid* ggrid = new VAPoR::GrownGrid( grid, _datamgr, DefaultZ );
-        _recentGrids.insert( key, new GridWrapper(ggrid, _datamgr) );
-        return ggrid;
+        VAPoR::GrownGrid* ggrid = new VAPoR::GrownGrid( grid, _datamgr, _defaultZ );
+        return new GridWrapper( ggrid, _datamgr );
     }
     else
     {
@@ -536,28 +669,3 @@ const VAPoR::Grid* VaporField::_getAGrid( size_t timestep, const std::string& va
         return nullptr;
     }
 }
-
-
-std::string 
-VaporField::_paramsToString(  size_t currentTS,               const std::string& var, 
-                              int refLevel,                   int compLevel, 
-                              const std::vector<double>& min, const std::vector<double>& max ) const
-{
-    // In case of an empty variable name, we generate a string that represents a
-    // ConstantGrid with zeros, no matter what other parameters are.
-    if( var.empty() )
-    {
-        return _constantGridZero;
-    }
-    else
-    {
-        std::ostringstream oss;
-        std::string space( "  " );
-        oss << currentTS << space << var << space << refLevel << space << compLevel << space ;
-        for( size_t i = 0; i < min.size(); i++ )
-            oss << min[i] << space;
-        for( size_t i = 0; i < max.size(); i++ )
-            oss << max[i] << space;
-        return oss.str();
-    }
-}
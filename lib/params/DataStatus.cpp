@@ -68,6 +68,7 @@ DataStatus::DataStatus(size_t cacheSize, int nThreads) {
 
 	_cacheSize = cacheSize;
 	_nThreads = nThreads;
+	_metadataCacheDir.clear();
 
 	_dataMgrs.clear();
 	_timeCoords.clear();
@@ -104,6 +105,11 @@ int DataStatus::Open(
 		myOptions.push_back(dm0->GetMapProjection());
 	}
 
+	if (! _metadataCacheDir.empty()) {
+		myOptions.push_back("-metadata_cache");
+		myOptions.push_back(_metadataCacheDir);
+	}
+
 	int rc = dataMgr->Initialize(files, myOptions);
 	if (rc < 0) {
 		delete dataMgr;
@@ -21,8 +21,10 @@
 #include <sstream>
 #include <fstream>
 #include <algorithm>
+#include <set>
 
 
+#include <vapor/CFuncs.h>
 #include <vapor/ParamsMgr.h>
 #include <vapor/ViewpointParams.h>
 #include <vapor/regionparams.h>
@@ -1180,10 +1182,7 @@ bool ParamsMgr::undoRedoHelper() {
 
 	// Get top of **undo** stack
 	//
-	const XmlNode *newNode = _ssave.GetTop(description);
-	if (! newNode) {
-		newNode = _ssave.GetBase();
-	}
+	XmlNode *newNode = _ssave.GetTop(description);
 	if (! newNode) return(false);	// nothing to undo - shouldnt get here
 
 	// Need to disable state saving so the undo itself doesn't trigger
@@ -1195,6 +1194,7 @@ bool ParamsMgr::undoRedoHelper() {
 	// Load the new Xml tree (which destroys the old one)
 	//
 	LoadState(newNode);
+	delete newNode;
 
 	// Restore state saving
 	//
@@ -1233,13 +1233,21 @@ ParamsMgr::PMgrStateSave::PMgrStateSave(int stackSize) :
 	_state0 = NULL;
 	_undoStack.clear();
 	_redoStack.clear();
+	_lastSaveNodes = 0;
+	_lastSaveTime = 0.0;
 }
 
 ParamsMgr::PMgrStateSave::~PMgrStateSave() {
 
 	cleanStack(0, _undoStack);
 	cleanStack(0, _redoStack);
-	if (_state0) delete _state0;
+}
+
+void ParamsMgr::PMgrStateSave::Rebase() {
+	VAssert(_rootNode);
+
+	size_t ncopied = 0;
+	_state0 = makeState(_rootNode, _state0, ncopied);
 }
 
 
@@ -1261,44 +1269,19 @@ void ParamsMgr::PMgrStateSave::Save(
 		return;
 	}
 
-
-
-	const XmlNode *topNode = NULL;
-	string s;
-	topNode = GetTop(s);
-	if (topNode && (*topNode == *_rootNode)) {
-
-		// Don't save tree if no changes
-		//
-		return;
-	}
-	
+	// Inside a group the state is saved by the last EndGroup()
+	//
 	if (! _groups.empty()) {
 		return;
 	}
 
-	if (! _state0) {
-		_state0 = new XmlNode(*_rootNode);
-	}
-
-	// Delete oldest elements if needed
-	// 
-	cleanStack(_stackSize, _undoStack);
-
-	// It not inside a group push this element onto the stack
-	//
-	_undoStack.push_back(make_pair(description, new XmlNode(*_rootNode)));
 //#define DEBUG
 #ifdef	DEBUG
 	cout << "ParamsMgr::PMgrStateSave::Save() : saving node " << 
 		node->GetTag() << " : " << description << endl;
 #endif
 
-	// Clear redo stack 
-	//
-	cleanStack(0, _redoStack);
-
-	emitStateChange();
+	saveState(description);
 }
 
 void ParamsMgr::PMgrStateSave::BeginGroup(string description) {
@@ -1324,55 +1307,185 @@ void ParamsMgr::PMgrStateSave::EndGroup() {
 	//
 	if (_groups.size()) return;	
 
-	const XmlNode *topNode = NULL;
-	string s;
-	topNode = GetTop(s);
+#ifdef	DEBUG
+	cout << "ParamsMgr::PMgrStateSave::EndGroup() : saving " 
+		<< " : " << desc << endl;
+#endif
+
+	saveState(desc);
+}
+
+void ParamsMgr::PMgrStateSave::saveState(const string &description) {
+
+	double t0 = Wasp::GetTime();
+
+	// Snapshot the tree, sharing the nodes that are unchanged since the
+	// most recently saved state
+	//
+	const State &prev = _undoStack.size() ? _undoStack.back().second : _state0;
+	size_t ncopied = 0;
+	State state = makeState(_rootNode, prev, ncopied);
+
+	_lastSaveNodes = ncopied;
+	_lastSaveTime = Wasp::GetTime() - t0;
+
+	if (_undoStack.size() && state == _undoStack.back().second) {
 
-	if (topNode && (*topNode == *_rootNode)) {
 		// Don't save tree if no changes
 		//
 		return;
 	}
 
 	if (! _state0) {
-		_state0 = new XmlNode(*_rootNode);
+		_state0 = state;
 	}
 
-#ifdef	DEBUG
-	cout << "ParamsMgr::PMgrStateSave::EndGroup() : saving " 
-		<< " : " << desc << endl;
-#endif
-
 	// Delete oldest elements if needed
 	// 
 	cleanStack(_stackSize, _undoStack);
 
+	_undoStack.push_back(make_pair(description, state));
+
 	// Clear redo stack 
 	//
 	cleanStack(0, _redoStack);
 
-	_undoStack.push_back(make_pair(desc, new XmlNode(*_rootNode)));
-
 	emitStateChange();
 }
 
+ParamsMgr::PMgrStateSave::State ParamsMgr::PMgrStateSave::makeState(
+	const XmlNode *node, const State &prev, size_t &ncopied
+) const {
+	VAssert(node);
+
+	size_t nchildren = node->GetNumChildren();
+	vector <State> children(nchildren);
+
+	// prev is returned as is if neither the node nor any of its
+	// descendants changed
+	//
+	bool unchanged = prev && prev->children.size() == nchildren;
+
+	for (size_t i=0; i<nchildren; i++) {
+		const XmlNode *child = node->GetChild(i);
+		const string &tag = child->GetTag();
+
+		// Match children to their previous snapshots by tag. Children
+		// are rarely reordered, so try the same position first.
+		//
+		State prevChild;
+		if (prev) {
+			const vector <State> &prevChildren = prev->children;
+			if (
+				i < prevChildren.size() && 
+				prevChildren[i]->content->GetTag() == tag
+			) {
+				prevChild = prevChildren[i];
+			}
+			for (size_t j=0; ! prevChild && j<prevChildren.size(); j++) {
+				if (prevChildren[j]->content->GetTag() == tag) {
+					prevChild = prevChildren[j];
+				}
+			}
+		}
+
+		children[i] = makeState(child, prevChild, ncopied);
+
+		if (unchanged && children[i] != prev->children[i]) unchanged = false;
+	}
+
+	bool sameContent = prev && prev->content->EqualsIgnoringChildren(*node);
+	if (unchanged && sameContent) return(prev);
+
+	std::shared_ptr <StateNode> state = std::make_shared <StateNode>();
+	if (sameContent) {
+		state->content = prev->content;
+	}
+	else {
+		state->content.reset(node->CloneWithoutChildren());
+		ncopied++;
+	}
+	state->children = std::move(children);
+
+	return(state);
+}
+
 void ParamsMgr::PMgrStateSave::IntermediateChange()
 {
     emitIntermediateStateChange();
 }
 
-const XmlNode *ParamsMgr::PMgrStateSave::GetTop(
+XmlNode *ParamsMgr::PMgrStateSave::GetTop(
 	string &description
 ) const {
 	VAssert(_rootNode);
 	description.clear();
 
-	if (! _undoStack.size()) return(NULL);
+	State state = _state0;
+	if (_undoStack.size()) {
+		const pair <string, State> &p1 = _undoStack.back();
 
-	const pair <string, XmlNode *> &p1 = _undoStack.back();
+		description = p1.first;
+		state = p1.second;
+	}
+	if (! state) return(NULL);
 
-	description = p1.first;
-	return(p1.second);
+	// Rebuild the tree top down. Each snapshot node holds a childless
+	// copy of its XmlNode, so AddChild() copies only that node.
+	//
+	XmlNode *root = new XmlNode(*state->content);
+
+	vector <pair <XmlNode *, const StateNode *>> todo;
+	todo.push_back(make_pair(root, state.get()));
+	while (todo.size()) {
+		XmlNode *node = todo.back().first;
+		const StateNode *snode = todo.back().second;
+		todo.pop_back();
+
+		for (const State &child : snode->children) {
+			XmlNode *newChild = node->AddChild(*child->content);
+			todo.push_back(make_pair(newChild, child.get()));
+		}
+	}
+
+	return(root);
+}
+
+void ParamsMgr::PMgrStateSave::GetStats(
+	size_t &nodes, size_t &bytes, size_t &lastSaveNodes,
+	double &lastSaveTime
+) const {
+	nodes = 0;
+	bytes = 0;
+	lastSaveNodes = _lastSaveNodes;
+	lastSaveTime = _lastSaveTime;
+
+	// Count each snapshot node, and each node content, once no matter
+	// how many saved states share it
+	//
+	vector <const StateNode *> todo;
+	if (_state0) todo.push_back(_state0.get());
+	for (const auto &p : _undoStack) todo.push_back(p.second.get());
+	for (const auto &p : _redoStack) todo.push_back(p.second.get());
+
+	std::set <const StateNode *> visited;
+	std::set <const XmlNode *> contents;
+	while (todo.size()) {
+		const StateNode *snode = todo.back();
+		todo.pop_back();
+
+		if (! visited.insert(snode).second) continue;
+
+		bytes += sizeof(*snode) + snode->children.capacity() * sizeof(State);
+		if (contents.insert(snode->content.get()).second) {
+			nodes++;
+			bytes += snode->content->GetNumBytes();
+		}
+
+		for (const State &child : snode->children) {
+			todo.push_back(child.get());
+		}
+	}
 }
 
 bool ParamsMgr::PMgrStateSave::Undo() {
@@ -1380,7 +1493,7 @@ bool ParamsMgr::PMgrStateSave::Undo() {
 
 	if (! _undoStack.size()) return(false);
 
-	pair <string, XmlNode *> &p1 = _undoStack.back();
+	pair <string, State> &p1 = _undoStack.back();
 
 	// Delete oldest elements if needed
 	// 
@@ -1400,7 +1513,7 @@ bool ParamsMgr::PMgrStateSave::Redo() {
 
 	if (! _redoStack.size()) return(false);
 
-	pair <string, XmlNode *> &p1 = _redoStack.back();
+	pair <string, State> &p1 = _redoStack.back();
 
 	// Delete oldest elements if needed
 	// 
@@ -1425,18 +1538,13 @@ void ParamsMgr::PMgrStateSave::Clear() {
 
 void ParamsMgr::PMgrStateSave::cleanStack(
 	int maxN,
-	std::deque <std::pair <string, XmlNode *>> &s
+	std::deque <std::pair <string, State>> &s
 ) {
 
-	// Delete oldest elements if needed
+	// Delete oldest elements if needed. Snapshot nodes are freed when
+	// no remaining state shares them.
 	// 
 	while (s.size() > maxN) {
-		pair <string, XmlNode *> &p1 = s.front();
-
-		if (p1.second) {
-			delete p1.second;
-		}
-
 		s.pop_front();
 	}
 }
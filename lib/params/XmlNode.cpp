@@ -210,12 +210,53 @@ XmlNode &XmlNode::operator=( const XmlNode& rhs ) {
 	return(*this);
 }
 
-bool XmlNode::operator==(const XmlNode &rhs) const {
+bool XmlNode::EqualsIgnoringChildren(const XmlNode &rhs) const {
+	if (_tag != rhs._tag) return(false);
 	if (_longmap != rhs._longmap) return(false);
 	if (_doublemap != rhs._doublemap) return(false);
 	if (_stringmap != rhs._stringmap) return(false);
 	if (_attrmap != rhs._attrmap) return(false);
-	if (_tag != rhs._tag) return(false);
+
+	return(true);
+}
+
+XmlNode *XmlNode::CloneWithoutChildren() const {
+	XmlNode *node = new XmlNode();
+
+	node->_tag = _tag;
+	node->_attrmap = _attrmap;
+	node->_longmap = _longmap;
+	node->_doublemap = _doublemap;
+	node->_stringmap = _stringmap;
+	node->_asciiLimit = _asciiLimit;
+
+	return(node);
+}
+
+size_t XmlNode::GetNumBytes() const {
+	size_t nbytes = sizeof(*this) + _tag.size();
+
+	// Approximate each map entry by its key and value payloads
+	//
+	for (const auto &itr : _longmap) {
+		nbytes += itr.first.size() + itr.second.size() * sizeof(long);
+	}
+	for (const auto &itr : _doublemap) {
+		nbytes += itr.first.size() + itr.second.size() * sizeof(double);
+	}
+	for (const auto &itr : _stringmap) {
+		nbytes += itr.first.size() + itr.second.size();
+	}
+	for (const auto &itr : _attrmap) {
+		nbytes += itr.first.size() + itr.second.size();
+	}
+	nbytes += _children.capacity() * sizeof(XmlNode *);
+
+	return(nbytes);
+}
+
+bool XmlNode::operator==(const XmlNode &rhs) const {
+	if (! EqualsIgnoringChildren(rhs)) return(false);
 
 	if (_children.size() != rhs._children.size()) return(false);
 	for (int i=0; i<_children.size(); i++) {
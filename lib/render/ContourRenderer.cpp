@@ -21,6 +21,11 @@
 #include <sstream>
 #include <string>
 #include <iterator>
+#include <algorithm>
+#include <limits>
+#include <thread>
+#include <atomic>
+#include <cmath>
 
 #include <vapor/glutil.h>    // Must be included first!!!
 
@@ -40,6 +45,11 @@
 
 using namespace VAPoR;
 
+namespace {
+    // Number of consecutive cells whose value range is kept together
+    const size_t TileSize = 4096;
+}
+
 #pragma pack(push, 4)
 struct ContourRenderer::VertexData {
     float x, y, z;
@@ -127,76 +137,169 @@ int ContourRenderer::_buildCache()
         return -1;
     }
     
-	double mv = grid->GetMissingValue();
+	float mv = grid->GetMissingValue();
     float Z0 = GetDefaultZ(_dataMgr, _cacheParams.ts);
-
-    Grid::ConstCellIterator it = grid->ConstCellBegin(
-		_cacheParams.boxMin, _cacheParams.boxMax
-	);
-
+    
+    // The contours crossing a cell are found by bisection
+    vector<float> sortedContours;
+    for (double c : contours)
+        if (!std::isnan(c))
+            sortedContours.push_back(c);
+    std::sort(sortedContours.begin(), sortedContours.end());
+    
+    // A contour crosses a cell or tile whose values range from lo to hi if
+    // lo <= contour < hi
+    auto crosses = [&sortedContours](float lo, float hi) {
+        auto c = std::lower_bound(sortedContours.begin(), sortedContours.end(), lo);
+        return c != sortedContours.end() && *c < hi;
+    };
+    
+    const vector<size_t> cellDims = grid->GetCellDimensions();
+    size_t nCells = 1;
+    for (size_t d : cellDims)
+        nCells *= d;
+    size_t nTiles = (nCells + TileSize - 1) / TileSize;
+    
+    // The value ranges of the tiles only depend on the grid, so they are
+    // kept for when just the contour values change
+    std::ostringstream key;
+    key.precision(17);
+    key << _cacheParams.varName << " " << _cacheParams.ts << " " << _cacheParams.level << " " << _cacheParams.lod;
+    for (double d : _cacheParams.boxMin) key << " " << d;
+    for (double d : _cacheParams.boxMax) key << " " << d;
+    bool haveRanges = key.str() == _tileRangesKey && _tileMin.size() == nTiles;
+    if (!haveRanges) {
+        _tileRangesKey = key.str();
+        _tileMin.assign(nTiles, std::numeric_limits<float>::max());
+        _tileMax.assign(nTiles, std::numeric_limits<float>::lowest());
+    }
+    
     size_t maxNodes = grid->GetMaxVertexPerCell();
     size_t nodeDim = grid->GetNodeDimensions().size();
-	size_t *nodes = (size_t*)alloca(sizeof(size_t) * maxNodes * nodeDim);
-
     size_t coordDim = grid->GetGeometryDim();
-
-	float *values = (float*)alloca(sizeof(float) * maxNodes);
-	double *coords = (double*)alloca(sizeof(double) * maxNodes * coordDim);
-
-    Grid::ConstCellIterator end = grid->ConstCellEnd();
-    for (; it != end; ++it)
-    {
-        const vector<size_t> &cell = *it;
-		int numNodes;
-        grid->GetCellNodes(cell.data(), nodes, numNodes);
-        
-		bool hasMissing = false;
-        for (int i = 0; i < numNodes; i++)
-        {
-            grid->GetUserCoordinates(&nodes[i*nodeDim], &coords[i*coordDim]);
-            //values[i] = grid->GetValue(&coords[i*coordDim]);
-            values[i] = grid->GetValueAtIndex(&nodes[i*nodeDim]);
-			if (values[i] == mv) {
-				hasMissing = true;
-			}
-        }
-		if (hasMissing) continue;
+    size_t boxDim = std::min(_cacheParams.boxMin.size(), coordDim);
+    
+    // Tiles of consecutive cells are handed out to the threads one at a
+    // time, and each thread appends the line segments it finds to its 
+    // own buffer
+    int nThreads = Grid::GetNumBlockThreads(_dataMgr->GetNumThreads());
+    vector<vector<VertexData>> threadVertices(nThreads);
+    std::atomic<size_t> nextTile(0);
+    
+    auto worker = [&](int thread) {
+        vector<size_t> cell(cellDims.size());
+        vector<size_t> nodes(maxNodes * nodeDim);
+        vector<float> values(maxNodes);
+        vector<double> coords(maxNodes * coordDim);
+        vector<VertexData> &out = threadVertices[thread];
         
-        for (int ci = 0; ci != contours.size(); ci++)
-        {
-            for (int a=numNodes-1, b=0; b < numNodes; a++, b++)
-            {
-                if (a == numNodes)
-                    a = 0;
-                float contour = contours[ci];
+        size_t tile;
+        while ((tile = nextTile++) < nTiles) {
+            if (haveRanges && !crosses(_tileMin[tile], _tileMax[tile]))
+                continue;
+            
+            float tileMin = std::numeric_limits<float>::max();
+            float tileMax = std::numeric_limits<float>::lowest();
+            size_t end = std::min(nCells, (tile + 1) * TileSize);
+            for (size_t c = tile * TileSize; c < end; c++) {
+                size_t l = c;
+                for (int i = 0; i < cellDims.size(); i++) {
+                    cell[i] = l % cellDims[i];
+                    l /= cellDims[i];
+                }
                 
-                if ((values[a] <= contour && values[b] <= contour)
-                    || (values[a] > contour && values[b] > contour))
+                int numNodes;
+                if (!grid->GetCellNodes(cell.data(), nodes.data(), numNodes))
                     continue;
                 
-                float t = (contour - values[a])/(values[b] - values[a]);
-                float v[3];
-                v[0] = coords[a*coordDim+0] + t * (coords[b*coordDim+0] - coords[a*coordDim+0]);
-                v[1] = coords[a*coordDim+1] + t * (coords[b*coordDim+1] - coords[a*coordDim+1]);
-                v[2] = Z0;
-                
-                if (heightGrid)
+                bool hasMissing = false;
+                float lo = std::numeric_limits<float>::max();
+                float hi = std::numeric_limits<float>::lowest();
+                for (int i = 0; i < numNodes; i++)
                 {
-                    //float aHeight = heightGrid->GetValue(&coords[a*coordDim]);
-                    //float bHeight = heightGrid->GetValue(&coords[b*coordDim]);
-                    float aHeight = heightGrid->GetValueAtIndex(&nodes[a*nodeDim]);
-                    float bHeight = heightGrid->GetValueAtIndex(&nodes[b*nodeDim]);
-                    v[2] = aHeight + t * (bHeight - aHeight);
+                    values[i] = grid->GetValueAtIndex(&nodes[i*nodeDim]);
+                    if (values[i] == mv) {
+                        hasMissing = true;
+                        break;
+                    }
+                    lo = std::min(lo, values[i]);
+                    hi = std::max(hi, values[i]);
                 }
+                if (hasMissing) continue;
+                
+                tileMin = std::min(tileMin, lo);
+                tileMax = std::max(tileMax, hi);
+                if (!crosses(lo, hi)) continue;
                 
-                vertices.push_back({
-                    v[0], v[1], v[2],
-                    contour
-                });
+                // Only cells that lie inside the box are drawn
+                bool inside = true;
+                for (int i = 0; i < numNodes && inside; i++)
+                {
+                    grid->GetUserCoordinates(&nodes[i*nodeDim], &coords[i*coordDim]);
+                    for (int d = 0; d < boxDim; d++)
+                        if (coords[i*coordDim+d] < _cacheParams.boxMin[d] || coords[i*coordDim+d] > _cacheParams.boxMax[d])
+                            inside = false;
+                }
+                if (!inside) continue;
                 
+                auto ci = std::lower_bound(sortedContours.begin(), sortedContours.end(), lo);
+                for (; ci != sortedContours.end() && *ci < hi; ++ci)
+                {
+                    float contour = *ci;
+                    for (int a=numNodes-1, b=0; b < numNodes; a++, b++)
+                    {
+                        if (a == numNodes)
+                            a = 0;
+                        
+                        if ((values[a] <= contour && values[b] <= contour)
+                            || (values[a] > contour && values[b] > contour))
+                            continue;
+                        
+                        float t = (contour - values[a])/(values[b] - values[a]);
+                        float v[3];
+                        v[0] = coords[a*coordDim+0] + t * (coords[b*coordDim+0] - coords[a*coordDim+0]);
+                        v[1] = coords[a*coordDim+1] + t * (coords[b*coordDim+1] - coords[a*coordDim+1]);
+                        v[2] = Z0;
+                        
+                        if (heightGrid)
+                        {
+                            float aHeight = heightGrid->GetValueAtIndex(&nodes[a*nodeDim]);
+                            float bHeight = heightGrid->GetValueAtIndex(&nodes[b*nodeDim]);
+                            v[2] = aHeight + t * (bHeight - aHeight);
+                        }
+                        
+                        out.push_back({
+                            v[0], v[1], v[2],
+                            contour
+                        });
+                    }
+                }
+            }
+            
+            // Each tile is visited by only one thread
+            if (!haveRanges) {
+                _tileMin[tile] = tileMin;
+                _tileMax[tile] = tileMax;
             }
         }
-    }
+    };
+    
+    vector<std::thread> threads;
+    for (int t = 1; t < nThreads; t++)
+        threads.push_back(std::thread(worker, t));
+    worker(0);
+    for (auto &thread : threads)
+        thread.join();
+    
+    size_t nVertices = 0;
+    for (const auto &tv : threadVertices)
+        nVertices += tv.size();
+    vertices.reserve(nVertices);
+    for (const auto &tv : threadVertices)
+        vertices.insert(vertices.end(), tv.begin(), tv.end());
+    
+    delete grid;
+    if (heightGrid) delete heightGrid;
     
     _nVertices = vertices.size();
     glBindVertexArray(_VAO);
@@ -425,6 +425,10 @@ void ControlExec::SetCacheSize(size_t sizeMB) {
     _dataStatus->SetCacheSize(sizeMB);
 }
 
+void ControlExec::SetMetadataCacheDir(string dir) {
+    _dataStatus->SetMetadataCacheDir(dir);
+}
+
 int ControlExec::activateClassRenderers(
 	string vizName, string dataSetName, string pClassName, 
 	vector <string> instNames, bool reportErrs
@@ -4,6 +4,8 @@
 #include <iostream>
 #include <cstring>
 #include <random>
+#include <limits>
+#include <sstream>
 
 #define GL_ERROR     -20
 
@@ -118,24 +120,7 @@ FlowRenderer::_paintGL( bool fast )
 
     if( params->GetNeedFlowlineOutput() )
     {
-        // In case of steady flow, output the number of particles that 
-        // equals to the advection steps plus one.
-        // In the case of unsteady flow, output particles that are up to 
-        // the advection time step.
-        if( params->GetIsSteady() )
-        {
-            rv = _advection.OutputStreamsGnuplotMaxPart( 
-                                params->GetFlowlineOutputFilename(),
-                                params->GetSteadyNumOfSteps() + 1,
-                                false );
-        }
-        else
-        {
-            rv = _advection.OutputStreamsGnuplotMaxTime( 
-                                params->GetFlowlineOutputFilename(),
-                                _timestamps.at( params->GetCurrentTimestep() ),
-                                false );
-        }
+        rv = _outputFlowlines( &_advection, params, false );
         if( rv != 0 )
         {
                 MyBase::SetErrMsg("Output flow lines wrong!");
@@ -144,20 +129,7 @@ FlowRenderer::_paintGL( bool fast )
 
         if( _2ndAdvection )     // bi-directional advection
         {
-            if( params->GetIsSteady() )
-            {
-                rv = _2ndAdvection->OutputStreamsGnuplotMaxPart( 
-                                        params->GetFlowlineOutputFilename(), 
-                                        params->GetSteadyNumOfSteps() + 1,                    
-                                        true );
-            }
-            else
-            {
-                rv = _2ndAdvection->OutputStreamsGnuplotMaxTime(
-                                        params->GetFlowlineOutputFilename(),
-                                        _timestamps.at( params->GetCurrentTimestep() ),
-                                        true );
-            }
+            rv = _outputFlowlines( _2ndAdvection.get(), params, true );
             if( rv != 0 )
             {
                     MyBase::SetErrMsg("Output flow lines wrong!");
@@ -174,8 +146,13 @@ FlowRenderer::_paintGL( bool fast )
         return flow::PARAMS_ERROR;
     }
     
-    if (_velocityStatus != FlowStatus::UPTODATE || _colorStatus != FlowStatus::UPTODATE)
+    // Particles that are only added to existing streams can be appended to the 
+    // rendered lines, but everything else requires rebuilding them.
+    if (_velocityStatus == FlowStatus::SIMPLE_OUTOFDATE || _colorStatus == FlowStatus::SIMPLE_OUTOFDATE)
         _renderStatus = FlowStatus::SIMPLE_OUTOFDATE;
+    else if ((_velocityStatus == FlowStatus::TIME_STEP_OOD || _colorStatus == FlowStatus::TIME_STEP_OOD) &&
+             _renderStatus == FlowStatus::UPTODATE)
+        _renderStatus = FlowStatus::TIME_STEP_OOD;
     
 
     _velocityField.UpdateParams( params );
@@ -202,7 +179,7 @@ FlowRenderer::_paintGL( bool fast )
         /* Read seeds from a file is a special case, so we put it up front */
         if( _cache_seedGenMode == FlowSeedMode::LIST )
         {
-            rv = _advection.InputStreamsGnuplot( params->GetSeedInputFilename() );
+            rv = _inputSeeds( &_advection, params->GetSeedInputFilename() );
             if( rv != 0 )
             {
                 MyBase::SetErrMsg("Input seed list wrong!");
@@ -216,7 +193,7 @@ FlowRenderer::_paintGL( bool fast )
             }
             if( _2ndAdvection )     // bi-directional advection
             {
-                _2ndAdvection->InputStreamsGnuplot( params->GetSeedInputFilename() );
+                _inputSeeds( _2ndAdvection.get(), params->GetSeedInputFilename() );
                 rv = _updateAdvectionPeriodicity( _2ndAdvection.get() ); 
                 if( rv != 0 )
                 {
@@ -258,6 +235,7 @@ FlowRenderer::_paintGL( bool fast )
         }
 
         _advectionComplete = false;
+        _advectedTS        = 0;
         _velocityStatus = FlowStatus::UPTODATE;
     }
     else if( _velocityStatus == FlowStatus::TIME_STEP_OOD )
@@ -286,6 +264,12 @@ FlowRenderer::_paintGL( bool fast )
 
     if( !_advectionComplete )
     {
+        // Use as many advection threads as the data manager was configured
+        // with (see ControlExec::SetNumThreads()).
+        _advection.SetNumThreads( _dataMgr->GetNumThreads() );
+        if( _2ndAdvection )
+            _2ndAdvection->SetNumThreads( _dataMgr->GetNumThreads() );
+
         float deltaT = _cache_deltaT;
         rv = flow::ADVECT_HAPPENED;
 
@@ -319,14 +303,16 @@ FlowRenderer::_paintGL( bool fast )
         }
 
         /* Advection scheme 2: advect to a certain timestamp.
-         * This scheme is used for unsteady flow */
+         * This scheme is used for unsteady flow.
+         * Only the time intervals that haven't been advected yet are visited. */
         else
         {
-            for( int i = 1; i <= _cache_currentTS; i++ )
+            for( size_t i = _advectedTS + 1; i <= _cache_currentTS; i++ )
             {
                 rv = _advection.AdvectTillTime( &_velocityField, _timestamps.at(i-1), 
                                                 deltaT, _timestamps.at(i) );
             }
+            _advectedTS = std::max( _advectedTS, _cache_currentTS );
         }
 
         _advectionComplete = true;
@@ -335,9 +321,9 @@ FlowRenderer::_paintGL( bool fast )
 
     if( !_coloringComplete )
     {
-        rv = _advection.CalculateParticleValues( &_colorField, true );
+        rv = _advection.CalculateNewParticleValues( &_colorField );
         if( _2ndAdvection )     // bi-directional advection
-            rv = _2ndAdvection->CalculateParticleValues( &_colorField, true );
+            rv = _2ndAdvection->CalculateNewParticleValues( &_colorField );
         _coloringComplete = true;
     }
     
@@ -375,85 +361,106 @@ FlowRenderer::_paintGL( bool fast )
     return ret;
 }
 
+int
+FlowRenderer::_outputFlowlines( const flow::Advection* adv,
+                                const FlowParams*      params,
+                                bool                   append ) const
+{
+    const std::string filename = params->GetFlowlineOutputFilename();
+    const std::string binaryExt = ".vfl";
+    bool  binary = filename.size() >= binaryExt.size() &&
+                   filename.compare( filename.size() - binaryExt.size(), 
+                                     binaryExt.size(), binaryExt ) == 0;
+
+    // In case of steady flow, output the number of particles that 
+    // equals to the advection steps plus one.
+    // In the case of unsteady flow, output particles that are up to 
+    // the advection time step.
+    size_t maxPart = params->GetSteadyNumOfSteps() + 1;
+    float  maxTime = _timestamps.at( params->GetCurrentTimestep() );
+    if( !binary )
+    {
+        if( params->GetIsSteady() )
+            return adv->OutputStreamsGnuplotMaxPart( filename, maxPart, append );
+        else
+            return adv->OutputStreamsGnuplotMaxTime( filename, maxTime, append );
+    }
+
+    // Binary files also record what the flow lines were computed from.
+    // The second advection of bi-directional flow is integrated backward.
+    const auto velocity = params->GetFieldVariableNames();
+    bool  backward = append || params->GetFlowDirection() == 1;
+    std::ostringstream meta;
+    meta << "velocity = "           << velocity.at(0) << " " << velocity.at(1) 
+                                    << " " << velocity.at(2) << "\n";
+    meta << "value = "              << params->GetColorMapVariableName() << "\n";
+    meta << "steady = "             << params->GetIsSteady() << "\n";
+    if( params->GetIsSteady() )
+    {
+        meta << "steady_num_of_steps = " << params->GetSteadyNumOfSteps() << "\n";
+        meta << "integration = "    << (backward ? "backward" : "forward") << "\n";
+    }
+    meta << "current_timestep = "   << params->GetCurrentTimestep() << "\n";
+    meta << "current_time = "       << maxTime << "\n";
+    meta << "velocity_multiplier = "<< params->GetVelocityMultiplier() << "\n";
+    meta << "refinement_level = "   << params->GetRefinementLevel() << "\n";
+    meta << "compression_level = "  << params->GetCompressionLevel() << "\n";
+
+    if( params->GetIsSteady() )
+        return adv->OutputStreamsBinaryMaxPart( filename, maxPart, append, meta.str() );
+    else
+        return adv->OutputStreamsBinaryMaxTime( filename, maxTime, append, meta.str() );
+}
+
+int
+FlowRenderer::_inputSeeds( flow::Advection* adv, const std::string& filename ) const
+{
+    if( flow::Advection::IsStreamsBinary( filename ) )
+        return adv->InputStreamsBinary( filename );
+    else
+        return adv->InputStreamsGnuplot( filename );
+}
+
 int FlowRenderer::_renderAdvection(const flow::Advection* adv)
 {
     FlowParams *rp = dynamic_cast<FlowParams*>(GetActiveParams());
     
     if (_renderStatus != FlowStatus::UPTODATE) {
-        int nStreams = adv->GetNumberOfStreams();
-        
-        typedef struct {vec3 p; float v;} Vertex;
-        vector<Vertex> vertices;
-        vector<int> sizes;
-        vector<Vertex> sv;
-        
-        // If streams are larger than this then need to skip remaining
-        size_t maxSamples = rp->GetSteadyNumOfSteps() + 1;
+        if (_renderStatus == FlowStatus::SIMPLE_OUTOFDATE)
+            _lineBuffer.Reset();
         
-        // First calculate the starting time stamp. Copied from legacy.
-        double startingTime;
-        if (!_cache_isSteady) {
-            int pastNumOfTimeSteps = dynamic_cast<FlowParams*>(GetActiveParams())->GetPastNumOfTimeSteps();
+        // Steady streams are cut off after a number of samples, and
+        // unsteady ones at the current time step.
+        size_t maxSamples   = std::numeric_limits<size_t>::max();
+        double maxTime      = std::numeric_limits<double>::max();
+        double startingTime = std::numeric_limits<double>::lowest();
+        if (_cache_isSteady) {
+            maxSamples = rp->GetSteadyNumOfSteps() + 1;
+        } else {
+            // First calculate the starting time stamp. Copied from legacy.
+            int pastNumOfTimeSteps = rp->GetPastNumOfTimeSteps();
             startingTime = _timestamps[0];
             if( _cache_currentTS - pastNumOfTimeSteps > 0 )
                 startingTime = _timestamps[ _cache_currentTS - pastNumOfTimeSteps ];
+            maxTime = _timestamps.at(_cache_currentTS);
         }
         
-        for (int s = 0; s < nStreams; s++) {
-            const vector<flow::Particle> &stream = adv->GetStreamAt(s);
-            sv.clear();
-            int sn = stream.size();
-            if (_cache_isSteady)
-                sn = std::min(sn, (int)maxSamples);
-            
-            for (int i = 0; i < sn + 1; i++) {
-                // "IsSpecial" means don't render this sample.
-                if (i == sn || stream[i].IsSpecial()) {
-                    int svn = sv.size();
-                    
-                    if (svn < 2) {
-                        sv.clear();
-                        continue;
-                    }
-                    
-                    vec3 prep(-normalize(sv[1].p-sv[0].p) + sv[0].p);
-                    vec3 post( normalize(sv[svn-1].p-sv[svn-2].p) + sv[svn-1].p);
-                    
-                    size_t vn = vertices.size();
-                    vertices.resize(vn + svn + 2);
-                    vertices[vn] = {prep, sv[0].v};
-                    vertices[vertices.size()-1] = {post, sv[svn-1].v};
-                    
-                    memcpy(vertices.data() + vn + 1, sv.data(), sizeof(Vertex) * svn);
-                    
-                    sizes.push_back(svn+2);
-                    sv.clear();
-                } else {
-                    const flow::Particle &p = stream[i];
-                    
-                    if (_cache_isSteady) {
-                        sv.push_back({p.location, p.value});
-                    } else {
-                        if(p.time > _timestamps.at(_cache_currentTS))
-                            continue;
-                        if(p.time >= startingTime)
-                            sv.push_back({p.location, p.value});
-                    }
-                }
-            }
-            
-            _renderStatus = FlowStatus::UPTODATE;
-        }
+        _lineBuffer.Update(adv, maxTime, maxSamples);
+        
+        vector<flow::FlowLineBuffer::Vertex> vertices;
+        vector<int> sizes;
+        _lineBuffer.Assemble(startingTime, vertices, sizes);
 
         assert(glIsVertexArray(_VAO) == GL_TRUE);
         assert(glIsBuffer(_VBO) == GL_TRUE);
 
         glBindVertexArray(_VAO);
         glBindBuffer(GL_ARRAY_BUFFER, _VBO);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * vertices.size(), vertices.data(), GL_STREAM_DRAW);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(flow::FlowLineBuffer::Vertex) * vertices.size(), vertices.data(), GL_STREAM_DRAW);
         glBindBuffer(GL_ARRAY_BUFFER, 0);
         
         _streamSizes = sizes;
+        _renderStatus = FlowStatus::UPTODATE;
     }
     
     bool show_dir = rp->GetValueLong(FlowParams::RenderShowStreamDirTag, false);
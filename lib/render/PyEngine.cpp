@@ -3,6 +3,8 @@
 #include <vector>
 #include <map>
 #include <new>
+#include <limits>
+#include <algorithm>
 #include <vapor/utils.h>
 #include <vapor/DataMgrUtils.h>
 #include <vapor/PyEngine.h>
@@ -183,6 +185,102 @@ void grid2c(
 	}
 }
 
+// Copy a strided tile of a grid block into a contiguous buffer, setting
+// missing values to infinity like grid2c()
+//
+void copy_tile(
+	const float *src,
+	const vector <size_t> &dims,
+	const vector <size_t> &strides,
+	float mv,
+	float *dst
+) {
+	size_t nx = dims[0];
+	size_t ny = dims.size() > 1 ? dims[1] : 1;
+	size_t nz = dims.size() > 2 ? dims[2] : 1;
+	size_t sy = strides.size() > 1 ? strides[1] : 0;
+	size_t sz = strides.size() > 2 ? strides[2] : 0;
+
+	for (size_t k=0; k<nz; k++) {
+	for (size_t j=0; j<ny; j++) {
+		const float *srcptr = src + k*sz + j*sy;
+		for (size_t i=0; i<nx; i++) {
+			float v = srcptr[i];
+			*dst++ = v == mv ? std::numeric_limits<float>::infinity() : v;
+		}
+	}
+	}
+}
+
+// Convert dimensions and strides, in elements and ordered fastest varying
+// first, to NumPy's shape and byte strides, ordered slowest varying first
+//
+void np_shape(
+	const vector <size_t> &dims, const vector <size_t> &strides,
+	npy_intp *pyDims, npy_intp *pyStrides
+) {
+	size_t stride = 1;
+	for (int j=0; j<dims.size(); j++) {
+		pyDims[dims.size()-j-1] = dims[j];
+		pyStrides[dims.size()-j-1] = 
+			(strides.size() ? strides[j] : stride) * sizeof(float);
+		stride *= dims[j];
+	}
+}
+
+// Python code that decides whether the script in __vapor_script only
+// applies element-wise operations to its inputs. Anything it doesn't
+// recognize, e.g. indexing, reductions, keyword arguments, control
+// flow, or user defined functions, makes the script non-pointwise.
+//
+const char *pointwiseTestScript = 
+	"import ast\n"
+	"_ops = set([\n"
+	"	'abs', 'absolute', 'fabs', 'sign', 'negative', 'positive',\n"
+	"	'add', 'subtract', 'multiply', 'divide', 'true_divide',\n"
+	"	'floor_divide', 'power', 'float_power', 'mod', 'fmod', 'remainder',\n"
+	"	'sqrt', 'cbrt', 'square', 'reciprocal', 'exp', 'exp2', 'expm1',\n"
+	"	'log', 'log2', 'log10', 'log1p', 'sin', 'cos', 'tan', 'arcsin',\n"
+	"	'arccos', 'arctan', 'arctan2', 'hypot', 'sinh', 'cosh', 'tanh',\n"
+	"	'arcsinh', 'arccosh', 'arctanh', 'deg2rad', 'rad2deg', 'degrees',\n"
+	"	'radians', 'floor', 'ceil', 'trunc', 'rint', 'clip', 'minimum',\n"
+	"	'maximum', 'fmin', 'fmax', 'where', 'isnan', 'isinf', 'isfinite',\n"
+	"	'logical_and', 'logical_or', 'logical_not', 'logical_xor',\n"
+	"	'greater', 'greater_equal', 'less', 'less_equal', 'equal',\n"
+	"	'not_equal', 'float32', 'astype', 'pi', 'e', 'nan', 'inf'\n"
+	"])\n"
+	"_nodes = (\n"
+	"	ast.Module, ast.Expr, ast.Assign, ast.Name, ast.Load, ast.Store,\n"
+	"	ast.BinOp, ast.UnaryOp, ast.Compare, ast.Import, ast.alias,\n"
+	"	ast.unaryop, ast.cmpop\n"
+	")\n"
+	"_binops = (\n"
+	"	ast.Add, ast.Sub, ast.Mult, ast.Div, ast.FloorDiv, ast.Mod,\n"
+	"	ast.Pow, ast.BitAnd, ast.BitOr, ast.BitXor\n"
+	")\n"
+	"def _isPointwise(src):\n"
+	"	try:\n"
+	"		tree = ast.parse(src)\n"
+	"	except SyntaxError:\n"
+	"		return False\n"
+	"	for node in ast.walk(tree):\n"
+	"		if isinstance(node, ast.Attribute):\n"
+	"			if node.attr not in _ops: return False\n"
+	"		elif isinstance(node, ast.Call):\n"
+	"			if node.keywords: return False\n"
+	"			f = node.func\n"
+	"			if isinstance(f, ast.Name):\n"
+	"				if f.id not in ('abs', 'print'): return False\n"
+	"			elif not isinstance(f, ast.Attribute): return False\n"
+	"		elif isinstance(node, ast.operator):\n"
+	"			if not isinstance(node, _binops): return False\n"
+	"		elif type(node).__name__ in ('Num', 'Str', 'Constant'):\n"
+	"			pass\n"
+	"		elif not isinstance(node, _nodes):\n"
+	"			return False\n"
+	"	return True\n"
+	"__vapor_pointwise = _isPointwise(__vapor_script)\n";
+
 void get_var_info(
 	DataMgr *dataMgr,
 	const vector <Grid *> &gs, const vector <string> &varNames,
@@ -301,6 +399,7 @@ int PyEngine::AddFunction(
     }
 	Py_DECREF(retObj);
 	
+	bool pointwiseFlag = _isPointwise(script);
 
 	const string timeCoordVarName = _getTimeCoordVarName(inputVarNames);
 
@@ -310,7 +409,7 @@ int PyEngine::AddFunction(
 		DerivedPythonVar *dvar = new DerivedPythonVar(
 			vname, "", DC::XType::FLOAT, outputVarMeshes[i],
 			timeCoordVarName, true, inputVarNames, script, _dataMgr,
-			coordFlag
+			coordFlag, pointwiseFlag
 		);
 		dvars.push_back(dvar);
 
@@ -434,11 +533,47 @@ int PyEngine::Calculate(
 	VAssert (outputVarNames.size() == outputVarDims.size());
 	VAssert (outputVarNames.size() == outputVarArrays.size());
 
+//cout << "PyEngine::Calculate() " << script << endl;
+
+	PyObject* code = Py_CompileString(script.c_str(), "", Py_file_input);
+	if (! code) {
+		SetErrMsg(
+			"Py_CompileString() : %s", MyPython::Instance()->PyErr().c_str()
+		);
+		return -1;
+	}
+
+	// Arrays are contiguous
+	//
+	vector <vector <size_t> > inputVarStrides(inputVarNames.size());
+	vector <vector <size_t> > outputVarStrides(outputVarNames.size());
+
+	int rc = _calculate(
+		code, inputVarNames, inputVarDims, inputVarStrides, inputVarArrays,
+		outputVarNames, outputVarDims, outputVarStrides, outputVarArrays
+	);
+
+	Py_DECREF(code);
+
+	return(rc);
+}
+
+int PyEngine::_calculate(
+	PyObject *code,
+	const vector <string> &inputVarNames,
+	const vector <vector <size_t> > &inputVarDims,
+	const vector <vector <size_t> > &inputVarStrides,
+	const vector <float *> &inputVarArrays,
+	const vector <string> &outputVarNames,
+	const vector <vector <size_t> > &outputVarDims,
+	const vector <vector <size_t> > &outputVarStrides,
+	const vector <float *> &outputVarArrays
+) {
+	VAssert(code);
+
 	vector <string> allNames = inputVarNames;
 	allNames.insert(allNames.end(), outputVarNames.begin(), outputVarNames.end());
 
-//cout << "PyEngine::Calculate() " << script << endl;
-
     // Convert the input arrays and put into dictionary:
 	//
     PyObject* mainModule = PyImport_AddModule("__main__");
@@ -455,7 +590,9 @@ int PyEngine::Calculate(
 
 	// Copy arrays into python environment
 	//
-	int rc = _c2python(mainDict, inputVarNames, inputVarDims, inputVarArrays);
+	int rc = _c2python(
+		mainDict, inputVarNames, inputVarDims, inputVarStrides, inputVarArrays
+	);
 	if (rc<0) {
 		_cleanupDict(mainDict, inputVarNames);
 		return(-1);
@@ -463,21 +600,23 @@ int PyEngine::Calculate(
 
 	// Run the script
 	//
-	PyObject* retObj = PyRun_String(
-		script.c_str(),Py_file_input, mainDict, mainDict
-	);
+	PyObject* retObj = PyEval_EvalCode(code, mainDict, mainDict);
 
     if (!retObj){
 		SetErrMsg(
-			"PyRun_String() : %s", MyPython::Instance()->PyErr().c_str()
+			"PyEval_EvalCode() : %s", MyPython::Instance()->PyErr().c_str()
 		);
 		_cleanupDict(mainDict, inputVarNames);
 		return -1;
     }
+	Py_DECREF(retObj);
 
 	// Retrieve calculated arrays from python environment
 	//
-	rc = _python2c(mainDict, outputVarNames, outputVarDims, outputVarArrays);
+	rc = _python2c(
+		mainDict, outputVarNames, outputVarDims, outputVarStrides,
+		outputVarArrays
+	);
 	if (rc<0) {
 		_cleanupDict(mainDict, allNames);
 		return(-1);
@@ -506,23 +645,36 @@ void PyEngine::_cleanupDict(PyObject *mainDict, vector <string> keynames) {
 
 int PyEngine::_c2python(
 	PyObject *dict,
-	vector <string> inputVarNames,
-	vector <vector <size_t> > inputVarDims,
-	vector <float *> inputVarArrays
+	const vector <string> &inputVarNames,
+	const vector <vector <size_t> > &inputVarDims,
+	const vector <vector <size_t> > &inputVarStrides,
+	const vector <float *> &inputVarArrays
 ) {
 
 	npy_intp pyDims[3];
+	npy_intp pyStrides[3];
 	for (int i=0; i<inputVarNames.size(); i++) {
 		VAssert(inputVarDims[i].size() >= 1 && inputVarDims[i].size() <= 3);
 
 		const vector <size_t> &dims = inputVarDims[i];
-		for (int j=0; j<dims.size(); j++) {
-			pyDims[dims.size()-j-1] = dims[j];
-		}
+		const vector <size_t> &strides = inputVarStrides[i];
+		np_shape(dims, strides, pyDims, pyStrides);
+
+		// Views of caller owned memory are read-only, so a script can't
+		// modify e.g. the DataMgr's cache
+		//
+		int flags = strides.size() ? NPY_ARRAY_ALIGNED : NPY_ARRAY_CARRAY;
 
-		PyObject* pyArray = PyArray_SimpleNewFromData(
-			dims.size(), pyDims, NPY_FLOAT32, inputVarArrays[i]
+		PyObject* pyArray = PyArray_New(
+			&PyArray_Type, dims.size(), pyDims, NPY_FLOAT32, pyStrides,
+			inputVarArrays[i], 0, flags, NULL
 		);
+		if (! pyArray) {
+			SetErrMsg(
+				"PyArray_New() : %s", MyPython::Instance()->PyErr().c_str()
+			);
+			return -1;
+		}
 
 		PyObject* ky = Py_BuildValue("s",inputVarNames[i].c_str());
 		PyObject_SetItem(dict,ky,pyArray);
@@ -535,16 +687,20 @@ int PyEngine::_c2python(
 
 int PyEngine::_python2c(
 	PyObject *dict,
-	vector <string> outputVarNames,
-	vector <vector <size_t> > outputVarDims,
-	vector <float *> outputVarArrays
+	const vector <string> &outputVarNames,
+	const vector <vector <size_t> > &outputVarDims,
+	const vector <vector <size_t> > &outputVarStrides,
+	const vector <float *> &outputVarArrays
 ) {
+	npy_intp dstDims[3];
+	npy_intp dstStrides[3];
 	for (int i=0; i<outputVarNames.size(); i++) {
 		const string &vname = outputVarNames[i];
 
 		PyObject* ky = Py_BuildValue("s",vname.c_str());
 
 		PyObject* o = PyDict_GetItem(dict, ky);
+		Py_DECREF(ky);
 		if (! o || ! PyArray_CheckExact(o)) {
 			SetErrMsg("Variable %s not produced by script",vname.c_str());
 			return -1;
@@ -572,19 +728,72 @@ int PyEngine::_python2c(
 			}
         }
 
-		float *dataArray = (float*)PyArray_DATA(varArray);
-		size_t nelements = VProduct(dims);
+		// Wrap the destination in an array and let NumPy do the copy,
+		// which handles non-contiguous script outputs and strided
+		// destinations
+		//
+		np_shape(dims, outputVarStrides[i], dstDims, dstStrides);
+
+		PyObject *dstArray = PyArray_New(
+			&PyArray_Type, dims.size(), dstDims, NPY_FLOAT32, dstStrides,
+			outputVarArrays[i], 0, NPY_ARRAY_ALIGNED | NPY_ARRAY_WRITEABLE,
+			NULL
+		);
+		if (! dstArray) {
+			SetErrMsg(
+				"PyArray_New() : %s", MyPython::Instance()->PyErr().c_str()
+			);
+			return -1;
+		}
 
-		float *outArray = outputVarArrays[i];
-		for (size_t j=0; j<nelements; j++) {
-			outArray[j] = dataArray[j];
+		int rc = PyArray_CopyInto((PyArrayObject *) dstArray, varArray);
+		Py_DECREF(dstArray);
+		if (rc<0) {
+			SetErrMsg(
+				"Failed to copy %s : %s", vname.c_str(),
+				MyPython::Instance()->PyErr().c_str()
+			);
+			return -1;
 		}
-			
 	}
 
 	return(0);
 }
 
+bool PyEngine::_isPointwise(const string &script) {
+
+	// Run the test in its own namespace, leaving __main__ alone
+	//
+	PyObject *dict = PyDict_New();
+	if (! dict) return(false);
+	PyDict_SetItemString(dict, "__builtins__", PyEval_GetBuiltins());
+
+	PyObject *src = PyUnicode_FromString(script.c_str());
+	if (! src) {
+		PyErr_Clear();
+		Py_DECREF(dict);
+		return(false);
+	}
+	PyDict_SetItemString(dict, "__vapor_script", src);
+	Py_DECREF(src);
+
+	bool pointwise = false;
+	PyObject *retObj = PyRun_String(
+		pointwiseTestScript, Py_file_input, dict, dict
+	);
+	if (retObj) {
+		PyObject *o = PyDict_GetItemString(dict, "__vapor_pointwise");
+		pointwise = o && PyObject_IsTrue(o) == 1;
+		Py_DECREF(retObj);
+	}
+	else {
+		PyErr_Clear();
+	}
+
+	Py_DECREF(dict);
+	return(pointwise);
+}
+
 
 
 PyEngine::DerivedPythonVar::DerivedPythonVar(
@@ -597,7 +806,8 @@ PyEngine::DerivedPythonVar::DerivedPythonVar(
 	std::vector <string> inNames,
 	string script,
 	DataMgr *dataMgr,
-	bool coordFlag
+	bool coordFlag,
+	bool pointwiseFlag
 ) : DerivedDataVar(varName), 
 	_varInfo(varName, units, type, "", std::vector <size_t> (),
 	std::vector <bool> (), mesh, time_coord_var, DC::Mesh::NODE)
@@ -606,6 +816,7 @@ PyEngine::DerivedPythonVar::DerivedPythonVar(
 	_script = script;
 	_dataMgr = dataMgr;
 	_coordFlag = coordFlag;
+	_pointwiseFlag = pointwiseFlag;
 	_dims.clear();
 	_meshMatchFlag = false;
 	_stdoutString.clear();
@@ -908,13 +1119,158 @@ int PyEngine::DerivedPythonVar::_readRegionSubset(
 	return(0);
 }
 
+int PyEngine::DerivedPythonVar::_readRegionTiled(
+	int fd,
+	const std::vector <size_t> &min, const std::vector <size_t> &max,
+	float *region
+) {
+
+	DC::FileTable::FileObject *f = _fileTable.GetEntry(fd);
+
+	vector <Grid *> variables;
+
+	size_t ts = f->GetTS();
+	int level = f->GetLevel();
+	int lod = f->GetLOD();
+	
+	int rc = DataMgrUtils::GetGrids(
+		_dataMgr, ts, _inNames, min, max, false, &level, &lod, variables
+	);
+	if (rc<0) return(-1);
+	VAssert(variables.size());
+
+	// The inputs are on the output's mesh, so their grids are expected to
+	// share dimensions and blocking. If not, evaluate the script the
+	// general way.
+	//
+	const Grid *g0 = variables[0];
+	const vector <size_t> gdims = g0->GetDimensions();
+	const vector <size_t> bs = g0->GetBlockSize();
+	const vector <size_t> bdims = g0->GetDimensionInBlks();
+	const vector <size_t> minAbs = g0->GetMinAbs();
+	for (int i=0; i<variables.size(); i++) {
+		const Grid *g = variables[i];
+		if (
+			g->GetDimensions() != gdims || g->GetBlockSize() != bs ||
+			g->GetMinAbs() != minAbs || gdims.size() != min.size() ||
+			bs.size() < gdims.size()
+		) {
+			DataMgrUtils::UnlockGrids(_dataMgr, variables);
+			return(_readRegionSubset(fd, min, max, region));
+		}
+	}
+
+	PyObject* code = Py_CompileString(_script.c_str(), "", Py_file_input);
+	if (! code) {
+		SetErrMsg(
+			"Py_CompileString() : %s", MyPython::Instance()->PyErr().c_str()
+		);
+		DataMgrUtils::UnlockGrids(_dataMgr, variables);
+		return(-1);
+	}
+
+	// Requested region relative to the grids, and the blocks it touches
+	//
+	size_t ndim = gdims.size();
+	vector <size_t> rmin, rmax, bmin, bmax;
+	for (int i=0; i<ndim; i++) {
+		rmin.push_back(min[i] - minAbs[i]);
+		rmax.push_back(max[i] - minAbs[i]);
+		bmin.push_back(rmin[i] / bs[i]);
+		bmax.push_back(rmax[i] / bs[i]);
+	}
+	const vector <size_t> regionDims = Dims(min, max);
+
+	vector <size_t> regionStrides;
+	size_t stride = 1;
+	for (int i=0; i<ndim; i++) {
+		regionStrides.push_back(stride);
+		stride *= regionDims[i];
+	}
+
+	//
+	// clear stdout from static class
+	//
+	(void) MyPython::Instance()->PyOut();
+
+	// Evaluate the script for each block's part of the requested region.
+	// Inputs are passed as views of the blocks, copied only if missing
+	// values need mapping to infinity, and the output is written straight
+	// into region.
+	//
+	vector <string> outputVarNames = {_derivedVarName};
+	vector <float> scratch;
+	vector <size_t> bcoord = bmin;
+	size_t nblocks = VProduct(Dims(bmin, bmax));
+	for (size_t b=0; b<nblocks && rc>=0; b++) {
+
+		vector <size_t> tmin, tdims, tstrides;
+		size_t blkOffset = 0;
+		stride = 1;
+		for (int i=0; i<ndim; i++) {
+			size_t b0 = bcoord[i] * bs[i];
+			tmin.push_back(std::max(b0, rmin[i]));
+			tdims.push_back(std::min(b0 + bs[i] - 1, rmax[i]) - tmin[i] + 1);
+			tstrides.push_back(stride);
+			blkOffset += (tmin[i] - b0) * stride;
+			stride *= bs[i];
+		}
+		size_t blkIndex = LinearizeCoords(bcoord, bdims);
+		size_t tsize = VProduct(tdims);
+
+		vector <vector <size_t> > inputVarDims(_inNames.size(), tdims);
+		vector <vector <size_t> > inputVarStrides;
+		vector <float *> inputVarArrays;
+		scratch.resize(_inNames.size() * tsize);
+		for (int i=0; i<variables.size(); i++) {
+			const Grid *g = variables[i];
+			const float *blk = g->GetBlks()[blkIndex] + blkOffset;
+
+			if (g->HasMissingData()) {
+				float *buf = scratch.data() + i * tsize;
+				copy_tile(blk, tdims, tstrides, g->GetMissingValue(), buf);
+				inputVarArrays.push_back(buf);
+				inputVarStrides.push_back(vector <size_t> ());
+			}
+			else {
+				inputVarArrays.push_back((float *) blk);
+				inputVarStrides.push_back(tstrides);
+			}
+		}
+
+		vector <size_t> offset;
+		for (int i=0; i<ndim; i++) offset.push_back(tmin[i] - rmin[i]);
+		float *dst = region + LinearizeCoords(offset, regionDims);
+
+		rc = PyEngine::_calculate(
+			code, _inNames, inputVarDims, inputVarStrides, inputVarArrays,
+			outputVarNames, {tdims}, {regionStrides}, {dst}
+		);
+
+		bcoord = IncrementCoords(bmin, bmax, bcoord);
+	}
+
+	//
+	// Capture any stdout
+	//
+	_stdoutString = MyPython::Instance()->PyOut().c_str();
+
+	Py_DECREF(code);
+	DataMgrUtils::UnlockGrids(_dataMgr, variables);
+
+	return(rc<0 ? -1 : 0);
+}
+
 int PyEngine::DerivedPythonVar::ReadRegion(
 	int fd,
 	const std::vector <size_t> &min, const std::vector <size_t> &max,
 	float *region
 ) {
 
-	if (_meshMatchFlag) {
+	if (_meshMatchFlag && _pointwiseFlag && ! _coordFlag && _inNames.size()) {
+		return(_readRegionTiled(fd, min, max, region));
+	}
+	else if (_meshMatchFlag) {
 		return(_readRegionSubset(fd, min, max, region));
 	}
 	else {
@@ -56,6 +56,7 @@ Renderer::Renderer(
 	
 	_colorbarTexture = 0;
 	_timestep = 0;
+	_prefetchTimestep = (size_t) -1;
 
     _fontName = "arimo";
 }
@@ -172,6 +173,27 @@ int Renderer::paintGL(bool fast) {
 
 	mm->PopMatrix();
 
+	// Read the next time steps into the cache in the background so 
+	// that they are available when the animation advances. Only needed
+	// when the time step (or variable) changes, not on every redraw.
+	//
+	string varname = rParams->GetVariableName();
+	if (
+		! varname.empty() && 
+		(_timestep != _prefetchTimestep || varname != _prefetchVarName) &&
+		_dataMgr->IsTimeVarying(varname)
+	) {
+		vector <double> minExt, maxExt;
+		rParams->GetBox()->GetExtents(minExt, maxExt);
+
+		_dataMgr->PrefetchAhead(
+			_timestep, varname, rParams->GetRefinementLevel(),
+			rParams->GetCompressionLevel(), minExt, maxExt
+		);
+		_prefetchTimestep = _timestep;
+		_prefetchVarName = varname;
+	}
+
 	if (rc<0) {
 		return(-1);
 	}
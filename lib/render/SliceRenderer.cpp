@@ -303,29 +303,16 @@ void SliceRenderer::_populateDataXY(
     Grid* grid
 ) const {
     std::vector<double> deltas = _calculateDeltas();
-    float varValue, missingValue; 
     std::vector<double> coords(3, 0.0); 
     coords[X] = _cacheParams.domainMin[X] + deltas[X]/2.f;
     coords[Y] = _cacheParams.domainMin[Y] + deltas[Y]/2.f;
     coords[Z] = _cacheParams.boxMin[Z];
 
-    int index = 0;
     for (int j=0; j<_textureSideSize; j++) {
         coords[X] = _cacheParams.domainMin[X];
-
-        for (int i=0; i<_textureSideSize; i++) {
-            varValue = grid->GetValue(coords);
-            missingValue = grid->GetMissingValue();
-            if (varValue == missingValue) 
-                dataValues[index+1] = 1.f;
-            else
-                dataValues[index+1] = 0.f;               
- 
-            dataValues[index]   = varValue;
-
-            index += 2;
-            coords[X] += deltas[X];
-        }
+        _populateDataRow(
+            dataValues + 2*j*_textureSideSize, grid, coords, X, deltas[X]
+        );
         coords[Y] += deltas[Y];
     }
 }
@@ -335,29 +322,16 @@ void SliceRenderer::_populateDataXZ(
     Grid* grid
 ) const {
     std::vector<double> deltas = _calculateDeltas();
-    float varValue, missingValue; 
     std::vector<double> coords(3, 0.0); 
     coords[X] = _cacheParams.domainMin[X];
     coords[Y] = _cacheParams.boxMin[Y];
     coords[Z] = _cacheParams.domainMin[Z];
 
-    int index = 0;
     for (int j=0; j<_textureSideSize; j++) {
         coords[X] = _cacheParams.domainMin[X];
-
-        for (int i=0; i<_textureSideSize; i++) {
-            varValue = grid->GetValue(coords);
-            missingValue = grid->GetMissingValue();
-            if (varValue == missingValue) 
-                dataValues[index+1] = 1.f;
-            else
-                dataValues[index+1] = 0.f;               
-            
-            dataValues[index]   = varValue;
-
-            index += 2;
-            coords[X] += deltas[X];
-        }
+        _populateDataRow(
+            dataValues + 2*j*_textureSideSize, grid, coords, X, deltas[X]
+        );
         coords[Z] += deltas[Z];
     }
 }
@@ -367,33 +341,53 @@ void SliceRenderer::_populateDataYZ(
     Grid* grid
 ) const {
     std::vector<double> deltas = _calculateDeltas();
-    float varValue, missingValue; 
     std::vector<double> coords(3, 0.0); 
     coords[X] = _cacheParams.boxMin[X];
     coords[Y] = _cacheParams.domainMin[Y];
     coords[Z] = _cacheParams.domainMin[Z];
 
-    int index = 0;
     for (int j=0; j<_textureSideSize; j++) {
         coords[Y] = _cacheParams.domainMin[Y];
-
-        for (int i=0; i<_textureSideSize; i++) {
-            varValue = grid->GetValue(coords);
-            missingValue = grid->GetMissingValue();
-            if (varValue == missingValue) 
-                dataValues[index+1] = 1.f;
-            else
-                dataValues[index+1] = 0.f;               
-            
-            dataValues[index]   = varValue;
-
-            index += 2;
-            coords[Y] += deltas[Y];
-        }
+        _populateDataRow(
+            dataValues + 2*j*_textureSideSize, grid, coords, Y, deltas[Y]
+        );
         coords[Z] += deltas[Z];
     }
 }
 
+// Samples one row of the texture, starting at coords and stepping by
+// delta along axis, with a single batched query to the grid. Each
+// texel gets the sampled value followed by a missing value flag.
+//
+void SliceRenderer::_populateDataRow(
+    float* dataValues,
+    Grid* grid,
+    std::vector<double> coords,
+    int axis,
+    double delta
+) const {
+    std::vector<double> rowCoords[3];
+    for (int a=0; a<3; a++) 
+        rowCoords[a].assign(_textureSideSize, coords[a]);
+
+    for (int i=0; i<_textureSideSize; i++) {
+        rowCoords[axis][i] = coords[axis];
+        coords[axis] += delta;
+    }
+
+    std::vector<float> values(_textureSideSize);
+    grid->SampleMany(
+        rowCoords[X].data(), rowCoords[Y].data(), rowCoords[Z].data(),
+        _textureSideSize, values.data()
+    );
+
+    float missingValue = grid->GetMissingValue();
+    for (int i=0; i<_textureSideSize; i++) {
+        dataValues[2*i]   = values[i];
+        dataValues[2*i+1] = values[i] == missingValue ? 1.f : 0.f;
+    }
+}
+
 int SliceRenderer::_saveTextureData() {
     Grid* grid = nullptr;
     int rc = DataMgrUtils::GetGrids(
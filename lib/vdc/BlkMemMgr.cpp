@@ -4,8 +4,12 @@
 #include <cerrno>
 #include <iostream>
 #include <new>
+#include <mutex>
 #ifndef WIN32
 #include <unistd.h>
+#include <sys/mman.h>
+#else
+#include <intrin.h>
 #endif
 
 #include <vapor/BlkMemMgr.h>
@@ -17,21 +21,181 @@ using namespace VAPoR;
 //	Static member initialization
 //
 bool BlkMemMgr::_page_aligned_req = true;
+bool BlkMemMgr::_huge_pages_req = false;
 size_t BlkMemMgr::_mem_size_max_req = 32768;
 size_t BlkMemMgr::_blk_size_req = 32*32*32;
 
 bool BlkMemMgr::_page_aligned = false;
+bool BlkMemMgr::_huge_pages = false;
 size_t BlkMemMgr::_mem_size_max = 0;
 size_t BlkMemMgr::_blk_size = 0;
+size_t BlkMemMgr::_nused = 0;
 
-vector <size_t>	BlkMemMgr::_mem_region_sizes;
-vector <unsigned char *> BlkMemMgr::_blks;
-vector < vector <BlkMemMgr::_mem_allocation_t > > BlkMemMgr::_mem_regions;
-#ifdef	VAPOR3_0_0_ALPHA
-#endif
+vector <BlkMemMgr::_mem_region_t> BlkMemMgr::_mem_regions;
+vector <size_t> BlkMemMgr::_run_size;
+vector <unsigned char> BlkMemMgr::_run_free;
+vector <size_t> BlkMemMgr::_next_free;
+vector <size_t> BlkMemMgr::_prev_free;
+
+size_t BlkMemMgr::_free_heads[BlkMemMgr::FL_COUNT][BlkMemMgr::SL_COUNT];
+unsigned long long BlkMemMgr::_fl_bitmap = 0;
+unsigned int BlkMemMgr::_sl_bitmap[BlkMemMgr::FL_COUNT];
 
 int	BlkMemMgr::_ref_count = 0;
 
+const size_t BlkMemMgr::NIL;
+
+namespace {
+
+// The memory pool is shared by all instances of BlkMemMgr, which may
+// be used from multiple threads.
+//
+std::mutex PoolMutex;
+
+// Index of most significant set bit. x must be non-zero
+//
+int msbIndex(unsigned long long x) {
+#ifdef WIN32
+	unsigned long index;
+	_BitScanReverse64(&index, x);
+	return((int) index);
+#else
+	return(63 - __builtin_clzll(x));
+#endif
+}
+
+// Index of least significant set bit. x must be non-zero
+//
+int lsbIndex(unsigned long long x) {
+#ifdef WIN32
+	unsigned long index;
+	_BitScanForward64(&index, x);
+	return((int) index);
+#else
+	return(__builtin_ctzll(x));
+#endif
+}
+
+};
+
+// Map a run length to its size class. Run lengths less than SL_COUNT
+// each have their own class. Larger lengths are grouped by their
+// most significant bit, and then into SL_COUNT linear subdivisions
+//
+void BlkMemMgr::_mapping_insert(size_t n, int &fl, int &sl) {
+	if (n < SL_COUNT) {
+		fl = 0;
+		sl = (int) n;
+	}
+	else {
+		int msb = msbIndex(n);
+		sl = (int) (n >> (msb - SL_LOG2)) ^ SL_COUNT;
+		fl = msb - SL_LOG2 + 1;
+	}
+}
+
+// Map a request to the smallest size class whose runs are all large
+// enough to satisfy it
+//
+void BlkMemMgr::_mapping_search(size_t n, int &fl, int &sl) {
+	if (n >= SL_COUNT) {
+		n += ((size_t) 1 << (msbIndex(n) - SL_LOG2)) - 1;
+	}
+	_mapping_insert(n, fl, sl);
+}
+
+void BlkMemMgr::_set_run(size_t blk, size_t n, bool free) {
+	_run_size[blk] = n;
+	_run_size[blk + n - 1] = n;
+	_run_free[blk] = free;
+	_run_free[blk + n - 1] = free;
+}
+
+void BlkMemMgr::_insert_free(size_t blk) {
+	int fl, sl;
+	_mapping_insert(_run_size[blk], fl, sl);
+
+	size_t head = _free_heads[fl][sl];
+	_next_free[blk] = head;
+	_prev_free[blk] = NIL;
+	if (head != NIL) _prev_free[head] = blk;
+	_free_heads[fl][sl] = blk;
+
+	_fl_bitmap |= (1ULL << fl);
+	_sl_bitmap[fl] |= (1U << sl);
+}
+
+void BlkMemMgr::_remove_free(size_t blk) {
+	int fl, sl;
+	_mapping_insert(_run_size[blk], fl, sl);
+
+	size_t next = _next_free[blk];
+	size_t prev = _prev_free[blk];
+	if (next != NIL) _prev_free[next] = prev;
+	if (prev != NIL) _next_free[prev] = next;
+	else _free_heads[fl][sl] = next;
+
+	if (_free_heads[fl][sl] == NIL) {
+		_sl_bitmap[fl] &= ~(1U << sl);
+		if (! _sl_bitmap[fl]) _fl_bitmap &= ~(1ULL << fl);
+	}
+}
+
+size_t BlkMemMgr::_find_free(size_t n) {
+	int fl, sl;
+	_mapping_search(n, fl, sl);
+
+	if (fl < FL_COUNT) {
+		unsigned int sl_map = _sl_bitmap[fl] & (~0U << sl);
+		if (! sl_map) {
+			unsigned long long fl_map = fl+1 < FL_COUNT ?
+				_fl_bitmap & (~0ULL << (fl+1)) : 0;
+
+			if (fl_map) {
+				fl = lsbIndex(fl_map);
+				sl_map = _sl_bitmap[fl];
+			}
+		}
+		if (sl_map) return(_free_heads[fl][lsbIndex(sl_map)]);
+	}
+
+	// No class is guaranteed to fit. Runs in the request's own class
+	// may still be large enough
+	//
+	_mapping_insert(n, fl, sl);
+	for (size_t blk = _free_heads[fl][sl]; blk != NIL; blk = _next_free[blk]) {
+		if (_run_size[blk] >= n) return(blk);
+	}
+	return(NIL);
+}
+
+void BlkMemMgr::_free_pool() {
+	for (int r=0; r<_mem_regions.size(); r++) {
+		const _mem_region_t &region = _mem_regions[r];
+#ifndef WIN32
+		if (region._mmapped) {
+			munmap(region._mem, region._mem_size);
+			continue;
+		}
+#endif
+		delete [] (unsigned char *) region._mem;
+	}
+	_mem_regions.clear();
+	_run_size.clear();
+	_run_free.clear();
+	_next_free.clear();
+	_prev_free.clear();
+
+	for (int fl=0; fl<FL_COUNT; fl++) {
+		for (int sl=0; sl<SL_COUNT; sl++) {
+			_free_heads[fl][sl] = NIL;
+		}
+		_sl_bitmap[fl] = 0;
+	}
+	_fl_bitmap = 0;
+	_nused = 0;
+}
+
 int	BlkMemMgr::_Reinit(size_t n)
 {
 	long page_size = 0;
@@ -40,6 +204,7 @@ int	BlkMemMgr::_Reinit(size_t n)
 	if (_mem_size_max_req == 0 || _blk_size_req == 0) return(false);
 
 	_page_aligned = _page_aligned_req;
+	_huge_pages = _huge_pages_req;
 	_mem_size_max = _mem_size_max_req;
 	_blk_size = _blk_size_req;
 
@@ -51,14 +216,13 @@ int	BlkMemMgr::_Reinit(size_t n)
 	//
 	// How much total memory already allocated
 	//
-	size_t total_size = 0;
-	int r;
-	for (r=0; r<_mem_regions.size(); r++) total_size += _mem_region_sizes[r];
+	size_t total_size = _run_size.size();
+	int r = _mem_regions.size();
 
 	//
 	// New region size is double preceding one
 	//
-	if (r>0) mem_size = _mem_region_sizes[r-1] << 1;
+	if (r>0) mem_size = _mem_regions[r-1]._nblks << 1;
 
 	// Make sure region size will be large enough, and not too large
 	//
@@ -68,7 +232,7 @@ int	BlkMemMgr::_Reinit(size_t n)
 	if (mem_size < n) return(false);
 
 
-	if (_page_aligned) {
+	if (_page_aligned && ! _huge_pages) {
 #ifdef WIN32
 		page_size = 4096;
 #else
@@ -77,22 +241,45 @@ int	BlkMemMgr::_Reinit(size_t n)
 #endif
 	}
 
-	unsigned char *blks;
+	void *mem = NULL;
+	bool mmapped = false;
 	do {
 		size = (size_t) _blk_size * (size_t) mem_size;
 		size += (size_t) page_size;
 
-		blks = new(nothrow) unsigned char[size];
-		if (! blks) {
+#ifndef WIN32
+		// Anonymous mappings are page aligned. Ask the kernel to back
+		// the mapping with transparent huge pages
+		//
+		if (_huge_pages) {
+			mem = mmap(
+				NULL, size, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS, -1, 0
+			);
+			if (mem == MAP_FAILED) {
+				mem = NULL;
+			}
+			else {
+				mmapped = true;
+#ifdef MADV_HUGEPAGE
+				(void) madvise(mem, size, MADV_HUGEPAGE);
+#endif
+			}
+		}
+		else
+#endif
+		mem = new(nothrow) unsigned char[size];
+
+		if (! mem) {
 			SetDiagMsg(
 				"BlkMemMgr::_Reinit() : failed to allocate %d blocks, retrying",
 				 mem_size
 			);
 			mem_size = mem_size >> 1;
 		}
-	} while (blks == NULL && mem_size > 0 && _blk_size > 0);
+	} while (mem == NULL && mem_size >= n && _blk_size > 0);
 
-	if (! blks && mem_size > 0 && _blk_size > 0) {
+	if (! mem) {
 		SetDiagMsg("Memory allocation of %lu bytes failed", size);
 		return(false);
 	}
@@ -100,34 +287,44 @@ int	BlkMemMgr::_Reinit(size_t n)
 		SetDiagMsg("BlkMemMgr() : allocated %lu bytes", size);
 	}
 
-	unsigned char *blkptr = blks;
+	unsigned char *blkptr = (unsigned char *) mem;
 
 	if (page_size) {
-		blkptr += page_size - (((size_t) blks) % page_size);
+		blkptr += page_size - (((size_t) mem) % page_size);
 	}
 
-	_mem_allocation_t m;
-	vector <_mem_allocation_t> mem_region;
-	m._nfree = mem_size;
-	m._nused = 0;
-	m._blk = blkptr;
-	mem_region.push_back(m);
-
-	_mem_regions.push_back(mem_region);
-	_blks.push_back(blks);
-	_mem_region_sizes.push_back(mem_size);
+	_mem_region_t region;
+	region._blks = blkptr;
+	region._mem = mem;
+	region._mem_size = size;
+	region._mmapped = mmapped;
+	region._nblks = mem_size;
+	region._first = total_size;
+	_mem_regions.push_back(region);
+
+	_run_size.resize(total_size + mem_size, 0);
+	_run_free.resize(total_size + mem_size, 0);
+	_next_free.resize(total_size + mem_size, NIL);
+	_prev_free.resize(total_size + mem_size, NIL);
+
+	// The entire region is a single free run
+	//
+	_set_run(region._first, mem_size, true);
+	_insert_free(region._first);
 
 	return(true);
 }
 
 int	BlkMemMgr::RequestMemSize(
-	size_t blk_size, 
-	size_t num_blks, 
-	bool page_aligned
+	size_t blk_size,
+	size_t num_blks,
+	bool page_aligned,
+	bool huge_pages
 ) {
 
 	SetDiagMsg(
-		"BlkMemMgr::RequestMemSize(%u,%u,%d)", blk_size, num_blks, page_aligned
+		"BlkMemMgr::RequestMemSize(%u,%u,%d,%d)",
+		blk_size, num_blks, page_aligned, huge_pages
 	);
 
 	//
@@ -139,9 +336,12 @@ int	BlkMemMgr::RequestMemSize(
 		return(-1);
 	}
 
+	std::lock_guard <std::mutex> guard(PoolMutex);
+
 	_blk_size_req = blk_size;
 	_mem_size_max_req = num_blks;
 	_page_aligned_req = page_aligned;
+	_huge_pages_req = huge_pages;
 
 	return(0);
 }
@@ -151,6 +351,7 @@ BlkMemMgr::BlkMemMgr(
 
 	SetDiagMsg("BlkMemMgr::BlkMemMgr()");
 
+	std::lock_guard <std::mutex> guard(PoolMutex);
 
 	//
 	// If there are no other instances of this object, re-initialized
@@ -161,14 +362,10 @@ BlkMemMgr::BlkMemMgr(
 		return;
 	}
 
-	for (int i=0; i<_blks.size(); i++) {
-		if (_blks[i]) delete [] _blks[i];
-	}
-	_mem_regions.clear();
-	_mem_region_sizes.clear();
-	_blks.clear();
+	_free_pool();
 
 	_page_aligned = _page_aligned_req;
+	_huge_pages = _huge_pages_req;
 	_mem_size_max = _mem_size_max_req;
 	_blk_size = _blk_size_req;
 
@@ -179,17 +376,13 @@ BlkMemMgr::BlkMemMgr(
 BlkMemMgr::~BlkMemMgr() {
 	SetDiagMsg("BlkMemMgr::~BlkMemMgr()");
 
+	std::lock_guard <std::mutex> guard(PoolMutex);
+
 	if (_ref_count > 0) _ref_count--;
 
 	if (_ref_count != 0) return;
 
-	for (int i=0; i<_blks.size(); i++) {
-		if (_blks[i]) delete [] _blks[i];
-	}
-	_blks.clear();
-	_mem_regions.clear();
-	_mem_region_sizes.clear();
-
+	_free_pool();
 }
 
 void	*BlkMemMgr::Alloc(
@@ -198,51 +391,48 @@ void	*BlkMemMgr::Alloc(
 ) {
 	SetDiagMsg("BlkMemMgr::Alloc(%d)", n);
 
-	//
-	// Check each region, find the first run of blocks large enough
-	// to satisfy the request
-	//
-	void *blk = NULL;
-	for (int r=0; r<_mem_regions.size() && ! blk; r++) {
-		vector <_mem_allocation_t> &mem_region = _mem_regions[r];
-		for (int i=0; i<mem_region.size() && ! blk; i++) {
-
-			if (n<=mem_region[i]._nfree) {	// Found a run of blocks
-				blk = mem_region[i]._blk;
-				mem_region[i]._nused = n;
-
-				//
-				// If run is strictly larger than request split it
-				//
-				if (n<mem_region[i]._nfree) {
-					_mem_allocation_t m;
-					m._nfree = mem_region[i]._nfree - n;
-					m._nused = 0;
-					m._blk = (unsigned char *) mem_region[i]._blk + (_blk_size * n);
-					mem_region.insert(mem_region.begin()+i+1, m);
-				}
-				mem_region[i]._nfree = 0;
-			}
-		}
-	}
-				
-	
-	if (! blk) {
+	if (n == 0) n = 1;
+
+	std::lock_guard <std::mutex> guard(PoolMutex);
+
+	size_t blk = _find_free(n);
+	if (blk == NIL) {
+
 		// Couldn't find space in existing memory pool.
 		// Try to allocate more memory.
 		//
-		if (! BlkMemMgr::_Reinit(n)) 
-			return(NULL);
+		if (! BlkMemMgr::_Reinit(n)) return(NULL);
+
+		blk = _find_free(n);
+		if (blk == NIL) return(NULL);
+	}
 
-		return(Alloc(n,fill));
+	_remove_free(blk);
+
+	//
+	// If run is strictly larger than request split it
+	//
+	size_t run_size = _run_size[blk];
+	if (n < run_size) {
+		_set_run(blk + n, run_size - n, true);
+		_insert_free(blk + n);
 	}
-				
+	_set_run(blk, n, false);
+	_nused += n;
+
+	// Find the region containing the run to compute its address
+	//
+	int r = _mem_regions.size() - 1;
+	while (_mem_regions[r]._first > blk) r--;
+	const _mem_region_t &region = _mem_regions[r];
+
+	unsigned char *ptr = region._blks + (blk - region._first) * _blk_size;
+
 	if (fill) {
-		unsigned char *ptr = (unsigned char *) blk;
-		for (size_t i=0; i<n*_blk_size; i++) ptr[i] = 0;
+		memset(ptr, 0, n*_blk_size);
 	}
 
-	return(blk);
+	return(ptr);
 }
 
 void	BlkMemMgr::FreeMem(
@@ -250,38 +440,74 @@ void	BlkMemMgr::FreeMem(
 ) {
 	SetDiagMsg("BlkMemMgr::FreeMem()");
 
+	std::lock_guard <std::mutex> guard(PoolMutex);
 
-	bool found = false;
-	for (int r=0; r<_mem_regions.size() && ! found; r++) {
-		vector <_mem_allocation_t> &mem_region = _mem_regions[r];
-		for (int i=0; i<mem_region.size() && ! found; i++) {
-			if (ptr == mem_region[i]._blk) {
-				found = true;
-				mem_region[i]._nfree = mem_region[i]._nused;
-				mem_region[i]._nused = 0;
+	unsigned char *cptr = (unsigned char *) ptr;
 
-			}
+	const _mem_region_t *region = NULL;
+	for (int r=0; r<_mem_regions.size() && ! region; r++) {
+		const _mem_region_t &reg = _mem_regions[r];
+		if (cptr >= reg._blks && cptr < reg._blks + reg._nblks * _blk_size) {
+			region = &reg;
 		}
 	}
-	if (! found) cerr << "Failed to free block " << ptr << endl;
+
+	size_t blk = NIL;
+	if (region && ((cptr - region->_blks) % _blk_size) == 0) {
+		blk = region->_first + (cptr - region->_blks) / _blk_size;
+	}
+	if (blk == NIL || _run_free[blk]) {
+		cerr << "Failed to free block " << ptr << endl;
+		return;
+	}
+
+	size_t n = _run_size[blk];
+	_nused -= n;
 
 	//
-	// Collapse any two adjacent runs of they're both free
+	// Coalesce with the adjacent runs if they're free. Runs never
+	// span regions.
 	//
-	bool collapse;
-	do {
-		collapse = false;
-		for (int r=0; r<_mem_regions.size(); r++) {
-		vector <_mem_allocation_t> &mem_region = _mem_regions[r];
-			for (int i=0; i<mem_region.size()-1; i++) {
-				if (mem_region[i]._nfree && mem_region[i+1]._nfree) {
-					mem_region[i]._nfree += mem_region[i+1]._nfree;
-					mem_region.erase(mem_region.begin() + i+1);
-					collapse = true;
-					break;
+	size_t end = region->_first + region->_nblks;
+	if (blk + n < end && _run_free[blk + n]) {
+		_remove_free(blk + n);
+		n += _run_size[blk + n];
+	}
+	if (blk > region->_first && _run_free[blk - 1]) {
+		size_t prev = blk - _run_size[blk - 1];
+		_remove_free(prev);
+		n += _run_size[prev];
+		blk = prev;
+	}
+
+	_set_run(blk, n, true);
+	_insert_free(blk);
+}
+
+BlkMemMgr::Stats BlkMemMgr::GetStats() {
+
+	std::lock_guard <std::mutex> guard(PoolMutex);
+
+	Stats stats;
+	stats.totalBlks = _run_size.size();
+	stats.usedBlks = _nused;
+	stats.freeBlks = stats.totalBlks - stats.usedBlks;
+
+	for (int fl=0; fl<FL_COUNT; fl++) {
+		for (int sl=0; sl<SL_COUNT; sl++) {
+			size_t blk = _free_heads[fl][sl];
+			for ( ; blk != NIL; blk = _next_free[blk]) {
+				stats.freeRuns++;
+				if (_run_size[blk] > stats.largestFreeRun) {
+					stats.largestFreeRun = _run_size[blk];
 				}
 			}
 		}
-	} while (collapse);
+	}
 
+	if (stats.freeBlks) {
+		stats.fragmentation = 1.0 -
+			((double) stats.largestFreeRun / (double) stats.freeBlks);
+	}
+	return(stats);
 }
@@ -0,0 +1,229 @@
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <vapor/VAssert.h>
+#include <vapor/CurvilinearFaceIndex.h>
+
+using namespace std;
+using namespace VAPoR;
+
+CurvilinearFaceIndex::Block::Block(
+	const RegularGrid &xrg, const RegularGrid &yrg,
+	size_t i0, size_t j0, size_t ni, size_t nj
+) : _ni(ni), _nj(nj) {
+
+	for (int i=0; i<4; i++) _bounds[i] = 0.0;
+
+	if (! ni || ! nj) {
+		_ni = _nj = 0;
+		_qtr.reset(new QuadTreeRectangle<float, size_t>(0.0, 0.0, 0.0, 0.0));
+		return;
+	}
+
+	VAssert(i0 + ni < xrg.GetDimensions()[0]);
+	VAssert(j0 + nj < xrg.GetDimensions()[1]);
+
+	// Fetch the coordinates of the block's nodes once. Each is shared
+	// by up to four faces.
+	//
+	size_t nx = ni + 1;
+	size_t ny = nj + 1;
+	vector <float> xc(nx * ny);
+	vector <float> yc(nx * ny);
+
+	float left = std::numeric_limits<float>::max();
+	float right = std::numeric_limits<float>::lowest();
+	float top = std::numeric_limits<float>::max();
+	float bottom = std::numeric_limits<float>::lowest();
+	for (size_t j=0; j<ny; j++) {
+	for (size_t i=0; i<nx; i++) {
+		float x = xrg.AccessIJK(i0+i, j0+j);
+		float y = yrg.AccessIJK(i0+i, j0+j);
+		xc[j*nx + i] = x;
+		yc[j*nx + i] = y;
+		left = std::min(left, x);
+		right = std::max(right, x);
+		top = std::min(top, y);
+		bottom = std::max(bottom, y);
+	}
+	}
+	_bounds[0] = left;
+	_bounds[1] = top;
+	_bounds[2] = right;
+	_bounds[3] = bottom;
+
+	_qtr.reset(new QuadTreeRectangle<float, size_t>(
+		left, top, right, bottom, 16, ni * nj
+	));
+
+	for (size_t j=0; j<nj; j++) {
+	for (size_t i=0; i<ni; i++) {
+
+		// Find bounding rectangle for each face
+		//
+		left = right = xc[j*nx + i];
+		top = bottom = yc[j*nx + i];
+		for(size_t jj=0; jj<2; jj++) {
+		for(size_t ii=0; ii<2; ii++) {
+			float x = xc[(j+jj)*nx + i+ii];
+			float y = yc[(j+jj)*nx + i+ii];
+			if (x < left) left = x;
+			if (x > right) right = x;
+			if (y < top) top = y;
+			if (y > bottom) bottom = y;
+		}
+		}
+
+		// Payload is the face's index within the block
+		//
+		_qtr->Insert(left, top, right, bottom, j*ni + i);
+	}
+	}
+}
+
+size_t CurvilinearFaceIndex::Block::GetNumBytes() const {
+	return(sizeof(*this) + _qtr->GetNumBytes());
+}
+
+CurvilinearFaceIndex::CurvilinearFaceIndex(
+	size_t dim0,
+	const vector <std::shared_ptr <const Block> > &blocks,
+	const vector <size_t> &origins
+) : _dim0(dim0) {
+	VAssert(origins.size() == 2 * blocks.size());
+
+	float left = std::numeric_limits<float>::max();
+	float right = std::numeric_limits<float>::lowest();
+	float top = std::numeric_limits<float>::max();
+	float bottom = std::numeric_limits<float>::lowest();
+	for (size_t b=0; b<blocks.size(); b++) {
+		VAssert(blocks[b]);
+		if (! blocks[b]->GetNumFaces()) continue;
+
+		_blocks.push_back(blocks[b]);
+		_origins.push_back(origins[2*b]);
+		_origins.push_back(origins[2*b+1]);
+
+		const float *bounds = blocks[b]->_bounds;
+		left = std::min(left, bounds[0]);
+		top = std::min(top, bounds[1]);
+		right = std::max(right, bounds[2]);
+		bottom = std::max(bottom, bounds[3]);
+	}
+
+	if (_blocks.empty()) {
+		left = top = right = bottom = 0.0;
+	}
+
+	_qtr.reset(new QuadTreeRectangle<float, size_t>(
+		left, top, right, bottom, 12, 4 * _blocks.size() + 1
+	));
+
+	for (size_t b=0; b<_blocks.size(); b++) {
+		const float *bounds = _blocks[b]->_bounds;
+		_qtr->Insert(bounds[0], bounds[1], bounds[2], bounds[3], b);
+	}
+}
+
+void CurvilinearFaceIndex::GetFacesContained(
+	float x, float y, vector <size_t> &faces
+) const {
+	faces.clear();
+
+	vector <size_t> blocks;
+	_qtr->GetPayloadContained(x, y, blocks);
+
+	// A block may be stored in more than one node of the tree if it
+	// straddles a node boundary
+	//
+	if (blocks.size() > 1) {
+		std::sort(blocks.begin(), blocks.end());
+		blocks.erase(std::unique(blocks.begin(), blocks.end()), blocks.end());
+	}
+
+	vector <size_t> payloads;
+	for (size_t b : blocks) {
+		const Block &block = *_blocks[b];
+		size_t i0 = _origins[2*b];
+		size_t j0 = _origins[2*b+1];
+
+		block._qtr->GetPayloadContained(x, y, payloads);
+		for (size_t p : payloads) {
+			size_t i = i0 + p % block._ni;
+			size_t j = j0 + p / block._ni;
+			faces.push_back(j * _dim0 + i);
+		}
+	}
+}
+
+void CurvilinearFaceIndex::MakeBlocks(
+	const RegularGrid &xrg, const RegularGrid &yrg,
+	const vector <size_t> &origins,
+	const vector <size_t> &sizes,
+	vector <std::shared_ptr <const Block> > &blocks,
+	int nthreads
+) {
+	VAssert(origins.size() == 2 * blocks.size());
+	VAssert(sizes.size() == 2 * blocks.size());
+
+	vector <size_t> missing;
+	for (size_t b=0; b<blocks.size(); b++) {
+		if (! blocks[b]) missing.push_back(b);
+	}
+
+	// Hand out blocks to the threads one at a time. The calling thread
+	// takes part.
+	//
+	std::atomic <size_t> next(0);
+	auto worker = [&]() {
+		size_t m;
+		while ((m = next++) < missing.size()) {
+			size_t b = missing[m];
+			blocks[b] = std::make_shared <Block>(
+				xrg, yrg, origins[2*b], origins[2*b+1],
+				sizes[2*b], sizes[2*b+1]
+			);
+		}
+	};
+
+	size_t n = Grid::GetNumBlockThreads(nthreads);
+	n = std::min(n, missing.size());
+
+	vector <std::thread> threads;
+	for (size_t t=1; t<n; t++) threads.push_back(std::thread(worker));
+	worker();
+	for (auto &thread : threads) thread.join();
+}
+
+std::shared_ptr <const CurvilinearFaceIndex> CurvilinearFaceIndex::Make(
+	const RegularGrid &xrg, const RegularGrid &yrg,
+	const vector <size_t> &bs, int nthreads
+) {
+	VAssert(bs.size() >= 2);
+
+	const vector <size_t> &dims = xrg.GetDimensions();
+
+	// There are dims[i]-1 faces along each dimension
+	//
+	size_t nfi = dims[0] > 1 ? dims[0] - 1 : 0;
+	size_t nfj = dims[1] > 1 ? dims[1] - 1 : 0;
+
+	vector <size_t> origins, sizes;
+	for (size_t j0=0; j0<nfj; j0+=bs[1]) {
+	for (size_t i0=0; i0<nfi; i0+=bs[0]) {
+		origins.push_back(i0);
+		origins.push_back(j0);
+		sizes.push_back(std::min(bs[0], nfi - i0));
+		sizes.push_back(std::min(bs[1], nfj - j0));
+	}
+	}
+
+	vector <std::shared_ptr <const Block> > blocks(origins.size() / 2);
+	MakeBlocks(xrg, yrg, origins, sizes, blocks, nthreads);
+
+	return(std::make_shared <CurvilinearFaceIndex>(
+		dims[0], blocks, origins
+	));
+}
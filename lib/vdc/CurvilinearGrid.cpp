@@ -4,9 +4,9 @@
 #include <cmath>
 #include <cfloat>
 #include <limits>
+#include <algorithm>
 #include <vapor/utils.h>
 #include <vapor/CurvilinearGrid.h>
-#include <vapor/QuadTreeRectangle.hpp>
 #include <vapor/vizutil.h>
 
 using namespace std;
@@ -17,7 +17,7 @@ void CurvilinearGrid::_curvilinearGrid(
 	const RegularGrid &yrg,
 	const RegularGrid &zrg,
 	const vector <double> &zcoords,
-	std::shared_ptr <const QuadTreeRectangle<float, size_t> > qtr
+	std::shared_ptr <const CurvilinearFaceIndex> faceIndex
 ) {
 	_zcoords.clear();
 	_minu.clear();
@@ -28,9 +28,11 @@ void CurvilinearGrid::_curvilinearGrid(
 
 	_zcoords = zcoords;
 
-	_qtr = qtr;
-	if (! _qtr) {
-		_qtr = _makeQuadTreeRectangle();
+	_faceIndex = faceIndex;
+	if (! _faceIndex) {
+		_faceIndex = CurvilinearFaceIndex::Make(
+			_xrg, _yrg, GetBlockSize(), 0
+		);
 	}
 
 }
@@ -42,7 +44,7 @@ CurvilinearGrid::CurvilinearGrid(
 	const RegularGrid &xrg,
 	const RegularGrid &yrg,
 	const vector <double> &zcoords,
-	std::shared_ptr <const QuadTreeRectangle<float, size_t> >qtr
+	std::shared_ptr <const CurvilinearFaceIndex> faceIndex
  ) : StructuredGrid(dims, bs, blks) {
 
 	VAssert(dims.size() == 2 || dims.size() == 3);
@@ -56,7 +58,7 @@ CurvilinearGrid::CurvilinearGrid(
 	VAssert(zcoords.size() == 0 || zcoords.size() == dims[2]);
 
 	_terrainFollowing = false;
-	_curvilinearGrid(xrg, yrg, RegularGrid(), zcoords, qtr);
+	_curvilinearGrid(xrg, yrg, RegularGrid(), zcoords, faceIndex);
 }
 
 CurvilinearGrid::CurvilinearGrid(
@@ -66,7 +68,7 @@ CurvilinearGrid::CurvilinearGrid(
 	const RegularGrid &xrg,
 	const RegularGrid &yrg,
 	const RegularGrid &zrg,
-	std::shared_ptr <const QuadTreeRectangle<float, size_t> >qtr
+	std::shared_ptr <const CurvilinearFaceIndex> faceIndex
  ) : StructuredGrid(dims, bs, blks) {
 
 	VAssert(dims.size() == 3);
@@ -80,7 +82,7 @@ CurvilinearGrid::CurvilinearGrid(
 	VAssert(zrg.GetDimensions().size() == 3);
 
 	_terrainFollowing = true;
-	_curvilinearGrid(xrg, yrg, zrg, vector <double> (), qtr);
+	_curvilinearGrid(xrg, yrg, zrg, vector <double> (), faceIndex);
 
 }
 
@@ -90,7 +92,7 @@ CurvilinearGrid::CurvilinearGrid(
 	const vector <float *> &blks,
 	const RegularGrid &xrg,
 	const RegularGrid &yrg,
-	std::shared_ptr <const QuadTreeRectangle<float, size_t> >qtr
+	std::shared_ptr <const CurvilinearFaceIndex> faceIndex
  ) : StructuredGrid(dims, bs, blks) {
 
 	VAssert(dims.size() == 2);
@@ -103,7 +105,7 @@ CurvilinearGrid::CurvilinearGrid(
 	VAssert(yrg.GetDimensions().size() == 2);
 
 	_terrainFollowing = false;
-	_curvilinearGrid(xrg, yrg, RegularGrid(), vector <double> (), qtr);
+	_curvilinearGrid(xrg, yrg, RegularGrid(), vector <double> (), faceIndex);
 }
 
 vector <size_t> CurvilinearGrid::GetCoordDimensions(size_t dim) const {
@@ -445,6 +447,14 @@ float CurvilinearGrid::GetValueNearestNeighbor(
 
 	if (! inside) return(GetMissingValue());
 
+	return(_getValueNearestNeighbor(i, j, k, lambda, zwgt));
+}
+
+float CurvilinearGrid::_getValueNearestNeighbor(
+	size_t i, size_t j, size_t k, const double lambda[4],
+	const double zwgt[2]
+) const {
+
 	// Find closest point within face
 	//
 	double maxl = lambda[0];
@@ -536,15 +546,21 @@ float CurvilinearGrid::GetValueLinear(
 	double z = GetGeometryDim() == 3 ? cCoords[2] : 0.0;
 	bool inside = _insideGrid(x, y, z, i, j, k, lambda, zwgt);
 
+	if (! inside) return(GetMissingValue());
 
-	float mv = GetMissingValue();
+	return(_getValueLinear(i, j, k, lambda, zwgt));
+}
+
+float CurvilinearGrid::_getValueLinear(
+	size_t i, size_t j, size_t k, const double lambda[4], double zwgt[2]
+) const {
 
-	if (! inside) return(mv);
+	float mv = GetMissingValue();
 
 	// Use Wachspress coordinates as weights to do linear interpolation
 	// along XY plane
 	//
-	vector <size_t> dims = GetDimensions();
+	const vector <size_t> &dims = GetDimensions();
 	VAssert(i<dims[0]-1);
 	VAssert(j<dims[1]-1);
 	if (dims.size() > 2) VAssert(k<dims[2]);
@@ -689,13 +705,28 @@ bool CurvilinearGrid::_insideGridHelperTerrain(
 	}
 
 	float z0, z1;
+	size_t nz = GetDimensions()[2];
 
-	// Check cached z values from last search first
+	// Check the cell found by the last search on this thread first. The
+	// hint is only used if the point lies strictly inside the cell's Z 
+	// range interpolated at this point, so the result never depends on
+	// earlier queries, or on which thread is asking.
 	//
-	if (((z-_insideGridCache.z0) * (z-_insideGridCache.z1)) < 0.0) {
-		k = _insideGridCache.k;
-		z0 = _insideGridCache.z0;
-		z1 = _insideGridCache.z1;
+	static thread_local size_t kHint = 0;
+
+	if (kHint+1 < nz) {
+		z0 = 
+			_zrg.AccessIJK(iv[0], jv[0], kHint) * lambda[0] +
+			_zrg.AccessIJK(iv[1], jv[1], kHint) * lambda[1] +
+			_zrg.AccessIJK(iv[2], jv[2], kHint) * lambda[2];
+		z1 = 
+			_zrg.AccessIJK(iv[0], jv[0], kHint+1) * lambda[0] +
+			_zrg.AccessIJK(iv[1], jv[1], kHint+1) * lambda[1] +
+			_zrg.AccessIJK(iv[2], jv[2], kHint+1) * lambda[2];
+	}
+
+	if (kHint+1 < nz && ((z-z0) * (z-z1)) < 0.0) {
+		k = kHint;
 	}
 	else {
 		 
@@ -704,7 +735,6 @@ bool CurvilinearGrid::_insideGridHelperTerrain(
 		//
 		vector <double> zcoords;
 
-		size_t nz = GetDimensions()[2];
 		for (int kk=0; kk<nz; kk++) {
 
 			// Interpolate Z coordinate across triangle
@@ -724,10 +754,7 @@ bool CurvilinearGrid::_insideGridHelperTerrain(
 		z0 = zcoords[k];
 		z1 = zcoords[k+1];
 
-		_insideGridCache.k = k;
-		_insideGridCache.z0 = z0;
-		_insideGridCache.z1 = z1;
-
+		kHint = k;
 	}
 
 	zwgt[0] = 1.0 - (z - z0) / (z1 - z0);
@@ -800,7 +827,7 @@ bool CurvilinearGrid::_insideGrid(
 	// Find the indices for the faces that might contain the point
 	//
 	vector <size_t> face_indices;
-	_qtr->GetPayloadContained(x, y, face_indices);
+	_faceIndex->GetFacesContained(x, y, face_indices);
 
 	bool inside = false;
 	double pt[] = {x,y};
@@ -832,71 +859,207 @@ bool CurvilinearGrid::_insideGrid(
 	}
 }
 
-std::shared_ptr <QuadTreeRectangle<float, size_t> >CurvilinearGrid::_makeQuadTreeRectangle() const {
+// Test whether a point is inside the face with first node (i,j), reading 
+// the face's vertices with the readers of the X and Y coordinate grids.
+// This is the test _insideFace() makes. If the point is outside 
+// 'exitEdge' is set to the edge the point lies furthest beyond: 
+// 0 (towards j-1), 1 (i+1), 2 (j+1), or 3 (i-1); or -1 if the point
+// isn't beyond any edge.
+//
+bool CurvilinearGrid::_testFace(
+	size_t i, size_t j, const double pt[2],
+	NodeReader &xr, NodeReader &yr, double lambda[4], int &exitEdge
+) const {
+	exitEdge = -1;
 
-	vector <double> minu, maxu;
-	GetUserExtents(minu, maxu);
+	// Vertices in the counter-clockwise order of GetCellNodes()
+	//
+	double verts[] = {
+		xr.Get(i,j), yr.Get(i,j),
+		xr.Get(i+1,j), yr.Get(i+1,j),
+		xr.Get(i+1,j+1), yr.Get(i+1,j+1),
+		xr.Get(i,j+1), yr.Get(i,j+1)
+	};
 
-	const vector <size_t> &dims = GetDimensions();
-	const vector <size_t> dims2d = {dims[0], dims[1]};
-	size_t reserve_size = dims2d[0] * dims2d[1];
+	if (
+		Grid::PointInsideBoundingRectangle(pt, verts, 4) && 
+		WachspressCoords2D(verts, pt, 4, lambda)
+	) {
+		return(true);
+	}
 
-	std::shared_ptr <QuadTreeRectangle<float, size_t> >qtr = 
-		std::make_shared <QuadTreeRectangle<float, size_t> >(
-			(float) minu[0], (float) minu[1], (float) maxu[0], (float) maxu[1], 
-			16, reserve_size
-		);
+	// The winding of the face depends on the handedness of the mesh
+	//
+	double area = SignedTriArea2D(&verts[0], &verts[2], &verts[4]) +
+		SignedTriArea2D(&verts[0], &verts[4], &verts[6]);
+	double sign = area < 0.0 ? -1.0 : 1.0;
+
+	double minArea = 0.0;
+	for (int e=0; e<4; e++) {
+		double a = sign * SignedTriArea2D(&verts[e*2], &verts[((e+1)%4)*2], pt);
+		if (a < minArea) {
+			minArea = a;
+			exitEdge = e;
+		}
+	}
+	return(false);
+}
 
+// Find the face containing a point. If 'useHint' is true the search
+// starts with face (i,j), and walks from face to face towards the point.
+// The face index is searched if the walk leaves the mesh or takes too 
+// long. 'faces' is scratch space.
+//
+bool CurvilinearGrid::_locateFace(
+	const double pt[2], NodeReader &xr, NodeReader &yr,
+	vector <size_t> &faces, bool useHint,
+	size_t &i, size_t &j, double lambda[4]
+) const {
+	const vector <size_t> &dims = GetDimensions();
+	const int maxSteps = 16;
+
+	int exitEdge;
+	if (useHint) {
+		for (int step=0; step<maxSteps; step++) {
+			if (_testFace(i, j, pt, xr, yr, lambda, exitEdge)) return(true);
+
+			if (exitEdge == 0 && j > 0) j--;
+			else if (exitEdge == 1 && i+2 < dims[0]) i++;
+			else if (exitEdge == 2 && j+2 < dims[1]) j++;
+			else if (exitEdge == 3 && i > 0) i--;
+			else break;
+		}
+	}
 
-	// Loop over horizontal dimensions only - the grid, if 3D, is layered.
-	// There are dims2d[i]-1 cells (faces) along each dimension.
-	//
-	float coords[2];
-	for (size_t j=0; j<dims2d[1]-1; j++) {
-	for (size_t i=0; i<dims2d[0]-1; i++) {
+	_faceIndex->GetFacesContained(pt[0], pt[1], faces);
 
-		// Find bounding rectangle for each cell
-		//
-		float left = std::numeric_limits<float>::max();
-		float right = std::numeric_limits<float>::lowest();
-		float top = std::numeric_limits<float>::max();
-		float bottom = std::numeric_limits<float>::lowest();
-		for(size_t jj=0; jj<2; jj++) {
-		for(size_t ii=0; ii<2; ii++) {
-			coords[0] = _xrg.AccessIJK(i+ii, j+jj);
-			coords[1] = _yrg.AccessIJK(i+ii, j+jj);
-			if (coords[0] < left) left = coords[0];
-			if (coords[0] > right) right = coords[0];
-			if (coords[1] < top) top = coords[1];
-			if (coords[1] > bottom) bottom = coords[1];
+	for (size_t f : faces) {
+		size_t fi = f % dims[0];
+		size_t fj = f / dims[0];
+		if (_testFace(fi, fj, pt, xr, yr, lambda, exitEdge)) {
+			i = fi;
+			j = fj;
+			return(true);
 		}
+	}
+	return(false);
+}
+
+// ClampCoord() only changes coordinates along periodic dimensions, and
+// dimensions of length one
+//
+bool CurvilinearGrid::_needsClampCoord() const {
+	const vector <size_t> &dims = GetDimensions();
+	const vector <bool> periodic = GetPeriodic();
+	for (int i=0; i<dims.size(); i++) {
+		if (dims[i] == 1 || (i < periodic.size() && periodic[i])) {
+			return(true);
 		}
+	}
+	return(false);
+}
 
-		// face index is index of first node in the face
-		//
-		vector <size_t> face = {i,j};
-		qtr->Insert(
-			left, top, right, bottom, Wasp::LinearizeCoords(face, dims2d)
-		);
+// The coherent version of _insideGrid(). If 'hint' is true the search
+// starts from the face (i,j). 'hint' is set once a face has been found.
+//
+bool CurvilinearGrid::_locateCell(
+	vector <double> &coords, bool clamp,
+	NodeReader &xr, NodeReader &yr, vector <size_t> &faces, bool &hint,
+	size_t &i, size_t &j, size_t &k, double lambda[4], double zwgt[2]
+) const {
+	for (int l=0; l<4; l++) lambda[l] = 0.0;
+	for (int l=0; l<2; l++) zwgt[l] = 0.0;
+
+	if (clamp) ClampCoord(coords);
+
+	double pt[] = {coords[0], coords[1]};
+	if (! _locateFace(pt, xr, yr, faces, hint, i, j, lambda)) return(false);
+	hint = true;
+
+	k = 0;
+	if (GetGeometryDim() == 2) {
+		zwgt[0] = 1.0;
+		zwgt[1] = 0.0;
+		return(true);
+	}
+
+	if (_terrainFollowing) {
+		return(_insideGridHelperTerrain(pt[0], pt[1], coords[2], i, j, k, zwgt));
 	}
+	else {
+		return(_insideGridHelperStretched(coords[2], k, zwgt));
 	}
+}
 
-#ifdef	DEBUG
-	vector <size_t> payload_histo;
-	vector <size_t> level_histo;
-	qtr->GetStats(payload_histo, level_histo);
-	cout << "Payload histo" << endl;
-	for (int i=0; i<payload_histo.size(); i++) {
-		cout << "	" << i << " " << payload_histo[i] << endl;
+void CurvilinearGrid::GetIndicesCellMany(
+	const double *coords, size_t n, size_t *indices, bool *found
+) const {
+	size_t ndim = GetGeometryDim();
+	size_t nidx = GetDimensions().size();
+	bool clamp = _needsClampCoord();
+
+	NodeReader xr(&_xrg);
+	NodeReader yr(&_yrg);
+
+	vector <double> point(ndim);
+	vector <size_t> faces;
+	bool hint = false;
+	size_t i = 0, j = 0, k = 0;
+	double lambda[4], zwgt[2];
+	for (size_t p=0; p<n; p++) {
+		point.resize(ndim);
+		for (int d=0; d<ndim; d++) point[d] = coords[p*ndim + d];
+
+		found[p] = _locateCell(
+			point, clamp, xr, yr, faces, hint, i, j, k, lambda, zwgt
+		);
+
+		size_t *cindices = indices + p*nidx;
+		cindices[0] = i;
+		cindices[1] = j;
+		if (nidx > 2) cindices[2] = k;
 	}
+}
+
+void CurvilinearGrid::SampleMany(
+	const double *coords, size_t n, float *values
+) const {
+	float mv = GetMissingValue();
 
-	cout << "Level histo" << endl;
-	for (int i=0; i<level_histo.size(); i++) {
-		cout << "	" << i << " " << level_histo[i] << endl;
+	if (! GetBlks().size()) {
+		std::fill(values, values + n, mv);
+		return;
 	}
-	cout << endl;
-#endif
-	
 
-	return(qtr);
+	size_t ndim = GetGeometryDim();
+	bool clamp = _needsClampCoord();
+	bool linear = GetInterpolationOrder() != 0;
+
+	NodeReader xr(&_xrg);
+	NodeReader yr(&_yrg);
+
+	// The body of the loop below must compute exactly what
+	// Grid::GetValue() does via GetValueNearestNeighbor() and 
+	// GetValueLinear()
+	//
+	vector <double> point(ndim);
+	vector <size_t> faces;
+	bool hint = false;
+	size_t i = 0, j = 0, k = 0;
+	double lambda[4], zwgt[2];
+	for (size_t p=0; p<n; p++) {
+		point.resize(ndim);
+		for (int d=0; d<ndim; d++) point[d] = coords[p*ndim + d];
+
+		if (! _locateCell(
+			point, clamp, xr, yr, faces, hint, i, j, k, lambda, zwgt
+		)) {
+			values[p] = mv;
+			continue;
+		}
+
+		values[p] = linear ? 
+			_getValueLinear(i, j, k, lambda, zwgt) :
+			_getValueNearestNeighbor(i, j, k, lambda, zwgt);
+	}
 }
@@ -1,5 +1,11 @@
 #include <iostream>
 #include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <algorithm>
+#include <cstdint>
+#include <ctime>
 #include <stdio.h>
 #include <cstring>
 #include "vapor/VAssert.h"
@@ -13,6 +19,7 @@
 #include <vapor/DCCF.h>
 #include <vapor/DCMPAS.h>
 #include <vapor/DerivedVar.h>
+#include <vapor/FileUtils.h>
 #include <vapor/DataMgr.h>
 #ifdef WIN32
 #include <float.h>
@@ -22,6 +29,94 @@ using namespace VAPoR;
 
 namespace {
 
+// True for the threads servicing prefetch requests. See DataMgr::Prefetch()
+//
+thread_local bool IsPrefetchThread = false;
+
+// Upper bound on the number of prefetch threads. Reads from the DC are
+// serialized, so more threads would only contend for the DC lock
+//
+const int MaxPrefetchThreads = 4;
+
+// 64-bit FNV-1a hash
+//
+const uint64_t FNVOffsetBasis = 14695981039346656037ULL;
+
+void fnv1a(const string &s, uint64_t &hash) {
+	for (size_t i=0; i<s.size(); i++) {
+		hash ^= (unsigned char) s[i];
+		hash *= 1099511628211ULL;
+	}
+}
+
+// Fold the path, size and modification time of \p path, or of every
+// file below \p path if it is a directory, into \p digest
+//
+void file_digest(const string &path, uint64_t &digest, size_t &nfiles) {
+	if (FileUtils::IsDirectory(path)) {
+		vector <string> names = FileUtils::ListFiles(path);
+		sort(names.begin(), names.end());
+		for (int i=0; i<names.size(); i++) {
+			file_digest(FileUtils::JoinPaths({path, names[i]}), digest, nfiles);
+		}
+		return;
+	}
+
+	ostringstream oss;
+	oss << path << ":" << FileUtils::GetFileSize(path) << ":" 
+		<< FileUtils::GetFileModifiedTime(path) << ";";
+	fnv1a(oss.str(), digest);
+	nfiles++;
+}
+
+// Scratch space for staging reads from the DC. Each thread keeps one
+// buffer that is reused from read to read, so that reading a region does
+// not allocate. A read nested within another read on the same thread 
+// (e.g. of the inputs of a derived variable) gets a buffer of its own.
+//
+struct read_scratch_t {
+	read_scratch_t() : busy(false) {}
+	std::vector <unsigned char> buf;
+	bool busy;
+};
+
+thread_local read_scratch_t ReadScratch;
+
+template <typename T>
+class ScratchBuffer {
+public:
+	// Buffers larger than maxKeep bytes are not kept after use
+	//
+	ScratchBuffer(size_t n, size_t maxKeep) : _maxKeep(maxKeep) {
+		size_t nbytes = n * sizeof(T);
+
+		_shared = ! ReadScratch.busy;
+		std::vector <unsigned char> &buf = _shared ? ReadScratch.buf : _buf;
+
+		if (buf.size() < nbytes) buf.resize(nbytes);
+		_data = (T *) buf.data();
+
+		if (_shared) ReadScratch.busy = true;
+	}
+
+	~ScratchBuffer() {
+		if (! _shared) return;
+
+		ReadScratch.busy = false;
+		if (ReadScratch.buf.size() > _maxKeep) {
+			std::vector <unsigned char> ().swap(ReadScratch.buf);
+		}
+	}
+
+	T *Data() const { return(_data); }
+
+private:
+	size_t _maxKeep;
+	bool _shared;
+	std::vector <unsigned char> _buf;
+	T *_data;
+};
+
 // Again, stupid gcc-4.8 on CentOS7 requires this alias.
 template< bool B, class T = void >
 using enable_if_t = typename std::enable_if<B,T>::type;
@@ -566,6 +661,16 @@ template <typename T> bool contains(const vector <T> &v, T element) {
 	return(find(v.begin(), v.end(), element) != v.end());
 }
 
+// True if all elements of a vector can be written to, and read back
+// from, a text stream
+//
+template <typename T> bool all_finite(const vector <T> &v) {
+	for (int i=0; i<v.size(); i++) {
+		if (! std::isfinite((double) v[i])) return(false);
+	}
+	return(true);
+}
+
 };
 
 
@@ -586,13 +691,27 @@ DataMgr::DataMgr(
 
 	if (! _mem_size) _mem_size = 100;
 
+	// Spatial search indices of unstructured and curvilinear grids are
+	// cached within a share of the memory budget. What they hold is
+	// charged against the block cache as they are built.
+	//
+	_gridHelper.SetCacheSize(_gridHelperCacheSize());
+	_gridHelper.SetNumThreads(_nthreads);
+
+	// Intermediate results of derived variables, likewise
+	//
+	_dvm.SetCacheSize(_derivedVarCacheSize());
+
 	_dc = NULL;
 
 	_blk_mem_mgr = NULL;
+	_blksInUse = 0;
 
 	_PipeLines.clear();
 
 	_regionsList.clear();
+	_regionsMap.clear();
+	_regionsBlksMap.clear();
 
 	_varInfoCacheSize_T.Clear();
 	_varInfoCacheDouble.Clear();
@@ -600,10 +719,15 @@ DataMgr::DataMgr(
 
 	_doTransformHorizontal = false;
 	_doTransformVertical = false;
-	_openVarName.clear();
 	_proj4String.clear();
 	_proj4StringDefault.clear();
 	_bs = {64,64,64};
+
+	_hugePages = false;
+
+	_prefetchIdle = 0;
+	_prefetchShutdown = false;
+	_prefetchWindow = 1;
 }
 
 
@@ -611,6 +735,10 @@ DataMgr::~DataMgr(
 ) {
 	SetDiagMsg("DataMgr::~DataMgr()");
 
+	_stopPrefetch();
+
+	(void) SaveMetadataCache();
+
 	if (_dc) delete _dc;
 	_dc = NULL;
 
@@ -637,6 +765,22 @@ int DataMgr::_parseOptions(vector <string> &options) {
 	bool ok = true;
 	int i = 0;
 	while (i<options.size() && ok) {
+		if (options[i] == "-metadata_cache") {
+			i++;
+			if (i>=options.size()) {
+				ok = false;
+			}
+			else {
+				_metadataCacheDir = options[i];
+				i++;
+			}
+			continue;
+		}
+		if (options[i] == "-huge_pages") {
+			_hugePages = true;
+			i++;
+			continue;
+		}
 		if (options[i] == "-proj4") {
 			i++;
 			if (i>=options.size()) {
@@ -671,11 +815,40 @@ int DataMgr::Initialize(
 	const vector <string> &files, const std::vector <string> &options
 ) {
 
+	_stopPrefetch();
+
+	// Persist metadata for the previous data collection, if any
+	//
+	(void) SaveMetadataCache();
+	_metadataCacheDir.clear();
+	_metadataCachePath.clear();
+	_metadataCacheSignature.clear();
+	_hugePages = false;
+
 	vector <string> deviceOptions = options;
 	int rc = _parseOptions(deviceOptions);
 	if (rc<0) return(-1);
 
 	Clear();
+
+	// The memory pool is allocated on first use, with the options given
+	// here (e.g. -huge_pages)
+	//
+	if (_blk_mem_mgr) delete _blk_mem_mgr;
+	_blk_mem_mgr = NULL;
+
+	// Cached metadata and intermediate results describe the previous 
+	// data collection
+	//
+	_dvm.ClearCache();
+	_varInfoCacheSize_T.Clear();
+	_varInfoCacheDouble.Clear();
+	_varInfoCacheVoidPtr.Clear();
+	{
+		std::lock_guard <std::mutex> guard(_blkExtsCacheMutex);
+		_blkExtsCache.clear();
+	}
+
 	if (_dc) delete _dc;
 
 	_dc = NULL;
@@ -735,6 +908,21 @@ int DataMgr::Initialize(
 		SetErrMsg("Failed to get time coordinates");
 		return(-1);
 	}
+
+	if (! _metadataCacheDir.empty()) {
+		_metadataCacheSignature = _metadataCacheSig(files, options);
+
+		ostringstream oss;
+		oss << std::hex << std::hash <string> ()(_metadataCacheSignature);
+		_metadataCachePath = FileUtils::JoinPaths(
+			{_metadataCacheDir, "vapor_" + oss.str() + ".vmc"}
+		);
+
+		// A missing or stale sidecar file is not an error
+		//
+		(void) _loadMetadataCache();
+	}
+
 	return(0);
 }
 
@@ -796,8 +984,11 @@ vector <string> DataMgr::GetDataVarNames() const {
 vector <string> DataMgr::GetDataVarNames(int ndim) const {
 	VAssert(_dc);
 
-	if (_dataVarNamesCache[ndim].size()) {
-		return(_dataVarNamesCache[ndim]);
+	{
+		std::lock_guard <std::mutex> guard(_dataVarNamesCacheMutex);
+		if (_dataVarNamesCache[ndim].size()) {
+			return(_dataVarNamesCache[ndim]);
+		}
 	}
 
 	vector <string> vars = _dc->GetDataVarNames(ndim);
@@ -818,6 +1009,7 @@ vector <string> DataMgr::GetDataVarNames(int ndim) const {
 		validVars.push_back(vars[i]);
 	}
 
+	std::lock_guard <std::mutex> guard(_dataVarNamesCacheMutex);
 	_dataVarNamesCache[ndim] = validVars;
 	return(validVars);
 }
@@ -1073,7 +1265,7 @@ Grid *DataMgr::GetVariable (
 		return (new RegularGrid());
 	}
 
-	return(DataMgr::GetVariable(ts, varname, level, lod, min_ui, max_ui));
+	return(DataMgr::GetVariable(ts, varname, level, lod, min_ui, max_ui, lock));
 
 }
 
@@ -1694,15 +1886,19 @@ int DataMgr::GetDataRange(
 		return(0);
 	}
 
+	// Lock the grid so that it can't be evicted by another thread
+	// while we're iterating over it
+	//
 	const Grid *sg = DataMgr::GetVariable(
-		ts, varname, level, lod, min_ui, max_ui, false
+		ts, varname, level, lod, min_ui, max_ui, true
 	);
 	if (! sg) return(-1);
 
 	float range_f[2];
-	sg->GetRange(range_f);
+	sg->GetRange(range_f, _nthreads);
 	range = {range_f[0], range_f[1]};
 
+	UnlockGrid(sg);
 	delete sg;
 
 	_varInfoCacheDouble.Set(ts, varname, level, lod, key, range);
@@ -1710,6 +1906,308 @@ int DataMgr::GetDataRange(
 	return(0);
 }
 
+int DataMgr::GetDataMoments(
+	size_t ts,
+	string varname,
+	int level,
+	int lod,
+	vector <double> min, vector <double> max,
+	Moments &moments,
+	int nthreads
+) {
+	SetDiagMsg("DataMgr::GetDataMoments(%d,%s)", ts, varname.c_str());
+
+	moments = Moments();
+
+	int rc = _level_correction(varname, level);
+	if (rc<0) return(-1);
+
+	rc = _lod_correction(varname, lod);
+	if (rc<0) return(-1);
+
+	// The ROI, not just the bounding grid, determines which values
+	// contribute, so key the cache on its exact user coordinates
+	//
+	ostringstream oss;
+	oss.precision(17);
+	oss << "VariableMoments";
+	for (int i=0; i<min.size(); i++) oss << " " << min[i];
+	for (int i=0; i<max.size(); i++) oss << " " << max[i];
+	string key = oss.str();
+
+	vector <double> values;
+	if (_varInfoCacheDouble.Get(ts, varname, level, lod, key, values)) {
+		if (moments.Decode(values)) return(0);
+	}
+
+	//
+	// Find the coordinates in voxels of the grid that contains
+	// the axis aligned bounding box specified in user coordinates
+	// by min and max
+	//
+	vector <size_t> min_ui, max_ui;
+	rc = _find_bounding_grid(
+		ts, varname, level, lod, min, max, min_ui, max_ui
+	);
+	if (rc<0) return(-1);
+
+	// No grid points in the ROI
+	//
+	if (! min_ui.size()) return(0);
+
+	// Lock the grid so that it can't be evicted by another thread
+	// while we're iterating over it
+	//
+	const Grid *sg = DataMgr::GetVariable(
+		ts, varname, level, lod, min_ui, max_ui, true
+	);
+	if (! sg) return(-1);
+
+	// Each thread accumulates its own moments, which are merged at the
+	// end
+	//
+	nthreads = Grid::GetNumBlockThreads(nthreads ? nthreads : _nthreads);
+	vector <Moments> partial(nthreads);
+	float mv = sg->GetMissingValue();
+	sg->ForEachBlock(
+		min, max,
+		[&partial, mv](
+			int thread, const float *v, const unsigned char *mask, size_t n
+		) {
+			partial[thread].Add(v, mask, n, mv);
+		},
+		nthreads
+	);
+
+	UnlockGrid(sg);
+	delete sg;
+
+	for (int i=0; i<partial.size(); i++) moments.Merge(partial[i]);
+
+	_varInfoCacheDouble.Set(ts, varname, level, lod, key, moments.Encode());
+
+	return(0);
+}
+
+void DataMgr::SetVariableMetadata(
+	size_t ts, string varname, int level, int lod, string key,
+	const vector <double> &values
+) {
+	_varInfoCacheDouble.Set(ts, varname, level, lod, "User" + key, values);
+}
+
+bool DataMgr::GetVariableMetadata(
+	size_t ts, string varname, int level, int lod, string key,
+	vector <double> &values
+) const {
+	return(
+		_varInfoCacheDouble.Get(ts, varname, level, lod, "User" + key, values)
+	);
+}
+
+string DataMgr::_metadataCacheSig(
+	const vector <string> &files, const vector <string> &options
+) const {
+	ostringstream oss;
+
+	oss << _format;
+	for (int i=0; i<options.size(); i++) {
+		oss << " " << options[i];
+	}
+
+	// The data of a VDC live in files below its data directory, not 
+	// in the master file that is passed in. The size and modification
+	// time of every data file are folded into a single digest to keep 
+	// the signature short.
+	//
+	vector <string> paths;
+	for (int i=0; i<files.size(); i++) {
+		oss << " " << files[i];
+		paths.push_back(files[i]);
+		if (_format == "vdc" && VDCNetCDF::DataDirExists(files[i])) {
+			paths.push_back(VDCNetCDF::GetDataDir(files[i]));
+		}
+	}
+
+	uint64_t digest = FNVOffsetBasis;
+	size_t nfiles = 0;
+	for (int i=0; i<paths.size(); i++) {
+		file_digest(paths[i], digest, nfiles);
+	}
+	oss << " " << nfiles << ":" << std::hex << digest;
+
+	return(oss.str());
+}
+
+namespace {
+const string MetadataCacheMagic = "VAPOR_DATAMGR_METADATA_CACHE 1";
+
+// Limits of the sidecar files kept in a metadata cache directory.
+// Every data collection opened adds a file.
+//
+const long MetadataCacheMaxAge = 90L * 24 * 60 * 60;	// seconds
+const long long MetadataCacheMaxBytes = 64LL * 1024 * 1024;
+
+bool isMetadataCacheFile(const string &name) {
+	const string prefix = "vapor_";
+	const vector <string> suffixes = {".vmc", ".vmc.tmp"};
+
+	if (name.compare(0, prefix.size(), prefix) != 0) return(false);
+	for (auto &suffix : suffixes) {
+		if (name.size() > prefix.size() + suffix.size() &&
+			name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0) {
+
+			return(true);
+		}
+	}
+	return(false);
+}
+};
+
+int DataMgr::SaveMetadataCache() {
+	if (_metadataCachePath.empty()) return(0);
+
+	// Write to a temporary file and rename it so that a reader never
+	// sees a partially written cache
+	//
+	string tmppath = _metadataCachePath + ".tmp";
+	ofstream out(tmppath.c_str());
+	if (! out) {
+		SetErrMsg("Failed to open file %s : %M", tmppath.c_str());
+		return(-1);
+	}
+
+	out << std::setprecision(std::numeric_limits<double>::max_digits10);
+	out << MetadataCacheMagic << endl;
+	out << _metadataCacheSignature << endl;
+
+	_varInfoCacheSize_T.Write(out);
+	_varInfoCacheDouble.Write(out);
+
+	{
+		std::lock_guard <std::mutex> guard(_blkExtsCacheMutex);
+
+		ostringstream oss;
+		oss << std::setprecision(std::numeric_limits<double>::max_digits10);
+
+		size_t n = 0;
+		map <string, BlkExts>::const_iterator itr;
+		for (itr = _blkExtsCache.begin(); itr != _blkExtsCache.end(); ++itr) {
+			ostringstream blkoss;
+			blkoss << std::setprecision(std::numeric_limits<double>::max_digits10);
+			if (! itr->second.Write(blkoss)) continue;
+
+			oss << itr->first << endl << blkoss.str();
+			n++;
+		}
+		out << n << endl << oss.str();
+	}
+
+	out.close();
+	if (! out) {
+		SetErrMsg("Failed to write file %s", tmppath.c_str());
+		(void) remove(tmppath.c_str());
+		return(-1);
+	}
+
+	if (rename(tmppath.c_str(), _metadataCachePath.c_str()) != 0) {
+		SetErrMsg(
+			"rename(%s, %s) : %M", tmppath.c_str(), _metadataCachePath.c_str()
+		);
+		(void) remove(tmppath.c_str());
+		return(-1);
+	}
+
+	_pruneMetadataCache();
+
+	return(0);
+}
+
+void DataMgr::_pruneMetadataCache() const {
+	if (_metadataCacheDir.empty()) return;
+
+	// Sidecar files are rewritten each time their data collection is
+	// closed, so the modification time is the time of last use
+	//
+	vector <pair <long, string> > files;
+	long long totalBytes = 0;
+	long now = (long) time(NULL);
+	vector <string> names = FileUtils::ListFiles(_metadataCacheDir);
+	for (auto &name : names) {
+		if (! isMetadataCacheFile(name)) continue;
+
+		string path = FileUtils::JoinPaths({_metadataCacheDir, name});
+		if (path == _metadataCachePath) continue;
+
+		long long nbytes = FileUtils::GetFileSize(path);
+		if (nbytes < 0) continue;
+
+		long mtime = FileUtils::GetFileModifiedTime(path);
+		if (now - mtime > MetadataCacheMaxAge) {
+			(void) remove(path.c_str());
+			continue;
+		}
+		files.push_back(make_pair(mtime, path));
+		totalBytes += nbytes;
+	}
+
+	// Least recently used first. The file just written is always kept
+	//
+	totalBytes += std::max(FileUtils::GetFileSize(_metadataCachePath), 0LL);
+	std::sort(files.begin(), files.end());
+	for (auto &f : files) {
+		if (totalBytes <= MetadataCacheMaxBytes) break;
+
+		long long nbytes = FileUtils::GetFileSize(f.second);
+		if (remove(f.second.c_str()) == 0 && nbytes > 0) totalBytes -= nbytes;
+	}
+}
+
+int DataMgr::_loadMetadataCache() {
+	ifstream in(_metadataCachePath.c_str());
+	if (! in) return(-1);
+
+	string magic, signature;
+	getline(in, magic);
+	getline(in, signature);
+	if (magic != MetadataCacheMagic || signature != _metadataCacheSignature) {
+		return(-1);
+	}
+
+	bool ok = _varInfoCacheSize_T.Read(in) && _varInfoCacheDouble.Read(in);
+
+	map <string, BlkExts> blkExtsCache;
+	size_t n = 0;
+	if (ok) ok = (bool) (in >> n);
+	for (size_t i=0; i<n && ok; i++) {
+		string hash;
+		in >> std::ws;
+		getline(in, hash);
+
+		BlkExts blkexts;
+		ok = blkexts.Read(in);
+		if (ok) blkExtsCache[hash] = blkexts;
+	}
+
+	// Don't trust any of the contents of a file that can't be read 
+	// in its entirety. Everything discarded here can be recomputed
+	//
+	if (! ok) {
+		SetDiagMsg(
+			"DataMgr::_loadMetadataCache() - ignoring corrupt file %s",
+			_metadataCachePath.c_str()
+		);
+		_varInfoCacheSize_T.Clear();
+		_varInfoCacheDouble.Clear();
+		return(-1);
+	}
+
+	std::lock_guard <std::mutex> guard(_blkExtsCacheMutex);
+	_blkExtsCache.insert(blkExtsCache.begin(), blkExtsCache.end());
+
+	return(0);
+}
+
 int DataMgr::GetDimLensAtLevel( 
     string varname, int level, 
 	std::vector <size_t> &dims_at_level,
@@ -1912,6 +2410,11 @@ bool DataMgr::IsVariableDerived(string name) const {
 int DataMgr::AddDerivedVar(DerivedDataVar *derivedVar) {
 	string varname = derivedVar->GetName();
 
+	// The prefetch threads look up variables in _dvm. Stop them before
+	// changing it. They are restarted by the next Prefetch()
+	//
+	_stopPrefetch();
+
 	if (_dvm.HasVar(varname)) {
 		SetErrMsg("Variable named %s already defined", varname.c_str());
 		return(-1);
@@ -1921,18 +2424,30 @@ int DataMgr::AddDerivedVar(DerivedDataVar *derivedVar) {
 	// 
 	// Clear variable name cache
 	//
-	for (auto itr = _dataVarNamesCache.begin(); itr!=_dataVarNamesCache.end(); ++itr) {
-		vector <string> &ref = itr->second;
-		ref.clear();
+	{
+		std::lock_guard <std::mutex> guard(_dataVarNamesCacheMutex);
+		for (auto itr = _dataVarNamesCache.begin(); itr!=_dataVarNamesCache.end(); ++itr) {
+			vector <string> &ref = itr->second;
+			ref.clear();
+		}
 	}
 
+	// Discard any metadata for a previous definition of the variable, 
+	// including metadata restored from the persistent cache
+	//
 	_varInfoCacheSize_T.Purge(vector<string> ({varname}));
+	_varInfoCacheDouble.Purge(vector<string> ({varname}));
 
 	return(0);
 }
 
 void DataMgr::RemoveDerivedVar(string varname) {
 
+	// A prefetch thread may be using the variable, which the caller 
+	// is free to delete once we return
+	//
+	_stopPrefetch();
+
 	if (! _dvm.HasVar(varname)) return;
 
 	_dvm.RemoveVar(_dvm.GetVar(varname));
@@ -1942,9 +2457,12 @@ void DataMgr::RemoveDerivedVar(string varname) {
 	// 
 	// Clear variable name cache
 	//
-	for (auto itr = _dataVarNamesCache.begin(); itr!=_dataVarNamesCache.end(); ++itr) {
-		vector <string> &ref = itr->second;
-		ref.clear();
+	{
+		std::lock_guard <std::mutex> guard(_dataVarNamesCacheMutex);
+		for (auto itr = _dataVarNamesCache.begin(); itr!=_dataVarNamesCache.end(); ++itr) {
+			vector <string> &ref = itr->second;
+			ref.clear();
+		}
 	}
 
 	_varInfoCacheSize_T.Purge(vector<string> ({varname}));
@@ -1952,8 +2470,14 @@ void DataMgr::RemoveDerivedVar(string varname) {
 
 void	DataMgr::Clear() {
 
+	// Don't free regions that a prefetch thread is filling
+	//
+	_stopPrefetch();
+
 	_PipeLines.clear();
 
+	std::lock_guard <std::recursive_mutex> guard(_regionsMutex);
+
 	list <region_t>::iterator itr;
 	for(itr = _regionsList.begin(); itr!=_regionsList.end(); itr++) {
 		const region_t &region = *itr;
@@ -1961,31 +2485,274 @@ void	DataMgr::Clear() {
 		if (region.blks) _blk_mem_mgr->FreeMem(region.blks);
 			
 	}
+	_blksInUse = 0;
 	_regionsList.clear();
-
+	_regionsMap.clear();
+	_regionsBlksMap.clear();
 }
 
+DataMgr::CacheStats DataMgr::GetCacheStats() const {
+	std::lock_guard <std::recursive_mutex> guard(_regionsMutex);
 
-	
+	CacheStats stats = _cacheStats;
+	stats.regions = _regionsList.size();
+	return(stats);
+}
 
-void	DataMgr::UnlockGrid(
-	const Grid *rg
+void DataMgr::ResetCacheStats() {
+	std::lock_guard <std::recursive_mutex> guard(_regionsMutex);
+	_cacheStats = CacheStats();
+}
+
+std::shared_future <int> DataMgr::Prefetch(
+	size_t ts, string varname, int level, int lod,
+	vector <double> min, vector <double> max
 ) {
-	SetDiagMsg("DataMgr::UnlockGrid()");
-	const vector <float *> &blks = rg->GetBlks();
-	if (blks.size()) _unlock_blocks(blks[0]);
+	SetDiagMsg(
+		"DataMgr::Prefetch(%d, %s, %d, %d)", ts,varname.c_str(), level, lod
+	);
 
-	const LayeredGrid *lg = dynamic_cast<const LayeredGrid *>(rg);
-	if (lg) {
-		const Grid &rg = lg->GetZRG();
-		if (rg.GetBlks().size()) _unlock_blocks(rg.GetBlks()[0]);
+	// Derived data variables (e.g. Python variables) may only be 
+	// evaluated on the calling thread, and are not prefetched
+	//
+	if (_getDerivedDataVar(varname)) {
+		std::promise <int> promise;
+		promise.set_value(-1);
+		return(promise.get_future().share());
 	}
-}
 
-size_t DataMgr::GetNumDimensions(string varname) const {
-	VAssert(_dc);
+	std::lock_guard <std::mutex> guard(_prefetchMutex);
 
-	DC::DataVar dvar;
+	// Coalesce with a pending request for the same region
+	//
+	for (auto itr = _prefetchQueue.begin(); itr!=_prefetchQueue.end(); ++itr) {
+		if (itr->ts == ts && itr->varname == varname && 
+			itr->level == level && itr->lod == lod &&
+			itr->min == min && itr->max == max) {
+
+			return(itr->future);
+		}
+	}
+
+	prefetch_request_t req;
+	req.ts = ts;
+	req.varname = varname;
+	req.level = level;
+	req.lod = lod;
+	req.min = min;
+	req.max = max;
+	req.promise = std::make_shared <std::promise <int> > ();
+	req.future = req.promise->get_future().share();
+
+	_prefetchQueue.push_back(req);
+
+	// Grow the pool if all of the workers are busy
+	//
+	int maxThreads = std::min(
+		Grid::GetNumBlockThreads(_nthreads), MaxPrefetchThreads
+	);
+	if (! _prefetchIdle && (int) _prefetchThreads.size() < maxThreads) {
+		_prefetchThreads.push_back(
+			std::thread(&DataMgr::_prefetchWorker, this)
+		);
+		_prefetchIdle++;
+	}
+	_prefetchCond.notify_one();
+
+	return(req.future);
+}
+
+void DataMgr::PrefetchAhead(
+	size_t ts, string varname, int level, int lod,
+	vector <double> min, vector <double> max
+) {
+	if (_prefetchWindow < 1 || varname.empty()) return;
+	if (_getDerivedDataVar(varname)) return;
+
+	size_t window = _prefetchWindow;
+
+	// Cancel pending requests that are no longer ahead of the current 
+	// time step
+	//
+	{
+		std::lock_guard <std::mutex> guard(_prefetchMutex);
+
+		auto itr = _prefetchQueue.begin();
+		while (itr != _prefetchQueue.end()) {
+			if (itr->varname == varname && 
+				(itr->ts <= ts || itr->ts > ts + window)) {
+
+				itr->promise->set_value(-1);
+				itr = _prefetchQueue.erase(itr);
+			}
+			else ++itr;
+		}
+	}
+
+	size_t nts = GetNumTimeSteps(varname);
+	for (size_t i=1; i<=window && ts+i < nts; i++) {
+		(void) Prefetch(ts+i, varname, level, lod, min, max);
+	}
+}
+
+void DataMgr::SetPrefetchWindow(int n) {
+	if (n < 0) n = 0;
+	_prefetchWindow = n;
+
+	if (! _prefetchWindow) CancelPrefetch();
+}
+
+void DataMgr::CancelPrefetch() {
+	std::lock_guard <std::mutex> guard(_prefetchMutex);
+
+	for (auto itr = _prefetchQueue.begin(); itr!=_prefetchQueue.end(); ++itr) {
+		itr->promise->set_value(-1);
+	}
+	_prefetchQueue.clear();
+}
+
+void DataMgr::_prefetchWorker() {
+	IsPrefetchThread = true;
+
+	// Failures are reported through the request's future. The message
+	// callbacks (e.g. the GUI's) must not be called from this thread
+	//
+	(void) EnableErrMsg(false);
+	(void) EnableDiagMsg(false);
+
+	std::unique_lock <std::mutex> lock(_prefetchMutex);
+	for (;;) {
+		_prefetchCond.wait(lock, [this] {
+			return(_prefetchShutdown || ! _prefetchQueue.empty());
+		});
+		if (_prefetchShutdown) return;
+
+		prefetch_request_t req = _prefetchQueue.front();
+		_prefetchQueue.pop_front();
+		_prefetchIdle--;
+		lock.unlock();
+
+		int rc = _prefetchRegion(req);
+		req.promise->set_value(rc);
+
+		lock.lock();
+		_prefetchIdle++;
+	}
+}
+
+int DataMgr::_prefetchRegion(const prefetch_request_t &req) {
+
+	int level = req.level;
+	int lod = req.lod;
+
+	int rc = _level_correction(req.varname, level);
+	if (rc<0) return(-1);
+
+	rc = _lod_correction(req.varname, lod);
+	if (rc<0) return(-1);
+
+	if (! VariableExists(req.ts, req.varname, level, lod)) return(-1);
+
+	// Extents may have more dimensions than the variable (e.g. a 3D
+	// box for a 2D variable)
+	//
+	vector <string> coord_vars;
+	bool ok = GetVarCoordVars(req.varname, true, coord_vars);
+	if (! ok) return(-1);
+
+	vector <double> min = req.min;
+	vector <double> max = req.max;
+	while (min.size() > coord_vars.size()) {
+		min.pop_back();
+		max.pop_back();
+	}
+
+	vector <size_t> min_ui, max_ui;
+	rc = _find_bounding_grid(
+		req.ts, req.varname, level, lod, min, max, min_ui, max_ui
+	);
+	if (rc<0) return(-1);
+
+	// Region doesn't intersect the variable. Nothing to read.
+	//
+	if (! min_ui.size()) return(0);
+
+	// The grid is discarded, but the data remain in the cache
+	//
+	Grid *rg = _getVariable(
+		req.ts, req.varname, level, lod, min_ui, max_ui, false, false
+	);
+	if (! rg) return(-1);
+
+	delete rg;
+	return(0);
+}
+
+void DataMgr::_stopPrefetch() {
+	{
+		std::lock_guard <std::mutex> guard(_prefetchMutex);
+		_prefetchShutdown = true;
+
+		for (auto itr = _prefetchQueue.begin(); itr!=_prefetchQueue.end(); ++itr) {
+			itr->promise->set_value(-1);
+		}
+		_prefetchQueue.clear();
+	}
+	_prefetchCond.notify_all();
+
+	for (int i=0; i<_prefetchThreads.size(); i++) {
+		_prefetchThreads[i].join();
+	}
+	_prefetchThreads.clear();
+	_prefetchIdle = 0;
+
+	_prefetchShutdown = false;
+}
+
+size_t DataMgr::region_key_hash_t::operator()(
+	const region_key_t &key
+) const {
+
+	// Combine member hashes as boost::hash_combine does
+	//
+	size_t seed = std::hash<string>()(key.varname);
+	auto combine = [&seed](size_t h) {
+		seed ^= h + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+	};
+
+	combine(std::hash<size_t>()(key.ts));
+	combine(std::hash<int>()(key.level));
+	combine(std::hash<int>()(key.lod));
+	for (int i=0; i<key.bmin.size(); i++) {
+		combine(std::hash<size_t>()(key.bmin[i]));
+	}
+	for (int i=0; i<key.bmax.size(); i++) {
+		combine(std::hash<size_t>()(key.bmax[i]));
+	}
+	return(seed);
+}
+
+
+	
+
+void	DataMgr::UnlockGrid(
+	const Grid *rg
+) {
+	SetDiagMsg("DataMgr::UnlockGrid()");
+	const vector <float *> &blks = rg->GetBlks();
+	if (blks.size()) _unlock_blocks(blks[0]);
+
+	const LayeredGrid *lg = dynamic_cast<const LayeredGrid *>(rg);
+	if (lg) {
+		const Grid &rg = lg->GetZRG();
+		if (rg.GetBlks().size()) _unlock_blocks(rg.GetBlks()[0]);
+	}
+}
+
+size_t DataMgr::GetNumDimensions(string varname) const {
+	VAssert(_dc);
+
+	DC::DataVar dvar;
 	bool status = GetDataVarInfo(varname, dvar);
 
 	if (status) {
@@ -2032,34 +2799,35 @@ T	*DataMgr::_get_region_from_cache(
 	bool	lock
 ) {
 
-	list <region_t>::iterator itr;
-	for(itr = _regionsList.begin(); itr!=_regionsList.end(); itr++) {
-		region_t &region = *itr;
-
-		if (region.ts == ts &&
-			region.varname.compare(varname) == 0 &&
-			region.level == level &&
-			region.lod == lod &&
-			region.bmin == bmin &&
-			region.bmax == bmax) {
-
-			// Increment the lock counter
-			region.lock_counter += lock ? 1 : 0;
-
-			// Move region to front of list
-			region_t tmp_region = region;
-			_regionsList.erase(itr);
-			_regionsList.push_back(tmp_region);
-
-			SetDiagMsg(
-				"DataMgr::_get_region_from_cache() - data in cache %xll\n",
-				 tmp_region.blks
-			);
-			return((T *) tmp_region.blks);
-		}
-	}
+	std::lock_guard <std::recursive_mutex> guard(_regionsMutex);
 
-	return(NULL);
+	auto mitr = _regionsMap.find(
+		region_key_t(ts, varname, level, lod, bmin, bmax)
+	);
+	if (mitr == _regionsMap.end()) return(NULL);
+
+	region_itr_t itr = mitr->second;
+	region_t &region = *itr;
+
+	// Region is allocated but another thread is still reading it
+	//
+	if (! region.valid) return(NULL);
+
+	// Increment the lock counter
+	region.lock_counter += lock ? 1 : 0;
+
+	// Move region to the most recently used end of the list. Splicing
+	// preserves iterators, so the indices remain valid
+	//
+	_regionsList.splice(_regionsList.end(), _regionsList, itr);
+
+	_cacheStats.hits++;
+
+	SetDiagMsg(
+		"DataMgr::_get_region_from_cache() - data in cache %xll\n",
+		 region.blks
+	);
+	return((T *) region.blks);
 }
 
 template <typename T>
@@ -2075,14 +2843,14 @@ int DataMgr::_get_unblocked_region_from_fs(
 	int fd = _openVariableRead(ts, varname, level, lod);
     if (fd < 0) return(fd);
 
-	T *region = new T[VProduct(Dims(grid_min, grid_max))];
-
 	int nlevels = DataMgr::GetNumRefLevels(varname);
 
 	// Downsample the data if needed
 	//
 	if (level < -nlevels) {
 
+		T *region = new T[VProduct(Dims(grid_min, grid_max))];
+
 		vector <size_t> dims;
 		int rc = GetDimLensAtLevel(varname, level, dims);
 		VAssert(rc>=0);
@@ -2104,9 +2872,11 @@ int DataMgr::_get_unblocked_region_from_fs(
 
 		T *buf = new T[VProduct(Dims(file_min, file_max))];
 
-		rc = _readRegion(fd, file_min, file_max, buf);
+		rc = _readRegion(fd, varname, file_min, file_max, buf);
 		if (rc<0) {
 			delete [] buf;
+			delete [] region;
+			(void) _closeVariable(fd, varname); 
 			return(-1);
 		}
 
@@ -2115,21 +2885,64 @@ int DataMgr::_get_unblocked_region_from_fs(
 		);
 
 		if (buf) delete [] buf;
+
+		copy_block(region, blks, grid_min, grid_max, grid_bs, grid_min, grid_max);
+
+		if (region) delete [] region;
+
+		(void) _closeVariable(fd, varname); 
+		return(0);
 	}
-	else {
-		
-		int rc = _readRegion(fd, grid_min, grid_max, region);
+
+	// If the region spans exactly one block along every axis but the 
+	// slowest varying one, the blocked layout of the cache is identical
+	// to the contiguous layout of the region, and the data may be read
+	// directly into the cache with no intermediate copy.
+	//
+	size_t ndims = grid_min.size();
+	bool direct = true;
+	for (int i=0; i<(int) ndims - 1; i++) {
+		if (grid_max[i] - grid_min[i] + 1 != grid_bs[i]) direct = false;
+	}
+
+	if (direct) {
+		int rc = _readRegion(fd, varname, grid_min, grid_max, blks);
+		(void) _closeVariable(fd, varname); 
+		return(rc < 0 ? -1 : 0);
+	}
+
+	// Otherwise read one slab of blocks along the slowest varying axis at
+	// a time. This bounds the temporary buffer by the size of a slab 
+	// rather than the size of the entire region
+	//
+	vector <size_t> slab_min = grid_min;
+	vector <size_t> slab_max = grid_max;
+	size_t slab_bs = ndims ? grid_bs[ndims-1] : 1;
+	if (ndims) slab_max[ndims-1] = min(
+		grid_max[ndims-1], grid_min[ndims-1] + slab_bs - 1
+	);
+
+	ScratchBuffer <T> scratch(
+		VProduct(Dims(slab_min, slab_max)), _maxScratchSize()
+	);
+	T *slab = scratch.Data();
+
+	while (true) {
+		int rc = _readRegion(fd, varname, slab_min, slab_max, slab);
 		if (rc<0) {
-			if (region) delete [] region;
+			(void) _closeVariable(fd, varname); 
 			return(-1);
 		}
-	}
 
-	copy_block(region, blks, grid_min, grid_max, grid_bs, grid_min, grid_max);
+		copy_block(slab, blks, slab_min, slab_max, grid_bs, grid_min, grid_max);
 
-	(void) _closeVariable(fd); 
+		if (! ndims || slab_max[ndims-1] >= grid_max[ndims-1]) break;
 
-	if (region) delete [] region;
+		slab_min[ndims-1] += slab_bs;
+		slab_max[ndims-1] = min(grid_max[ndims-1], slab_max[ndims-1] + slab_bs);
+	}
+
+	(void) _closeVariable(fd, varname); 
 
 	return(0);
 }
@@ -2170,15 +2983,18 @@ int DataMgr::_get_blocked_region_from_fs(
 
 	vector <size_t> file_min, file_max;
 	map_blk_to_vox(file_bs, bmin, bmax, file_min, file_max);
-	T *file_block = new T[VProduct(Dims(file_min,file_max))];
+	ScratchBuffer <T> scratch(
+		VProduct(Dims(file_min,file_max)), _maxScratchSize()
+	);
+	T *file_block = scratch.Data();
 
 	for (size_t i=0; i<nreads; i++) {
 
 		map_blk_to_vox(file_bs, file_dims, bmin, bmax, file_min, file_max);
 
-		int rc = _readRegion(fd, file_min, file_max, file_block);
+		int rc = _readRegion(fd, varname, file_min, file_max, file_block);
 		if (rc<0) {
-			delete [] file_block;
+			(void) _closeVariable(fd, varname); 
 			return(-1);
 		}
 
@@ -2193,9 +3009,7 @@ int DataMgr::_get_blocked_region_from_fs(
 		bmax = IncrementCoords(file_bmin, file_bmax, bmax, 2);
 	}
 
-	(void) _closeVariable(fd); 
-
-	if (file_block) delete [] file_block;
+	(void) _closeVariable(fd, varname); 
 
 	return(0);
 }
@@ -2248,6 +3062,15 @@ T *DataMgr::_get_region_from_fs(
 		return(NULL);
 	}
 
+	// Data are now available to other threads
+	//
+	{
+		std::lock_guard <std::recursive_mutex> guard(_regionsMutex);
+		auto mitr = _regionsBlksMap.find(blks);
+		VAssert(mitr != _regionsBlksMap.end());
+		mitr->second->valid = true;
+	}
+
 	SetDiagMsg("DataMgr::GetGrid() - data read from fs\n");
 	return(blks);
 }
@@ -2276,12 +3099,37 @@ T *DataMgr::_get_region(
 	);
 	if (! blks ) {
 
-		blks = (T *) _get_region_from_fs<T>(
-			ts, varname, level, lod, dims, bs, bmin, bmax, lock
+		// Only one thread reads a given variable and time step at a time.
+		// If another thread was already reading this region it will be in
+		// the cache by the time we acquire the lock, and is not read a 
+		// second time. Other reads proceed concurrently, except for the 
+		// calls into the DC itself (see _lockDC()).
+		//
+		std::lock_guard <std::recursive_mutex> guard(
+			_varReadMutex(ts, varname)
 		);
 
+		blks = _get_region_from_cache<T>(
+			ts, varname, level, lod, bmin, bmax, lock
+		);
+
+		if (! blks) {
+			{
+				std::lock_guard <std::recursive_mutex> rguard(_regionsMutex);
+				_cacheStats.misses++;
+			}
+
+			blks = (T *) _get_region_from_fs<T>(
+				ts, varname, level, lod, dims, bs, bmin, bmax, lock
+			);
+		}
 	}
 	if (! blks) {
+
+		// Prefetch failures are reported through the request's future
+		//
+		if (IsPrefetchThread) return(NULL);
+
 		SetErrMsg(
 			"Failed to read region from variable/timestep/level/lod (%s, %d, %d, %d)",
 			varname.c_str(), ts, level, lod
@@ -2365,14 +3213,20 @@ void	*DataMgr::_alloc_region(
 	VAssert(bmin.size() == bmax.size());
 	VAssert(bmin.size() == bs.size());
 
+	std::lock_guard <std::recursive_mutex> guard(_regionsMutex);
+
 	size_t mem_block_size;
 	if (! _blk_mem_mgr) {
 
 		mem_block_size = 1024 * 1024;
 
-		size_t num_blks = (_mem_size * 1024 * 1024) / mem_block_size;
+		size_t num_blks = max(
+			_blockCacheSize() / mem_block_size, (size_t) 1
+		);
 
-		BlkMemMgr::RequestMemSize(mem_block_size, num_blks);
+		BlkMemMgr::RequestMemSize(
+			mem_block_size, num_blks, true, _hugePages
+		);
 		_blk_mem_mgr = new BlkMemMgr();
 	}
 	mem_block_size = BlkMemMgr::GetBlkSize();
@@ -2389,28 +3243,40 @@ void	*DataMgr::_alloc_region(
 	
 	size_t nblocks = (size_t) ceil((double) size / (double) mem_block_size);
 		
-	void *blks;
-	while (! (blks = (void *) _blk_mem_mgr->Alloc(nblocks, fill))) {
-		if (! _free_lru()) {
+	void *blks = NULL;
+	while (! blks) {
+		if (_fitsBlockCache(nblocks)) {
+			blks = (void *) _blk_mem_mgr->Alloc(nblocks, fill);
+			if (blks) break;
+		}
+
+		// Prefetch requests may only use free memory
+		//
+		if (IsPrefetchThread) return(NULL);
+
+		// Evict regions first, then whatever the caches that share the
+		// budget hold
+		//
+		if (! _free_lru() && ! _trimSharedCaches(nblocks)) {
 			SetErrMsg("Failed to allocate requested memory");
 			return(NULL);
 		}
 	}
+	_blksInUse += nblocks;
 
 	region_t region;
 
-	region.ts = ts;
-	region.varname = varname;
-	region.level = level;
-	region.lod = lod;
-	region.bmin = bmin;
-	region.bmax = bmax;
+	region.key = region_key_t(ts, varname, level, lod, bmin, bmax);
 	region.lock_counter = lock ? 1 : 0;
 	region.blks = blks;
+	region.nblks = nblocks;
+	region.valid = false;
 
-	_regionsList.push_back(region);
+	region_itr_t itr = _regionsList.insert(_regionsList.end(), region);
+	_regionsMap[itr->key] = itr;
+	_regionsBlksMap[itr->blks] = itr;
 
-	return(region.blks);
+	return(itr->blks);
 }
 
 void	DataMgr::_free_region(
@@ -2422,45 +3288,33 @@ void	DataMgr::_free_region(
 	vector <size_t> bmax,
 	bool forceFlag
 ) {
+	std::lock_guard <std::recursive_mutex> guard(_regionsMutex);
 
-	list <region_t>::iterator itr;
-	for(itr = _regionsList.begin(); itr!=_regionsList.end(); itr++) {
-		const region_t &region = *itr;
-
-		if (region.ts == ts &&
-			region.varname.compare(varname) == 0 &&
-			region.level == level &&
-			region.lod == lod &&
-			region.bmin == bmin &&
-			region.bmax == bmax)  {
+	auto mitr = _regionsMap.find(
+		region_key_t(ts, varname, level, lod, bmin, bmax)
+	);
+	if (mitr == _regionsMap.end()) return;
 
-			if (region.lock_counter == 0 || forceFlag) {
-				if (region.blks) _blk_mem_mgr->FreeMem(region.blks);
-				
-				_regionsList.erase(itr);
-				return;
-			}
-		}
+	region_itr_t itr = mitr->second;
+	if (itr->lock_counter == 0 || forceFlag) {
+		_erase_region(itr);
 	}
-
-	return;
 }
 
 
 void	DataMgr::_free_var(string varname) {
 
-	list <region_t>::iterator itr;
-	for(itr = _regionsList.begin(); itr!=_regionsList.end(); ) {
-		const region_t &region = *itr;
+	std::lock_guard <std::recursive_mutex> guard(_regionsMutex);
 
-		if (region.varname.compare(varname) == 0) {
+	region_itr_t itr;
+	for(itr = _regionsList.begin(); itr!=_regionsList.end(); ) {
+		region_itr_t next = itr;
+		++next;
 
-			if (region.blks) _blk_mem_mgr->FreeMem(region.blks);
-				
-			_regionsList.erase(itr);
-			itr = _regionsList.begin();
+		if (itr->key.varname.compare(varname) == 0) {
+			_erase_region(itr);
 		}
-		else itr++;
+		itr = next;
 	}
  
 	_varInfoCacheSize_T.Purge(vector <string> (1,varname));
@@ -2473,15 +3327,16 @@ void	DataMgr::_free_var(string varname) {
 bool	DataMgr::_free_lru(
 ) {
 
+	std::lock_guard <std::recursive_mutex> guard(_regionsMutex);
+
 	// The least recently used region is at the front of the list
 	//
-	list <region_t>::iterator itr;
+	region_itr_t itr;
 	for(itr = _regionsList.begin(); itr!=_regionsList.end(); itr++) {
-		const region_t &region = *itr;
 
-		if (region.lock_counter == 0) {
-			if (region.blks) _blk_mem_mgr->FreeMem(region.blks);
-			_regionsList.erase(itr);
+		if (itr->lock_counter == 0) {
+			_erase_region(itr);
+			_cacheStats.evictions++;
 			return(true);
 		}
 	}
@@ -2489,6 +3344,46 @@ bool	DataMgr::_free_lru(
 	// nothing to free
 	return(false);
 }
+
+void	DataMgr::_erase_region(region_itr_t itr) {
+
+	if (itr->blks) {
+		_blk_mem_mgr->FreeMem(itr->blks);
+		_regionsBlksMap.erase(itr->blks);
+		_blksInUse -= itr->nblks;
+	}
+	_regionsMap.erase(itr->key);
+	_regionsList.erase(itr);
+}
+
+bool	DataMgr::_fitsBlockCache(size_t nblocks) const {
+	size_t nbytes = (_blksInUse + nblocks) * BlkMemMgr::GetBlkSize();
+	return(nbytes + _sharedCacheBytes() <= _blockCacheSize());
+}
+
+bool	DataMgr::_trimSharedCaches(size_t nblocks) {
+	size_t shared = _sharedCacheBytes();
+	if (! shared) return(false);
+
+	// Bytes over budget once the blocks are allocated. If the blocks 
+	// fit, the pool is too fragmented, and evicting everything is all
+	// that is left to try
+	//
+	size_t nbytes = (_blksInUse + nblocks) * BlkMemMgr::GetBlkSize();
+	size_t over = nbytes + shared > _blockCacheSize() ? 
+		nbytes + shared - _blockCacheSize() : shared;
+
+	// Intermediate results are cheaper to recompute than search indices
+	//
+	size_t dvBytes = _dvm.GetCacheBytes();
+	_dvm.TrimCache(dvBytes > over ? dvBytes - over : 0);
+	over -= std::min(over, dvBytes);
+
+	size_t ghBytes = _gridHelper.GetCacheBytes();
+	_gridHelper.TrimCache(ghBytes > over ? ghBytes - over : 0);
+
+	return(_sharedCacheBytes() < shared);
+}
 	
 
 
@@ -2694,6 +3589,8 @@ void DataMgr::VarInfoCache<C>::Set(
 	const vector <C> &values
 ) {
 	string hash = _make_hash(key, ts, varnames, level, lod);
+
+	std::lock_guard <std::mutex> guard(_mutex);
 	_cache[hash] = values;
 }
 
@@ -2705,6 +3602,8 @@ bool DataMgr::VarInfoCache<C>::Get(
 	values.clear();
 
 	string hash = _make_hash(key, ts, varnames, level, lod);
+
+	std::lock_guard <std::mutex> guard(_mutex);
 	typename map <string, vector <C>>::const_iterator itr = _cache.find(hash);
 
 	if (itr == _cache.end()) return(false);
@@ -2718,6 +3617,8 @@ void DataMgr::VarInfoCache<C>::Purge(
 	size_t ts, vector <string> varnames, int level, int lod, string key
 ) {
 	string hash = _make_hash(key, ts, varnames, level, lod);
+
+	std::lock_guard <std::mutex> guard(_mutex);
 	typename map <string, vector <C> >::iterator itr = _cache.find(hash);
 
 	if (itr == _cache.end()) return;
@@ -2730,6 +3631,8 @@ void DataMgr::VarInfoCache<C>::Purge(
 	vector <string> varnames
 ) {
 
+	std::lock_guard <std::mutex> guard(_mutex);
+
 	vector <string> hashes;
 	typename map <string, std::vector <C> >::iterator itr;
 	for (itr=_cache.begin(); itr!= _cache.end(); ++itr) {
@@ -2747,9 +3650,61 @@ void DataMgr::VarInfoCache<C>::Purge(
 		_decode_hash(hash, key, ts, cvarnames, level, lod);
 
 		if (varnames == cvarnames) {
-			Purge(ts, varnames, level, lod, key);
+			_cache.erase(hash);
+		}
+	}
+}
+
+template <typename C>
+void DataMgr::VarInfoCache<C>::Write(std::ostream &o) const {
+	std::lock_guard <std::mutex> guard(_mutex);
+
+	// Non-finite values can't be read back in, so entries containing
+	// them are not written
+	//
+	size_t n = 0;
+	typename map <string, vector <C> >::const_iterator itr;
+	for (itr=_cache.begin(); itr!= _cache.end(); ++itr) {
+		if (all_finite(itr->second)) n++;
+	}
+
+	o << n << endl;
+
+	for (itr=_cache.begin(); itr!= _cache.end(); ++itr) {
+		const vector <C> &values = itr->second;
+		if (! all_finite(values)) continue;
+
+		o << itr->first << endl;
+		o << values.size();
+		for (int i=0; i<values.size(); i++) {
+			o << " " << values[i];
+		}
+		o << endl;
+	}
+}
+
+template <typename C>
+bool DataMgr::VarInfoCache<C>::Read(std::istream &in) {
+	size_t n;
+	if (! (in >> n)) return(false);
+
+	map <string, vector <C> > cache;
+	for (size_t i=0; i<n; i++) {
+		string hash;
+		size_t nvalues;
+		in >> std::ws;
+		if (! getline(in, hash) || ! (in >> nvalues)) return(false);
+
+		vector <C> values(nvalues);
+		for (size_t j=0; j<nvalues; j++) {
+			if (! (in >> values[j])) return(false);
 		}
+		cache[hash] = values;
 	}
+
+	std::lock_guard <std::mutex> guard(_mutex);
+	_cache.insert(cache.begin(), cache.end());
+	return(true);
 }
 
 DataMgr::BlkExts::BlkExts() {
@@ -2788,6 +3743,53 @@ void DataMgr::BlkExts::Insert(
 
 }
 
+bool DataMgr::BlkExts::Write(std::ostream &o) const {
+	for (size_t offset=0; offset<_mins.size(); offset++) {
+		if (! all_finite(_mins[offset]) || ! all_finite(_maxs[offset])) {
+			return(false);
+		}
+	}
+
+	o << _bmin.size();
+	for (int i=0; i<_bmin.size(); i++) o << " " << _bmin[i] << " " << _bmax[i];
+	o << endl;
+
+	for (size_t offset=0; offset<_mins.size(); offset++) {
+		o << _mins[offset].size();
+		for (int j=0; j<_mins[offset].size(); j++) {
+			o << " " << _mins[offset][j] << " " << _maxs[offset][j];
+		}
+		o << endl;
+	}
+	return(true);
+}
+
+bool DataMgr::BlkExts::Read(std::istream &in) {
+	size_t ndim;
+	if (! (in >> ndim) || ndim < 1 || ndim > 3) return(false);
+
+	vector <size_t> bmin(ndim), bmax(ndim);
+	for (int i=0; i<ndim; i++) {
+		if (! (in >> bmin[i] >> bmax[i]) || bmin[i] > bmax[i]) return(false);
+	}
+
+	BlkExts blkexts(bmin, bmax);
+	for (size_t offset=0; offset<blkexts._mins.size(); offset++) {
+		size_t n;
+		if (! (in >> n) || n > 3) return(false);
+
+		blkexts._mins[offset].resize(n);
+		blkexts._maxs[offset].resize(n);
+		for (int j=0; j<n; j++) {
+			in >> blkexts._mins[offset][j] >> blkexts._maxs[offset][j];
+		}
+		if (! in) return(false);
+	}
+
+	*this = blkexts;
+	return(true);
+}
+
 bool DataMgr::BlkExts::Intersect(
     const std::vector <double> &min,
     const std::vector <double> &max,
@@ -3162,9 +4164,16 @@ int DataMgr::_find_bounding_grid(
 	// See if bounding volumes for individual blocks are already 
 	// cached for this grid
 	//
+	// N.B. std::map iterators remain valid after insertions, and
+	// entries are never removed, so the mutex need only be held
+	// while the map itself is accessed
+	//
+	std::unique_lock <std::mutex> blkExtsLock(_blkExtsCacheMutex);
 	map <string, BlkExts >::iterator itr = _blkExtsCache.find(hash);
+	bool found = itr != _blkExtsCache.end();
+	blkExtsLock.unlock();
 
-	if (itr == _blkExtsCache.end()) {
+	if (! found) {
 		SetDiagMsg(
 			"DataMgr::_find_bounding_grid() - coordinates not in cache"
 		);
@@ -3172,7 +4181,7 @@ int DataMgr::_find_bounding_grid(
 		// Get a "dataless" Grid - a Grid class the contains
 		// coordiante information, but not data
 		//
-		Grid *rg = _getVariable(ts, varname, level, lod, false, true);
+		Grid *rg = _getVariable(ts, varname, level, lod, true, true);
 		if (! rg) return(-1);
 
 		// Voxel and block min and max coordinates of entire grid
@@ -3224,11 +4233,16 @@ int DataMgr::_find_bounding_grid(
 
 		} 
 
+		UnlockGrid(rg);
+		delete rg;
+
 		// Add to the hash table
 		//
+		blkExtsLock.lock();
 		_blkExtsCache[hash] = blkexts;
 		itr = _blkExtsCache.find(hash);
 		VAssert (itr != _blkExtsCache.end());
+		blkExtsLock.unlock();
 
 	}
 	else {
@@ -3268,17 +4282,13 @@ int DataMgr::_find_bounding_grid(
 void	DataMgr::_unlock_blocks(
 	const void *blks
 ) {
+	std::lock_guard <std::recursive_mutex> guard(_regionsMutex);
 
-	list <region_t>::iterator itr;
-	for(itr = _regionsList.begin(); itr!=_regionsList.end(); itr++) {
-		region_t &region = *itr;
+	auto mitr = _regionsBlksMap.find(blks);
+	if (mitr == _regionsBlksMap.end()) return;
 
-		if (region.blks == blks && region.lock_counter>0) {
-			region.lock_counter--;
-			return;
-		}
-	}
-	return;
+	region_t &region = *(mitr->second);
+	if (region.lock_counter>0) region.lock_counter--;
 }
 
 vector <string> DataMgr::_getDataVarNamesDerived(int ndim) const {
@@ -3541,33 +4551,62 @@ DerivedCoordVar *DataMgr::_getDerivedCoordVar(string varname) const {
 	return(NULL);
 }
 
+std::recursive_mutex &DataMgr::_varReadMutex(size_t ts, string varname) {
+
+	std::lock_guard <std::mutex> guard(_varReadMutexesMutex);
+
+	std::unique_ptr <std::recursive_mutex> &m = _varReadMutexes[
+		std::make_pair(ts, varname)
+	];
+	if (! m) m.reset(new std::recursive_mutex());
+	return(*m);
+}
+
+std::unique_lock <std::recursive_mutex> DataMgr::_lockDC(string varname) {
+
+	// Derived data variables (e.g. Python variables) read their inputs 
+	// through the DataMgr, which locks the DC itself for each input.
+	//
+	if (_getDerivedDataVar(varname)) {
+		return(std::unique_lock <std::recursive_mutex> (
+			_dcMutex, std::defer_lock
+		));
+	}
+
+	return(std::unique_lock <std::recursive_mutex> (_dcMutex));
+}
+
 int DataMgr::_openVariableRead(size_t ts, string varname, int level, int lod) {
 
-	_openVarName = varname;
+	std::unique_lock <std::recursive_mutex> guard = _lockDC(varname);
 
-	DerivedVar *derivedVar = _getDerivedVar(_openVarName);
+	DerivedVar *derivedVar = _getDerivedVar(varname);
 	if (derivedVar) {
 		return (derivedVar->OpenVariableRead(ts, level, lod));
 	}
 
-	return (_dc->OpenVariableRead(ts, _openVarName, level, lod));
+	return (_dc->OpenVariableRead(ts, varname, level, lod));
 }
 
 
 template <class T>
 int DataMgr::_readRegionBlock(
-	int fd,
+	int fd, string varname,
 	const vector <size_t> &min, const vector <size_t> &max, T *region
 ) {
 
 	int rc = 0;
-	DerivedVar *derivedVar = _getDerivedVar(_openVarName);
-	if (derivedVar) {
-		VAssert ((std::is_same<T,float>::value) == true);
-		rc = derivedVar->ReadRegionBlock(fd, min, max, (float *) region);
-	}
-	else {
-		rc = _dc->ReadRegionBlock(fd, min, max, region);
+	{
+		std::unique_lock <std::recursive_mutex> guard = _lockDC(varname);
+
+		DerivedVar *derivedVar = _getDerivedVar(varname);
+		if (derivedVar) {
+			VAssert ((std::is_same<T,float>::value) == true);
+			rc = derivedVar->ReadRegionBlock(fd, min, max, (float *) region);
+		}
+		else {
+			rc = _dc->ReadRegionBlock(fd, min, max, region);
+		}
 	}
 
 	_sanitizeFloats(region, Wasp::VProduct(Wasp::Dims(min, max)));
@@ -3576,34 +4615,37 @@ int DataMgr::_readRegionBlock(
 
 template <class T>
 int DataMgr::_readRegion(
-	int fd,
+	int fd, string varname,
 	const vector <size_t> &min, const vector <size_t> &max, T *region
 ) {
 
 	int rc = 0;
-	DerivedVar *derivedVar = _getDerivedVar(_openVarName);
-	if (derivedVar) {
-		VAssert ((std::is_same<T,float>::value) == true);
-		rc = derivedVar->ReadRegion(fd, min, max, (float *) region);
-	}
-	else {
-		rc = _dc->ReadRegion(fd, min, max, region);
+	{
+		std::unique_lock <std::recursive_mutex> guard = _lockDC(varname);
+
+		DerivedVar *derivedVar = _getDerivedVar(varname);
+		if (derivedVar) {
+			VAssert ((std::is_same<T,float>::value) == true);
+			rc = derivedVar->ReadRegion(fd, min, max, (float *) region);
+		}
+		else {
+			rc = _dc->ReadRegion(fd, min, max, region);
+		}
 	}
 	
 	_sanitizeFloats(region, Wasp::VProduct(Wasp::Dims(min, max)));
 	return(rc);
 }
 
-int DataMgr::_closeVariable(int fd) {
+int DataMgr::_closeVariable(int fd, string varname) {
 
+	std::unique_lock <std::recursive_mutex> guard = _lockDC(varname);
 
-	DerivedVar *derivedVar = _getDerivedVar(_openVarName);
+	DerivedVar *derivedVar = _getDerivedVar(varname);
 	if (derivedVar) {
 		return(derivedVar->CloseVariable(fd));
 	}
 
-	_openVarName.clear();
-
 	return(_dc->CloseVariable(fd));
 }
 
@@ -3647,6 +4689,8 @@ int DataMgr::_getVar(
 		max.push_back(dims_at_level[i]-1);
 	}
 
+	std::lock_guard <std::recursive_mutex> guard(_dcMutex);
+
 	int fd = _dc->OpenVariableRead(ts, varname, level, lod);
 	if (fd<0) return(-1);
 
@@ -515,6 +515,170 @@ int main(int argc, char **argv) {
 
 };
 
+DerivedVarCache::DerivedVarCache(size_t max_bytes) {
+	_maxBytes = max_bytes;
+	_bytes = 0;
+}
+
+void DerivedVarCache::SetCacheSize(size_t max_bytes) {
+	std::lock_guard <std::mutex> guard(_mutex);
+
+	_maxBytes = max_bytes;
+	_evict(_maxBytes);
+}
+
+size_t DerivedVarCache::GetBytes() const {
+	std::lock_guard <std::mutex> guard(_mutex);
+
+	return(_bytes);
+}
+
+void DerivedVarCache::Trim(size_t max_bytes) {
+	std::lock_guard <std::mutex> guard(_mutex);
+
+	_evict(max_bytes);
+}
+
+DerivedVarCache::Array DerivedVarCache::Get(const string &key) {
+	std::lock_guard <std::mutex> guard(_mutex);
+
+	auto itr = _map.find(key);
+	if (itr == _map.end()) return(NULL);
+
+	// Move to front of the LRU list
+	//
+	_lru.splice(_lru.begin(), _lru, itr->second);
+	return(itr->second->second);
+}
+
+void DerivedVarCache::Put(const string &key, const Array &array) {
+	VAssert(array);
+
+	std::lock_guard <std::mutex> guard(_mutex);
+
+	auto itr = _map.find(key);
+	if (itr != _map.end()) {
+		_bytes -= itr->second->second->size() * sizeof(float);
+		_lru.erase(itr->second);
+		_map.erase(itr);
+	}
+
+	size_t nbytes = array->size() * sizeof(float);
+	if (nbytes > _maxBytes) return;
+
+	_lru.push_front(make_pair(key, array));
+	_map[key] = _lru.begin();
+	_bytes += nbytes;
+
+	_evict(_maxBytes);
+}
+
+void DerivedVarCache::SetTimeInvariant(const string &key, bool invariant) {
+	std::lock_guard <std::mutex> guard(_mutex);
+
+	_timeInvariant[key] = invariant;
+}
+
+int DerivedVarCache::GetTimeInvariant(const string &key) const {
+	std::lock_guard <std::mutex> guard(_mutex);
+
+	auto itr = _timeInvariant.find(key);
+	if (itr == _timeInvariant.end()) return(-1);
+
+	return(itr->second ? 1 : 0);
+}
+
+void DerivedVarCache::Clear() {
+	std::lock_guard <std::mutex> guard(_mutex);
+
+	_lru.clear();
+	_map.clear();
+	_timeInvariant.clear();
+	_bytes = 0;
+}
+
+void DerivedVarCache::_evict(size_t max_bytes) {
+	while (_bytes > max_bytes && ! _lru.empty()) {
+		const pair <string, Array> &p = _lru.back();
+		_bytes -= p.second->size() * sizeof(float);
+		_map.erase(p.first);
+		_lru.pop_back();
+	}
+}
+
+string DerivedVar::_cacheKey(
+	const string &name, size_t ts, int level, int lod,
+	const vector <size_t> &min, const vector <size_t> &max
+) {
+	ostringstream oss;
+	oss << name << ":" << ts << ":" << level << ":" << lod;
+	for (int i=0; i<min.size(); i++) {
+		oss << ":" << min[i] << "-" << max[i];
+	}
+	return(oss.str());
+}
+
+int DerivedVar::_getVarCached(
+	DC *dc, size_t ts, string varname, int level, int lod,
+	const vector <size_t> &min, const vector <size_t> &max,
+	bool timeInvariant, DerivedVarCache::Array &array
+) const {
+	array.reset();
+
+	// Time invariance is recorded per region, as whether a region 
+	// varies says nothing about the others
+	//
+	string constKey = _cacheKey("const:" + varname, 0, level, lod, min, max);
+	if (timeInvariant && _cache && _cache->GetTimeInvariant(constKey) == 0) {
+		timeInvariant = false;
+	}
+
+	// Time invariant values are stored once, separately from values
+	// stored per time step
+	//
+	string key = timeInvariant ? 
+		constKey : _cacheKey(varname, ts, level, lod, min, max);
+
+	if (_cache) {
+		array = _cache->Get(key);
+		if (array) return(0);
+	}
+
+	std::shared_ptr <vector <float> > buf(
+		new vector <float> (numElements(min, max))
+	);
+	int rc = _getVar(dc, ts, varname, level, lod, min, max, buf->data());
+	if (rc<0) return(rc);
+
+	array = buf;
+	if (! _cache) return(0);
+
+	// The first time a region is read, check that its values really
+	// are the same at another time step
+	//
+	if (timeInvariant && _cache->GetTimeInvariant(constKey) < 0) {
+		int nts = dc->GetNumTimeSteps(varname);
+		bool invariant = true;
+		if (nts > 1) {
+			size_t other = ts == 0 ? nts - 1 : 0;
+			vector <float> buf2(buf->size());
+			rc = _getVar(
+				dc, other, varname, level, lod, min, max, buf2.data()
+			);
+			if (rc<0) return(rc);
+
+			invariant = buf2 == *buf;
+		}
+		_cache->SetTimeInvariant(constKey, invariant);
+
+		if (! invariant) key = _cacheKey(varname, ts, level, lod, min, max);
+	}
+
+	_cache->Put(key, array);
+
+	return(0);
+}
+
 int DerivedVar::_getVar(
 	DC *dc, size_t ts, string varname, int level, int lod,
     const vector <size_t> &min, const vector <size_t> &max, float *region
@@ -716,19 +880,14 @@ int DerivedCoordVar_PCSFromLatLon::_readRegionHelperCylindrical(
 
 int DerivedCoordVar_PCSFromLatLon::_readRegionHelper1D(
 	DC::FileTable::FileObject *f,
-    const vector <size_t> &min, const vector <size_t> &max, float *region
+    const vector <size_t> &min, const vector <size_t> &max, float *region,
+	float *buf
 ) {
 
 	size_t ts = f->GetTS();
 	string varname = f->GetVarname();
 	int lod = f->GetLOD();
 
-	// Need temporary buffer space for the X or Y coordinate
-	// NOT being returned (we still need to calculate it)
-	//
-	size_t nElements = numElements(min, max);
-	float *buf = new float[nElements];
-
 	vector <size_t> roidims;
 	for (int i=0; i<min.size(); i++) {
 		roidims.push_back(max[i] - min[i] + 1);
@@ -752,44 +911,31 @@ int DerivedCoordVar_PCSFromLatLon::_readRegionHelper1D(
 	vector <size_t> lonMin = {min[0]};
 	vector <size_t> lonMax = {max[0]};
 	int rc = _getVar(_dc,ts,_lonName,-1,lod, lonMin, lonMax, lonBufPtr);
-	if (rc<0) {
-		delete [] buf;
-		return(rc);
-	}
+	if (rc<0) return(rc);
 
 	vector <size_t> latMin = {min[1]};
 	vector <size_t> latMax = {max[1]};
 	rc = _getVar(_dc, ts, _latName, -1, lod, latMin, latMax, latBufPtr);
-	if (rc<0) {
-		delete [] buf;
-		return(rc);
-	}
+	if (rc<0) return(rc);
 
 	// Combine the 2 1D arrays into a 2D array
 	//
 	make2D(lonBufPtr, latBufPtr, roidims);
 
-	rc = _proj4API.Transform(lonBufPtr, latBufPtr, vproduct(roidims));
-
-	delete [] buf;
-
-	return(rc);
+	return(_proj4API.Transform(lonBufPtr, latBufPtr, vproduct(roidims)));
 }
 
 int DerivedCoordVar_PCSFromLatLon::_readRegionHelper2D(
 	DC::FileTable::FileObject *f,
-    const vector <size_t> &min, const vector <size_t> &max, float *region
+    const vector <size_t> &min, const vector <size_t> &max, float *region,
+	float *buf
 ) {
 
 	size_t ts = f->GetTS();
 	string varname = f->GetVarname();
 	int lod = f->GetLOD();
 
-	// Need temporary buffer space for the X or Y coordinate
-	// NOT being returned (we still need to calculate it)
-	//
 	size_t nElements = numElements(min, max);
-	float *buf = new float[nElements];
 
 	// Assign temporary buffer 'buf' as appropriate
 	//
@@ -805,22 +951,27 @@ int DerivedCoordVar_PCSFromLatLon::_readRegionHelper2D(
 	}
 
 	int rc = _getVar(_dc, ts, _lonName, -1, lod, min, max, lonBufPtr);
-	if (rc<0) {
-		delete [] buf;
-		return(rc);
-	}
+	if (rc<0) return(rc);
 
 	rc = _getVar(_dc, ts, _latName, -1, lod, min, max, latBufPtr);
-	if (rc<0) {
-		delete [] buf;
-		return(rc);
-	}
+	if (rc<0) return(rc);
 
-	rc = _proj4API.Transform(lonBufPtr, latBufPtr, nElements);
+	return(_proj4API.Transform(lonBufPtr, latBufPtr, nElements));
+}
 
-	delete [] buf;
+string DerivedCoordVar_PCSFromLatLon::_projCacheKey(
+	bool lonFlag, size_t ts, int lod,
+	const vector <size_t> &min, const vector <size_t> &max
+) const {
 
-	return(rc);
+	// Coordinates that don't vary with time are shared by all time steps
+	//
+	if (_coordVarInfo.GetTimeDimName().empty()) ts = 0;
+
+	string name = "PCSFromLatLon:" + string(lonFlag ? "X:" : "Y:") + 
+		_lonName + ":" + _latName + ":" + _proj4String;
+
+	return(_cacheKey(name, ts, -1, lod, min, max));
 }
 
 int DerivedCoordVar_PCSFromLatLon::ReadRegion(
@@ -834,25 +985,57 @@ int DerivedCoordVar_PCSFromLatLon::ReadRegion(
 		return(-1);
 	}
 
+	string key = _projCacheKey(_lonFlag, f->GetTS(), f->GetLOD(), min, max);
+	if (_cache) {
+		DerivedVarCache::Array array = _cache->Get(key);
+		if (array) {
+			std::copy(array->begin(), array->end(), region);
+			return(0);
+		}
+	}
+
+	size_t nElements = numElements(min, max);
+
+	// Both X and Y are projected at once. Keep the coordinate NOT being
+	// returned for the other coordinate variable
+	//
+	std::shared_ptr <vector <float> > other;
+
+	int rc;
 	if (min.size() == 1) {
 		
 		// Lat and Lon are 1D variables
 		//
-		return(_readRegionHelperCylindrical(f,min,max,region));
+		rc = _readRegionHelperCylindrical(f,min,max,region);
 	}
 	else {
+		other.reset(new vector <float> (nElements));
 		if (_make2DFlag) {
 
 			// Lat and Lon are 1D variables but projections to PCS
 			// result in X and Y coordinate variables that are 2D
 			//
-			return(_readRegionHelper1D(f, min, max, region));
+			rc = _readRegionHelper1D(f, min, max, region, other->data());
 		}
 		else {
-			return(_readRegionHelper2D(f, min, max, region));
+			rc = _readRegionHelper2D(f, min, max, region, other->data());
+		}
+	}
+	if (rc<0) return(rc);
+
+	if (_cache) {
+		_cache->Put(
+			key, std::make_shared <vector <float> > (region, region+nElements)
+		);
+		if (other) {
+			_cache->Put(
+				_projCacheKey(! _lonFlag, f->GetTS(), f->GetLOD(), min, max),
+				other
+			);
 		}
 	}
 
+	return(0);
 }
 
 bool DerivedCoordVar_PCSFromLatLon::VariableExists(
@@ -2327,80 +2510,128 @@ int DerivedCoordVarStandardWRF_Terrain::ReadRegion(
 		bMax[2] -= 1;
 	}
 
-	size_t nElements = std::max(numElements(wMin, wMax), numElements(min, max));
+	// Elevation on the W grid, and its resampling to the base grid,
+	// are shared by all of the elevation variables, and memoized
+	//
+	DerivedVarCache::Array elev;
+	if (varname == "ElevationW") {
+		rc = _getElevationW(
+			f->GetTS(), f->GetLevel(), f->GetLOD(), wMin, wMax, elev
+		);
+		if (rc<0) return(rc);
 
+		std::copy(elev->begin(), elev->end(), region);
+		return(0);
+	}
 
-	float *buf1 = new float[nElements];
-	rc = _getVar(
-		_dc, f->GetTS(), _PHVar, f->GetLevel(), f->GetLOD(),
-		wMin, wMax, buf1
+	rc = _getElevation(
+		f->GetTS(), f->GetLevel(), f->GetLOD(), wMin, wMax, bMin, bMax, elev
 	);
-	if (rc<0) {
-		delete [] buf1;
-		return(rc);
+	if (rc<0) return(rc);
+
+	if (varname == "Elevation") {
+		std::copy(elev->begin(), elev->end(), region);
+		return(0);
 	}
 
-	float *buf2 = new float[nElements];
-	rc = _getVar(
-		_dc, f->GetTS(), _PHBVar, f->GetLevel(), f->GetLOD(),
-		wMin, wMax, buf2
+	// Resample base grid to staggered U or V grid. resampleToStaggered()
+	// needs a scratch buffer for its input.
+	//
+	vector <float> buf(
+		std::max(numElements(bMin, bMax), numElements(min, max))
 	);
-	if (rc<0) {
-		delete [] buf1;
-		delete [] buf2;
-		return(rc);
+	std::copy(elev->begin(), elev->end(), buf.begin());
+
+	if (varname == "ElevationU") {
+		resampleToStaggered(
+			buf.data(), bMin, bMax, region, min, max, 0
+		);
 	}
+	else if (varname == "ElevationV") {
+		resampleToStaggered(
+			buf.data(), bMin, bMax, region, min, max, 1
+		);
+	}
+
+	return(0);
+}
+
+int DerivedCoordVarStandardWRF_Terrain::_getElevationW(
+	size_t ts, int level, int lod,
+	const vector <size_t> &wMin, const vector <size_t> &wMax,
+	DerivedVarCache::Array &elev
+) const {
+	elev.reset();
 
-	float *dst = region;
-	if (varname != "ElevationW") {
-		dst = buf1;
+	string key = _cacheKey(
+		"ElevationW:" + _PHVar + ":" + _PHBVar, ts, level, lod, wMin, wMax
+	);
+	if (_cache) {
+		elev = _cache->Get(key);
+		if (elev) return(0);
 	}
-	
-	// Compute elevation on the W grid
-	//
-    for (size_t i=0; i<nElements; i++) {
-        dst[i] = (buf1[i] + buf2[i]) / _grav;
-    }
 
-	// Elevation is correct for W grid. If we want Elevation, ElevationU, or 
-	// Elevation V grid we need to interpolate
+	// PHB, the base state geopotential, normally doesn't change over time
 	//
+	DerivedVarCache::Array phb;
+	int rc = _getVarCached(
+		_dc, ts, _PHBVar, level, lod, wMin, wMax, true, phb
+	);
+	if (rc<0) return(rc);
 
-	if (varname == "Elevation") {
-		
-		// Resample stagged W grid to base grid
-		//
-		resampleToUnStaggered(
-			buf1, wMin, wMax, region, min, max, 2
-		);
+	std::shared_ptr <vector <float> > buf(new vector <float> (phb->size()));
+	rc = _getVar(_dc, ts, _PHVar, level, lod, wMin, wMax, buf->data());
+	if (rc<0) return(rc);
+
+	// Compute elevation on the W grid
+	//
+	float *ph = buf->data();
+	const float *phbptr = phb->data();
+	for (size_t i=0; i<buf->size(); i++) {
+		ph[i] = (ph[i] + phbptr[i]) / _grav;
 	}
-	else if (varname == "ElevationU") {
 
-		// Resample stagged W grid to base grid
-		//
-		resampleToUnStaggered(
-			buf1, wMin, wMax, buf2, bMin, bMax, 2
-		);
+	elev = buf;
+	if (_cache) _cache->Put(key, elev);
 
-		resampleToStaggered(
-			buf2, bMin, bMax, region, min, max, 0
-		);
-	}
-	else if (varname == "ElevationV") {
+	return(0);
+}
 
-		// Resample stagged W grid to base grid
-		//
-		resampleToUnStaggered(
-			buf1, wMin, wMax, buf2, bMin, bMax, 2
-		);
+int DerivedCoordVarStandardWRF_Terrain::_getElevation(
+	size_t ts, int level, int lod,
+	const vector <size_t> &wMin, const vector <size_t> &wMax,
+	const vector <size_t> &bMin, const vector <size_t> &bMax,
+	DerivedVarCache::Array &elev
+) const {
+	elev.reset();
 
-		resampleToStaggered(
-			buf2, bMin, bMax, region, min, max, 1
-		);
+	string key = _cacheKey(
+		"Elevation:" + _PHVar + ":" + _PHBVar, ts, level, lod, bMin, bMax
+	);
+	if (_cache) {
+		elev = _cache->Get(key);
+		if (elev) return(0);
 	}
 
-	delete [] buf1;
-	delete [] buf2;
+	DerivedVarCache::Array elevW;
+	int rc = _getElevationW(ts, level, lod, wMin, wMax, elevW);
+	if (rc<0) return(rc);
+
+	// Resample staggered W grid to base grid. resampleToUnStaggered()
+	// needs a scratch buffer for its input.
+	//
+	vector <float> buf(
+		std::max(numElements(wMin, wMax), numElements(bMin, bMax))
+	);
+	std::copy(elevW->begin(), elevW->end(), buf.begin());
+
+	std::shared_ptr <vector <float> > out(
+		new vector <float> (numElements(bMin, bMax))
+	);
+	resampleToUnStaggered(buf.data(), wMin, wMax, out->data(), bMin, bMax, 2);
+
+	elev = out;
+	if (_cache) _cache->Put(key, elev);
 
 	return(0);
 }
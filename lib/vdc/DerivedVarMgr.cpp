@@ -18,12 +18,14 @@ void DerivedVarMgr::AddCoordVar(DerivedCoordVar *cvar) {
 
 	_coordVars[cvar->GetName()] = cvar;
 	_vars[cvar->GetName()] = cvar;
+	cvar->SetCache(&_cache);
 }
     
 void DerivedVarMgr::AddDataVar(DerivedDataVar *dvar) {
 
 	_dataVars[dvar->GetName()] = dvar;
 	_vars[dvar->GetName()] = dvar;
+	dvar->SetCache(&_cache);
 }
 
 void DerivedVarMgr::RemoveVar(const DerivedVar *var) {
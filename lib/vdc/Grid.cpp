@@ -3,6 +3,10 @@
 #include "vapor/VAssert.h"
 #include <numeric>
 #include <cmath>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <memory>
 #include <time.h>
 #ifdef  Darwin
 #include <mach/mach_time.h>
@@ -15,6 +19,7 @@
 
 #include <vapor/utils.h>
 #include <vapor/Grid.h>
+#include <vapor/vizutil.h>
 
 using namespace std;
 using namespace VAPoR;
@@ -119,21 +124,60 @@ void Grid::SetValueIJK(size_t i, size_t j, size_t k, float v) {
 }
 
 
-void Grid::GetRange(float range[2]) const 
+void Grid::GetRange(float range[2], int nthreads) const 
 {
-    float missingValue = GetMissingValue();
-    Grid::ConstIterator itr    = this->cbegin();
-    Grid::ConstIterator enditr = this->cend();
-    range[0] = *itr;
-    range[1] = range[0];
-    while( itr != enditr )
-    {
-        if (*itr < range[0] && *itr != missingValue) 
-            range[0] = *itr;
-        else if (*itr > range[1] && *itr != missingValue) 
-            range[1] = *itr;
-        ++itr;
-    }
+	float mv = GetMissingValue();
+
+	// Per thread results, padded to keep threads off each other's
+	// cache lines
+	//
+	struct ThreadRange {
+		float min;
+		float max;
+		size_t count;
+		char pad[64];
+	};
+	int n = GetNumBlockThreads(nthreads);
+	vector <ThreadRange> ranges(n);
+	for (int t=0; t<n; t++) {
+		ranges[t].min = std::numeric_limits<float>::infinity();
+		ranges[t].max = -std::numeric_limits<float>::infinity();
+		ranges[t].count = 0;
+	}
+
+	ForEachBlock(
+		[&ranges, mv](
+			int t, const float *values, const unsigned char *, size_t n
+		) {
+			float min = ranges[t].min;
+			float max = ranges[t].max;
+			size_t count = 0;
+			for (size_t i=0; i<n; i++) {
+				float v = values[i];
+				if (v == mv) continue;
+				min = v < min ? v : min;
+				max = v > max ? v : max;
+				count++;
+			}
+			ranges[t].min = min;
+			ranges[t].max = max;
+			ranges[t].count += count;
+		},
+		n
+	);
+
+	range[0] = range[1] = mv;
+	bool first = true;
+	for (int t=0; t<n; t++) {
+		if (! ranges[t].count) continue;
+		if (first) {
+			range[0] = ranges[t].min;
+			range[1] = ranges[t].max;
+			first = false;
+		}
+		range[0] = std::min(range[0], ranges[t].min);
+		range[1] = std::max(range[1], ranges[t].max);
+	}
 }
 
 void Grid::GetRange(
@@ -213,6 +257,304 @@ float Grid::GetValue(const std::vector <double> &coords) const {
     }
 }
 
+void Grid::SampleMany(
+	const double *coords, size_t n, float *values
+) const {
+	size_t ndim = GetGeometryDim();
+
+	// Reuse a single coordinate vector for all of the points
+	//
+	vector <double> point(ndim);
+	for (size_t p=0; p<n; p++) {
+		for (int i=0; i<ndim; i++) point[i] = coords[p*ndim + i];
+		values[p] = GetValue(point);
+	}
+}
+
+void Grid::SampleMany(
+	const double *x, const double *y, const double *z, size_t n,
+	float *values
+) const {
+	size_t ndim = GetGeometryDim();
+	VAssert(ndim >= 1 && ndim <= 3);
+
+	const double *soa[] = {x, y, z};
+
+	// Interleave the points a chunk at a time
+	//
+	const size_t chunk = 256;
+	double coords[3*chunk];
+	for (size_t p0 = 0; p0 < n; p0 += chunk) {
+		size_t m = std::min(chunk, n - p0);
+		for (size_t p=0; p<m; p++) {
+			for (int i=0; i<ndim; i++) coords[p*ndim + i] = soa[i][p0+p];
+		}
+		SampleMany(coords, m, values + p0);
+	}
+}
+
+void Grid::LocateCellsMany(
+	const double *coords, size_t n, size_t *indices, bool *found,
+	bool morton
+) const {
+	if (! morton || n < 2) {
+		GetIndicesCellMany(coords, n, indices, found);
+		return;
+	}
+
+	size_t ndim = GetGeometryDim();
+	size_t nidx = GetDimensions().size();
+
+	vector <size_t> order;
+	MortonOrder(coords, n, ndim, order);
+
+	// Locate the points in Morton order, and put the results back in 
+	// the order the points were given
+	//
+	vector <double> sorted(n * ndim);
+	for (size_t p=0; p<n; p++) {
+		for (int i=0; i<ndim; i++) sorted[p*ndim + i] = coords[order[p]*ndim + i];
+	}
+
+	vector <size_t> sortedIndices(n * nidx);
+	std::unique_ptr <bool[]> sortedFound(new bool[n]);
+	GetIndicesCellMany(
+		sorted.data(), n, sortedIndices.data(), sortedFound.get()
+	);
+
+	for (size_t p=0; p<n; p++) {
+		found[order[p]] = sortedFound[p];
+		for (int i=0; i<nidx; i++) {
+			indices[order[p]*nidx + i] = sortedIndices[p*nidx + i];
+		}
+	}
+}
+
+void Grid::GetIndicesCellMany(
+	const double *coords, size_t n, size_t *indices, bool *found
+) const {
+	size_t ndim = GetGeometryDim();
+	size_t nidx = GetDimensions().size();
+
+	// Reuse the same vectors for all of the points
+	//
+	vector <double> point(ndim);
+	vector <size_t> cindices;
+	for (size_t p=0; p<n; p++) {
+		for (int i=0; i<ndim; i++) point[i] = coords[p*ndim + i];
+
+		cindices.clear();
+		found[p] = GetIndicesCell(point, cindices);
+		for (int i=0; i<nidx; i++) {
+			indices[p*nidx + i] = i < cindices.size() ? cindices[i] : 0;
+		}
+	}
+}
+
+int Grid::GetNumBlockThreads(int nthreads) {
+	if (nthreads < 1) nthreads = std::thread::hardware_concurrency();
+	return(nthreads < 1 ? 1 : nthreads);
+}
+
+void Grid::ForEachBlock(const BlockVisitor &visitor, int nthreads) const {
+	ForEachBlock(vector <double> (), vector <double> (), visitor, nthreads);
+}
+
+void Grid::ForEachBlock(
+	const std::vector <double> &minu, const std::vector <double> &maxu,
+	const BlockVisitor &visitor, int nthreads
+) const {
+	ForEachIndexedBlock(
+		minu, maxu,
+		[&visitor](
+			int t, size_t, const float *values, const unsigned char *mask,
+			size_t n
+		) {
+			visitor(t, values, mask, n);
+		},
+		nthreads
+	);
+}
+
+void Grid::ForEachIndexedBlock(
+	const std::vector <double> &minu, const std::vector <double> &maxu,
+	const IndexedBlockVisitor &visitor, int nthreads
+) const {
+	if (! _blks.size()) return;
+
+	vector <size_t> dims = GetDimensions();
+	vector <size_t> bdims = GetDimensionInBlks();
+	vector <size_t> bs = GetBlockSize();
+	for (int i=dims.size(); i<3; i++) {
+		dims.push_back(1);
+		bdims.push_back(1);
+		bs.push_back(1);
+	}
+
+	// Only compute masks if some of the grid is outside of the box
+	//
+	size_t nbox = std::min(minu.size(), (size_t) GetGeometryDim());
+	bool useMask = false;
+	if (nbox) {
+		vector <double> gridMin, gridMax;
+		GetUserExtents(gridMin, gridMax);
+		for (int i=0; i<nbox && i<gridMin.size(); i++) {
+			if (gridMin[i] < minu[i] || gridMax[i] > maxu[i]) useMask = true;
+		}
+	}
+
+	int n = GetNumBlockThreads(nthreads);
+	vector <vector <unsigned char> > masks(n);
+
+	// Visit the grid points [x0, x0+nx) x [y0, y0+ny) x [z0, z0+nz),
+	// which are stored contiguously starting at values
+	//
+	auto visitSpan = [&](
+		int t, size_t b, bool blockMask, const float *values, 
+		size_t x0, size_t nx, size_t y0, size_t ny, size_t z0, size_t nz
+	) {
+		size_t nvalues = nx * ny * nz;
+		if (! blockMask) {
+			visitor(t, b, values, NULL, nvalues);
+			return;
+		}
+
+		vector <unsigned char> &mask = masks[t];
+		mask.resize(nvalues);
+
+		size_t indices[3];
+		double coords[3];
+		size_t nInside = 0;
+		size_t m = 0;
+		for (size_t z=z0; z<z0+nz; z++) {
+		for (size_t y=y0; y<y0+ny; y++) {
+		for (size_t x=x0; x<x0+nx; x++) {
+			indices[0] = x; indices[1] = y; indices[2] = z;
+			GetUserCoordinates(indices, coords);
+
+			bool inside = true;
+			for (int i=0; i<nbox; i++) {
+				if (coords[i] < minu[i] || coords[i] > maxu[i]) inside = false;
+			}
+			mask[m++] = inside;
+			nInside += inside;
+		}
+		}
+		}
+		if (nInside) visitor(t, b, values, mask.data(), nvalues);
+	};
+
+	size_t nblocks = bdims[0] * bdims[1] * bdims[2];
+	auto visitBlock = [&](int t, size_t b) {
+		size_t xb = b % bdims[0];
+		size_t yb = (b / bdims[0]) % bdims[1];
+		size_t zb = b / (bdims[0] * bdims[1]);
+
+		size_t x0 = xb * bs[0];
+		size_t y0 = yb * bs[1];
+		size_t z0 = zb * bs[2];
+		size_t nx = std::min(bs[0], dims[0] - x0);
+		size_t ny = std::min(bs[1], dims[1] - y0);
+		size_t nz = std::min(bs[2], dims[2] - z0);
+
+		const float *blk = _blks[b];
+
+		// A block needs a mask only if its bounding box straddles the 
+		// box, and is skipped if its bounding box lies outside of it
+		//
+		bool blockMask = useMask;
+		if (useMask) {
+			vector <size_t> bmin = {x0, y0, z0};
+			vector <size_t> bmax = {x0+nx-1, y0+ny-1, z0+nz-1};
+			bmin.resize(GetDimensions().size());
+			bmax.resize(GetDimensions().size());
+
+			vector <double> bminu, bmaxu;
+			GetBoundingBox(bmin, bmax, bminu, bmaxu);
+
+			blockMask = false;
+			for (int i=0; i<nbox && i<bminu.size(); i++) {
+				if (bmaxu[i] < minu[i] || bminu[i] > maxu[i]) return;
+				if (bminu[i] < minu[i] || bmaxu[i] > maxu[i]) blockMask = true;
+			}
+		}
+
+		// Blocks on the upper boundaries of the grid may be partially
+		// filled. Merge as many rows and planes into a span as are 
+		// contiguous in memory.
+		//
+		if (nx == bs[0] && ny == bs[1]) {
+			visitSpan(t, b, blockMask, blk, x0, nx, y0, ny, z0, nz);
+		}
+		else if (nx == bs[0]) {
+			for (size_t z=0; z<nz; z++) {
+				visitSpan(
+					t, b, blockMask, blk + z*bs[0]*bs[1], 
+					x0, nx, y0, ny, z0 + z, 1
+				);
+			}
+		}
+		else {
+			for (size_t z=0; z<nz; z++) {
+			for (size_t y=0; y<ny; y++) {
+				visitSpan(
+					t, b, blockMask, blk + (z*bs[1] + y)*bs[0], 
+					x0, nx, y0 + y, 1, z0 + z, 1
+				);
+			}
+			}
+		}
+	};
+
+	if (n == 1 || nblocks == 1) {
+		for (size_t b=0; b<nblocks; b++) visitBlock(0, b);
+		return;
+	}
+
+	// Hand out blocks to the threads one at a time. The calling thread
+	// takes part.
+	//
+	std::atomic <size_t> next(0);
+	auto worker = [&](int t) {
+		size_t b;
+		while ((b = next++) < nblocks) visitBlock(t, b);
+	};
+
+	vector <std::thread> threads;
+	for (int t=1; t<n; t++) threads.push_back(std::thread(worker, t));
+	worker(0);
+	for (auto &thread : threads) thread.join();
+}
+
+Grid::NodeReader::NodeReader(const Grid *g) {
+	const vector <size_t> &dims = g->GetNodeDimensions();
+	size_t ndim = g->GetDimensions().size();
+
+	for (int i=0; i<3; i++) {
+		_dims[i] = i < ndim && i < dims.size() ? dims[i] : 1;
+		_bs[i] = i < ndim ? g->_bs[i] : 1;
+		_bdims[i] = i < ndim ? g->_bdims[i] : 1;
+		_org[i] = 0;
+	}
+	_blks = g->_blks.size() ? &g->_blks : NULL;
+	_blk = NULL;
+	_missingValue = g->GetMissingValue();
+
+	if (_blks) _setBlock(0,0,0);
+}
+
+void Grid::NodeReader::_setBlock(size_t i, size_t j, size_t k) {
+	size_t xb = i / _bs[0];
+	size_t yb = j / _bs[1];
+	size_t zb = k / _bs[2];
+
+	_org[0] = xb * _bs[0];
+	_org[1] = yb * _bs[1];
+	_org[2] = zb * _bs[2];
+
+	_blk = (*_blks)[zb*_bdims[0]*_bdims[1] + yb*_bdims[0] + xb];
+}
+
 void Grid::GetUserCoordinates(
 	const std::vector <size_t> &indices,
 	std::vector <double> &coords
@@ -2,6 +2,7 @@
 #include <sstream>
 #include <vector>
 #include <map>
+#include <algorithm>
 #include <vapor/QuadTreeRectangle.hpp>
 #include <vapor/GridHelper.h>
 using namespace Wasp;
@@ -178,6 +179,26 @@ string GridHelper::_getQuadTreeRectangleKey(
 	return(oss.str());
 }
 
+string GridHelper::_getFaceBlockKey(
+	size_t ts,
+	int level,
+	int lod,
+    const vector <DC::CoordVar> &cvarsinfo, 
+	const vector <size_t> &block,
+	const vector <size_t> &nfaces
+) const {
+
+	// Key by the block's location in the full mesh, not in the ROI
+	//
+	ostringstream oss;
+	oss << "faces:";
+	oss << _getQuadTreeRectangleKey(ts, level, lod, cvarsinfo, block, block);
+	oss << ":";
+	oss << vector_to_string(nfaces);
+
+	return(oss.str());
+}
+
 RegularGrid *GridHelper::_make_grid_regular(
 	const vector <size_t> &dims,
     const vector <float *> &blkvec,
@@ -389,17 +410,56 @@ CurvilinearGrid *GridHelper::_make_grid_curvilinear(
 	RegularGrid xrg(dims2d, bs2d, xcblkptrs, minu2d, maxu2d);
 	RegularGrid yrg(dims2d, bs2d, ycblkptrs, minu2d, maxu2d);
 
-	string qtr_key = _getQuadTreeRectangleKey(
-		ts, level, lod, cvarsinfo, bmin, bmax
+	// Assemble the index of the grid's faces from per-block pieces. A 
+	// piece only depends on the coordinates of the block's nodes, and
+	// on how many of the block's faces are inside the ROI, so pieces
+	// are cached by block and shared by all grids containing the
+	// block, whatever their ROI. Only the missing pieces are built, in
+	// parallel, since indexing the faces of a large mesh is expensive.
+	//
+	size_t nfi = dims2d[0] > 1 ? dims2d[0] - 1 : 0;
+	size_t nfj = dims2d[1] > 1 ? dims2d[1] - 1 : 0;
+
+	vector <string> keys;
+	vector <size_t> origins, sizes;
+	vector <std::shared_ptr <const CurvilinearFaceIndex::Block> > blocks;
+	for (size_t j0=0; j0<nfj; j0+=bs2d[1]) {
+	for (size_t i0=0; i0<nfi; i0+=bs2d[0]) {
+		vector <size_t> block = {
+			bmin[0] + i0 / bs2d[0], bmin[1] + j0 / bs2d[1]
+		};
+		vector <size_t> nfaces = {
+			std::min(bs2d[0], nfi - i0), std::min(bs2d[1], nfj - j0)
+		};
+
+		keys.push_back(_getFaceBlockKey(
+			ts, level, lod, cvarsinfo, block, nfaces
+		));
+		origins.push_back(i0);
+		origins.push_back(j0);
+		sizes.insert(sizes.end(), nfaces.begin(), nfaces.end());
+		blocks.push_back(
+			std::static_pointer_cast<const CurvilinearFaceIndex::Block>(
+				_indexCache.get(keys.back())
+			)
+		);
+	}
+	}
+
+	vector <bool> cached;
+	for (const auto &block : blocks) cached.push_back((bool) block);
+
+	CurvilinearFaceIndex::MakeBlocks(
+		xrg, yrg, origins, sizes, blocks, _nthreads
 	);
 
-	// Try to get a shared pointer to the QuadTreeRectangle from the 
-	// cache. If one does not exist the Grid class will make one. We use
-	// a shared pointer so that we can cache it for use by other Grid
-	// classes. This a peformance optimization, necessary be creating
-	// a QuadTreeRectangle is expensive.
-	//
-	std::shared_ptr<const QuadTreeRectangle<float, size_t> > qtr = _qtrCache.get(qtr_key);
+	for (size_t b=0; b<blocks.size(); b++) {
+		if (cached[b]) continue;
+		_indexCache.put(keys[b], blocks[b], blocks[b]->GetNumBytes());
+	}
+
+	std::shared_ptr <const CurvilinearFaceIndex> faceIndex = 
+		std::make_shared <CurvilinearFaceIndex>(dims2d[0], blocks, origins);
 
 	CurvilinearGrid *g;
 	if (dims.size() == 3 && cvarsinfo[2].GetDimNames().size() == 3) {
@@ -416,7 +476,7 @@ CurvilinearGrid *GridHelper::_make_grid_curvilinear(
 
 		RegularGrid zrg(dims, bs, zcblkptrs, minu, maxu);
 
-		g = new CurvilinearGrid(dims, bs, blkptrs, xrg, yrg, zrg, qtr);
+		g = new CurvilinearGrid(dims, bs, blkptrs, xrg, yrg, zrg, faceIndex);
 
 	}
 	else if (dims.size() == 3 && cvarsinfo[2].GetDimNames().size() == 1) {
@@ -426,26 +486,19 @@ CurvilinearGrid *GridHelper::_make_grid_curvilinear(
 		vector <double> zcoords;
 		for (int i=0; i<dims[2]; i++) zcoords.push_back(blkvec[3][i]);
 
-		g = new CurvilinearGrid(dims, bs, blkptrs, xrg, yrg, zcoords, qtr);
+		g = new CurvilinearGrid(
+			dims, bs, blkptrs, xrg, yrg, zcoords, faceIndex
+		);
 	}
 	else {
 
 		// 2D
 		//
 		g = new CurvilinearGrid(
-			dims, bs, blkptrs, xrg, yrg, vector <double> (), qtr
+			dims, bs, blkptrs, xrg, yrg, vector <double> (), faceIndex
 		);
 	}
 
-	// No QuadTreeRectangle in cache. So get shared pointer for one created
-	// by UnstructuredGrid2D() and cache it for later use. The memory
-	// will be garbage collected when all pointers to it go out of scope
-	//
-	if (! qtr) {
-		qtr = g->GetQuadTreeRectangle();
-		(void) _qtrCache.put(qtr_key, qtr);
-	}
-
 	return(g);
 }
 
@@ -548,6 +601,10 @@ UnstructuredGrid2D *GridHelper::_make_grid_unstructured2d(
 
 	UnstructuredGridCoordless zug;
 
+	// Unlike curvilinear face indices, the quad tree is keyed by the
+	// region. Unstructured grids can't be subset, so DataMgr always
+	// requests the whole mesh, and the key doesn't change with the ROI.
+	//
 	string qtr_key = _getQuadTreeRectangleKey(
 		ts, level, lod, cvarsinfo, bmin, bmax
 	);
@@ -558,7 +615,10 @@ UnstructuredGrid2D *GridHelper::_make_grid_unstructured2d(
 	// classes. This a peformance optimization, necessary be creating
 	// a QuadTreeRectangle is expensive.
 	//
-	std::shared_ptr<const QuadTreeRectangle<float, size_t> > qtr = _qtrCache.get(qtr_key);
+	std::shared_ptr<const QuadTreeRectangle<float, size_t> > qtr = 
+		std::static_pointer_cast<const QuadTreeRectangle<float, size_t> >(
+			_indexCache.get(qtr_key)
+		);
 
 	UnstructuredGrid2D *g = new UnstructuredGrid2D(
 		vertexDims, faceDims, edgeDims, bs, blkptrs, 
@@ -574,7 +634,7 @@ UnstructuredGrid2D *GridHelper::_make_grid_unstructured2d(
 	//
 	if (! qtr) {
 		qtr = g->GetQuadTreeRectangle();
-		(void) _qtrCache.put(qtr_key, qtr);
+		_indexCache.put(qtr_key, qtr, qtr->GetNumBytes());
 	}
 
 
@@ -704,6 +764,9 @@ UnstructuredGridLayered *GridHelper::_make_grid_unstructured_layered(
 		vertexOffset, faceOffset
 	);
 
+	// Keyed by the region, which is always the whole mesh. See
+	// _make_grid_unstructured2d()
+	//
 	string qtr_key = _getQuadTreeRectangleKey(
 		ts, level, lod, cvarsinfo, bmin, bmax
 	);
@@ -714,7 +777,10 @@ UnstructuredGridLayered *GridHelper::_make_grid_unstructured_layered(
 	// classes. This a peformance optimization, necessary be creating
 	// a QuadTreeRectangle is expensive.
 	//
-	std::shared_ptr<const QuadTreeRectangle<float, size_t> > qtr = _qtrCache.get(qtr_key);
+	std::shared_ptr<const QuadTreeRectangle<float, size_t> > qtr = 
+		std::static_pointer_cast<const QuadTreeRectangle<float, size_t> >(
+			_indexCache.get(qtr_key)
+		);
 
 	UnstructuredGridLayered *g = new UnstructuredGridLayered(
 		vertexDims, faceDims, edgeDims, bs, blkptrs, 
@@ -729,7 +795,7 @@ UnstructuredGridLayered *GridHelper::_make_grid_unstructured_layered(
 	//
 	if (! qtr) {
 		qtr = g->GetQuadTreeRectangle();
-		(void) _qtrCache.put(qtr_key, qtr);
+		_indexCache.put(qtr_key, qtr, qtr->GetNumBytes());
 	}
 
 	return(g);
@@ -889,7 +955,7 @@ UnstructuredGrid *GridHelper::MakeGridUnstructured(
 
 GridHelper::~GridHelper() {
 
-	while ((_qtrCache.remove_lru()) != NULL) {
+	while ((_indexCache.remove_lru()) != NULL) {
 	}
 }
 
@@ -320,6 +320,119 @@ float LayeredGrid::GetValue(const std::vector <double> &coords) const {
 
 }
 
+void LayeredGrid::SampleMany(
+	const double *coords, size_t n, float *values
+) const {
+	const vector <size_t> &dims = GetDimensions();
+
+	if (! GetBlks().size() || GetGeometryDim() != 3) {
+		Grid::SampleMany(coords, n, values);
+		return;
+	}
+
+	// Figure out interpolation order
+	//
+	int interp_order = _interpolationOrder;
+	if (interp_order == 2) {
+		if (dims[2] < 3) interp_order = 1;
+	}
+
+	const float missingValue = GetMissingValue();
+	NodeReader reader(this);
+
+	// The body of the loop below must compute exactly what GetValue()
+	// does. GetValue() locates the cell containing each point twice, 
+	// once in InsideGrid() and again in GetValueLinear() or 
+	// GetValueNearestNeighbor(). Here it is located once.
+	//
+	vector <double> clampedCoords(3);
+	for (size_t p=0; p<n; p++) {
+		for (int a=0; a<3; a++) clampedCoords[a] = coords[p*3 + a];
+		ClampCoord(clampedCoords);
+
+		if (interp_order == 2) {
+			if (! LayeredGrid::InsideGrid(clampedCoords)) {
+				values[p] = missingValue;
+			}
+			else {
+				values[p] = _getValueQuadratic(clampedCoords);
+			}
+			continue;
+		}
+
+		size_t indices0[3];
+		double wgts[3];
+		if (! _getCellAndWeights(clampedCoords.data(), indices0, wgts)) {
+			values[p] = missingValue;
+			continue;
+		}
+
+		if (interp_order == 0) {
+			if (wgts[0] > 0.5) indices0[0] += 1;
+			if (wgts[1] > 0.5) indices0[1] += 1;
+			if (wgts[2] > 0.5) indices0[2] += 1;
+
+			values[p] = reader.Get(indices0[0],indices0[1],indices0[2]);
+			continue;
+		}
+
+		size_t i0 = indices0[0];
+		size_t j0 = indices0[1];
+		size_t k0 = indices0[2];
+		size_t i1 = indices0[0]+1;
+		size_t j1 = indices0[1]+1;
+		size_t k1 = indices0[2]+1;
+
+		double iwgt = wgts[0];
+		double jwgt = wgts[1];
+		double kwgt = wgts[2];
+
+		double p0,p1,p2,p3,p4,p5,p6,p7;
+		p1 = p2 = p3 = p4 = p5 = p6 = p7 = 0.0;
+
+		p0 = reader.Get(i0,j0,k0);
+		bool missing = p0 == missingValue;
+
+		if (! missing && iwgt!=0.0) {
+			p1 = reader.Get(i1,j0,k0);
+			missing = p1 == missingValue;
+		}
+		if (! missing && jwgt!=0.0) {
+			p2 = reader.Get(i0,j1,k0);
+			missing = p2 == missingValue;
+		}
+		if (! missing && iwgt!=0.0 && jwgt!=0.0) {
+			p3 = reader.Get(i1,j1,k0);
+			missing = p3 == missingValue;
+		}
+		if (! missing && kwgt!=0.0) {
+			p4 = reader.Get(i0,j0,k1);
+			missing = p4 == missingValue;
+		}
+		if (! missing && kwgt!=0.0 && iwgt!=0.0) {
+			p5 = reader.Get(i1,j0,k1);
+			missing = p5 == missingValue;
+		}
+		if (! missing && kwgt!=0.0 && jwgt!=0.0) {
+			p6 = reader.Get(i0,j1,k1);
+			missing = p6 == missingValue;
+		}
+		if (! missing && kwgt!=0.0 && iwgt!=0.0 && jwgt!=0.0) {
+			p7 = reader.Get(i1,j1,k1);
+			missing = p7 == missingValue;
+		}
+		if (missing) {
+			values[p] = missingValue;
+			continue;
+		}
+
+		double c0 = p0+iwgt*(p1-p0) + jwgt*((p2+iwgt*(p3-p2))-(p0+iwgt*(p1-p0)));
+		double c1 = p4+iwgt*(p5-p4) + jwgt*((p6+iwgt*(p7-p6))-(p4+iwgt*(p5-p4)));
+
+		values[p] = c0+kwgt*(c1-c0);
+	}
+}
+
 void LayeredGrid::SetInterpolationOrder(int order) {
     if (order<0 || order>3) order = 2;
     _interpolationOrder = order;
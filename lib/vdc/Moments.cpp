@@ -0,0 +1,115 @@
+#include <vector>
+#include <limits>
+#include <cmath>
+#include <vapor/Moments.h>
+
+using namespace std;
+using namespace VAPoR;
+
+Moments::Moments() :
+	_count(0),
+	_min(std::numeric_limits<double>::max()),
+	_max(std::numeric_limits<double>::lowest()),
+	_mean(0.0),
+	_m2(0.0)
+{}
+
+void Moments::Add(double v) {
+	if (std::isnan(v)) return;
+
+	_count++;
+	double delta = v - _mean;
+	_mean += delta / (double) _count;
+	_m2 += delta * (v - _mean);
+
+	if (v < _min) _min = v;
+	if (v > _max) _max = v;
+}
+
+void Moments::Add(
+	const float *values, const unsigned char *mask, size_t n,
+	float missingValue
+) {
+
+	// Summarize the span on its own with two passes over it while it is
+	// in cache, the second taking deviations from the span's own mean,
+	// and merge the result. This is as accurate as adding the values one
+	// at a time, but doesn't divide per value.
+	//
+	Moments span;
+	double sum = 0.0;
+	double min = span._min;
+	double max = span._max;
+	size_t count = 0;
+	for (size_t i=0; i<n; i++) {
+		float v = values[i];
+		if (v == missingValue || (mask && ! mask[i]) || std::isnan(v)) continue;
+
+		sum += v;
+		min = v < min ? v : min;
+		max = v > max ? v : max;
+		count++;
+	}
+	if (! count) return;
+
+	double mean = sum / (double) count;
+	double m2 = 0.0;
+	for (size_t i=0; i<n; i++) {
+		float v = values[i];
+		if (v == missingValue || (mask && ! mask[i]) || std::isnan(v)) continue;
+
+		double d = v - mean;
+		m2 += d * d;
+	}
+
+	span._count = count;
+	span._min = min;
+	span._max = max;
+	span._mean = mean;
+	span._m2 = m2;
+	Merge(span);
+}
+
+void Moments::Merge(const Moments &rhs) {
+	if (! rhs._count) return;
+	if (! _count) {
+		*this = rhs;
+		return;
+	}
+
+	double n_a = (double) _count;
+	double n_b = (double) rhs._count;
+	double n = n_a + n_b;
+	double delta = rhs._mean - _mean;
+
+	_mean += delta * (n_b / n);
+	_m2 += rhs._m2 + delta * delta * (n_a * n_b / n);
+	_count += rhs._count;
+
+	if (rhs._min < _min) _min = rhs._min;
+	if (rhs._max > _max) _max = rhs._max;
+}
+
+double Moments::GetVariance() const {
+	if (! _count) return(0.0);
+	return(_m2 / (double) _count);
+}
+
+double Moments::GetStddev() const {
+	return(std::sqrt(GetVariance()));
+}
+
+vector <double> Moments::Encode() const {
+	return(vector <double> {(double) _count, _min, _max, _mean, _m2});
+}
+
+bool Moments::Decode(const vector <double> &v) {
+	if (v.size() != 5 || v[0] < 0.0) return(false);
+
+	_count = (size_t) v[0];
+	_min = v[1];
+	_max = v[2];
+	_mean = v[3];
+	_m2 = v[4];
+	return(true);
+}
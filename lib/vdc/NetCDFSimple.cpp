@@ -1,4 +1,12 @@
 #include <iostream>
+#include <cstring>
+#include <stdint.h>
+#ifndef WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
 #include "vapor/VAssert.h"
 #include <netcdf.h>
 #include <vapor/NetCDFSimple.h>
@@ -7,8 +15,130 @@ using namespace VAPoR;
 using namespace Wasp;
 using namespace std;
 
+bool NetCDFSimple::_mmapReadEnabled = true;
+
+namespace {
+
+// Sequential reader for the big-endian fields of a netCDF classic
+// format header. Reads past the end of the buffer are not performed
+// and cause Ok() to return false
+//
+class header_reader {
+public:
+	header_reader(const unsigned char *p, size_t len) :
+		_p(p), _len(len), _pos(0), _ok(true) {}
+
+	uint64_t Get(int nbytes) {
+		if (! _ok || _len - _pos < (size_t) nbytes) {
+			_ok = false;
+			return(0);
+		}
+		uint64_t v = 0;
+		for (int i=0; i<nbytes; i++) v = (v << 8) | _p[_pos++];
+		return(v);
+	}
+
+	void Skip(uint64_t nbytes) {
+		if (! _ok || _len - _pos < nbytes) {
+			_ok = false;
+			return;
+		}
+		_pos += nbytes;
+	}
+
+	bool Ok() const {return(_ok); }
+
+private:
+	const unsigned char *_p;
+	size_t _len;
+	size_t _pos;
+	bool _ok;
+};
+
+const uint64_t NC_TAG_DIMENSION = 0x0A;
+const uint64_t NC_TAG_VARIABLE = 0x0B;
+const uint64_t NC_TAG_ATTRIBUTE = 0x0C;
+const uint64_t NC_STREAMING = 0xFFFFFFFF;
+
+size_t nc_type_size(int type) {
+	switch (type) {
+	case NC_BYTE:
+	case NC_CHAR:
+		return(1);
+	case NC_SHORT:
+		return(2);
+	case NC_INT:
+	case NC_FLOAT:
+		return(4);
+	case NC_DOUBLE:
+		return(8);
+	default:
+		return(0);
+	}
+}
+
+uint64_t pad4(uint64_t n) { return((n + 3) & ~((uint64_t) 3)); }
+
+// Skip over a name, or a list of attributes, in a classic header
+//
+void skip_name(header_reader &hdr) {
+	hdr.Skip(pad4(hdr.Get(4)));
+}
+
+void skip_atts(header_reader &hdr) {
+	uint64_t tag = hdr.Get(4);
+	uint64_t n = hdr.Get(4);
+	if (tag != NC_TAG_ATTRIBUTE && ! (tag == 0 && n == 0)) {
+		hdr.Skip((uint64_t) -1);
+		return;
+	}
+	for (uint64_t i=0; i<n && hdr.Ok(); i++) {
+		skip_name(hdr);
+		size_t tsize = nc_type_size((int) hdr.Get(4));
+		uint64_t nelems = hdr.Get(4);
+		if (! tsize) {
+			hdr.Skip((uint64_t) -1);
+			return;
+		}
+		hdr.Skip(pad4(nelems * tsize));
+	}
+}
+
+// netCDF external type corresponding to a Read() buffer type
+//
+int nc_type_of(const float *) { return(NC_FLOAT); }
+int nc_type_of(const int *) { return(NC_INT); }
+int nc_type_of(const char *) { return(NC_CHAR); }
+
+bool host_is_little_endian() {
+	const uint16_t one = 1;
+	return(*((const unsigned char *) &one) == 1);
+}
+
+// Copy n big-endian elements from src to dst, converting to host
+// byte order
+//
+template <class T>
+void copy_from_big_endian(const unsigned char *src, T *dst, size_t n) {
+	memcpy(dst, src, n * sizeof(T));
+	if (sizeof(T) == 1 || ! host_is_little_endian()) return;
+
+	unsigned char *p = (unsigned char *) dst;
+	for (size_t i=0; i<n; i++, p += sizeof(T)) {
+		for (size_t j=0; j<sizeof(T)/2; j++) {
+			std::swap(p[j], p[sizeof(T)-1-j]);
+		}
+	}
+}
+
+};
+
 NetCDFSimple::NetCDFSimple() {
 	_ncid = -1;
+	_mmapVars.clear();
+	_mmapRecSize = 0;
+	_mmapAddr = NULL;
+	_mmapLen = 0;
 	_ovr_table.clear();
 	_path = "";	// so _path.c_str() returns an empty string
 	_dimnames.clear();
@@ -22,6 +152,8 @@ NetCDFSimple::NetCDFSimple() {
 
 NetCDFSimple::~NetCDFSimple() {
 
+	_mmapClose();
+
 	if (_ncid != -1)  {
 		int rc = nc_close(_ncid);
 		if (rc != 0) {
@@ -147,6 +279,13 @@ int NetCDFSimple::Initialize(string path)
 
 
 	nc_close(ncid);
+
+	// Record where each variable lives in the file so that reads
+	// can be serviced from a memory mapping. Failure is not an error;
+	// it simply disables mapped reads for this file
+	//
+	(void) _mmapParseHeader();
+
 	return(0);
 }
 
@@ -164,6 +303,8 @@ int NetCDFSimple::OpenRead(
 			return(-1);
 		}
 		_ncid = ncid;
+
+		_mmapOpen();
 	}
 
 	int varid;
@@ -201,6 +342,8 @@ int NetCDFSimple::Read(
 	}
 	int varid = itr->second;
 
+	if (_mmapRead(varid, start, count, data)) return(0);
+
 	int rc = nc_get_vara_float(
 		_ncid, varid, start, count, data
 	);
@@ -225,6 +368,8 @@ int NetCDFSimple::Read(
 	}
 	int varid = itr->second;
 
+	if (_mmapRead(varid, start, count, data)) return(0);
+
 	int rc = nc_get_vara_int(
 		_ncid, varid, start, count, data
 	);
@@ -249,6 +394,8 @@ int NetCDFSimple::Read(
 	}
 	int varid = itr->second;
 
+	if (_mmapRead(varid, start, count, data)) return(0);
+
 	int rc = nc_get_vara_text(
 		_ncid, varid, start, count, data
 	);
@@ -274,11 +421,221 @@ int NetCDFSimple::Close(int fd) {
 	if (_ovr_table.empty() && _ncid != -1) {
 		(void) nc_close(_ncid);
 		_ncid = -1;
+
+		_mmapClose();
+	}
+
+	return(0);
+}
+
+int NetCDFSimple::_mmapParseHeader() {
+	_mmapVars.clear();
+	_mmapRecSize = 0;
+
+#ifndef WIN32
+	int fd = open(_path.c_str(), O_RDONLY);
+	if (fd < 0) return(-1);
+
+	struct stat statbuf;
+	if (fstat(fd, &statbuf) < 0 || statbuf.st_size < 8) {
+		close(fd);
+		return(-1);
+	}
+	size_t len = statbuf.st_size;
+
+	void *addr = mmap(NULL, len, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (addr == MAP_FAILED) return(-1);
+
+	const unsigned char *p = (const unsigned char *) addr;
+	header_reader hdr(p, len);
+
+	// Only classic (CDF-1) and 64-bit offset (CDF-2) formats are 
+	// supported. Variable offsets are 4 and 8 bytes wide, respectively
+	//
+	int offset_size = 0;
+	if (p[0] == 'C' && p[1] == 'D' && p[2] == 'F') {
+		if (p[3] == 1) offset_size = 4;
+		else if (p[3] == 2) offset_size = 8;
 	}
+	hdr.Skip(4);
+
+	uint64_t numrecs = hdr.Get(4);
+	if (! offset_size || numrecs == NC_STREAMING) {
+		munmap(addr, len);
+		return(-1);
+	}
+
+	// Dimension lengths. A length of zero identifies the record dimension
+	//
+	vector <uint64_t> dimlens;
+	uint64_t tag = hdr.Get(4);
+	uint64_t n = hdr.Get(4);
+	if (tag != NC_TAG_DIMENSION && ! (tag == 0 && n == 0)) {
+		hdr.Skip((uint64_t) -1);
+	}
+	for (uint64_t i=0; i<n && hdr.Ok(); i++) {
+		skip_name(hdr);
+		dimlens.push_back(hdr.Get(4));
+	}
+
+	skip_atts(hdr);	// global attributes
+
+	vector <mmap_var_t> vars;
+	tag = hdr.Get(4);
+	n = hdr.Get(4);
+	if (tag != NC_TAG_VARIABLE && ! (tag == 0 && n == 0)) {
+		hdr.Skip((uint64_t) -1);
+	}
+	for (uint64_t i=0; i<n && hdr.Ok(); i++) {
+		mmap_var_t var;
+		var._isRecord = false;
+
+		skip_name(hdr);
+		uint64_t ndims = hdr.Get(4);
+		for (uint64_t j=0; j<ndims && hdr.Ok(); j++) {
+			uint64_t dimid = hdr.Get(4);
+			if (dimid >= dimlens.size()) {
+				hdr.Skip((uint64_t) -1);
+				break;
+			}
+			var._dims.push_back(dimlens[dimid] ? dimlens[dimid] : numrecs);
+			if (j == 0) var._isRecord = dimlens[dimid] == 0;
+		}
+
+		skip_atts(hdr);
+
+		var._type = (int) hdr.Get(4);
+		(void) hdr.Get(4);	// vsize. Unreliable for large variables
+		var._begin = hdr.Get(offset_size);
+
+		vars.push_back(var);
+	}
+
+	munmap(addr, len);
+
+	if (! hdr.Ok() || vars.size() != _variables.size()) return(-1);
+
+	// Size of a record is the sum of the per-record sizes of all
+	// record variables, each padded to a 4-byte boundary unless there
+	// is only one record variable
+	//
+	size_t nrecvars = 0;
+	for (size_t i=0; i<vars.size(); i++) {
+		if (vars[i]._isRecord) nrecvars++;
+	}
+	size_t recsize = 0;
+	for (size_t i=0; i<vars.size(); i++) {
+		if (! vars[i]._isRecord) continue;
+
+		size_t size = nc_type_size(vars[i]._type);
+		for (size_t j=1; j<vars[i]._dims.size(); j++) {
+			size *= vars[i]._dims[j];
+		}
+		recsize += nrecvars > 1 ? pad4(size) : size;
+	}
+
+	_mmapVars = vars;
+	_mmapRecSize = recsize;
+#endif
 
 	return(0);
 }
 
+void NetCDFSimple::_mmapOpen() {
+	_mmapClose();
+
+	if (! _mmapReadEnabled || _mmapVars.empty()) return;
+
+#ifndef WIN32
+	int fd = open(_path.c_str(), O_RDONLY);
+	if (fd < 0) return;
+
+	struct stat statbuf;
+	if (fstat(fd, &statbuf) < 0 || statbuf.st_size == 0) {
+		close(fd);
+		return;
+	}
+
+	void *addr = mmap(NULL, statbuf.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (addr == MAP_FAILED) return;
+
+	_mmapAddr = (const unsigned char *) addr;
+	_mmapLen = statbuf.st_size;
+#endif
+}
+
+void NetCDFSimple::_mmapClose() {
+#ifndef WIN32
+	if (_mmapAddr) munmap((void *) _mmapAddr, _mmapLen);
+#endif
+	_mmapAddr = NULL;
+	_mmapLen = 0;
+}
+
+template <class T>
+bool NetCDFSimple::_mmapRead(
+	int varid, const size_t start[], const size_t count[], T *data
+) const {
+	if (! _mmapAddr || varid < 0 || varid >= (int) _mmapVars.size()) {
+		return(false);
+	}
+
+	// No type conversion is performed on mapped reads
+	//
+	const mmap_var_t &var = _mmapVars[varid];
+	if (var._type != nc_type_of(data)) return(false);
+
+	const vector <size_t> &dims = var._dims;
+	size_t ndims = dims.size();
+
+	// Byte stride of each dimension in the file. Consecutive records
+	// of a record variable are separated by the size of a whole record
+	//
+	vector <size_t> stride(ndims, sizeof(T));
+	for (int i=(int) ndims-2; i>=0; i--) {
+		stride[i] = stride[i+1] * dims[i+1];
+	}
+	if (var._isRecord) stride[0] = _mmapRecSize;
+
+	// Let the netCDF library report invalid hyperslabs. Also guard 
+	// against a file that has been truncated since it was opened
+	//
+	size_t last = var._begin;
+	for (size_t i=0; i<ndims; i++) {
+		if (count[i] == 0) return(true);
+		if (start[i] + count[i] > dims[i]) return(false);
+		last += (start[i] + count[i] - 1) * stride[i];
+	}
+	if (last + sizeof(T) > _mmapLen) return(false);
+
+	// Copy the hyperslab one contiguous row (fastest varying dimension)
+	// at a time
+	//
+	size_t rowlen = ndims ? count[ndims-1] : 1;
+	size_t nrows = 1;
+	for (size_t i=0; i+1<ndims; i++) nrows *= count[i];
+
+	vector <size_t> index(ndims, 0);
+	for (size_t r=0; r<nrows; r++) {
+		size_t offset = var._begin;
+		for (size_t i=0; i<ndims; i++) {
+			offset += (start[i] + index[i]) * stride[i];
+		}
+
+		copy_from_big_endian(_mmapAddr + offset, data, rowlen);
+		data += rowlen;
+
+		for (int i=(int) ndims-2; i>=0; i--) {
+			if (++index[i] < count[i]) break;
+			index[i] = 0;
+		}
+	}
+
+	return(true);
+}
+
 
 
 void NetCDFSimple::GetDimensions(
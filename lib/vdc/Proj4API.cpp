@@ -1,6 +1,14 @@
 #define ACCEPT_USE_OF_DEPRECATED_PROJ_API_H 1
+#define _USE_MATH_DEFINES
 
 #include <iostream>
+#include <sstream>
+#include <cstdlib>
+#include <cmath>
+#include <map>
+#include <vector>
+#include <thread>
+#include <algorithm>
 #include <proj_api.h>
 #include <vapor/ResourcePath.h>
 #include <vapor/Proj4API.h>
@@ -8,9 +16,461 @@
 using namespace VAPoR;
 using namespace Wasp;
 
+namespace {
+
+// Transforms with fewer points than this aren't split across threads
+//
+const size_t minPointsPerThread = 16384;
+
+// Transform one range of points. pjSrc and pjDst may only be used by one
+// thread at a time. Returns the pj_transform() error code
+//
+int transform_range(
+	projPJ pjSrc, projPJ pjDst,
+	double *x, double *y, double *z, size_t n, int offset
+) {
+
+	//
+	// Convert from degrees to radians if source is in 
+	// geographic coordinates
+	//
+	if (pj_is_latlong(pjSrc)) {
+		if (x) {
+			for (size_t i=0; i<n; i++) {
+				x[i * (size_t) offset] *= DEG_TO_RAD;
+			}
+		}
+		if (y) {
+			for (size_t i=0; i<n; i++) {
+				y[i * (size_t) offset] *= DEG_TO_RAD;
+			}
+		}
+		if (z) {
+			for (size_t i=0; i<n; i++) {
+				z[i * (size_t) offset] *= DEG_TO_RAD;
+			}
+		}
+	}
+
+	int rc = pj_transform(pjSrc, pjDst, n, offset, x, y, NULL);
+	if (rc != 0) return(rc);
+
+	//
+	// Convert from radians degrees if destination is in 
+	// geographic coordinates
+	//
+	if (pj_is_latlong(pjDst)) {
+		if (x) {
+			for (size_t i=0; i<n; i++) {
+				x[i * (size_t) offset] *= RAD_TO_DEG;
+			}
+		}
+		if (y) {
+			for (size_t i=0; i<n; i++) {
+				y[i * (size_t) offset] *= RAD_TO_DEG;
+			}
+		}
+		if (z) {
+			for (size_t i=0; i<n; i++) {
+				z[i * (size_t) offset] *= RAD_TO_DEG;
+			}
+		}
+	}
+	return(0);
+}
+
+// Number of threads to split a transform of n points across
+//
+size_t num_threads(size_t n) {
+	size_t nthreads = std::thread::hardware_concurrency();
+	if (nthreads < 1) nthreads = 1;
+	return(std::max((size_t) 1, std::min(nthreads, n / minPointsPerThread)));
+}
+
+// Apply f(first, count) to consecutive ranges of [0..n-1], one per thread.
+// The calling thread takes the first range.
+//
+template <typename F>
+void for_each_range(size_t n, size_t nthreads, const F &f) {
+	size_t count = (n + nthreads - 1) / nthreads;
+
+	vector <std::thread> threads;
+	for (size_t t=1; t<nthreads; t++) {
+		size_t first = t * count;
+		if (first >= n) break;
+		threads.push_back(std::thread(f, t, first, std::min(count, n - first)));
+	}
+	f(0, 0, std::min(count, n));
+	for (auto &thread : threads) thread.join();
+}
+
+string proj_def(projPJ pj) {
+	char *def = pj_get_def(pj, 0);
+	if (! def) return("");
+
+	string s = def;
+	pj_dalloc(def);
+	return(s);
+}
+
+// Parse a proj4 definition into its +key=value parameters. Flags have
+// empty values
+//
+map <string, string> parse_def(const string &def) {
+	map <string, string> params;
+
+	std::istringstream iss(def);
+	string token;
+	while (iss >> token) {
+		if (token.empty() || token[0] != '+') continue;
+
+		string::size_type eq = token.find('=');
+		if (eq == string::npos) {
+			params[token.substr(1)] = "";
+		}
+		else {
+			params[token.substr(1, eq-1)] = token.substr(eq+1);
+		}
+	}
+	return(params);
+}
+
+// Parse an angle, in decimal degrees, into radians
+//
+bool parse_angle(
+	const map <string, string> &params, const string &key, double &v
+) {
+	auto itr = params.find(key);
+	if (itr == params.end()) return(false);
+
+	const char *s = itr->second.c_str();
+	char *end;
+	v = strtod(s, &end) * DEG_TO_RAD;
+	return(*s && ! *end);
+}
+
+bool parse_double(
+	const map <string, string> &params, const string &key, double &v
+) {
+	auto itr = params.find(key);
+	if (itr == params.end()) return(false);
+
+	const char *s = itr->second.c_str();
+	char *end;
+	v = strtod(s, &end);
+	return(*s && ! *end);
+}
+
+// Ellipsoid functions, as in proj4's pj_tsfn.c, pj_msfn.c, pj_phi2.c, and
+// adjlon.c
+//
+inline double tsfn(double phi, double sinphi, double e) {
+	sinphi *= e;
+	return(
+		tan(.5 * (M_PI_2 - phi)) / pow((1. - sinphi) / (1. + sinphi), .5 * e)
+	);
+}
+
+inline double msfn(double sinphi, double cosphi, double es) {
+	return(cosphi / sqrt(1. - es * sinphi * sinphi));
+}
+
+inline double phi2(double ts, double e) {
+	double eccnth = .5 * e;
+	double phi = M_PI_2 - 2. * atan(ts);
+	double dphi;
+	int i = 15;
+	do {
+		double con = e * sin(phi);
+		dphi = M_PI_2 - 2. * atan(ts * pow((1. - con) / (1. + con), eccnth)) - 
+			phi;
+		phi += dphi;
+	} while (fabs(dphi) > 1.0e-10 && --i);
+	return(phi);
+}
+
+inline double adjlon(double lon) {
+	if (fabs(lon) < M_PI + 1e-12) return(lon);
+
+	lon += M_PI;
+	lon -= 2. * M_PI * floor(lon / (2. * M_PI));
+	lon -= M_PI;
+	return(lon);
+}
+
+const double EPS10 = 1.e-10;
+
+};
+
+//
+// Closed form Mercator and Lambert Conformal Conic projections, following
+// Snyder, "Map Projections - A Working Manual" and proj4's PJ_merc.c and
+// PJ_lcc.c
+//
+class Proj4API::FastProj {
+public:
+
+ // Returns NULL if the projection defined by \p def isn't supported
+ //
+ static FastProj *Make(const string &def, double a, double es);
+
+ // Geographic coordinates, in degrees, to projected coordinates. 
+ // Returns false, leaving x and y partially transformed, if a point 
+ // can't be projected.
+ //
+ bool Forward(double *x, double *y, size_t n, int offset) const;
+
+ // Projected coordinates to geographic coordinates, in degrees
+ //
+ bool Inverse(double *x, double *y, size_t n, int offset) const;
+
+private:
+ enum Type {MERC, LCC};
+
+ Type _type;
+ double _a;
+ double _e;
+ double _es;
+ double _lam0;
+ double _x0;
+ double _y0;
+ double _k0;
+ double _n;		// cone constant
+ double _c;
+ double _rho0;
+
+ FastProj() {}
+};
+
+Proj4API::FastProj *Proj4API::FastProj::Make(
+	const string &def, double a, double es
+) {
+	map <string, string> params = parse_def(def);
+
+	// Anything that changes the projection in a way not handled here
+	// (axis order, units, prime meridian, etc.) disables the fast path
+	//
+	const vector <string> known = {
+		"proj", "lat_0", "lon_0", "lat_1", "lat_2", "lat_ts", "k", "k_0",
+		"x_0", "y_0", "units", "ellps", "datum", "towgs84", "nadgrids",
+		"a", "b", "R", "rf", "f", "es", "e", "no_defs", "wktext", "type"
+	};
+	for (auto itr = params.begin(); itr != params.end(); ++itr) {
+		if (std::find(known.begin(), known.end(), itr->first) == known.end()) {
+			return(NULL);
+		}
+	}
+	if (params.count("units") && params["units"] != "m") return(NULL);
+
+	if (! (a > 0.0) || ! (es >= 0.0 && es < 1.0)) return(NULL);
+
+	FastProj fp;
+	fp._a = a;
+	fp._es = es;
+	fp._e = sqrt(es);
+	fp._lam0 = fp._x0 = fp._y0 = 0.0;
+	fp._k0 = 1.0;
+	fp._n = fp._c = fp._rho0 = 0.0;
+
+	double phi0 = 0.0;
+	if (params.count("lat_0") && ! parse_angle(params, "lat_0", phi0)) {
+		return(NULL);
+	}
+	if (params.count("lon_0") && ! parse_angle(params, "lon_0", fp._lam0)) {
+		return(NULL);
+	}
+	if (params.count("x_0") && ! parse_double(params, "x_0", fp._x0)) {
+		return(NULL);
+	}
+	if (params.count("y_0") && ! parse_double(params, "y_0", fp._y0)) {
+		return(NULL);
+	}
+	if (params.count("k_0")) {
+		if (! parse_double(params, "k_0", fp._k0)) return(NULL);
+	}
+	else if (params.count("k")) {
+		if (! parse_double(params, "k", fp._k0)) return(NULL);
+	}
+
+	if (params["proj"] == "merc") {
+		fp._type = MERC;
+
+		if (params.count("lat_ts")) {
+			double phits;
+			if (! parse_angle(params, "lat_ts", phits)) return(NULL);
+			phits = fabs(phits);
+			if (phits >= M_PI_2) return(NULL);
+
+			fp._k0 = es != 0.0 ? 
+				msfn(sin(phits), cos(phits), es) : cos(phits);
+		}
+	}
+	else if (params["proj"] == "lcc") {
+		fp._type = LCC;
+
+		double phi1, phi2;
+		if (! parse_angle(params, "lat_1", phi1)) return(NULL);
+		if (params.count("lat_2")) {
+			if (! parse_angle(params, "lat_2", phi2)) return(NULL);
+		}
+		else {
+			phi2 = phi1;
+			if (! params.count("lat_0")) phi0 = phi1;
+		}
+		if (fabs(phi1 + phi2) < EPS10) return(NULL);
+
+		double sinphi = sin(phi1);
+		double cosphi = cos(phi1);
+		bool secant = fabs(phi1 - phi2) >= EPS10;
+		if (es != 0.0) {
+			double m1 = msfn(sinphi, cosphi, es);
+			double ml1 = tsfn(phi1, sinphi, fp._e);
+			fp._n = sinphi;
+			if (secant) {
+				sinphi = sin(phi2);
+				fp._n = log(m1 / msfn(sinphi, cos(phi2), es));
+				fp._n /= log(ml1 / tsfn(phi2, sinphi, fp._e));
+			}
+			fp._c = m1 * pow(ml1, -fp._n) / fp._n;
+			fp._rho0 = fabs(fabs(phi0) - M_PI_2) < EPS10 ? 0. :
+				fp._c * pow(tsfn(phi0, sin(phi0), fp._e), fp._n);
+		}
+		else {
+			fp._n = sinphi;
+			if (secant) {
+				fp._n = log(cosphi / cos(phi2)) /
+					log(tan(M_PI_4 + .5 * phi2) / tan(M_PI_4 + .5 * phi1));
+			}
+			fp._c = cosphi * pow(tan(M_PI_4 + .5 * phi1), fp._n) / fp._n;
+			fp._rho0 = fabs(fabs(phi0) - M_PI_2) < EPS10 ? 0. :
+				fp._c * pow(tan(M_PI_4 + .5 * phi0), -fp._n);
+		}
+		if (! std::isfinite(fp._n) || fp._n == 0.0) return(NULL);
+		if (! std::isfinite(fp._c) || ! std::isfinite(fp._rho0)) return(NULL);
+	}
+	else {
+		return(NULL);
+	}
+
+	return(new FastProj(fp));
+}
+
+bool Proj4API::FastProj::Forward(
+	double *x, double *y, size_t n, int offset
+) const {
+
+	bool ok = true;
+	for (size_t i=0; i<n; i++) {
+		double &xr = x[i * (size_t) offset];
+		double &yr = y[i * (size_t) offset];
+
+		double lam = xr * DEG_TO_RAD;
+		double phi = yr * DEG_TO_RAD;
+
+		// Out of range coordinates are errors for proj4, which wraps
+		// the longitude before and after removing the central meridian
+		//
+		double t = fabs(phi) - M_PI_2;
+		if (! (t <= 1.e-12) || ! (fabs(lam) <= 10.)) {
+			ok = false;
+			continue;
+		}
+		if (fabs(t) <= 1.e-12) phi = phi < 0. ? -M_PI_2 : M_PI_2;
+		lam = adjlon(adjlon(lam) - _lam0);
+
+		double px, py;
+		if (_type == MERC) {
+			if (fabs(fabs(phi) - M_PI_2) <= EPS10) {
+				ok = false;
+				continue;
+			}
+			px = _k0 * lam;
+			py = _es != 0.0 ? 
+				-_k0 * log(tsfn(phi, sin(phi), _e)) :
+				_k0 * log(tan(M_PI_4 + .5 * phi));
+		}
+		else {
+			double rho;
+			if (fabs(fabs(phi) - M_PI_2) < EPS10) {
+				if ((phi * _n) <= 0.) {
+					ok = false;
+					continue;
+				}
+				rho = 0.;
+			}
+			else {
+				rho = _c * (_es != 0.0 ? 
+					pow(tsfn(phi, sin(phi), _e), _n) :
+					pow(tan(M_PI_4 + .5 * phi), -_n));
+			}
+			lam *= _n;
+			px = _k0 * (rho * sin(lam));
+			py = _k0 * (_rho0 - rho * cos(lam));
+		}
+		xr = _a * px + _x0;
+		yr = _a * py + _y0;
+	}
+	return(ok);
+}
+
+bool Proj4API::FastProj::Inverse(
+	double *x, double *y, size_t n, int offset
+) const {
+
+	bool ok = true;
+	for (size_t i=0; i<n; i++) {
+		double &xr = x[i * (size_t) offset];
+		double &yr = y[i * (size_t) offset];
+
+		double px = (xr - _x0) / _a;
+		double py = (yr - _y0) / _a;
+		if (! std::isfinite(px) || ! std::isfinite(py)) {
+			ok = false;
+			continue;
+		}
+
+		double lam, phi;
+		if (_type == MERC) {
+			phi = _es != 0.0 ? 
+				phi2(exp(-py / _k0), _e) :
+				M_PI_2 - 2. * atan(exp(-py / _k0));
+			lam = px / _k0;
+		}
+		else {
+			px /= _k0;
+			py = _rho0 - py / _k0;
+			double rho = hypot(px, py);
+			if (rho != 0.0) {
+				if (_n < 0.) {
+					rho = -rho;
+					px = -px;
+					py = -py;
+				}
+				if (_es != 0.0) {
+					phi = phi2(pow(rho / _c, 1. / _n), _e);
+				}
+				else {
+					phi = 2. * atan(pow(_c / rho, 1. / _n)) - M_PI_2;
+				}
+				lam = atan2(px, py) / _n;
+			}
+			else {
+				lam = 0.;
+				phi = _n > 0. ? M_PI_2 : -M_PI_2;
+			}
+		}
+		xr = adjlon(lam + _lam0) * RAD_TO_DEG;
+		yr = phi * RAD_TO_DEG;
+	}
+	return(ok);
+}
+
 Proj4API::Proj4API() {
 	_pjSrc = NULL;
 	_pjDst = NULL;
+	_fastProj = NULL;
+	_fastForward = true;
+	_fastVerified = -1;
 
     string path = GetSharePath("proj");
 	if (! path.empty()) {
@@ -28,6 +488,7 @@ Proj4API::Proj4API() {
 Proj4API::~Proj4API() {
 	if (_pjSrc) pj_free(_pjSrc);
 	if (_pjDst) pj_free(_pjDst);
+	if (_fastProj) delete _fastProj;
 }
 
 int Proj4API::_Initialize(
@@ -84,7 +545,145 @@ int Proj4API::Initialize(string srcdef, string dstdef) {
 	_pjSrc = NULL;
 	_pjDst = NULL;
 
-	return(_Initialize(srcdef, dstdef, &_pjSrc, &_pjDst));
+	int rc = _Initialize(srcdef, dstdef, &_pjSrc, &_pjDst);
+	if (rc<0) return(rc);
+
+	_initFastProj();
+	return(0);
+}
+
+void Proj4API::_initFastProj() {
+	if (_fastProj) delete _fastProj;
+	_fastProj = NULL;
+	_fastVerified = -1;
+
+	if (! _pjSrc || ! _pjDst) return;
+
+	bool srcLatLon = pj_is_latlong(_pjSrc);
+	bool dstLatLon = pj_is_latlong(_pjDst);
+	if (srcLatLon == dstLatLon) return;
+
+	_fastForward = srcLatLon;
+	projPJ pjGeo = _fastForward ? _pjSrc : _pjDst;
+	projPJ pjProj = _fastForward ? _pjDst : _pjSrc;
+
+	// The geographic coordinates must be on the projection's own datum,
+	// relative to Greenwich
+	//
+	map <string, string> geo = parse_def(proj_def(pjGeo));
+	map <string, string> proj = parse_def(proj_def(pjProj));
+	const vector <string> datumKeys = {"datum", "towgs84", "nadgrids"};
+	for (auto &key : datumKeys) {
+		if (geo.count(key) != proj.count(key)) return;
+		if (geo.count(key) && geo[key] != proj[key]) return;
+	}
+	const vector <string> geoKeys = {
+		"proj", "ellps", "datum", "towgs84", "nadgrids",
+		"a", "b", "R", "rf", "f", "es", "e", "no_defs", "wktext", "type"
+	};
+	for (auto itr = geo.begin(); itr != geo.end(); ++itr) {
+		if (std::find(geoKeys.begin(), geoKeys.end(), itr->first) == 
+			geoKeys.end()) {
+
+			return;
+		}
+	}
+
+	double a, es, geoA, geoEs;
+	pj_get_spheroid_defn(pjProj, &a, &es);
+	pj_get_spheroid_defn(pjGeo, &geoA, &geoEs);
+	if (a != geoA || es != geoEs) return;
+
+	_fastProj = FastProj::Make(proj_def(pjProj), a, es);
+}
+
+bool Proj4API::_fastTransform(
+	double *x, double *y, size_t n, int offset
+) const {
+	int verified = _fastVerified.load();
+	if (! _fastProj || ! verified || ! x || ! y || ! n) return(false);
+
+	auto transform = [this](double *x, double *y, size_t n, int offset) {
+		return(
+			_fastForward ? 
+			_fastProj->Forward(x, y, n, offset) :
+			_fastProj->Inverse(x, y, n, offset)
+		);
+	};
+
+	// Check a sample of the points against proj4 the first time
+	//
+	if (verified < 0) {
+		size_t ns = std::min(n, (size_t) 16);
+		vector <double> px(ns), py(ns);
+		for (size_t s=0; s<ns; s++) {
+			size_t i = s * (n / ns);
+			px[s] = x[i * (size_t) offset];
+			py[s] = y[i * (size_t) offset];
+		}
+		vector <double> fx = px;
+		vector <double> fy = py;
+
+		// Points that either can't transform say nothing about agreement
+		//
+		if (transform_range(
+			(projPJ) _pjSrc, (projPJ) _pjDst, px.data(), py.data(), NULL, ns, 1
+		) != 0) return(false);
+		if (! transform(fx.data(), fy.data(), ns, 1)) return(false);
+
+		// Millimeters, or roughly the same in degrees. Projected 
+		// coordinates near a pole are huge, and longitudes there are 
+		// ill conditioned, so scale the tolerance accordingly
+		//
+		for (size_t s=0; s<ns; s++) {
+			double dx = fabs(px[s] - fx[s]);
+			double dy = fabs(py[s] - fy[s]);
+			bool agree;
+			if (_fastForward) {
+				agree = dx <= 1.0e-3 + 1.0e-8 * fabs(px[s]) &&
+					dy <= 1.0e-3 + 1.0e-8 * fabs(py[s]);
+			}
+			else {
+				dx = std::min(dx, fabs(dx - 360.0));
+				agree = dx * cos(py[s] * DEG_TO_RAD) <= 1.0e-8 && 
+					dy <= 1.0e-8;
+			}
+			if (! agree) {
+				_fastVerified = 0;
+				return(false);
+			}
+		}
+
+		// Don't overwrite a disagreement found by another thread
+		//
+		verified = -1;
+		_fastVerified.compare_exchange_strong(verified, 1);
+		if (_fastVerified.load() != 1) return(false);
+	}
+
+	// The points are transformed in place, so let proj4 handle the 
+	// whole transform if any point fails
+	//
+	vector <double> xcopy(n), ycopy(n);
+	for (size_t i=0; i<n; i++) {
+		xcopy[i] = x[i * (size_t) offset];
+		ycopy[i] = y[i * (size_t) offset];
+	}
+
+	size_t nthreads = num_threads(n);
+	vector <char> ok(nthreads, 1);
+	for_each_range(n, nthreads, [&](size_t t, size_t first, size_t count) {
+		ok[t] = transform(
+			xcopy.data() + first, ycopy.data() + first, count, 1
+		);
+	});
+	if (std::find(ok.begin(), ok.end(), 0) != ok.end()) return(false);
+
+	for (size_t i=0; i<n; i++) {
+		x[i * (size_t) offset] = xcopy[i];
+		y[i * (size_t) offset] = ycopy[i];
+	}
+	return(true);
 }
 
 bool Proj4API::IsLatLonSrc() const {
@@ -137,59 +736,65 @@ int Proj4API::_Transform(
 	//
 	if (pjSrc == NULL || pjDst == NULL) return(0);
 
-	//
-	// Convert from degrees to radians if source is in 
-	// geographic coordinates
-	//
-	if (pj_is_latlong(pjSrc)) {
-		if (x) {
-			for (size_t i=0; i<n; i++) {
-				x[i * (size_t) offset] *= DEG_TO_RAD;
-			}
-		}
-		if (y) {
-			for (size_t i=0; i<n; i++) {
-				y[i * (size_t) offset] *= DEG_TO_RAD;
-			}
-		}
-		if (z) {
-			for (size_t i=0; i<n; i++) {
-				z[i * (size_t) offset] *= DEG_TO_RAD;
-			}
-		}
+	if (pjSrc == _pjSrc && pjDst == _pjDst && ! z) {
+		if (_fastTransform(x, y, n, offset)) return(0);
 	}
 
-	int rc = pj_transform(pjSrc, pjDst, n, offset, x, y, NULL);
-	if (rc != 0) {
-		SetErrMsg("pj_transform() : %s", ProjErr().c_str());
-		return(-1);
+	size_t nthreads = num_threads(n);
+	if (nthreads < 2) {
+		int rc = transform_range(
+			(projPJ) pjSrc, (projPJ) pjDst, x, y, z, n, offset
+		);
+		if (rc != 0) {
+			SetErrMsg("pj_transform() : %s", pj_strerrno(rc));
+			return(-1);
+		}
+		return(0);
 	}
 
+	// proj4 projections can't be shared by threads, so each thread 
+	// gets its own context and copies of the projections
 	//
-	// Convert from radians degrees if destination is in 
-	// geographic coordinates
-	//
-	if (pj_is_latlong(pjDst)) {
-		if (x) {
-			for (size_t i=0; i<n; i++) {
-				x[i * (size_t) offset] *= RAD_TO_DEG;
-			}
+	string srcdef = proj_def((projPJ) pjSrc);
+	string dstdef = proj_def((projPJ) pjDst);
+	vector <int> rcs(nthreads, 0);
+	for_each_range(n, nthreads, [&](size_t t, size_t first, size_t count) {
+		size_t o = first * (size_t) offset;
+		double *xt = x ? x + o : NULL;
+		double *yt = y ? y + o : NULL;
+		double *zt = z ? z + o : NULL;
+
+		if (t == 0) {
+			rcs[t] = transform_range(
+				(projPJ) pjSrc, (projPJ) pjDst, xt, yt, zt, count, offset
+			);
+			return;
 		}
-		if (y) {
-			for (size_t i=0; i<n; i++) {
-				y[i * (size_t) offset] *= RAD_TO_DEG;
-			}
+
+		projCtx ctx = pj_ctx_alloc();
+		projPJ src = pj_init_plus_ctx(ctx, srcdef.c_str());
+		projPJ dst = pj_init_plus_ctx(ctx, dstdef.c_str());
+		if (src && dst) {
+			rcs[t] = transform_range(src, dst, xt, yt, zt, count, offset);
 		}
-		if (z) {
-			for (size_t i=0; i<n; i++) {
-				z[i * (size_t) offset] *= RAD_TO_DEG;
-			}
+		else {
+			rcs[t] = pj_ctx_get_errno(ctx);
+			if (! rcs[t]) rcs[t] = -1;
+		}
+		if (src) pj_free(src);
+		if (dst) pj_free(dst);
+		pj_ctx_free(ctx);
+	});
+
+	for (size_t t=0; t<nthreads; t++) {
+		if (rcs[t] != 0) {
+			SetErrMsg("pj_transform() : %s", pj_strerrno(rcs[t]));
+			return(-1);
 		}
 	}
 	return(0);
 }
 
-
 int Proj4API::Transform(
 	double *x, double *y, double *z, size_t n, int offset
 ) const {
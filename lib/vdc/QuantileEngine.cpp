@@ -0,0 +1,480 @@
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <cmath>
+#include "vapor/VAssert.h"
+#include <vapor/QuantileEngine.h>
+
+using namespace std;
+using namespace VAPoR;
+
+namespace {
+
+// Number of histogram bins used to narrow down the range of each quantile
+// in exact mode
+//
+const size_t NumBins = 4096;
+
+// Return true if v is neither NaN nor infinite. Such values are ignored,
+// as they have no place in the histograms.
+//
+inline bool isFinite(float v) {
+	return(std::fabs(v) <= std::numeric_limits<float>::max());
+}
+
+};
+
+//
+// A KLL quantile sketch (Karnin, Lang, Liberty, "Optimal Quantile
+// Approximation in Streams", 2016). Level h holds items that each stand
+// for 2^h values. When a level fills up it is sorted, and every other item
+// is promoted to the next level, starting at a random offset.
+//
+class QuantileEngine::Sketch {
+public:
+ Sketch(size_t k, unsigned int seed) : _k(k), _n(0), _rng(seed) {
+	_levels.resize(1);
+ }
+
+ void Add(float v) {
+	_levels[0].push_back(v);
+	_n++;
+	if (_levels[0].size() >= _capacity(0)) _compress();
+ }
+
+ void Merge(const Sketch &rhs) {
+	if (_levels.size() < rhs._levels.size()) _levels.resize(rhs._levels.size());
+	for (size_t h=0; h<rhs._levels.size(); h++) {
+		_levels[h].insert(
+			_levels[h].end(), rhs._levels[h].begin(), rhs._levels[h].end()
+		);
+	}
+	_n += rhs._n;
+	_compress();
+ }
+
+ size_t Count() const { return(_n); }
+
+ // Return the value with the given rank in the weighted sample
+ //
+ float Quantile(size_t rank) const {
+	vector <pair <float, size_t> > items;
+	for (size_t h=0; h<_levels.size(); h++) {
+		for (float v : _levels[h]) items.push_back(make_pair(v, (size_t) 1 << h));
+	}
+	VAssert(items.size());
+
+	sort(items.begin(), items.end());
+
+	size_t weight = 0;
+	for (const auto &item : items) {
+		weight += item.second;
+		if (weight > rank) return(item.first);
+	}
+	return(items.back().first);
+ }
+
+private:
+ size_t _k;
+ size_t _n;
+ std::minstd_rand _rng;
+ vector <vector <float> > _levels;
+
+ // Capacities decrease geometrically towards the lower levels
+ //
+ size_t _capacity(size_t h) const {
+	double c = _k * pow(2.0/3.0, (double) (_levels.size() - 1 - h));
+	return(max((size_t) 2, (size_t) ceil(c)));
+ }
+
+ void _compress() {
+	for (;;) {
+		size_t size = 0;
+		size_t capacity = 0;
+		for (size_t h=0; h<_levels.size(); h++) {
+			size += _levels[h].size();
+			capacity += _capacity(h);
+		}
+		if (size < capacity) return;
+
+		for (size_t h=0; h<_levels.size(); h++) {
+			if (_levels[h].size() >= _capacity(h)) {
+				_compact(h);
+				break;
+			}
+		}
+	}
+ }
+
+ void _compact(size_t h) {
+	if (h + 1 == _levels.size()) _levels.resize(h + 2);
+
+	vector <float> &level = _levels[h];
+	sort(level.begin(), level.end());
+
+	// An odd item out stays behind, so that the total weight is preserved
+	//
+	size_t m = level.size() & ~(size_t) 1;
+	for (size_t i = _rng() & 1; i<m; i+=2) {
+		_levels[h+1].push_back(level[i]);
+	}
+	level.erase(level.begin(), level.begin() + m);
+ }
+};
+
+// The range of values known to contain a quantile in exact mode. Values
+// in [lo, hi] are either binned into a histogram, or collected once few
+// enough of them are left.
+//
+struct QuantileEngine::Target {
+	size_t rank;	// rank of the quantile among all values
+	size_t below;	// number of values less than lo
+	size_t n;		// number of values in [lo, hi]
+	float lo;
+	float hi;
+	double scale;	// histogram bins per unit value
+	bool collect;
+	bool done;
+	double value;
+};
+
+struct QuantileEngine::ThreadState {
+	size_t count;
+	float min;
+	float max;
+	vector <vector <size_t> > hist;
+	vector <vector <float> > binMin;
+	vector <vector <float> > binMax;
+	vector <vector <float> > buffers;
+	std::unique_ptr <Sketch> sketch;
+};
+
+QuantileEngine::QuantileEngine(
+	Mode mode, double epsilon, int nthreads, size_t bufferLimit
+) {
+	_mode = mode;
+	_epsilon = epsilon > 0.0 ? epsilon : 0.001;
+	_nthreads = Grid::GetNumBlockThreads(nthreads);
+	_bufferLimit = max(bufferLimit, (size_t) 1);
+	_quantiles = {0.5};
+
+	_reset();
+}
+
+QuantileEngine::~QuantileEngine() {
+}
+
+void QuantileEngine::SetQuantiles(const vector <double> &quantiles) {
+	_quantiles = quantiles;
+	for (auto &q : _quantiles) q = std::min(std::max(q, 0.0), 1.0);
+	_reset();
+}
+
+void QuantileEngine::_reset() {
+	_pass = 0;
+	_done = _quantiles.empty();
+	_count = 0;
+	_min = _max = 0.0;
+	_targets.clear();
+	_results.clear();
+
+	_threads.clear();
+	for (int t=0; t<_nthreads; t++) {
+		_threads.push_back(std::unique_ptr <ThreadState> (new ThreadState()));
+	}
+}
+
+bool QuantileEngine::BeginPass() {
+	if (_done) return(false);
+
+	// Reset per thread state for the pass
+	//
+	size_t k = (size_t) ceil(1.7 / _epsilon);
+	for (int t=0; t<_nthreads; t++) {
+		ThreadState &ts = *_threads[t];
+		ts.count = 0;
+		ts.min = std::numeric_limits<float>::infinity();
+		ts.max = -std::numeric_limits<float>::infinity();
+
+		if (_mode == APPROXIMATE) {
+			ts.sketch.reset(new Sketch(k, t + 1));
+			continue;
+		}
+
+		ts.hist.resize(_targets.size());
+		ts.binMin.resize(_targets.size());
+		ts.binMax.resize(_targets.size());
+		ts.buffers.resize(_targets.size());
+		for (size_t i=0; i<_targets.size(); i++) {
+			const Target &target = _targets[i];
+			bool binning = ! target.done && ! target.collect;
+
+			ts.hist[i].assign(binning ? NumBins : 0, 0);
+			ts.binMin[i].assign(
+				binning ? NumBins : 0, std::numeric_limits<float>::infinity()
+			);
+			ts.binMax[i].assign(
+				binning ? NumBins : 0, -std::numeric_limits<float>::infinity()
+			);
+			ts.buffers[i].clear();
+		}
+	}
+	return(true);
+}
+
+void QuantileEngine::Add(
+	int thread, const float *values, const unsigned char *mask, size_t n,
+	float missingValue
+) {
+	VAssert(thread >= 0 && thread < _nthreads);
+	ThreadState &ts = *_threads[thread];
+
+	if (_mode == APPROXIMATE) {
+		for (size_t i=0; i<n; i++) {
+			float v = values[i];
+			if (v == missingValue || (mask && ! mask[i]) || ! isFinite(v)) continue;
+			ts.sketch->Add(v);
+		}
+		return;
+	}
+
+	if (_pass == 0) {
+		float min = ts.min;
+		float max = ts.max;
+		size_t count = 0;
+		for (size_t i=0; i<n; i++) {
+			float v = values[i];
+			if (v == missingValue || (mask && ! mask[i]) || ! isFinite(v)) continue;
+			min = v < min ? v : min;
+			max = v > max ? v : max;
+			count++;
+		}
+		ts.min = min;
+		ts.max = max;
+		ts.count += count;
+		return;
+	}
+
+	for (size_t j=0; j<_targets.size(); j++) {
+		const Target &target = _targets[j];
+		if (target.done) continue;
+
+		const float lo = target.lo;
+		const float hi = target.hi;
+		if (target.collect) {
+			vector <float> &buffer = ts.buffers[j];
+			for (size_t i=0; i<n; i++) {
+				float v = values[i];
+				if (v == missingValue || (mask && ! mask[i])) continue;
+				if (! (v >= lo && v <= hi)) continue;
+				buffer.push_back(v);
+			}
+			continue;
+		}
+
+		size_t *hist = ts.hist[j].data();
+		float *binMin = ts.binMin[j].data();
+		float *binMax = ts.binMax[j].data();
+		for (size_t i=0; i<n; i++) {
+			float v = values[i];
+			if (v == missingValue || (mask && ! mask[i])) continue;
+			if (! (v >= lo && v <= hi)) continue;
+
+			// Monotonic in v, so each bin holds a contiguous range of values
+			//
+			size_t b = (size_t) (((double) v - lo) * target.scale);
+			if (b >= NumBins) b = NumBins - 1;
+
+			hist[b]++;
+			binMin[b] = v < binMin[b] ? v : binMin[b];
+			binMax[b] = v > binMax[b] ? v : binMax[b];
+		}
+	}
+}
+
+Grid::BlockVisitor QuantileEngine::GetVisitor(float missingValue) {
+	return(
+		[this, missingValue](
+			int thread, const float *values, const unsigned char *mask, size_t n
+		) {
+			Add(thread, values, mask, n, missingValue);
+		}
+	);
+}
+
+void QuantileEngine::EndPass() {
+	if (_done) return;
+
+	if (_mode == APPROXIMATE) _endApproximatePass();
+	else if (_pass == 0) _endCountPass();
+	else _endRefinePass();
+
+	_pass++;
+}
+
+size_t QuantileEngine::_rank(double q) const {
+	VAssert(_count);
+	size_t rank = (size_t) (q * (double) _count);
+	return(std::min(rank, _count - 1));
+}
+
+void QuantileEngine::_endApproximatePass() {
+	Sketch &sketch = *_threads[0]->sketch;
+	for (int t=1; t<_nthreads; t++) {
+		sketch.Merge(*_threads[t]->sketch);
+		_threads[t]->sketch.reset();
+	}
+
+	_count = sketch.Count();
+	if (_count) {
+		for (auto q : _quantiles) {
+			_results.push_back(sketch.Quantile(_rank(q)));
+		}
+	}
+	_threads[0]->sketch.reset();
+	_done = true;
+}
+
+void QuantileEngine::_endCountPass() {
+	_count = 0;
+	_min = std::numeric_limits<float>::infinity();
+	_max = -std::numeric_limits<float>::infinity();
+	for (int t=0; t<_nthreads; t++) {
+		_count += _threads[t]->count;
+		_min = std::min(_min, _threads[t]->min);
+		_max = std::max(_max, _threads[t]->max);
+	}
+
+	if (! _count) {
+		_done = true;
+		return;
+	}
+
+	for (auto q : _quantiles) {
+		Target target;
+		target.rank = _rank(q);
+		target.below = 0;
+		target.n = _count;
+		target.lo = _min;
+		target.hi = _max;
+		target.done = false;
+		target.value = 0.0;
+		_targets.push_back(target);
+	}
+
+	_done = true;
+	for (auto &target : _targets) {
+		if (target.lo == target.hi) {
+			target.done = true;
+			target.value = target.lo;
+			continue;
+		}
+		target.collect = target.n <= _bufferLimit;
+		target.scale = NumBins / ((double) target.hi - target.lo);
+		_done = false;
+	}
+	if (_done) {
+		for (const auto &target : _targets) _results.push_back(target.value);
+	}
+}
+
+void QuantileEngine::_endRefinePass() {
+	_done = true;
+	for (size_t j=0; j<_targets.size(); j++) {
+		Target &target = _targets[j];
+		if (target.done) continue;
+
+		if (target.collect) {
+			vector <float> values;
+			values.reserve(target.n);
+			for (int t=0; t<_nthreads; t++) {
+				vector <float> &buffer = _threads[t]->buffers[j];
+				values.insert(values.end(), buffer.begin(), buffer.end());
+				vector <float> ().swap(buffer);
+			}
+
+			// All passes have to add the same values
+			//
+			if (values.size() != target.n) {
+				SetErrMsg("Values changed between passes");
+				_count = 0;
+				_results.clear();
+				return;
+			}
+
+			size_t k = target.rank - target.below;
+			nth_element(values.begin(), values.begin() + k, values.end());
+			target.value = values[k];
+			target.done = true;
+			continue;
+		}
+
+		// Find the bin holding the quantile, and narrow the range down to
+		// the values in that bin
+		//
+		vector <size_t> hist(NumBins, 0);
+		vector <float> binMin(NumBins, std::numeric_limits<float>::infinity());
+		vector <float> binMax(NumBins, -std::numeric_limits<float>::infinity());
+		for (int t=0; t<_nthreads; t++) {
+			const ThreadState &ts = *_threads[t];
+			for (size_t b=0; b<NumBins; b++) {
+				hist[b] += ts.hist[j][b];
+				binMin[b] = std::min(binMin[b], ts.binMin[j][b]);
+				binMax[b] = std::max(binMax[b], ts.binMax[j][b]);
+			}
+		}
+
+		size_t below = target.below;
+		size_t b = 0;
+		for (; b<NumBins; b++) {
+			if (below + hist[b] > target.rank) break;
+			below += hist[b];
+		}
+		if (b == NumBins) {
+			SetErrMsg("Values changed between passes");
+			_count = 0;
+			_results.clear();
+			return;
+		}
+
+		// A pass that fails to narrow the range would be repeated forever,
+		// so the remaining values are then collected regardless of the
+		// buffer limit
+		//
+		bool shrunk = binMin[b] > target.lo || binMax[b] < target.hi;
+
+		target.below = below;
+		target.n = hist[b];
+		target.lo = binMin[b];
+		target.hi = binMax[b];
+		if (target.lo == target.hi) {
+			target.done = true;
+			target.value = target.lo;
+			continue;
+		}
+		target.collect = target.n <= _bufferLimit || ! shrunk;
+		target.scale = NumBins / ((double) target.hi - target.lo);
+		_done = false;
+	}
+
+	if (_done) {
+		for (const auto &target : _targets) _results.push_back(target.value);
+	}
+}
+
+int QuantileEngine::GetQuantiles(vector <double> &values) const {
+	values.clear();
+
+	if (! _done || _results.size() != _quantiles.size()) {
+		SetErrMsg("Quantiles not available");
+		return(-1);
+	}
+
+	values = _results;
+	return(0);
+}
+
+size_t QuantileEngine::GetCount() const {
+	return(_count);
+}
@@ -241,6 +241,128 @@ float RegularGrid::GetValueLinear(const std::vector <double> &coords) const {
 
 }
 
+void RegularGrid::SampleMany(
+	const double *coords, size_t n, float *values
+) const {
+	const vector <size_t> &dims = GetDimensions();
+	size_t ndim = GetGeometryDim();
+
+	// The specialized path handles 2D and 3D grids with data whose 
+	// geometry and topology dimensions agree. Everything else takes 
+	// the general path
+	//
+	if (! GetBlks().size() || ndim != dims.size() || ndim < 2) {
+		Grid::SampleMany(coords, n, values);
+		return;
+	}
+
+	const vector <bool> periodic = GetPeriodic();
+	const float missingValue = GetMissingValue();
+	const bool linear = GetInterpolationOrder() != 0;
+	NodeReader reader(this);
+
+	// The body of the loop below must compute exactly what
+	// Grid::GetValue() does via GetValueNearestNeighbor() and 
+	// GetValueLinear()
+	//
+	double c[3] = {0.0, 0.0, 0.0};
+	for (size_t p=0; p<n; p++) {
+
+		// Clamp coordinates on periodic boundaries to grid extents, as
+		// StructuredGrid::ClampCoord() does, and check if inside
+		//
+		bool inside = true;
+		for (int a=0; a<ndim; a++) {
+			c[a] = coords[p*ndim + a];
+			if (dims[a] == 1) {
+				c[a] = _minu[a];
+			}
+			else if (periodic[a]) {
+				while (c[a]<_minu[a]) c[a] += _maxu[a]-_minu[a];
+				while (c[a]>_maxu[a]) c[a] -= _maxu[a]-_minu[a];
+			}
+			if (c[a] < _minu[a] || c[a] > _maxu[a]) inside = false;
+		}
+		if (! inside) {
+			values[p] = missingValue;
+			continue;
+		}
+
+		size_t i = 0;
+		size_t j = 0;
+		size_t k = 0;
+		double iwgt = 0.0;
+		double jwgt = 0.0;
+		double kwgt = 0.0;
+
+		if (_delta[0] != 0.0) {
+			i = (size_t) floor ((c[0]-_minu[0]) / _delta[0]);
+			iwgt = ((c[0] - _minu[0]) - (i * _delta[0])) / _delta[0];
+		}
+		if (_delta[1] != 0.0) {
+			j = (size_t) floor ((c[1]-_minu[1]) / _delta[1]);
+			jwgt = ((c[1] - _minu[1]) - (j * _delta[1])) / _delta[1];
+		}
+		if (ndim == 3 && _delta[2] != 0.0) {
+			k = (size_t) floor ((c[2]-_minu[2]) / _delta[2]);
+			kwgt = ((c[2] - _minu[2]) - (k * _delta[2])) / _delta[2];
+		}
+
+		if (! linear) {
+			if (iwgt>0.5) i++;
+			if (jwgt>0.5) j++;
+			if (kwgt>0.5) k++;
+
+			values[p] = reader.Get(i,j,k);
+			continue;
+		}
+
+		double p0,p1,p2,p3,p4,p5,p6,p7;
+		p1 = p2 = p3 = p4 = p5 = p6 = p7 = 0.0;
+
+		p0 = reader.Get(i,j,k);
+		bool missing = p0 == missingValue;
+
+		if (! missing && iwgt!=0.0) {
+			p1 = reader.Get(i+1,j,k);
+			missing = p1 == missingValue;
+		}
+		if (! missing && jwgt!=0.0) {
+			p2 = reader.Get(i,j+1,k);
+			missing = p2 == missingValue;
+		}
+		if (! missing && iwgt!=0.0 && jwgt!=0.0) {
+			p3 = reader.Get(i+1,j+1,k);
+			missing = p3 == missingValue;
+		}
+		if (! missing && kwgt!=0.0) {
+			p4 = reader.Get(i,j,k+1);
+			missing = p4 == missingValue;
+		}
+		if (! missing && kwgt!=0.0 && iwgt!=0.0) {
+			p5 = reader.Get(i+1,j,k+1);
+			missing = p5 == missingValue;
+		}
+		if (! missing && kwgt!=0.0 && jwgt!=0.0) {
+			p6 = reader.Get(i,j+1,k+1);
+			missing = p6 == missingValue;
+		}
+		if (! missing && kwgt!=0.0 && iwgt!=0.0 && jwgt!=0.0) {
+			p7 = reader.Get(i+1,j+1,k+1);
+			missing = p7 == missingValue;
+		}
+		if (missing) {
+			values[p] = missingValue;
+			continue;
+		}
+
+		double c0 = p0+iwgt*(p1-p0) + jwgt*((p2+iwgt*(p3-p2))-(p0+iwgt*(p1-p0)));
+		double c1 = p4+iwgt*(p5-p4) + jwgt*((p6+iwgt*(p7-p6))-(p4+iwgt*(p5-p4)));
+
+		values[p] = c0+kwgt*(c1-c0);
+	}
+}
+
 void RegularGrid::GetUserExtents(
 	vector <double> &minu, vector <double> &maxu
 ) const {
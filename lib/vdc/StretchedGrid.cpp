@@ -11,6 +11,32 @@
 using namespace std;
 using namespace VAPoR;
 
+namespace {
+
+// Returns the same result as Wasp::BinarySearchRange(), but first tries
+// the interval found by the previous search, which is usually the right
+// one for runs of nearby points. The hint is only used if x lies strictly
+// inside the interval, where the interval containing x is unique.
+//
+bool search_range_hint(
+	const vector <double> &sorted, double x, size_t &hint, size_t &i
+) {
+	if (hint+1 < sorted.size()) {
+		double x0 = sorted[hint];
+		double x1 = sorted[hint+1];
+		if ((x0 < x && x < x1) || (x1 < x && x < x0)) {
+			i = hint;
+			return(true);
+		}
+	}
+
+	if (! Wasp::BinarySearchRange(sorted, x, i)) return(false);
+	hint = i;
+	return(true);
+}
+
+};
+
 void StretchedGrid::_stretchedGrid(
 	const vector <double> &xcoords,
 	const vector <double> &ycoords,
@@ -367,6 +393,103 @@ float StretchedGrid::GetValueLinear(
 
 }
 
+void StretchedGrid::SampleMany(
+	const double *coords, size_t n, float *values
+) const {
+	const vector <size_t> &dims = GetDimensions();
+	size_t ndim = GetGeometryDim();
+
+	// The specialized path handles 2D and 3D grids with data whose 
+	// geometry and topology dimensions agree. Everything else takes 
+	// the general path
+	//
+	if (! GetBlks().size() || ndim != dims.size() || ndim < 2) {
+		Grid::SampleMany(coords, n, values);
+		return;
+	}
+
+	const vector <bool> periodic = GetPeriodic();
+	const float missingValue = GetMissingValue();
+	const bool linear = GetInterpolationOrder() != 0;
+	NodeReader reader(this);
+	const vector <double> *axes[] = {&_xcoords, &_ycoords, &_zcoords};
+	size_t hints[] = {0, 0, 0};
+
+	// The body of the loop below must compute exactly what
+	// Grid::GetValue() does via GetValueNearestNeighbor() and 
+	// GetValueLinear()
+	//
+	double c[3] = {0.0, 0.0, 0.0};
+	for (size_t p=0; p<n; p++) {
+
+		// Clamp coordinates on periodic boundaries to grid extents, as
+		// StructuredGrid::ClampCoord() does
+		//
+		for (int a=0; a<ndim; a++) {
+			c[a] = coords[p*ndim + a];
+			if (dims[a] == 1) {
+				c[a] = _minu[a];
+			}
+			else if (periodic[a]) {
+				while (c[a]<_minu[a]) c[a] += _maxu[a]-_minu[a];
+				while (c[a]>_maxu[a]) c[a] -= _maxu[a]-_minu[a];
+			}
+		}
+
+		// Same as _insideGrid()
+		//
+		size_t idx[] = {0, 0, 0};
+		double wgt[3][2] = {{0.0, 0.0}, {0.0, 0.0}, {1.0, 0.0}};
+		bool inside = true;
+		for (int a=0; a<ndim && inside; a++) {
+			const vector <double> &axis = *axes[a];
+			inside = search_range_hint(axis, c[a], hints[a], idx[a]);
+			if (! inside) break;
+
+			wgt[a][0] = 1.0 - 
+				(c[a] - axis[idx[a]]) / (axis[idx[a]+1] - axis[idx[a]]);
+			wgt[a][1] = 1.0 - wgt[a][0];
+		}
+		if (! inside) {
+			values[p] = missingValue;
+			continue;
+		}
+
+		size_t i = idx[0];
+		size_t j = idx[1];
+		size_t k = idx[2];
+
+		if (! linear) {
+			if (wgt[0][1] > wgt[0][0]) i++;
+			if (wgt[1][1] > wgt[1][0]) j++;
+			if (wgt[2][1] > wgt[2][0]) k++;
+
+			values[p] = reader.Get(i,j,k);
+			continue;
+		}
+
+		const double *xwgt = wgt[0];
+		const double *ywgt = wgt[1];
+		const double *zwgt = wgt[2];
+
+		float v0 = 
+			((reader.Get(i,j,k)*xwgt[0] + reader.Get(i+1,j,k)*xwgt[1]) * ywgt[0]) +
+			((reader.Get(i,j+1,k)*xwgt[0] + reader.Get(i+1,j+1,k)*xwgt[1]) * ywgt[1]);
+
+		if (ndim == 2) {
+			values[p] = v0;
+			continue;
+		}
+
+		k++;
+		float v1 = 
+			((reader.Get(i,j,k)*xwgt[0] + reader.Get(i+1,j,k)*xwgt[1]) * ywgt[0]) +
+			((reader.Get(i,j+1,k)*xwgt[0] + reader.Get(i+1,j+1,k)*xwgt[1]) * ywgt[1]);
+
+		values[p] = v0*zwgt[0] + v1*zwgt[1];
+	}
+}
+
 void StretchedGrid::_GetUserExtents(
 	vector <double> &minext, vector <double> &maxext
 ) const {
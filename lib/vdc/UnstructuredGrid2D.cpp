@@ -266,13 +266,13 @@ float UnstructuredGrid2D::GetValueNearestNeighbor (
 
 	const int *ptr = _vertexOnFace + (face * _maxVertexPerFace);
 
-	int maxindx = lambda[0];
+	int maxindx = 0;
 	for (int i=1; i<nlambda; i++) {
 		if (lambda[i] > lambda[maxindx]) maxindx = i;
 	}
 
 	long offset = GetNodeOffset();
-	float value = AccessIJK(*ptr + maxindx + offset);
+	float value = AccessIJK(ptr[maxindx] + offset);
 
 	delete [] lambda;
 
@@ -518,6 +518,174 @@ bool UnstructuredGrid2D::_insideFace(
 	return ret;
 }
 
+// Test whether a point is inside a face, as _insideFace() does, but
+// without allocating memory. 'verts' must have space for the coordinates
+// of _maxVertexPerFace vertices.
+//
+bool UnstructuredGrid2D::_testFace(
+	size_t face, const double pt[2], double *verts, double *lambda,
+	int &nlambda
+) const {
+	const int *ptr = _vertexOnFace + (face * _maxVertexPerFace);
+	long offset = GetNodeOffset();
+
+	nlambda = 0;
+	for (int i=0; i<_maxVertexPerFace; i++) {
+		if (ptr[i] == GetMissingID()) break;
+
+		long vertex = ptr[i] + offset;
+		if (vertex < 0) break;
+
+		verts[nlambda*2+0] = _xug.AccessIJK(vertex, 0, 0);
+		verts[nlambda*2+1] = _yug.AccessIJK(vertex, 0, 0);
+		nlambda++;
+	}
+
+	if (nlambda < 3) return(false);
+
+	if (! Grid::PointInsideBoundingRectangle(pt, verts, nlambda)) return(false);
+
+	return(WachspressCoords2D(verts, pt, nlambda, lambda));
+}
+
+// Locate the face containing a node centered point. Test the face 
+// containing the previous point first, then its neighbors, and only 
+// search the quad tree if neither contain the point. 'hint' is set once
+// a face has been found.
+//
+bool UnstructuredGrid2D::_locateFace(
+	const double pt[2], bool &hint, size_t &face,
+	vector <size_t> &candidates, double *verts, double *lambda,
+	int &nlambda
+) const {
+	long nfaces = GetCellDimensions()[0];
+	long offset = GetCellOffset();
+
+	if (hint) {
+		if (_testFace(face, pt, verts, lambda, nlambda)) return(true);
+
+		const int *ptr = _faceOnFace ? 
+			_faceOnFace + (face * _maxVertexPerFace) : NULL;
+		for (int i=0; ptr && i<_maxVertexPerFace; i++) {
+			if (ptr[i] == GetMissingID()) break;
+			if (ptr[i] == GetBoundaryID()) continue;
+
+			long neighbor = ptr[i] + offset;
+			if (neighbor < 0 || neighbor >= nfaces) continue;
+
+			if (_testFace(neighbor, pt, verts, lambda, nlambda)) {
+				face = neighbor;
+				return(true);
+			}
+		}
+	}
+
+	_qtr->GetPayloadContained(pt[0], pt[1], candidates);
+	for (size_t f : candidates) {
+		if (_testFace(f, pt, verts, lambda, nlambda)) {
+			face = f;
+			hint = true;
+			return(true);
+		}
+	}
+
+	return(false);
+}
+
+void UnstructuredGrid2D::GetIndicesCellMany(
+	const double *coords, size_t n, size_t *indices, bool *found
+) const {
+	if (_location != NODE) {
+		Grid::GetIndicesCellMany(coords, n, indices, found);
+		return;
+	}
+
+	size_t ndim = GetGeometryDim();
+	size_t nidx = GetDimensions().size();
+
+	vector <double> point(ndim);
+	vector <double> verts(2 * _maxVertexPerFace);
+	vector <double> lambda(_maxVertexPerFace);
+	vector <size_t> candidates;
+
+	bool hint = false;
+	size_t face = 0;
+	for (size_t p=0; p<n; p++) {
+		for (int i=0; i<ndim; i++) point[i] = coords[p*ndim + i];
+		ClampCoord(point);
+		double pt[] = {point[0], point[1]};
+
+		int nlambda;
+		found[p] = _locateFace(
+			pt, hint, face, candidates, verts.data(), lambda.data(), nlambda
+		);
+
+		indices[p*nidx] = face;
+		for (int i=1; i<nidx; i++) indices[p*nidx + i] = 0;
+	}
+}
+
+void UnstructuredGrid2D::SampleMany(
+	const double *coords, size_t n, float *values
+) const {
+	float mv = GetMissingValue();
+
+	if (! GetBlks().size()) {
+		std::fill(values, values + n, mv);
+		return;
+	}
+
+	if (_location != NODE) {
+		Grid::SampleMany(coords, n, values);
+		return;
+	}
+
+	size_t ndim = GetGeometryDim();
+	bool linear = GetInterpolationOrder() != 0;
+	long offset = GetNodeOffset();
+
+	vector <double> point(ndim);
+	vector <double> verts(2 * _maxVertexPerFace);
+	vector <double> lambda(_maxVertexPerFace);
+	vector <size_t> candidates;
+
+	// The body of the loop below must compute exactly what
+	// Grid::GetValue() does via GetValueNearestNeighbor() and 
+	// GetValueLinear()
+	//
+	bool hint = false;
+	size_t face = 0;
+	for (size_t p=0; p<n; p++) {
+		for (int i=0; i<ndim; i++) point[i] = coords[p*ndim + i];
+		ClampCoord(point);
+		double pt[] = {point[0], point[1]};
+
+		int nlambda;
+		if (! _locateFace(
+			pt, hint, face, candidates, verts.data(), lambda.data(), nlambda
+		)) {
+			values[p] = mv;
+			continue;
+		}
+
+		const int *ptr = _vertexOnFace + (face * _maxVertexPerFace);
+		if (linear) {
+			double value = 0;
+			for (int i=0; i<nlambda; i++) {
+				value += AccessIJK(ptr[i] + offset, 0, 0) * lambda[i];
+			}
+			values[p] = (float) value;
+		}
+		else {
+			int maxindx = 0;
+			for (int i=1; i<nlambda; i++) {
+				if (lambda[i] > lambda[maxindx]) maxindx = i;
+			}
+			values[p] = AccessIJK(ptr[maxindx] + offset);
+		}
+	}
+}
+
 std::shared_ptr <QuadTreeRectangle<float, size_t> >UnstructuredGrid2D::_makeQuadTreeRectangle() const {
 
 	size_t maxNodes = GetMaxVertexPerCell();
@@ -1,5 +1,8 @@
 #include <cmath>
 #include <iostream>
+#include <algorithm>
+#include <limits>
+#include <cstdint>
 #include "vapor/VAssert.h"
 #include <vapor/vizutil.h>
 
@@ -9,6 +12,30 @@ double dot2d(const double a[], const double b[]) {
 	return((a[0] * b[0]) + (a[1] * b[1]));
 }
 
+// Spread the low 32 bits of v out to the even bits of the result
+//
+uint64_t spreadBits2(uint64_t v) {
+	v &= 0xffffffff;
+	v = (v | (v << 16)) & 0x0000ffff0000ffffULL;
+	v = (v | (v << 8)) & 0x00ff00ff00ff00ffULL;
+	v = (v | (v << 4)) & 0x0f0f0f0f0f0f0f0fULL;
+	v = (v | (v << 2)) & 0x3333333333333333ULL;
+	v = (v | (v << 1)) & 0x5555555555555555ULL;
+	return(v);
+}
+
+// Spread the low 21 bits of v out to every third bit of the result
+//
+uint64_t spreadBits3(uint64_t v) {
+	v &= 0x1fffff;
+	v = (v | (v << 32)) & 0x001f00000000ffffULL;
+	v = (v | (v << 16)) & 0x001f0000ff0000ffULL;
+	v = (v | (v << 8)) & 0x100f00f00f00f00fULL;
+	v = (v | (v << 4)) & 0x10c30c30c30c30c3ULL;
+	v = (v | (v << 2)) & 0x1249249249249249ULL;
+	return(v);
+}
+
 };
 
 void VAPoR::HexahedronToTets(
@@ -317,5 +344,56 @@ bool VAPoR::InsideConvexPolygon(
 	return(false);
 }
 
+void VAPoR::MortonOrder(
+	const double coords[], size_t n, int ndim, std::vector <size_t> &order
+) {
+	VAssert(ndim >= 1 && ndim <= 3);
+
+	order.resize(n);
+	for (size_t p=0; p<n; p++) order[p] = p;
+	if (n < 2) return;
 
+	double min[3], max[3];
+	for (int d=0; d<ndim; d++) {
+		min[d] = std::numeric_limits<double>::max();
+		max[d] = std::numeric_limits<double>::lowest();
+	}
+	for (size_t p=0; p<n; p++) {
+		for (int d=0; d<ndim; d++) {
+			double c = coords[p*ndim + d];
+			if (c < min[d]) min[d] = c;
+			if (c > max[d]) max[d] = c;
+		}
+	}
 
+	// Quantize each coordinate to as many bits as fit in a 64 bit key.
+	// NaNs fail every comparison and are mapped to zero.
+	//
+	const int nbits = ndim == 3 ? 21 : 32;
+	const double qmax = (double) ((1ULL << nbits) - 1);
+	double scale[3];
+	for (int d=0; d<ndim; d++) {
+		scale[d] = max[d] > min[d] ? qmax / (max[d] - min[d]) : 0.0;
+	}
+
+	std::vector <std::pair <uint64_t, size_t> > keys(n);
+	for (size_t p=0; p<n; p++) {
+		uint64_t q[3] = {0, 0, 0};
+		for (int d=0; d<ndim; d++) {
+			double c = (coords[p*ndim + d] - min[d]) * scale[d];
+			if (c > 0.0) q[d] = (uint64_t) std::min(c, qmax);
+		}
+
+		uint64_t key;
+		if (ndim == 1) key = q[0];
+		else if (ndim == 2) key = spreadBits2(q[0]) | (spreadBits2(q[1]) << 1);
+		else {
+			key = spreadBits3(q[0]) | (spreadBits3(q[1]) << 1) |
+				(spreadBits3(q[2]) << 2);
+		}
+		keys[p] = std::make_pair(key, p);
+	}
+
+	std::sort(keys.begin(), keys.end());
+	for (size_t p=0; p<n; p++) order[p] = keys[p].second;
+}
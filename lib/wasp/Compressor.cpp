@@ -125,26 +125,73 @@ Compressor::~Compressor() {
 }
 
 
+namespace {
+
+inline float magnitude(float x) { return(fabsf(x)); }
+inline double magnitude(double x) { return(fabs(x)); }
+inline int magnitude(int x) { return(abs(x)); }
+inline long magnitude(long x) { return(labs(x)); }
+
+// Ordering of wavelet coefficients, referenced by their index, by 
+// decreasing magnitude. Ties are broken by index so that the
+// ordering is total, and the coefficients selected are independent of
+// the selection algorithm.
 //
-// Comparision functions for the C++ Std Lib sort function
+template <class T>
+class greater_magnitude {
+public:
+ greater_magnitude(const T *C) : _C(C) {}
+
+ bool operator()(size_t a, size_t b) const {
+	T ma = magnitude(_C[a]);
+	T mb = magnitude(_C[b]);
+	if (ma != mb) return(ma > mb);
+	return(a < b);
+ }
+
+private:
+ const T *_C;
+};
+
+const unsigned char NoGroup = 0xff;
+
+// Select the largest magnitude detail coefficients, C[numkeep..clen-1],
+// for each of a sequence of groups. The first group receives the 
+// lens[0] largest coefficients, the second group the next lens[1] 
+// largest, and so on. On return groupvec[i] contains the group that 
+// coefficient i was assigned to, or NoGroup.
 //
-inline bool my_compare_f(const void * x1, const void * x2) {
-	return(fabsf(* (float *) x1) > fabsf(* (float *) x2));
-}
+// Rather than sorting all of the coefficients, each group is found 
+// with a selection (O(n) on average) on the coefficients remaining 
+// after the previous groups were removed.
+//
+template <class T>
+void select_coefficients(
+	const T *C, size_t clen, size_t numkeep, const vector <size_t> &lens,
+	vector <size_t> &indexvec, vector <unsigned char> &groupvec
+) {
+	VAssert(lens.size() < NoGroup);
 
-inline bool my_compare_d(const void * x1, const void * x2) {
-	return(fabs(* (double *) x1) > fabs(* (double *) x2));
-}
+	indexvec.clear();
+	for (size_t i=numkeep; i<clen; i++) indexvec.push_back(i);
 
-inline bool my_compare_i(const void * x1, const void * x2) {
-	return(abs(* (int *) x1) > abs(* (int *) x2));
-}
+	groupvec.assign(clen, NoGroup);
 
-inline bool my_compare_l(const void * x1, const void * x2) {
-	return(labs(* (long *) x1) > labs(* (long *) x2));
-}
+	greater_magnitude <T> cmp(C);
+	vector <size_t>::iterator first = indexvec.begin();
+	for (int j=0; j<lens.size(); j++) {
+		if (lens[j] == 0) continue;
 
-namespace {
+		VAssert(lens[j] <= indexvec.end() - first);
+
+		vector <size_t>::iterator last = first + lens[j];
+		if (last != indexvec.end()) {
+			nth_element(first, last - 1, indexvec.end(), cmp);
+		}
+
+		for (; first != last; ++first) groupvec[*first] = j;
+	}
+}
 
 template <class T>
 int compress_template(
@@ -158,8 +205,8 @@ int compress_template(
 	SignificanceMap *sigmap,
 	const vector <size_t> &dims,
 	size_t nlevels,
-	vector <void *> indexvec,
-	bool my_compare(const void *, const void *)
+	vector <size_t> &indexvec,
+	vector <unsigned char> &groupvec
 ) {
 
 	if (! C) {
@@ -226,21 +273,19 @@ int compress_template(
 		dst_arr_len -= numkeep;
 	}
 
-	indexvec.clear();
-	for (size_t i=numkeep; i<clen; i++) indexvec.push_back(&C[i]);
-    sort(indexvec.begin(), indexvec.end(), my_compare);
-
+	select_coefficients(
+		C, clen, numkeep, vector <size_t> (1, dst_arr_len), indexvec, groupvec
+	);
 
 	// Copy coefficients that are larger than the threshold to
-	// the destination array. Record their location in the significance
-	// map.
+	// the destination array, in coefficient order. Record their location 
+	// in the significance map.
 	//
-
-	sort(indexvec.begin(), indexvec.begin()+dst_arr_len);
 	for (size_t idx = numkeep, i = 0; idx<clen && i<dst_arr_len; idx++) {
-		const T *cptr =  (T *) indexvec[i];
-		dst_arr[i++] = *cptr;
-		sigmap->Set(cptr - C);
+		if (groupvec[idx] == NoGroup) continue;
+
+		dst_arr[i++] = C[idx];
+		sigmap->Set(idx);
 	}
 	return(0);
 }
@@ -255,7 +300,7 @@ int Compressor::Compress(
 
 	return compress_template(
 		this, src_arr, dst_arr, dst_arr_len, (float *) _C, _CLen,
-		_L, sigmap, _dims, _nlevels, _indexvec, my_compare_f
+		_L, sigmap, _dims, _nlevels, _indexvec, _groupvec
 	);
 }
 
@@ -268,7 +313,7 @@ int Compressor::Compress(
 
 	return compress_template(
 		this, src_arr, dst_arr, dst_arr_len, (double *) _C, _CLen,
-		_L, sigmap, _dims, _nlevels, _indexvec, my_compare_d
+		_L, sigmap, _dims, _nlevels, _indexvec, _groupvec
 	);
 }
 
@@ -281,7 +326,7 @@ int Compressor::Compress(
 
 	return compress_template(
 		this, src_arr, dst_arr, dst_arr_len, (int *) _C, _CLen,
-		_L, sigmap, _dims, _nlevels, _indexvec, my_compare_i
+		_L, sigmap, _dims, _nlevels, _indexvec, _groupvec
 	);
 }
 
@@ -294,7 +339,7 @@ int Compressor::Compress(
 
 	return compress_template(
 		this, src_arr, dst_arr, dst_arr_len, (long *) _C, _CLen,
-		_L, sigmap, _dims, _nlevels, _indexvec, my_compare_l
+		_L, sigmap, _dims, _nlevels, _indexvec, _groupvec
 	);
 }
 
@@ -444,8 +489,8 @@ int decompose_template(
 	vector <SignificanceMap> &sigmaps,
 	const vector <size_t> &dims,
 	size_t nlevels,
-	vector <void *> indexvec,
-	bool my_compare(const void *, const void *)
+	vector <size_t> &indexvec,
+	vector <unsigned char> &groupvec
 ) {
 	if (! C) {
 		Compressor::SetErrMsg("Invalid state");
@@ -524,26 +569,30 @@ int decompose_template(
 	}
 
 	//
-	// sort the **indecies** of the coefficients based on the 
+	// Assign the coefficients to compression levels based on the 
 	// coefficient's magnitude
 	//
-	indexvec.clear();
-	for (size_t i=numkeep; i<clen; i++)  indexvec.push_back(&C[i]); 
-    sort(indexvec.begin(), indexvec.end(), my_compare);
+	select_coefficients(
+		C, clen, numkeep, my_dst_arr_lens, indexvec, groupvec
+	);
 
-	
-	vector <void *>::iterator itr = indexvec.begin();
-	for (int j = 0, idx=0; j<my_dst_arr_lens.size(); j++) {
-		sort(itr, itr+my_dst_arr_lens[j]);	// sort coefficient's indecies
-		itr += my_dst_arr_lens[j];
-		for (int i = 0; i<my_dst_arr_lens[j]; i++, idx++) {
-			const T *cptr =  (T *) indexvec[idx];
-			dst_arr[i] = *cptr;
-			sigmaps[j].Set(cptr - C);
-		}
+	// Copy each level's coefficients to its section of the destination
+	// array in a single pass, in coefficient order
+	//
+	vector <T *> dst_ptrs;
+	for (int j = 0; j<my_dst_arr_lens.size(); j++) {
+		dst_ptrs.push_back(dst_arr);
 		dst_arr += my_dst_arr_lens[j];
 	}
 
+	for (size_t idx = numkeep; idx<clen; idx++) {
+		unsigned char j = groupvec[idx];
+		if (j == NoGroup) continue;
+
+		*dst_ptrs[j]++ = C[idx];
+		sigmaps[j].Set(idx);
+	}
+
 	return(0);
 }
 
@@ -638,7 +687,7 @@ int Compressor::Decompose(
 ) {
 	return decompose_template(
 		this, src_arr, dst_arr, dst_arr_lens, (float *) _C, _CLen,
-		_L, sigmaps, _dims, _nlevels, _indexvec, my_compare_f
+		_L, sigmaps, _dims, _nlevels, _indexvec, _groupvec
 	);
 }
 
@@ -648,7 +697,7 @@ int Compressor::Decompose(
 ) {
 	return decompose_template(
 		this, src_arr, dst_arr, dst_arr_lens, (double *) _C, _CLen,
-		_L, sigmaps, _dims, _nlevels, _indexvec, my_compare_d
+		_L, sigmaps, _dims, _nlevels, _indexvec, _groupvec
 	);
 }
 
@@ -658,7 +707,7 @@ int Compressor::Decompose(
 ) {
 	return decompose_template(
 		this, src_arr, dst_arr, dst_arr_lens, (int *) _C, _CLen,
-		_L, sigmaps, _dims, _nlevels, _indexvec, my_compare_i
+		_L, sigmaps, _dims, _nlevels, _indexvec, _groupvec
 	);
 }
 
@@ -668,7 +717,7 @@ int Compressor::Decompose(
 ) {
 	return decompose_template(
 		this, src_arr, dst_arr, dst_arr_lens, (long *) _C, _CLen,
-		_L, sigmaps, _dims, _nlevels, _indexvec, my_compare_l
+		_L, sigmaps, _dims, _nlevels, _indexvec, _groupvec
 	);
 }
 
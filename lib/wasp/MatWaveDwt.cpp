@@ -327,6 +327,14 @@ int wextend_1D_center (
 // sigIn must contain sigInLen + filterLen + 1 samples if oddlow or oddhigh
 // is true, otherwise sigInLen + filterLen samples are required
 //
+// The input is first split into its even and odd indexed samples, which
+// are stored in 'scratch'. 'scratch' must have room for 
+// sigInLen + filterLen + 1 samples. Filter taps are then applied one 
+// at a time across all of the outputs with unit stride, which allows 
+// the compiler to vectorize the inner loops. Each output accumulates 
+// its terms in the same order as a direct convolution, so results are
+// bit for bit identical.
+//
 // See G. Strang and T. Nguyen, "Wavelets and Filter Banks", chap 8, finite
 // length filters
 //
@@ -334,68 +342,92 @@ void
 forward_xform (
 	const double *sigIn, size_t sigInLen, 
 	const double *low_filter, const double *high_filter, 
-	int filterLen, double *cA, double *cD, bool oddlow, bool oddhigh
+	int filterLen, double *cA, double *cD, bool oddlow, bool oddhigh,
+	double *scratch
 ) {
 //	VAssert(sigInLen > filterLen);
 
 	size_t xlstart = oddlow ? 1 : 0;
-	size_t xl;
 	size_t xhstart = oddhigh ? 1 : 0;
-	size_t xh;
 
-	for (size_t yi = 0; yi < sigInLen; yi += 2) {
-		cA[yi>>1] = cD[yi>>1] = 0.0;
+	size_t n = (sigInLen + 1) >> 1;	// number of cA and cD samples
+	if (! n) return;
+
+	// Number of input samples referenced
+	//
+	size_t nx = max(xlstart, xhstart) + 2*(n-1) + filterLen;
+
+	double *even = scratch;
+	double *odd = scratch + ((nx + 1) >> 1);
+	for (size_t i = 0; 2*i < nx; i++) even[i] = sigIn[2*i];
+	for (size_t i = 0; 2*i+1 < nx; i++) odd[i] = sigIn[2*i+1];
+
+	for (size_t i = 0; i < n; i++) {
+		cA[i] = cD[i] = 0.0;
+	}
+
+	for (int t = 0; t < filterLen; t++) {
+		int k = filterLen - 1 - t;
+		const double lk = low_filter[k];
+		const double hk = high_filter[k];
 
-		xl = xlstart;
-		xh = xhstart;
+		size_t xl = xlstart + t;
+		size_t xh = xhstart + t;
+		const double *sl = ((xl & 1) ? odd : even) + (xl >> 1);
+		const double *sh = ((xh & 1) ? odd : even) + (xh >> 1);
 
-		for (int k = filterLen - 1; k >= 0; k--) {
-			cA[yi>>1] += low_filter[k] * sigIn[xl];
-			cD[yi>>1] += high_filter[k] * sigIn[xh];
-			xl++;
-			xh++;
+		for (size_t i = 0; i < n; i++) {
+			cA[i] += lk * sl[i];
+			cD[i] += hk * sh[i];
 		}
-		xlstart+=2;
-		xhstart+=2;
 	}
 
 	return;
 }
 
+//
+// Inverse transforms. Even and odd indexed output samples are computed 
+// separately, one filter tap at a time across all samples of the same
+// parity, and accumulated in 'scratch' before being interleaved into
+// 'sigOut'. 'scratch' must have room for (sigOutLen + 1) / 2 samples.
+// As with forward_xform() the terms of each output sample are summed in
+// the same order as a direct convolution.
+//
 void
 inverse_xform_even (
 	const double *cA, const double *cD, size_t sigOutLen, 
 	const double *low_filter, const double *high_filter, 
-	int filterLen, double *sigOut, bool matlab
+	int filterLen, double *sigOut, bool matlab, double *scratch
 ) {
-	size_t xi; // input and out signal indecies
-	int k; // filter index
-
 	VAssert((filterLen % 2) == 0);
 
-	for (size_t yi = 0; yi < sigOutLen; yi++ ) {
-		sigOut[yi] = 0.0;
+	for (size_t p = 0; p < 2; p++) {	// output parity
+		size_t n = (sigOutLen + 1 - p) >> 1;
 
+		size_t xi; // input signal index of first output sample
+		int kstart; // first filter index
 		if (matlab  || (filterLen>>1)%2) { // odd length half filter
-			xi = yi >> 1;
-			if (yi % 2) {
-				k =  filterLen - 1;
-			} else {
-				k =  filterLen - 2;
-			}
+			xi = 0;
+			kstart = p ? filterLen - 1 : filterLen - 2;
 		} else {
-			xi = (yi+1) >> 1;
-			if (yi % 2) {
-				k = filterLen - 2;
-			} else {
-				k = filterLen - 1;
-			}
+			xi = p;
+			kstart = p ? filterLen - 2 : filterLen - 1;
 		}
 
-		for (; k >= 0; k-=2) {
-			sigOut[yi] += (low_filter[k] * cA[xi]) + (high_filter[k] * cD[xi]);
-			xi++;
+		for (size_t i = 0; i < n; i++) scratch[i] = 0.0;
+
+		for (int k = kstart; k >= 0; k-=2, xi++) {
+			const double lk = low_filter[k];
+			const double hk = high_filter[k];
+			const double *a = cA + xi;
+			const double *d = cD + xi;
+
+			for (size_t i = 0; i < n; i++) {
+				scratch[i] += (lk * a[i]) + (hk * d[i]);
+			}
 		}
+
+		for (size_t i = 0; i < n; i++) sigOut[2*i+p] = scratch[i];
 	}
 
 	return;
@@ -413,38 +445,32 @@ void
 inverse_xform_odd (
 	const double *cA, const double *cD, size_t sigOutLen, 
 	const double *low_filter, const double *high_filter, 
-	int filterLen, double *sigOut
+	int filterLen, double *sigOut, double *scratch
 ) {
-	size_t xi; // input and out signal indecies
-	int k; // filter index
-
 	VAssert((filterLen % 2) == 1);
 
-	for (size_t yi = 0; yi < sigOutLen; yi++ ) {
-		sigOut[yi] = 0.0;
+	for (size_t p = 0; p < 2; p++) {	// output parity
+		size_t n = (sigOutLen + 1 - p) >> 1;
 
-		xi = (yi+1) >> 1;
-		if (yi % 2) {
-			k = filterLen - 2;
-		} else {
-			k = filterLen - 1;
-		}
-		for (; k >= 0; k-=2) {
-			sigOut[yi] += (low_filter[k] * cA[xi]);
-			xi++;
-		}
+		for (size_t i = 0; i < n; i++) scratch[i] = 0.0;
 
-		xi = (yi) >> 1;
-		if (yi % 2) {
-			k = filterLen - 1;
-		} else {
-			k = filterLen - 2;
+		size_t xi = p;
+		for (int k = p ? filterLen-2 : filterLen-1; k >= 0; k-=2, xi++) {
+			const double lk = low_filter[k];
+			const double *a = cA + xi;
+
+			for (size_t i = 0; i < n; i++) scratch[i] += (lk * a[i]);
 		}
-		for (; k >= 0; k-=2) {
-			sigOut[yi] += (high_filter[k] * cD[xi]);
-			xi++;
+
+		xi = 0;
+		for (int k = p ? filterLen-1 : filterLen-2; k >= 0; k-=2, xi++) {
+			const double hk = high_filter[k];
+			const double *d = cD + xi;
+
+			for (size_t i = 0; i < n; i++) scratch[i] += (hk * d[i]);
 		}
 
+		for (size_t i = 0; i < n; i++) sigOut[2*i+p] = scratch[i];
 	}
 
 	return;
@@ -453,17 +479,18 @@ inverse_xform_odd (
 void inverse_xform (
 	const double *cA, const double *cD, size_t sigOutLen, 
 	const double *low_filter, const double *high_filter, 
-	int filterLen, double *sigOut, bool matlab
+	int filterLen, double *sigOut, bool matlab, double *scratch
 ) {
 	if (filterLen % 2) {
 		inverse_xform_odd (
-			cA, cD, sigOutLen, low_filter, high_filter, filterLen, sigOut 
+			cA, cD, sigOutLen, low_filter, high_filter, filterLen, sigOut,
+			scratch
 		);
 	}
 	else {
 		inverse_xform_even (
 			cA, cD, sigOutLen, low_filter, high_filter, filterLen, sigOut, 
-			matlab 
+			matlab, scratch
 		);
 	}
 }
@@ -602,10 +629,14 @@ int dwt_template(
 	}
 	size_t sigExtendedLen = sigInLen + (2*extendLen);
 
-	V *buf = (V *) sbuf.Alloc(sizeof(dummy) * (sigExtendedLen+sigConvolvedLen));
+	size_t scratchLen = L[0] + L[1] + filterLen + 1;
+	V *buf = (V *) sbuf.Alloc(
+		sizeof(dummy) * (sigExtendedLen+sigConvolvedLen+scratchLen)
+	);
 
 	V *sigExtended = buf;
 	V *sigConvolved = sigExtended + sigExtendedLen;
+	V *scratch = sigConvolved + sigConvolvedLen;
 
 	// Signal boundary extension
 	//
@@ -635,7 +666,7 @@ int dwt_template(
 		forward_xform(
 			s, L[0]+L[1], wf->GetLowDecomFilCoef(),
 			wf->GetHighDecomFilCoef(), filterLen, 
-			cAdbl, cDdbl, oddlow, oddhigh
+			cAdbl, cDdbl, oddlow, oddhigh, (double *) scratch
 		);
 	}
 	else {
@@ -842,14 +873,17 @@ int idwt_template(
 	reconTempLen = L[2];
 	if (reconTempLen % 2) reconTempLen++;
 
+	size_t scratchLen = (reconTempLen + 1) >> 1;
 	V *buf = (V *) sbuf.Alloc(
-		sizeof(dummy) * (cATempLen + cDTempLen + reconTempLen + cDPadLen)
+		sizeof(dummy) * 
+		(cATempLen + cDTempLen + reconTempLen + cDPadLen + scratchLen)
 	);
 
 	V *cATemp = buf;
 	V *cDTemp = cATemp + cATempLen;
 	V *reconTemp = cDTemp + cDTempLen;
 	V *cDPad = reconTemp + reconTempLen;
+	V *scratch = cDPad + cDPadLen;
 
 	//printmatrix1d("idwt: low pass reconstruct filter", wf->GetLowReconFilCoef(), filterLen);
 	//printmatrix1d("idwt: high pass reconstruct filter", wf->GetHighReconFilCoef(), filterLen);
@@ -915,7 +949,8 @@ int idwt_template(
 		
 		inverse_xform(
 			cAdbl, cDdbl, L[2], wf->GetLowReconFilCoef(), 
-			wf->GetHighReconFilCoef(), filterLen, s, ! do_sym_conv 
+			wf->GetHighReconFilCoef(), filterLen, s, ! do_sym_conv,
+			(double *) scratch
 		);
 	}
 	else {
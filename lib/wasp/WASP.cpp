@@ -2,6 +2,8 @@
 #include <sstream>
 #include <sstream>
 #include <iterator>
+#include <mutex>
+#include <condition_variable>
 #include <sys/stat.h>
 #include "vapor/utils.h"
 #include "vapor/MatWaveBase.h"
@@ -164,21 +166,16 @@ void vectorinc::ith(
 	start.clear();
 	offset = 0;
 
+	// Coordinates are incremented in row-major order (last coordinate 
+	// varies fastest), so the index can be decomposed directly
+	//
 	start = _start;
-	for (size_t idx = 0; idx < index; idx++) {
+	for (int i=start.size()-1; i>=0; i--) {
+		size_t n = (_end[i] - _start[i] + _inc[i] - 1) / _inc[i];
+		if (n < 1) n = 1;
 
-		int i = start.size()-1;
-		bool done = false;
-		while (i >= 0 && ! done) {
-			start[i] += _inc[i];
-			if (start[i] >= _end[i]) {
-				start[i] = _start[i];
-			}
-			else {
-				done = true;
-			}
-			i--;
-		}
+		start[i] += (index % n) * _inc[i];
+		index /= n;
 	}
 
 	offset = linearize_coords(start, _dims);
@@ -209,6 +206,105 @@ bool vectorinc::next(vector <size_t> &start, size_t &offset) {
 }
 #endif
 
+// Bounded queue of encoded blocks awaiting output to disk, used to
+// pipeline block compression with file I/O. Compression threads deposit 
+// the i'th block of a hyperslab in slot i % nslots, and a single I/O 
+// thread drains the queue in block order. A compression thread may not
+// claim a slot for block i until block i - nslots has been written, 
+// which bounds memory use and guarantees that the block the I/O thread 
+// is waiting on can always be produced.
+//
+class write_queue {
+public:
+ // Slots are padded to a multiple of \p align bytes, so that every slot
+ // is aligned for the element types stored in it
+ //
+ write_queue(size_t nblocks, size_t nslots, size_t slot_size, size_t align) :
+	_nblocks(nblocks), _nslots(nslots), _next(0), _abort(false)
+ {
+	VAssert(_nslots >= 1);
+	VAssert(align >= 1);
+
+	_slot_size = ((slot_size + align - 1) / align) * align;
+	_buf.resize(_nslots * _slot_size);
+	_ready.resize(_nslots, false);
+ }
+
+ size_t SlotSize() const { return(_slot_size); }
+
+ // Compression threads: return storage for block i, waiting for its slot
+ // to be written out if necessary. NULL is returned if the pipeline
+ // has been aborted
+ //
+ unsigned char *Acquire(size_t i) {
+	std::unique_lock <std::mutex> lock(_mutex);
+	_cond.wait(lock, [&] { return(_abort || i < _next + _nslots); });
+	if (_abort) return(NULL);
+	return(Slot(i));
+ }
+
+ // Compression threads: block i is ready to be written
+ //
+ void Release(size_t i) {
+	std::lock_guard <std::mutex> lock(_mutex);
+	_ready[i % _nslots] = true;
+	_cond.notify_all();
+ }
+
+ // I/O thread: wait for block i to be ready. Returns the number of 
+ // consecutive blocks, starting with i and no more than max, that are 
+ // ready and stored in contiguous slots. Zero is returned if the 
+ // pipeline has been aborted
+ //
+ size_t Wait(size_t i, size_t max) {
+	std::unique_lock <std::mutex> lock(_mutex);
+	_cond.wait(lock, [&] { return(_abort || _ready[i % _nslots]); });
+	if (_abort) return(0);
+
+	size_t n = 1;
+	while (
+		n < max && i+n < _nblocks && (i+n) % _nslots != 0 && 
+		_ready[(i+n) % _nslots]
+	) {
+		n++;
+	}
+	return(n);
+ }
+
+ // I/O thread: blocks [i, i+n) have been written and their slots 
+ // may be reused
+ //
+ void Done(size_t i, size_t n) {
+	std::lock_guard <std::mutex> lock(_mutex);
+	for (size_t j=i; j<i+n; j++) _ready[j % _nslots] = false;
+	_next = i + n;
+	_cond.notify_all();
+ }
+
+ // Any thread: stop the pipeline after an error
+ //
+ void Abort() {
+	std::lock_guard <std::mutex> lock(_mutex);
+	_abort = true;
+	_cond.notify_all();
+ }
+
+ unsigned char *Slot(size_t i) {
+	return(_buf.data() + (i % _nslots) * _slot_size);
+ }
+
+private:
+ size_t _nblocks;
+ size_t _nslots;
+ size_t _slot_size;
+ std::vector <unsigned char> _buf;
+ std::vector <bool> _ready;
+ size_t _next;		// next block to be written
+ bool _abort;
+ std::mutex _mutex;
+ std::condition_variable _cond;
+};
+
 // Execution thread state for data reads and writes
 //
 class thread_state {
@@ -235,6 +331,7 @@ public:
  unsigned char *_maps;	// private (not shared)
  int _level;
  bool _unblock_flag; // unblock the data after reconstruction?
+ write_queue *_queue;	// global. Output queue for writes
  static int _status;	// error indicator
 
  thread_state(
@@ -247,7 +344,7 @@ public:
 	const vector <Compressor *> &compressors,  
 	void *data, int data_type, unsigned char *mask, void *block, 
 	void *coeffs, int block_type, int xtype, unsigned char *maps, int level, 
-	bool unblock_flag
+	bool unblock_flag, write_queue *queue = NULL
  ) : _id(id), _et(et), _nthreads(nthreads), _varname(varname), 
 	_ncdfcptrs(ncdfcptrs), 
 	_start(start), _count(count), _bs(bs), _udims(udims),
@@ -255,7 +352,7 @@ public:
 	_compressors(compressors), _data(data), _data_type(data_type), 
 	_mask(mask), _block(block), _coeffs(coeffs), _block_type(block_type),
 	_xtype(xtype), _maps(maps), _level(level),
-	_unblock_flag(unblock_flag)
+	_unblock_flag(unblock_flag), _queue(queue)
  {_status = 0;}
 
 };
@@ -863,18 +960,20 @@ int ReconstructBlock(
 	return(0);
 }
 
-// Write a single block (no compression) to disk
+// Write one or more blocks (no compression) to disk
 //
 // varname : name of variable
 // ncdfcptr : NetCDFCpp file pointer
 // bcoords : coordinates of block in voxel coords relative to start of variable
+// nblocks : number of consecutive blocks, along the fastest varying block
+// axis, to write
 // bs : blocksize
-// block : data block
+// block : data blocks, stored contiguously
 //
 template <class T>
 int StoreBlock(
 	string varname, NetCDFCpp * ncdfcptr, vector <size_t> bcoords, 
-	 size_t block_size, const T *block
+	 size_t nblocks, size_t block_size, const T *block
 	
 ) {
 
@@ -882,6 +981,7 @@ int StoreBlock(
 	start.push_back(0);
 
 	vector <size_t> count(start.size(), 1);
+	count[count.size()-2] = nblocks;
 	count[count.size()-1] = block_size;
 
 
@@ -1110,20 +1210,24 @@ int FetchBlockCompressed(
 }
 
 
+// Compression thread for writes of uncompressed data. Blocks are 
+// extracted directly into the output queue
+//
 template <class T>
 void *RunWriteThreadTemplate(thread_state &s, T dummy) 
 {
 
 	vectorinc vec(s._start, s._count, s._udims, s._bs);
 
-	s._status = 0;
-
 	//
 	// Process blocks of data assigned to this thread
 	//
 	int n = vec.num();
 	for (int i=s._id; i<n; i += s._nthreads) {
 
+		T *block = (T *) s._queue->Acquire(i);
+		if (! block) break;	// I/O failed
+
 		// Get starting coordinates of i'th block
 		//
 		size_t offset;
@@ -1140,31 +1244,70 @@ void *RunWriteThreadTemplate(thread_state &s, T dummy)
 		//
 		T min, max;
 		Block(
-			(T *) s._data, NULL, s._count, roi_start, (T *) s._block, 
+			(T *) s._data, NULL, s._count, roi_start, block, 
 			s._bs, "symh", min, max
 		);
 
+		s._queue->Release(i);
+	}
+	return(0);
+}
+
+// I/O thread for writes of uncompressed data. Drains the output queue in
+// block order. Runs of blocks that are adjacent along the fastest 
+// varying block axis are written with a single PutVara call
+//
+template <class T>
+void *RunStoreThreadTemplate(thread_state &s, T dummy) 
+{
+
+	vectorinc vec(s._start, s._count, s._udims, s._bs);
+
+	// Adjacent slots hold a contiguous run of blocks only if the slots
+	// are unpadded
+	//
+	bool merge = s._queue->SlotSize() == vproduct(s._bs) * sizeof(T);
+
+	size_t n = vec.num();
+	size_t i = 0;
+	while (i<n) {
+
+		size_t nready = s._queue->Wait(i, merge ? n-i : 1);
+		if (! nready) break;	// compression failed
+
 		// Convert from voxel to block coordinates
 		//
+		size_t offset;
+		vector <size_t> start;
+		vec.ith(i, start, offset);
+
 		vector <size_t> bcoords;
 		size_t residual;
 		to_block_coords(start, s._bs, bcoords, residual);
 		VAssert(residual == 0);
 
-		// Write the transformed block to disk. Need a mutex because
-		// NetCDF library is not thread safe
-		//
-		//
-		s._et->MutexLock();
-			int rc = StoreBlock(
-				s._varname, s._ncdfcptrs[0], bcoords, 
-				s._encoded_dims[0], (T *) s._block
-			);
-			if (rc<0) {
-				s._status = -1;
-			}
-		s._et->MutexUnlock();
-		if (s._status < 0) break;
+		size_t nblocks = 1;
+		for (; nblocks<nready; nblocks++) {
+			vector <size_t> next, next_bcoords;
+			vec.ith(i+nblocks, next, offset);
+			to_block_coords(next, s._bs, next_bcoords, residual);
+
+			next_bcoords.back() -= nblocks;
+			if (next_bcoords != bcoords) break;
+		}
+
+		int rc = StoreBlock(
+			s._varname, s._ncdfcptrs[0], bcoords, nblocks,
+			s._encoded_dims[0], (T *) s._queue->Slot(i)
+		);
+		if (rc<0) {
+			s._status = -1;
+			s._queue->Abort();
+			break;
+		}
+
+		s._queue->Done(i, nblocks);
+		i += nblocks;
 	}
 	return(0);
 }
@@ -1195,24 +1338,70 @@ void *RunWriteThread(void *arg) {
 	}
 }
 
-// Thread execution help function for data writes
+void *RunStoreThread(void *arg) {
+	thread_state &s = *(thread_state *) arg;
+
+	switch(s._data_type) {
+	case NC_FLOAT: {
+		float dummy = 0.0;
+		return(RunStoreThreadTemplate(s, dummy));
+	}
+	case NC_DOUBLE: {
+		double dummy = 0.0;
+		return(RunStoreThreadTemplate(s, dummy));
+	}
+	case NC_INT: {
+		int dummy = 0.0;
+		return(RunStoreThreadTemplate(s, dummy));
+	}
+	case NC_SHORT: {
+		int16_t dummy = 0.0;
+		return(RunStoreThreadTemplate(s, dummy));
+	}
+	default:
+		VAssert(0);
+		return(NULL);
+	}
+}
+
+// Storage for a compressed block in the output queue: the block's data 
+// range, followed by the wavelet coefficients for all compression 
+// levels, followed by the encoded significance maps
 //
-	
+template <class U>
+U *slot_datarange(unsigned char *slot) {
+	return((U *) slot);
+}
 
+template <class U>
+U *slot_coeffs(unsigned char *slot) {
+	return((U *) slot + BLK_HDR_SZ);
+}
 
+template <class U>
+unsigned char *slot_maps(unsigned char *slot, const vector <size_t> &ncoeffs) {
+	return((unsigned char *) (slot_coeffs<U>(slot) + vsum(ncoeffs)));
+}
+
+
+
+// Compression thread for writes of compressed data. Wavelet coefficients
+// and significance maps are encoded directly into the output queue
+//
 template <class T, class U>
 void *RunWriteThreadCompressedTemplate(thread_state &s, T dummy1, U dummy2) {
 
 	vectorinc vec(s._start, s._count, s._udims, s._bs);
 
-	s._status = 0;
-
 	//
 	// Process blocks of data assigned to this thread
 	//
 	int n = vec.num();
 	for (int i=s._id; i<n; i += s._nthreads) {
 
+		unsigned char *slot = s._queue->Acquire(i);
+		if (! slot) break;	// I/O failed
+
 		// Get starting coordinates of i'th block
 		//
 		size_t offset;
@@ -1227,7 +1416,7 @@ void *RunWriteThreadCompressedTemplate(thread_state &s, T dummy1, U dummy2) {
 		// Extract the block with coordinates 'start' from the 
 		// array, 'data'. 
 		//
-		U datarange[2];
+		U *datarange = slot_datarange<U>(slot);
 		Block(
 			(T *) s._data, s._mask, s._count, roi_start, (U *) s._block, s._bs, 
 			s._compressors[s._id]->dwtmode(), datarange[0], datarange[1]
@@ -1238,38 +1427,76 @@ void *RunWriteThreadCompressedTemplate(thread_state &s, T dummy1, U dummy2) {
 		//
 		int rc = DecomposeBlock(
 			s._compressors[s._id], (const U *) s._block, vproduct(s._bs),
-			(U *) s._coeffs, s._maps, s._xtype, s._ncoeffs, s._encoded_dims
+			slot_coeffs<U>(slot), slot_maps<U>(slot, s._ncoeffs), 
+			s._xtype, s._ncoeffs, s._encoded_dims
 		);
 		if (rc<0) {
 			s._status = -1;
+			s._queue->Abort();
 			break;
 		}
 
+		s._queue->Release(i);
+	}
+	return(0);
+}
+
+// I/O thread for writes of compressed data. Drains the output queue in 
+// block order
+//
+template <class U>
+void *RunStoreThreadCompressedTemplate(thread_state &s, U dummy) {
+
+	vectorinc vec(s._start, s._count, s._udims, s._bs);
+
+	size_t n = vec.num();
+	for (size_t i=0; i<n; i++) {
+
+		if (! s._queue->Wait(i, 1)) break;	// compression failed
+
 		// Convert from voxel to block coordinates
 		//
+		size_t offset;
+		vector <size_t> start;
+		vec.ith(i, start, offset);
+
 		vector <size_t> bcoords;
 		size_t residual;
 		to_block_coords(start, s._bs, bcoords, residual);
 		VAssert(residual == 0);
 
-		// Write the transformed block to disk. Need a mutex because
-		// NetCDF library is not thread safe
-		//
-		//
-		s._et->MutexLock();
-			rc = StoreBlockCompressed(
-				s._varname, s._ncdfcptrs, bcoords, s._ncoeffs, s._encoded_dims,
-				(U *) s._coeffs, datarange, s._maps, s._xtype
-			);
-			if (rc<0) {
-				s._status = -1;
-			}
-		s._et->MutexUnlock();
-		if (s._status < 0) break;
+		unsigned char *slot = s._queue->Slot(i);
+		int rc = StoreBlockCompressed(
+			s._varname, s._ncdfcptrs, bcoords, s._ncoeffs, s._encoded_dims,
+			slot_coeffs<U>(slot), slot_datarange<U>(slot), 
+			slot_maps<U>(slot, s._ncoeffs), s._xtype
+		);
+		if (rc<0) {
+			s._status = -1;
+			s._queue->Abort();
+			break;
+		}
+
+		s._queue->Done(i, 1);
 	}
 	return(0);
 }
 
+void *RunStoreThreadCompressed(void *arg) {
+	thread_state &s = *(thread_state *) arg;
+
+	VAssert(s._block_type == NC_INT64 || s._block_type == NC_DOUBLE);
+
+	if (s._block_type == NC_INT64) {
+		long dummy = 0;
+		return(RunStoreThreadCompressedTemplate(s, dummy));
+	}
+	else {
+		double dummy = 0;
+		return(RunStoreThreadCompressedTemplate(s, dummy));
+	}
+}
+
 void *RunWriteThreadCompressed(void *arg) {
 	thread_state &s = *(thread_state *) arg;
 
@@ -1349,6 +1576,24 @@ void *RunWriteThreadCompressed(void *arg) {
 	}
 }
 
+// Entry points for the threads of a pipelined write. Threads 0 through 
+// nthreads-1 compress blocks into the output queue, and the last thread
+// writes them out
+//
+void *RunWritePipeline(void *arg) {
+	thread_state &s = *(thread_state *) arg;
+
+	if (s._id == s._nthreads) return(RunStoreThread(arg));
+	return(RunWriteThread(arg));
+}
+
+void *RunWritePipelineCompressed(void *arg) {
+	thread_state &s = *(thread_state *) arg;
+
+	if (s._id == s._nthreads) return(RunStoreThreadCompressed(arg));
+	return(RunWriteThreadCompressed(arg));
+}
+
 // Thread execution helper function for data writes
 //
 template <class T>
@@ -2593,12 +2838,14 @@ int WASP::_PutVara(
 	size_t block_size = vproduct(_open_bs);
 	U *block = (U *) _blockbuf.Alloc(block_size * _nthreads * sizeof(U));
 
-	// Allocate space for coefficients and sigmap if data are compressed
+	// Size of an encoded block in the output queue. Blocks are compressed
+	// directly into the queue, so no per-thread coefficient or 
+	// significance map storage is needed. Uncompressed blocks need no 
+	// padding, which lets the I/O thread write runs of them at once. 
+	// Encoded blocks are padded to keep the coefficients aligned.
 	//
-	size_t coeffs_size = 0;
-	U *coeffs = NULL;
-	size_t maps_size = 0;
-	unsigned char *maps = NULL;
+	size_t slot_size = block_size * sizeof(T);
+	size_t slot_align = sizeof(T);
 	if (! _open_wname.empty()) {
 
 		// Handle case where not all coefficients are wanted
@@ -2608,16 +2855,26 @@ int WASP::_PutVara(
 			encoded_dims.pop_back();
 		}
 
-		coeffs_size = vsum(ncoeffs);
-		coeffs = (U *) _coeffbuf.Alloc(coeffs_size * _nthreads * sizeof(U));
-
-		maps_size = vsum(encoded_dims) - vsum(ncoeffs);  
+		size_t maps_size = vsum(encoded_dims) - vsum(ncoeffs);  
 		maps_size -= BLK_HDR_SZ; 
-		maps = (unsigned char*) _sigbuf.Alloc(
-			maps_size * _nthreads * NetCDFCpp::SizeOf(_open_varxtype)
-		);
+
+		slot_size = (BLK_HDR_SZ + vsum(ncoeffs)) * sizeof(U) + 
+			maps_size * NetCDFCpp::SizeOf(_open_varxtype);
+		slot_align = sizeof(U);
 	}
 
+	// Compression threads feed a single I/O thread through a bounded 
+	// queue, since the NetCDF library is not thread safe. A few slots
+	// per compression thread keep the threads busy while the I/O thread
+	// is writing
+	//
+	const size_t SlotsPerThread = 4;
+	size_t nblocks = vectorinc(start, count, _open_udims, _open_bs).num();
+	write_queue queue(
+		nblocks, min(nblocks, SlotsPerThread * _nthreads), slot_size,
+		slot_align
+	);
+
 	// Ugh. Can't preserve type in thread_state, which has to be passed
 	// as a void * to thread library
 	//
@@ -2625,45 +2882,44 @@ int WASP::_PutVara(
 	int block_type = _NetCDFType(*block);
 
 	//
-	// Set up thread state for parallel (threaded) execution
+	// Set up thread state for parallel (threaded) execution. The last
+	// thread is the I/O thread. The compression threads and the I/O 
+	// thread must run concurrently, so all of them are run by a single
+	// ParRun() with one more thread than usual
 	//
+	EasyThreads et(_nthreads + 1);
+
 	vector <void *> argvec;
-	for (int i=0; i<_nthreads; i++) {
+	for (int i=0; i<_nthreads+1; i++) {
 
 		argvec.push_back((void *) new thread_state(
-			i, _et, _nthreads, _open_varname, _ncdfcptrs, start, count, 
+			i, &et, _nthreads, _open_varname, _ncdfcptrs, start, count, 
 			_open_bs, _open_udims, ncoeffs, encoded_dims, _open_compressors, 
 			(void *) data, data_type, (unsigned char *) mask,
-			block + i*block_size, coeffs + i*coeffs_size, 
-			block_type, _open_varxtype,
-			maps + i*maps_size*NetCDFCpp::SizeOf(_open_varxtype), 0, true
+			i < _nthreads ? block + i*block_size : NULL, NULL, 
+			block_type, _open_varxtype, NULL, 0, true, &queue
 		));
 	}
 
-	if (_nthreads == 1) {
-		if (_open_wname.empty()) {
-			RunWriteThread(argvec[0]);
-		}
-		else {
-			RunWriteThreadCompressed(argvec[0]);
-		}
+	int rc;
+	if (_open_wname.empty()) {
+		rc = et.ParRun(RunWritePipeline, argvec);
 	}
 	else {
-		int rc;
-		if (_open_wname.empty()) {
-			rc = _et->ParRun(RunWriteThread, argvec);
-		}
-		else {
-			rc = _et->ParRun(RunWriteThreadCompressed, argvec);
-		}
-
-		if (rc < 0) {
-			SetErrMsg("Error spawning threads");
-			return(-1);
-		}
+		rc = et.ParRun(RunWritePipelineCompressed, argvec);
 	}
+
+	// Release any threads that did start
+	//
+	if (rc < 0) queue.Abort();
+
 	for (int i=0; i<argvec.size(); i++) delete (thread_state *) argvec[i];
 
+	if (rc < 0) {
+		SetErrMsg("Error spawning threads");
+		return(-1);
+	}
+
 	return(thread_state::_status);
 }
 
@@ -2906,15 +3162,8 @@ int WASP::_GetVara(
 
 	size_t block_size = vproduct(bs_at_level);
 
-	// Need temporary space for storing reconstructed data
-	//
-	U *block = NULL;
-	block = (U *) _blockbuf.Alloc(block_size * _nthreads * sizeof(U));
-
     size_t coeffs_size = 0;
-    U *coeffs = NULL;
     size_t maps_size = 0;
-    unsigned char *maps = NULL;
 	if (! _open_wname.empty()) {
 		// Handle case where not all coefficients are wanted
 		//
@@ -2924,15 +3173,28 @@ int WASP::_GetVara(
 		}
 
 		coeffs_size = vsum(ncoeffs);
-		coeffs = (U *) _coeffbuf.Alloc(coeffs_size * _nthreads * sizeof(U));
 
 		maps_size = vsum(encoded_dims) - vsum(ncoeffs);  
 		maps_size -= BLK_HDR_SZ;
-		maps = (unsigned char*) _sigbuf.Alloc(
-			maps_size * _nthreads * NetCDFCpp::SizeOf(_open_varxtype)
-		);
 	}
 
+	// Need temporary space for storing reconstructed data, and for 
+	// the coefficients and significance maps read from disk. All of it
+	// is carved from one buffer: the blocks, then the coefficients (both
+	// of type U), then the maps
+	//
+	size_t block_bytes = block_size * _nthreads * sizeof(U);
+	size_t coeffs_bytes = coeffs_size * _nthreads * sizeof(U);
+	size_t maps_bytes = 
+		maps_size * _nthreads * NetCDFCpp::SizeOf(_open_varxtype);
+
+	unsigned char *buf = (unsigned char *) _blockbuf.Alloc(
+		block_bytes + coeffs_bytes + maps_bytes
+	);
+	U *block = (U *) buf;
+	U *coeffs = (U *) (buf + block_bytes);
+	unsigned char *maps = buf + block_bytes + coeffs_bytes;
+
 	// Ugh. Can't preserve type in thread_state, which has to be passed
 	// as a void * to thread library
 	//
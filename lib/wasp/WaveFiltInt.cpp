@@ -34,6 +34,19 @@ namespace {
 
 	const double h2_2[] = {-1/8, 1/4, 3/4, 1/4, -1/8};
 	const double hm2_2[] = {0, -1/2, 1, -1/2, 0};
+
+	// Lifting step rounding: floor((a+b)/2) and floor((a+b)/4 + 1/2).
+	// Arithmetic right shift is floor division for signed integers, 
+	// so these match the floating point formulation exactly while 
+	// keeping the lifting loops in integer arithmetic, where they 
+	// vectorize.
+	//
+	inline long half_floor(long a, long b) {
+		return((a + b) >> 1);
+	}
+	inline long quarter_round(long a, long b) {
+		return((a + b + 2) >> 2);
+	}
 };
 
 void WaveFiltInt::_analysis_initialize () 
@@ -115,28 +128,28 @@ void WaveFiltInt::_AnalysisCDF5_3(
 	if (sigInLen % 2) nC++;
 
 	for (size_t i=0; i<nD; i++) {
-		cD[i] = x[2*i+1] - floor(0.5 * (x[2*(i+1)] + x[2*i]));
+		cD[i] = x[2*i+1] - half_floor(x[2*(i+1)], x[2*i]);
 	}
 
 	// Left boundary of approximation coefficients requires special 
 	// handling (we don't have cD[i] for i==-1
 	//
-	long cDm1 = x[-1] - floor(0.5 * (x[0] + x[-2]));
-	cA[0] = x[0] + floor(0.25 * (cD[0] + cDm1) + 0.5);
+	long cDm1 = x[-1] - half_floor(x[0], x[-2]);
+	cA[0] = x[0] + quarter_round(cD[0], cDm1);
 
 	// For even length signals nD=nC. For odd, nD=nC-1 and we need
 	// special handling for right boundary
 	//
 	for (size_t i=1; i<nD; i++) {
-		cA[i] = x[2*i] + floor(0.25 * (cD[i] + cD[i-1]) +0.5);
+		cA[i] = x[2*i] + quarter_round(cD[i], cD[i-1]);
 	}
 
 	// Boundary handling for odd length signals
 	//
 	if (sigInLen % 2) {
 		size_t i = nC-1;
-		long cDp1  = x[2*i+1] - floor(0.5 * (x[2*(i+1)] + x[2*i]));
-		cA[i] = x[2*i] + floor(0.25 * (cDp1 + cD[i-1]) +0.5);
+		long cDp1  = x[2*i+1] - half_floor(x[2*(i+1)], x[2*i]);
+		cA[i] = x[2*i] + quarter_round(cDp1, cD[i-1]);
 	}
 }
 
@@ -162,19 +175,19 @@ void WaveFiltInt::_SynthesisCDF5_3(
 	// Even samples
 	//
 	for (size_t i=0; i<n; i++) {
-		sigOut[2*i] = cA[i] - floor(0.25 * (cD[i-1]+cD[i]) + 0.5);
+		sigOut[2*i] = cA[i] - quarter_round(cD[i-1], cD[i]);
 	}
 
 	// Odd  samples
 	//
 	for (size_t i=0; i<n-1; i++) {
-		sigOut[2*i+1] = cD[i] + floor(0.5 * (sigOut[2*(i+1)]+sigOut[2*i]));
+		sigOut[2*i+1] = cD[i] + half_floor(sigOut[2*(i+1)], sigOut[2*i]);
 	}
 
 	// Right boundary requires special handling - we don't have 
 	// even sample for sigOut[2*(i+1)] when i==n-1
 	//
 	size_t i = n-1;
-	long sp1 = cA[n] - floor(0.25 * (cD[n-1]+cD[n]) + 0.5);
-	sigOut[2*i+1] = cD[i] + floor(0.5 * (sp1+sigOut[2*i]));
+	long sp1 = cA[n] - quarter_round(cD[n-1], cD[n]);
+	sigOut[2*i+1] = cD[i] + half_floor(sp1, sigOut[2*i]);
 }
@@ -8,6 +8,7 @@
     GradFinDiff - calculate gradient using finite differences.
     interp3d - interpolate a 3D variable to a vertical level surface of another variable.
     vector_rotate - rotate and scale vector field for lat-lon grid.    
+    ReadFlowlines - read a binary flow line file written by the Flow renderer.
 """
 
 import numpy as np
@@ -835,3 +836,69 @@ def mag2d(a1,a2):
     of the sum of the squares of A and B.'''
     from np import sqrt
     return sqrt(a1*a1 + a2*a2)
+
+def ReadFlowlines(filename):
+    """Read a binary flow line file written by the Flow renderer
+
+    Flow lines written to a file whose name ends in ".vfl" are stored in
+    a binary format. The file is memory-mapped, so arrays are only read
+    when they are accessed.
+
+    Parameters
+    ----------
+    filename : str
+        Path to the file
+
+    Returns
+    -------
+    sections : list of dict
+        One dict per section of the file (bi-directional flow has two), with
+        keys 'metadata' (a dict of the parameters the flow lines were
+        computed with), 'offsets' (particles offsets[i] to offsets[i+1]-1 
+        belong to stream i), 'x', 'y', 'z', 'time', 'value', and 
+        'properties' (a 2D array with one row per property). Separators
+        between pieces of a stream have NaN time and value.
+    """
+
+    header = np.dtype([
+        ('magic', 'S8'), ('version', '<u4'), ('nprops', '<u4'),
+        ('nstreams', '<u8'), ('nparticles', '<u8'), ('nmeta', '<u8')
+    ])
+
+    data = np.memmap(filename, dtype=np.uint8, mode='r')
+    sections = []
+    pos = 0
+    while pos < data.size:
+        h = data[pos:pos + header.itemsize].view(header)[0]
+        if h['magic'] != b'VAPORFL' or h['version'] != 1:
+            raise ValueError('Not a binary flow line file: ' + filename)
+
+        nprops = int(h['nprops'])
+        nstreams = int(h['nstreams'])
+        n = int(h['nparticles'])
+        nmeta = int(h['nmeta'])
+
+        start = pos + header.itemsize
+        text = data[start:start + nmeta].tobytes().decode()
+        metadata = {}
+        for line in text.splitlines():
+            if '=' in line:
+                key, value = line.split('=', 1)
+                metadata[key.strip()] = value.strip()
+
+        start = pos + (header.itemsize + nmeta + 7) // 8 * 8
+        offsets = data[start:start + 8 * (nstreams + 1)].view('<u8')
+
+        start += 8 * (nstreams + 1)
+        arrays = data[start:start + 4 * n * (5 + nprops)].view('<f4')
+        arrays = arrays.reshape(5 + nprops, n)
+
+        sections.append({
+            'metadata': metadata, 'offsets': offsets,
+            'x': arrays[0], 'y': arrays[1], 'z': arrays[2],
+            'time': arrays[3], 'value': arrays[4], 'properties': arrays[5:]
+        })
+
+        pos = start + (4 * n * (5 + nprops) + 7) // 8 * 8
+
+    return sections
@@ -447,6 +447,18 @@ int main(int argc, char **argv) {
 	if (! opt.quiet) {
 
 		fprintf(stdout, "total process time : %f\n", timer);
+
+		DataMgr::CacheStats stats = datamgr.GetCacheStats();
+		fprintf(
+			stdout, "cache hits : %zu, misses : %zu, evictions : %zu\n",
+			stats.hits, stats.misses, stats.evictions
+		);
+
+		BlkMemMgr::Stats memStats = BlkMemMgr::GetStats();
+		fprintf(
+			stdout, "cache blocks used : %zu, free : %zu, fragmentation : %f\n",
+			memStats.usedBlks, memStats.freeBlks, memStats.fragmentation
+		);
 	}
 
 	exit(0);
@@ -0,0 +1,301 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+
+#include <vapor/FileUtils.h>
+#include <vapor/CFuncs.h>
+#include <vapor/OptionParser.h>
+#include <vapor/Advection.h>
+#include <vapor/FlowLineBuffer.h>
+
+using namespace std;
+
+using namespace Wasp;
+using namespace flow;
+
+//
+// Compares the flow lines that FlowLineBuffer assembles incrementally, as
+// an advection grows, with those of a buffer rebuilt from scratch, and 
+// checks the layout of the assembled lines
+//
+
+struct {
+	int nsteps;
+	int nseeds;
+	OptionParser::Boolean_T	help;
+} opt;
+
+OptionParser::OptDescRec_T	set_opts[] = {
+	{"nsteps",  1,  "60","Number of advection steps"},
+	{"nseeds",  1,  "5","Number of seeds"},
+	{"help",	0,	"",	"Print this message and exit"},
+	{NULL}
+};
+
+
+OptionParser::Option_T	get_options[] = {
+	{"nsteps", Wasp::CvtToInt, &opt.nsteps, sizeof(opt.nsteps)},
+	{"nseeds", Wasp::CvtToInt, &opt.nseeds, sizeof(opt.nseeds)},
+	{"help", Wasp::CvtToBoolean, &opt.help, sizeof(opt.help)},
+	{NULL}
+};
+
+const char	*ProgName;
+
+// A steady, uniform velocity field in the box [0..10]^3. Its scalar is 
+// the X coordinate.
+//
+class UniformField : public Field {
+public:
+	UniformField() { IsSteady = true; }
+
+	bool InsideVolumeVelocity(float time, const glm::vec3 &pos) const {
+		for (int i=0; i<3; i++) {
+			if (! (pos[i] >= 0.0f && pos[i] <= 10.0f)) return(false);
+		}
+		return(true);
+	}
+	bool InsideVolumeScalar(float time, const glm::vec3 &pos) const {
+		return(InsideVolumeVelocity(time, pos));
+	}
+	int GetNumberOfTimesteps() const { return(1); }
+
+	int GetScalar(
+		float time, const glm::vec3 &pos, float &val, bool checkInsideVolume
+	) const {
+		if (checkInsideVolume && ! InsideVolumeScalar(time, pos)) return(-1);
+		val = pos.x;
+		return(0);
+	}
+	int GetVelocity(
+		float time, const glm::vec3 &pos, glm::vec3 &vel, 
+		bool checkInsideVolume
+	) const {
+		if (checkInsideVolume && ! InsideVolumeVelocity(time, pos)) return(-1);
+		vel = glm::vec3(1.0f, 0.25f, 0.0f);
+		return(0);
+	}
+};
+
+bool same(
+	const vector <FlowLineBuffer::Vertex> &v0, const vector <int> &s0,
+	const vector <FlowLineBuffer::Vertex> &v1, const vector <int> &s1
+) {
+	if (v0.size() != v1.size() || s0 != s1) return(false);
+	for (size_t i=0; i<v0.size(); i++) {
+		if (v0[i].v != v1[i].v) return(false);
+		for (int k=0; k<3; k++) {
+			if (v0[i].p[k] != v1[i].p[k]) return(false);
+		}
+	}
+	return(true);
+}
+
+// Returns true if assembling "buf" gives the same lines as a buffer 
+// rebuilt from scratch
+//
+bool same_as_rebuilt(
+	const FlowLineBuffer &buf, const Advection &adv, double maxTime, 
+	size_t maxParticles, double minTime
+) {
+	FlowLineBuffer rebuilt;
+	rebuilt.Update(&adv, maxTime, maxParticles);
+
+	vector <FlowLineBuffer::Vertex> v0, v1;
+	vector <int> s0, s1;
+	buf.Assemble(minTime, v0, s0);
+	rebuilt.Assemble(minTime, v1, s1);
+	return(same(v0, s0, v1, s1));
+}
+
+// Checks the layout of the assembled lines: each line has a padding 
+// vertex at either end, one unit along the line's end segment, with the 
+// value of the end vertex. Consecutive samples of a line are at most a 
+// few units apart; a wrapped particle left in a line would be a jump 
+// across the box.
+//
+size_t test_layout(const FlowLineBuffer &buf, double minTime) {
+	vector <FlowLineBuffer::Vertex> vertices;
+	vector <int> sizes;
+	buf.Assemble(minTime, vertices, sizes);
+
+	size_t nwrong = 0;
+	size_t total = 0;
+	for (size_t l=0; l<sizes.size(); l++) {
+		const FlowLineBuffer::Vertex *v = vertices.data() + total;
+		int n = sizes[l];
+		total += n;
+		if (n < 4) {
+			nwrong++;
+			continue;
+		}
+
+		glm::vec3 prep = -glm::normalize(v[2].p - v[1].p) + v[1].p;
+		glm::vec3 post = glm::normalize(v[n-2].p - v[n-3].p) + v[n-2].p;
+		if (glm::length(v[0].p - prep) > 1e-5) nwrong++;
+		if (glm::length(v[n-1].p - post) > 1e-5) nwrong++;
+		if (v[0].v != v[1].v || v[n-1].v != v[n-2].v) nwrong++;
+
+		for (int i=1; i<n-2; i++) {
+			if (glm::length(v[i+1].p - v[i].p) > 5.0) nwrong++;
+		}
+	}
+	if (total != vertices.size()) nwrong++;
+
+	return(nwrong);
+}
+
+// Returns the number of lines in the advection, splitting streams at 
+// separators, and counting lines of a single particle
+//
+size_t num_lines(const Advection &adv) {
+	size_t nlines = 0;
+	for (size_t s=0; s<adv.GetNumberOfStreams(); s++) {
+		const vector <Particle> &stream = adv.GetStreamAt(s);
+		bool open = false;
+		for (size_t i=0; i<stream.size(); i++) {
+			if (stream[i].IsSpecial()) open = false;
+			else if (! open) {
+				open = true;
+				nlines++;
+			}
+		}
+	}
+	return(nlines);
+}
+
+int main(int argc, char **argv) {
+
+	OptionParser op;
+
+	ProgName = FileUtils::LegacyBasename(argv[0]);
+
+	MyBase::SetErrMsgFilePtr(stderr);
+
+	if (op.AppendOptions(set_opts) < 0) {
+		cerr << ProgName << " : " << op.GetErrMsg();
+		exit(1);
+	}
+
+	if (op.ParseOptions(&argc, argv, get_options) < 0) {
+		cerr << ProgName << " : " << op.GetErrMsg();
+		exit(1);
+	}
+
+	if (opt.help) {
+		cerr << "Usage: " << ProgName << " [options] " << endl;
+		op.PrintOptionHelp(stderr);
+		exit(0);
+	}
+
+	if (opt.nsteps < 1 || opt.nseeds < 1) {
+		cerr << "Usage: " << ProgName << " [options] " << endl;
+		op.PrintOptionHelp(stderr);
+		exit(1);
+	}
+
+	UniformField field;
+
+	// Seeds staggered in X, so that streams leave the box, and wrap 
+	// around, at different steps
+	//
+	vector <Particle> seeds;
+	for (int i=0; i<opt.nseeds; i++) {
+		seeds.push_back(Particle(
+			1.0f + 8.0f * i / opt.nseeds, 1.0f + 0.5f * i, 5.0f, 0.0f
+		));
+	}
+
+	Advection adv;
+	adv.SetNumThreads(1);
+	adv.SetXPeriodicity(true, 0.0f, 10.0f);
+	adv.UseSeedParticles(seeds);
+
+	const double maxTime = 1e30;
+	const size_t maxParticles = (size_t) -1;
+	const float deltaT = 0.5f;
+
+	size_t nwrong = 0;
+
+	// Incremental updates, as the advection steps forward, match a 
+	// rebuilt buffer. Stepping past the box wraps particles that were
+	// already added.
+	//
+	FlowLineBuffer buf;
+	size_t nmismatch = 0;
+	for (int step=0; step<opt.nsteps; step++) {
+		adv.AdvectOneStep(&field, deltaT, Advection::ADVECTION_METHOD::EULER);
+		adv.CalculateNewParticleValues(&field);
+		buf.Update(&adv, maxTime, maxParticles);
+
+		if (! same_as_rebuilt(buf, adv, maxTime, maxParticles, 0.0)) {
+			nmismatch++;
+		}
+		if (! same_as_rebuilt(buf, adv, maxTime, maxParticles, step * 0.25)) {
+			nmismatch++;
+		}
+		nwrong += test_layout(buf, 0.0);
+	}
+	size_t nwraps = num_lines(adv) - adv.GetNumberOfStreams();
+	cout << "Incremental update, " << nwraps << " wraps : " << nmismatch 
+		<< " mismatches" << endl;
+	nwrong += nmismatch;
+
+	// The advection must have wrapped for the test to mean anything
+	//
+	if (! nwraps) nwrong++;
+
+	// Shrinking either cutoff starts over, and growing it again extends
+	// what was kept
+	//
+	nmismatch = 0;
+	double endTime = opt.nsteps * deltaT;
+	double times[] = {endTime / 2, endTime / 4, endTime / 3, endTime};
+	for (int i=0; i<4; i++) {
+		buf.Update(&adv, times[i], maxParticles);
+		if (! same_as_rebuilt(buf, adv, times[i], maxParticles, 0.0)) {
+			nmismatch++;
+		}
+	}
+	size_t counts[] = {30, 10, 20, 5, maxParticles};
+	for (int i=0; i<5; i++) {
+		buf.Update(&adv, maxTime, counts[i]);
+		if (! same_as_rebuilt(buf, adv, maxTime, counts[i], 0.0)) {
+			nmismatch++;
+		}
+	}
+	cout << "Shrinking cutoffs : " << nmismatch << " mismatches" << endl;
+	nwrong += nmismatch;
+
+	// Each sample is kept once
+	//
+	size_t nsamples = 0;
+	for (size_t s=0; s<adv.GetNumberOfStreams(); s++) {
+		const vector <Particle> &stream = adv.GetStreamAt(s);
+		for (size_t i=0; i<stream.size(); i++) {
+			if (! stream[i].IsSpecial()) nsamples++;
+		}
+	}
+	if (buf.GetNumOfSamples() != nsamples) nwrong++;
+
+	// Layout of the assembled lines, including a window that leaves 
+	// some lines with too few samples to draw
+	//
+	size_t nlayout = 0;
+	for (int i=0; i<4; i++) {
+		nlayout += test_layout(buf, times[i]);
+	}
+	cout << "Layout : " << nlayout << " wrong" << endl;
+	nwrong += nlayout;
+
+	buf.Reset();
+	if (buf.GetNumOfSamples() != 0) nwrong++;
+
+	if (nwrong) {
+		cerr << ProgName << " : " << nwrong << " mismatches" << endl;
+		return(1);
+	}
+
+	return 0;
+}
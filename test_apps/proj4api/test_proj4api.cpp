@@ -0,0 +1,297 @@
+#define ACCEPT_USE_OF_DEPRECATED_PROJ_API_H 1
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstdlib>
+#include <proj_api.h>
+
+#include <vapor/FileUtils.h>
+#include <vapor/CFuncs.h>
+#include <vapor/OptionParser.h>
+#include <vapor/Proj4API.h>
+
+using namespace std;
+
+using namespace Wasp;
+using namespace VAPoR;
+
+//
+// Compares Proj4API::Transform(), which computes the Mercator and Lambert
+// Conformal Conic projections in closed form, with pj_transform() over a
+// lat/lon grid that includes the poles and the antimeridian, in both 
+// directions
+//
+
+struct {
+	float delta;
+	OptionParser::Boolean_T	verbose;
+	OptionParser::Boolean_T	help;
+} opt;
+
+OptionParser::OptDescRec_T	set_opts[] = {
+	{"delta", 1,  "5.0","Grid spacing in degrees"},
+	{"verbose",	0,	"",	"Print each point that differs"},
+	{"help",	0,	"",	"Print this message and exit"},
+	{NULL}
+};
+
+
+OptionParser::Option_T	get_options[] = {
+	{"delta", Wasp::CvtToFloat, &opt.delta, sizeof(opt.delta)},
+	{"verbose", Wasp::CvtToBoolean, &opt.verbose, sizeof(opt.verbose)},
+	{"help", Wasp::CvtToBoolean, &opt.help, sizeof(opt.help)},
+	{NULL}
+};
+
+const char	*ProgName;
+
+struct Case {
+	string geodef;
+	string projdef;
+	double lon0;
+};
+
+const Case cases[] = {
+	{
+		"+proj=latlong +ellps=WGS84",
+		"+proj=merc +lon_0=0 +ellps=WGS84", 0.0
+	},
+	{
+		"+proj=latlong +a=6370000 +b=6370000",
+		"+proj=merc +lat_ts=30 +lon_0=-100 +a=6370000 +b=6370000", -100.0
+	},
+	{
+		"+proj=latlong +ellps=WGS84",
+		"+proj=merc +lon_0=150 +k=0.9 +x_0=1000 +y_0=-500 +ellps=WGS84", 150.0
+	},
+	{
+		"+proj=latlong +a=6370000 +b=6370000",
+		"+proj=lcc +lat_1=30 +lat_2=60 +lat_0=40 +lon_0=-97 "
+		"+a=6370000 +b=6370000", -97.0
+	},
+	{
+		"+proj=latlong +ellps=WGS84",
+		"+proj=lcc +lat_1=30 +lat_2=60 +lat_0=40 +lon_0=-97 +ellps=WGS84", 
+		-97.0
+	},
+	{
+		"+proj=latlong +ellps=WGS84",
+		"+proj=lcc +lat_1=-30 +lat_2=-60 +lat_0=-45 +lon_0=135 +ellps=WGS84", 
+		135.0
+	},
+	{
+		"+proj=latlong +a=6370000 +b=6370000",
+		"+proj=lcc +lat_1=-35 +lat_0=-35 +lon_0=170 +a=6370000 +b=6370000", 
+		170.0
+	},
+	{
+		"+proj=latlong +ellps=WGS84",
+		"+proj=lcc +lat_1=45 +lon_0=10 +ellps=WGS84", 10.0
+	}
+};
+
+// Points that proj4 can't transform are set to HUGE_VAL
+//
+bool failed(double v) {
+	return(! std::isfinite(v) || fabs(v) >= 1e30);
+}
+
+// The proj4 reference, with geographic coordinates in degrees
+//
+int reference(
+	projPJ pjSrc, projPJ pjDst, vector <double> &x, vector <double> &y
+) {
+	if (pj_is_latlong(pjSrc)) {
+		for (size_t i=0; i<x.size(); i++) {
+			x[i] *= DEG_TO_RAD;
+			y[i] *= DEG_TO_RAD;
+		}
+	}
+
+	int rc = pj_transform(pjSrc, pjDst, x.size(), 1, x.data(), y.data(), NULL);
+	if (rc != 0) return(rc);
+
+	if (pj_is_latlong(pjDst)) {
+		for (size_t i=0; i<x.size(); i++) {
+			if (failed(x[i]) || failed(y[i])) continue;
+			x[i] *= RAD_TO_DEG;
+			y[i] *= RAD_TO_DEG;
+		}
+	}
+	return(0);
+}
+
+// Returns true if a point agrees to within millimeters, or roughly the 
+// same in degrees. Projected coordinates near a pole are huge, and 
+// longitudes there are ill conditioned.
+//
+bool agree(
+	double x, double y, double xref, double yref, bool geographic
+) {
+	if (failed(xref) || failed(yref)) return(failed(x) || failed(y));
+	if (failed(x) || failed(y)) return(false);
+
+	double dx = fabs(x - xref);
+	double dy = fabs(y - yref);
+	if (! geographic) {
+		return(
+			dx <= 1.0e-3 + 1.0e-7 * fabs(xref) && 
+			dy <= 1.0e-3 + 1.0e-7 * fabs(yref)
+		);
+	}
+	dx = std::min(dx, fabs(dx - 360.0));
+	return(dx * cos(yref * DEG_TO_RAD) <= 1.0e-7 && dy <= 1.0e-7);
+}
+
+// Transforms the points with both Proj4API and proj4, and returns the 
+// number of points that differ. The points are transformed in place 
+// by proj4.
+//
+size_t test_row(
+	const Proj4API &proj4API, projPJ pjSrc, projPJ pjDst, 
+	vector <double> &x, vector <double> &y
+) {
+	vector <double> xapi = x;
+	vector <double> yapi = y;
+	vector <double> xin = x;
+	vector <double> yin = y;
+
+	int rcapi = proj4API.Transform(xapi.data(), yapi.data(), xapi.size());
+	int rc = reference(pjSrc, pjDst, x, y);
+
+	// Both must fail, or both must succeed
+	//
+	if ((rcapi != 0) != (rc != 0)) {
+		if (opt.verbose) {
+			cout << "	row at " << xin[0] << " " << yin[0] << " : status " 
+				<< rcapi << " vs " << rc << endl;
+		}
+		return(x.size());
+	}
+	if (rc != 0) return(0);
+
+	bool geographic = pj_is_latlong(pjDst);
+	size_t nwrong = 0;
+	for (size_t i=0; i<x.size(); i++) {
+		if (agree(xapi[i], yapi[i], x[i], y[i], geographic)) continue;
+
+		nwrong++;
+		if (opt.verbose) {
+			cout.precision(12);
+			cout << "	" << xin[i] << " " << yin[i] << " : " 
+				<< xapi[i] << " " << yapi[i] << " vs " 
+				<< x[i] << " " << y[i] << endl;
+		}
+	}
+	return(nwrong);
+}
+
+size_t test_case(const Case &c) {
+	Proj4API fwdAPI, invAPI;
+	if (fwdAPI.Initialize(c.geodef, c.projdef) < 0) return(1);
+	if (invAPI.Initialize(c.projdef, c.geodef) < 0) return(1);
+
+	projPJ pjGeo = pj_init_plus(c.geodef.c_str());
+	projPJ pjProj = pj_init_plus(c.projdef.c_str());
+	if (! pjGeo || ! pjProj) {
+		cerr << ProgName << " : pj_init_plus() : " 
+			<< pj_strerrno(*pj_get_errno_ref()) << endl;
+		if (pjGeo) pj_free(pjGeo);
+		if (pjProj) pj_free(pjProj);
+		return(1);
+	}
+
+	// Longitudes at each end of the range, and on either side of the 
+	// meridian opposite the projection's central meridian
+	//
+	vector <double> lons;
+	for (double lon = -180.0; lon <= 180.0; lon += opt.delta) {
+		lons.push_back(lon);
+	}
+	lons.push_back(-179.999999);
+	lons.push_back(179.999999);
+	lons.push_back(c.lon0 + 180.0);
+	lons.push_back(c.lon0 - 180.0);
+	lons.push_back(c.lon0 + 180.0 - 1e-7);
+	lons.push_back(c.lon0 - 180.0 + 1e-7);
+
+	vector <double> lats;
+	for (double lat = -90.0; lat <= 90.0; lat += opt.delta) {
+		lats.push_back(lat);
+	}
+	lats.push_back(-89.999999);
+	lats.push_back(89.999999);
+
+	size_t nwrong = 0;
+	size_t npts = 0;
+	for (size_t j=0; j<lats.size(); j++) {
+		vector <double> x = lons;
+		vector <double> y(lons.size(), lats[j]);
+		nwrong += test_row(fwdAPI, pjGeo, pjProj, x, y);
+		npts += x.size();
+
+		// The inverse of the points proj4 could project
+		//
+		vector <double> px, py;
+		for (size_t i=0; i<x.size(); i++) {
+			if (failed(x[i]) || failed(y[i])) continue;
+			px.push_back(x[i]);
+			py.push_back(y[i]);
+		}
+		if (px.empty()) continue;
+
+		nwrong += test_row(invAPI, pjProj, pjGeo, px, py);
+		npts += px.size();
+	}
+	cout << c.projdef << endl;
+	cout << "	" << npts << " points, " << nwrong << " wrong" << endl;
+
+	pj_free(pjGeo);
+	pj_free(pjProj);
+	return(nwrong);
+}
+
+int main(int argc, char **argv) {
+
+	OptionParser op;
+
+	ProgName = FileUtils::LegacyBasename(argv[0]);
+
+	MyBase::SetErrMsgFilePtr(stderr);
+
+	if (op.AppendOptions(set_opts) < 0) {
+		cerr << ProgName << " : " << op.GetErrMsg();
+		exit(1);
+	}
+
+	if (op.ParseOptions(&argc, argv, get_options) < 0) {
+		cerr << ProgName << " : " << op.GetErrMsg();
+		exit(1);
+	}
+
+	if (opt.help) {
+		cerr << "Usage: " << ProgName << " [options] " << endl;
+		op.PrintOptionHelp(stderr);
+		exit(0);
+	}
+
+	if (! (opt.delta > 0.0)) {
+		cerr << "Usage: " << ProgName << " [options] " << endl;
+		op.PrintOptionHelp(stderr);
+		exit(1);
+	}
+
+	size_t nwrong = 0;
+	for (size_t i=0; i<sizeof(cases) / sizeof(cases[0]); i++) {
+		nwrong += test_case(cases[i]);
+	}
+
+	if (nwrong) {
+		cerr << ProgName << " : " << nwrong << " mismatches" << endl;
+		return(1);
+	}
+
+	return 0;
+}
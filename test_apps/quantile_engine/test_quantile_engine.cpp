@@ -0,0 +1,277 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cfloat>
+#include <limits>
+#include <algorithm>
+#include <thread>
+#include <random>
+
+#include <vapor/FileUtils.h>
+#include <vapor/CFuncs.h>
+#include <vapor/OptionParser.h>
+#include <vapor/QuantileEngine.h>
+
+using namespace std;
+
+using namespace Wasp;
+using namespace VAPoR;
+
+//
+// Compares the quantiles computed by QuantileEngine, in exact and 
+// approximate (KLL sketch) modes, with those selected by 
+// std::nth_element
+//
+
+struct {
+	int n;
+	int nthreads;
+	float epsilon;
+	OptionParser::Boolean_T	help;
+} opt;
+
+OptionParser::OptDescRec_T	set_opts[] = {
+	{"n",     1,  "1000000","Number of values"},
+	{"nthreads",  1,  "4","Number of threads adding values"},
+	{"epsilon",  1,  "0.001","Relative rank error of approximate quantiles"},
+	{"help",	0,	"",	"Print this message and exit"},
+	{NULL}
+};
+
+
+OptionParser::Option_T	get_options[] = {
+	{"n", Wasp::CvtToInt, &opt.n, sizeof(opt.n)},
+	{"nthreads", Wasp::CvtToInt, &opt.nthreads, sizeof(opt.nthreads)},
+	{"epsilon", Wasp::CvtToFloat, &opt.epsilon, sizeof(opt.epsilon)},
+	{"help", Wasp::CvtToBoolean, &opt.help, sizeof(opt.help)},
+	{NULL}
+};
+
+const char	*ProgName;
+
+const float MissingValue = -999.0;
+
+const vector <double> Quantiles = {0.0, 0.001, 0.25, 0.5, 0.75, 0.999, 1.0};
+
+// The values QuantileEngine is expected to consider, sorted
+//
+vector <float> valid_sorted(const vector <float> &values) {
+	vector <float> valid;
+	for (size_t i=0; i<values.size(); i++) {
+		float v = values[i];
+		if (v == MissingValue || ! (fabs(v) <= FLT_MAX)) continue;
+		valid.push_back(v);
+	}
+	std::sort(valid.begin(), valid.end());
+	return(valid);
+}
+
+size_t quantile_rank(double q, size_t n) {
+	return(std::min((size_t) (q * n), n - 1));
+}
+
+// Streams the values, split across threads, until the engine is done
+//
+int run_engine(
+	QuantileEngine &qe, const vector <float> &values, vector <double> &results
+) {
+	qe.SetQuantiles(Quantiles);
+
+	int nthreads = qe.GetNumThreads();
+	while (qe.BeginPass()) {
+		vector <std::thread> threads;
+		size_t chunk = (values.size() + nthreads - 1) / nthreads;
+		for (int t=0; t<nthreads; t++) {
+			size_t first = std::min(t * chunk, values.size());
+			size_t count = std::min(chunk, values.size() - first);
+			threads.push_back(std::thread([&qe, &values, t, first, count]() {
+
+				// Several spans per thread, as ForEachBlock() visits them
+				//
+				size_t span = 4096;
+				for (size_t i=first; i<first+count; i+=span) {
+					qe.Add(
+						t, values.data() + i, NULL, 
+						std::min(span, first + count - i), MissingValue
+					);
+				}
+			}));
+		}
+		for (int t=0; t<threads.size(); t++) threads[t].join();
+		qe.EndPass();
+	}
+
+	return(qe.GetQuantiles(results));
+}
+
+// Returns the number of wrong quantiles
+//
+size_t test_exact(
+	string name, const vector <float> &values, size_t bufferLimit
+) {
+	QuantileEngine qe(QuantileEngine::EXACT, 0.0, opt.nthreads, bufferLimit);
+	vector <double> results;
+	int rc = run_engine(qe, values, results);
+
+	vector <float> valid = valid_sorted(values);
+
+	size_t nwrong = 0;
+	if (valid.empty()) {
+		if (rc >= 0) nwrong++;
+	}
+	else if (rc < 0 || results.size() != Quantiles.size()) {
+		nwrong = Quantiles.size();
+	}
+	else {
+		for (int i=0; i<Quantiles.size(); i++) {
+			vector <float> copy = valid;
+			size_t r = quantile_rank(Quantiles[i], copy.size());
+			std::nth_element(copy.begin(), copy.begin() + r, copy.end());
+			if (results[i] != copy[r]) nwrong++;
+		}
+	}
+	cout << "	exact, " << name << ", buffer " << bufferLimit << " : " 
+		<< nwrong << " wrong" << endl;
+
+	return(nwrong);
+}
+
+// Returns the number of quantiles whose rank is off by more than the 
+// error bound
+//
+size_t test_approximate(string name, const vector <float> &values) {
+	QuantileEngine qe(QuantileEngine::APPROXIMATE, opt.epsilon, opt.nthreads);
+	vector <double> results;
+	int rc = run_engine(qe, values, results);
+
+	vector <float> valid = valid_sorted(values);
+
+	size_t nwrong = 0;
+	double maxerr = 0.0;
+	if (valid.empty()) {
+		if (rc >= 0) nwrong++;
+	}
+	else if (rc < 0 || results.size() != Quantiles.size()) {
+		nwrong = Quantiles.size();
+	}
+	else {
+		size_t n = valid.size();
+		for (int i=0; i<Quantiles.size(); i++) {
+			size_t r = quantile_rank(Quantiles[i], n);
+
+			// Distance from the requested rank to the ranks held by the
+			// returned value. A value not in the input is wrong.
+			//
+			float v = (float) results[i];
+			size_t lo = std::lower_bound(valid.begin(), valid.end(), v) - 
+				valid.begin();
+			size_t hi = std::upper_bound(valid.begin(), valid.end(), v) - 
+				valid.begin();
+			if (lo == hi) {
+				nwrong++;
+				continue;
+			}
+			double err = r < lo ? lo - r : (r >= hi ? r - (hi - 1) : 0);
+			err /= n;
+			maxerr = std::max(maxerr, err);
+
+			if (err > 2.0 * opt.epsilon) nwrong++;
+		}
+	}
+	cout << "	approximate, " << name << " : max rank error " << maxerr 
+		<< ", " << nwrong << " wrong" << endl;
+
+	return(nwrong);
+}
+
+int main(int argc, char **argv) {
+
+	OptionParser op;
+
+	ProgName = FileUtils::LegacyBasename(argv[0]);
+
+	MyBase::SetErrMsgFilePtr(stderr);
+
+	if (op.AppendOptions(set_opts) < 0) {
+		cerr << ProgName << " : " << op.GetErrMsg();
+		exit(1);
+	}
+
+	if (op.ParseOptions(&argc, argv, get_options) < 0) {
+		cerr << ProgName << " : " << op.GetErrMsg();
+		exit(1);
+	}
+
+	if (opt.help) {
+		cerr << "Usage: " << ProgName << " [options] " << endl;
+		op.PrintOptionHelp(stderr);
+		exit(0);
+	}
+
+	if (opt.n < 1 || opt.nthreads < 1 || ! (opt.epsilon > 0.0)) {
+		cerr << "Usage: " << ProgName << " [options] " << endl;
+		op.PrintOptionHelp(stderr);
+		exit(1);
+	}
+
+	std::mt19937 gen(1);
+	std::uniform_real_distribution <float> uniform(-1.0, 1.0);
+	std::normal_distribution <float> normal(10.0, 3.0);
+	std::uniform_int_distribution <int> dice(0, 99);
+
+	vector <pair <string, vector <float> > > inputs;
+
+	vector <float> values(opt.n);
+	for (size_t i=0; i<values.size(); i++) values[i] = uniform(gen);
+	inputs.push_back(make_pair("uniform", values));
+
+	// Heavy tailed, with missing values and many duplicates
+	//
+	for (size_t i=0; i<values.size(); i++) {
+		int d = dice(gen);
+		if (d < 10) values[i] = MissingValue;
+		else if (d < 40) values[i] = (float) (int) normal(gen);
+		else values[i] = exp(normal(gen));
+	}
+	inputs.push_back(make_pair("skewed", values));
+
+	std::fill(values.begin(), values.end(), 3.5f);
+	inputs.push_back(make_pair("constant", values));
+
+	std::fill(values.begin(), values.end(), MissingValue);
+	inputs.push_back(make_pair("all missing", values));
+
+	// Infinities and NaNs are ignored
+	//
+	for (size_t i=0; i<values.size(); i++) {
+		int d = dice(gen);
+		if (d < 10) values[i] = std::numeric_limits<float>::infinity();
+		else if (d < 20) values[i] = -std::numeric_limits<float>::infinity();
+		else if (d < 25) values[i] = std::numeric_limits<float>::quiet_NaN();
+		else values[i] = uniform(gen);
+	}
+	inputs.push_back(make_pair("infinities", values));
+
+	std::fill(values.begin(), values.end(), std::numeric_limits<float>::infinity());
+	for (size_t i=0; i<values.size(); i+=2) values[i] = -values[i];
+	inputs.push_back(make_pair("only infinities", values));
+
+	size_t nwrong = 0;
+	for (int i=0; i<inputs.size(); i++) {
+		cout << inputs[i].first << endl;
+
+		// A small buffer forces several refinement passes
+		//
+		nwrong += test_exact(inputs[i].first, inputs[i].second, 1 << 22);
+		nwrong += test_exact(inputs[i].first, inputs[i].second, 1000);
+		nwrong += test_approximate(inputs[i].first, inputs[i].second);
+	}
+
+	if (nwrong) {
+		cerr << ProgName << " : " << nwrong << " mismatches" << endl;
+		return(1);
+	}
+
+	return 0;
+}
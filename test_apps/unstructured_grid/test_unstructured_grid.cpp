@@ -0,0 +1,270 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include "vapor/VAssert.h"
+
+#include <vapor/FileUtils.h>
+#include <vapor/CFuncs.h>
+#include <vapor/OptionParser.h>
+#include <vapor/UnstructuredGrid2D.h>
+
+using namespace std;
+
+using namespace Wasp;
+using namespace VAPoR;
+
+//
+// Compares the bulk sampling and point location paths of 
+// UnstructuredGrid2D (SampleMany(), LocateCellsMany()) with the scalar
+// paths (GetValue(), GetIndicesCell()) on a jittered triangle mesh
+//
+
+struct {
+	int n;
+	int npts;
+	OptionParser::Boolean_T	help;
+} opt;
+
+OptionParser::OptDescRec_T	set_opts[] = {
+	{"n",     1,  "100","Mesh X & Y dimensions in vertices"},
+	{"npts",  1,  "100000","Number of random sample points"},
+	{"help",	0,	"",	"Print this message and exit"},
+	{NULL}
+};
+
+
+OptionParser::Option_T	get_options[] = {
+	{"n", Wasp::CvtToInt, &opt.n, sizeof(opt.n)},
+	{"npts", Wasp::CvtToInt, &opt.npts, sizeof(opt.npts)},
+	{"help", Wasp::CvtToBoolean, &opt.help, sizeof(opt.help)},
+	{NULL}
+};
+
+const char	*ProgName;
+
+// A mesh of n x n jittered vertices on the unit square. Each quad is
+// split into two triangles: (a,b,c) and (a,c,d), where a is the lower 
+// left vertex and the others follow counterclockwise.
+//
+struct Mesh {
+	size_t n;
+	vector <float> x, y, values;
+	vector <int> vertexOnFace;
+	vector <int> faceOnVertex;
+	vector <int> faceOnFace;
+
+	Mesh(size_t n) : n(n) {
+		double delta = 1.0 / (n - 1);
+		srand48(1);
+		for (size_t j=0; j<n; j++) {
+		for (size_t i=0; i<n; i++) {
+			double xv = i * delta;
+			double yv = j * delta;
+			if (i > 0 && i < n-1) xv += (drand48() - 0.5) * 0.6 * delta;
+			if (j > 0 && j < n-1) yv += (drand48() - 0.5) * 0.6 * delta;
+			x.push_back(xv);
+			y.push_back(yv);
+			values.push_back(sin(6.0 * xv) * cos(4.0 * yv) + xv);
+		}
+		}
+
+		auto vertex = [n](size_t i, size_t j) -> int {return(j * n + i); };
+		auto tri = [n](long i, long j, int t) -> int {
+			if (i < 0 || j < 0 || i >= n-1 || j >= n-1) return(-2);
+			return((j * (n-1) + i) * 2 + t);
+		};
+
+		for (long j=0; j<n-1; j++) {
+		for (long i=0; i<n-1; i++) {
+			int a = vertex(i, j), b = vertex(i+1, j);
+			int c = vertex(i+1, j+1), d = vertex(i, j+1);
+
+			int v0[] = {a, b, c};
+			int n0[] = {tri(i, j-1, 1), tri(i+1, j, 1), tri(i, j, 1)};
+			vertexOnFace.insert(vertexOnFace.end(), v0, v0+3);
+			faceOnFace.insert(faceOnFace.end(), n0, n0+3);
+
+			int v1[] = {a, c, d};
+			int n1[] = {tri(i, j, 0), tri(i, j+1, 0), tri(i-1, j, 0)};
+			vertexOnFace.insert(vertexOnFace.end(), v1, v1+3);
+			faceOnFace.insert(faceOnFace.end(), n1, n1+3);
+		}
+		}
+
+		faceOnVertex.assign(n * n * 6, -1);
+	}
+
+	size_t NumFaces() const { return(vertexOnFace.size() / 3); }
+};
+
+UnstructuredGrid2D *make_grid(Mesh &mesh) {
+	vector <size_t> vertexDims = {mesh.n * mesh.n};
+	vector <size_t> faceDims = {mesh.NumFaces()};
+	vector <size_t> edgeDims;
+	vector <size_t> bs = vertexDims;
+
+	UnstructuredGridCoordless xug(
+		vertexDims, faceDims, edgeDims, bs, {mesh.x.data()}, 2,
+		mesh.vertexOnFace.data(), mesh.faceOnVertex.data(), 
+		mesh.faceOnFace.data(), UnstructuredGrid::NODE, 3, 6, 0, 0
+	);
+	UnstructuredGridCoordless yug(
+		vertexDims, faceDims, edgeDims, bs, {mesh.y.data()}, 2,
+		mesh.vertexOnFace.data(), mesh.faceOnVertex.data(), 
+		mesh.faceOnFace.data(), UnstructuredGrid::NODE, 3, 6, 0, 0
+	);
+	UnstructuredGridCoordless zug;
+
+	return(new UnstructuredGrid2D(
+		vertexDims, faceDims, edgeDims, bs, {mesh.values.data()},
+		mesh.vertexOnFace.data(), mesh.faceOnVertex.data(), 
+		mesh.faceOnFace.data(), UnstructuredGrid::NODE, 3, 6, 0, 0,
+		xug, yug, zug, nullptr
+	));
+}
+
+// Returns the number of points whose values differ
+//
+size_t test_sample(const Grid *g, const vector <double> &coords) {
+	size_t n = coords.size() / 2;
+	vector <float> values(n);
+	g->SampleMany(coords.data(), n, values.data());
+
+	float mv = g->GetMissingValue();
+	size_t nmissing = 0;
+	size_t nwrong = 0;
+	vector <double> pt(2);
+	for (size_t p=0; p<n; p++) {
+		pt[0] = coords[p*2];
+		pt[1] = coords[p*2+1];
+		float v = g->GetValue(pt);
+
+		if (v == mv) nmissing++;
+
+		// Points on an edge shared by two faces may be located in either,
+		// which only changes the rounding of the interpolated value
+		//
+		bool same = v == mv ? 
+			values[p] == mv : fabs(values[p] - v) <= 1e-5 * (1.0 + fabs(v));
+		if (! same) nwrong++;
+	}
+	cout << "	" << n << " points, " << nmissing << " outside, " 
+		<< nwrong << " wrong" << endl;
+
+	return(nwrong);
+}
+
+// Returns the number of points whose cells differ
+//
+size_t test_locate(
+	const UnstructuredGrid2D *g, const Mesh &mesh, 
+	const vector <double> &coords, bool morton
+) {
+	size_t n = coords.size() / 2;
+	vector <size_t> indices(n);
+	std::unique_ptr <bool[]> found(new bool[n]);
+	g->LocateCellsMany(coords.data(), n, indices.data(), found.get(), morton);
+
+	size_t nwrong = 0;
+	vector <double> pt(2);
+	vector <size_t> cindices;
+	for (size_t p=0; p<n; p++) {
+		pt[0] = coords[p*2];
+		pt[1] = coords[p*2+1];
+		bool inside = g->GetIndicesCell(pt, cindices);
+
+		if (inside != found[p]) {
+			nwrong++;
+			continue;
+		}
+		if (! inside || cindices[0] == indices[p]) continue;
+
+		// A different face is only right if it contains the point too.
+		// They must share an edge or vertex.
+		//
+		const int *f0 = &mesh.vertexOnFace[cindices[0] * 3];
+		const int *f1 = &mesh.vertexOnFace[indices[p] * 3];
+		int shared = 0;
+		for (int i=0; i<3; i++) {
+		for (int j=0; j<3; j++) {
+			if (f0[i] == f1[j]) shared++;
+		}
+		}
+		if (! shared) nwrong++;
+	}
+	cout << "	" << n << " points, morton " << (morton ? "on" : "off") << ", " 
+		<< nwrong << " wrong" << endl;
+
+	return(nwrong);
+}
+
+int main(int argc, char **argv) {
+
+	OptionParser op;
+
+	ProgName = FileUtils::LegacyBasename(argv[0]);
+
+	MyBase::SetErrMsgFilePtr(stderr);
+
+	if (op.AppendOptions(set_opts) < 0) {
+		cerr << ProgName << " : " << op.GetErrMsg();
+		exit(1);
+	}
+
+	if (op.ParseOptions(&argc, argv, get_options) < 0) {
+		cerr << ProgName << " : " << op.GetErrMsg();
+		exit(1);
+	}
+
+	if (opt.help) {
+		cerr << "Usage: " << ProgName << " [options] " << endl;
+		op.PrintOptionHelp(stderr);
+		exit(0);
+	}
+
+	VAssert(opt.n >= 2);
+
+	Mesh mesh(opt.n);
+	std::unique_ptr <UnstructuredGrid2D> g(make_grid(mesh));
+
+	// Scattered points, some of them outside of the mesh
+	//
+	vector <double> scattered;
+	for (int p=0; p<opt.npts; p++) {
+		scattered.push_back(drand48() * 1.2 - 0.1);
+		scattered.push_back(drand48() * 1.2 - 0.1);
+	}
+
+	// A raster, as sampled by a slice
+	//
+	vector <double> raster;
+	int m = (int) sqrt((double) opt.npts);
+	for (int j=0; j<m; j++) {
+	for (int i=0; i<m; i++) {
+		raster.push_back((i + 0.5) / m);
+		raster.push_back((j + 0.5) / m);
+	}
+	}
+
+	size_t nwrong = 0;
+	for (int order=0; order<2; order++) {
+		g->SetInterpolationOrder(order);
+		cout << "SampleMany, interpolation order " << order << endl;
+		nwrong += test_sample(g.get(), scattered);
+		nwrong += test_sample(g.get(), raster);
+	}
+
+	cout << "LocateCellsMany" << endl;
+	nwrong += test_locate(g.get(), mesh, scattered, false);
+	nwrong += test_locate(g.get(), mesh, scattered, true);
+	nwrong += test_locate(g.get(), mesh, raster, false);
+
+	if (nwrong) {
+		cerr << ProgName << " : " << nwrong << " mismatches" << endl;
+		return(1);
+	}
+
+	return 0;
+}